@@ -0,0 +1,156 @@
+/**
+ * @file backendBenchmark.cpp
+ * @brief Comparison of the linear algebra backends of QSMatrix (GEMM, GEMV, solve).
+ * @details Every backend compiled in (built-in, CBLAS, Eigen) runs the same random problems. For each size
+ * the time per call, the GFLOP/s and the largest difference with the built-in result are printed.
+ *
+ * Usage: backend_benchmark [max size] (default 1024)
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "QSMatrix.h"
+#include "linearAlgebraBackend.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+// Repeat f for at least minSeconds, returns the mean time per call (seconds)
+template <typename F>
+double timeCall(F f, const double minSeconds = 0.2)
+{
+    unsigned int calls = 0;
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double elapsed = 0;
+
+    do
+    {
+        f();
+        calls++;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    } while (elapsed < minSeconds);
+
+    return elapsed / calls;
+}
+
+template <typename T>
+double maxDifference(const vector<T>& a, const vector<T>& b)
+{
+    double d = 0;
+    for (unsigned int i=0;i<a.size();i++) d = max(d, (double)fabs(a[i] - b[i]));
+    return d;
+}
+
+void printRow(const string& operation, const unsigned int n, const string& backend, const double seconds, const double flops, const double difference)
+{
+    cout << left << setw(7) << operation << right << setw(6) << n << "  " << left << setw(10) << backend << right
+    << setw(12) << setprecision(4) << seconds * 1e6 << " us" << setw(10) << setprecision(4) << flops / seconds * 1e-9 << " GFLOP/s"
+    << "   diff " << setprecision(3) << difference << endl;
+}
+
+template <typename T, typename Backend>
+void benchmarkGemm(const unsigned int n, const vector<T>& A, const vector<T>& B, const vector<T>& reference)
+{
+    vector<T> C(n * n);
+    const double seconds = timeCall([&]() { Backend::gemm(n, n, n, T(1), A.data(), n, B.data(), n, T(0), C.data(), n, QSMatrix<T>::getThreadCount()); });
+    printRow("gemm", n, Backend::name(), seconds, 2.0 * n * n * n, maxDifference(C, reference));
+}
+
+template <typename T, typename Backend>
+void benchmarkGemv(const unsigned int n, const vector<T>& A, const vector<T>& x, const vector<T>& reference)
+{
+    vector<T> y(n);
+    const double seconds = timeCall([&]() { Backend::gemv(n, n, T(1), A.data(), n, x.data(), T(0), y.data()); });
+    printRow("gemv", n, Backend::name(), seconds, 2.0 * n * n, maxDifference(y, reference));
+}
+
+template <typename T, typename Backend>
+void benchmarkSolve(const unsigned int n, const vector<T>& A, const vector<T>& B, const vector<T>& reference)
+{
+    vector<T> LU, X;
+    const double seconds = timeCall([&]() { LU = A; X = B; Backend::solve(n, 1, LU.data(), X.data()); });
+    printRow("solve", n, Backend::name(), seconds, 2.0 / 3.0 * n * n * n, maxDifference(X, reference));
+}
+
+template <typename T>
+void benchmark(const unsigned int maxSize)
+{
+    mt19937 generator(1);
+    uniform_real_distribution<double> distribution(-1, 1);
+
+    for (unsigned int n=16;n<=maxSize;n*=4)
+    {
+        QSMatrix<T> A(n, n, 0), B(n, n, 0);
+        vector<T> x(n);
+
+        for (unsigned int i=0;i<n;i++)
+        {
+            for (unsigned int j=0;j<n;j++)
+            {
+                A(i,j) = distribution(generator);
+                B(i,j) = distribution(generator);
+            }
+            A(i,i) += n;   // Well conditioned system
+            x[i] = distribution(generator);
+        }
+
+        vector<T> a(A.data(), A.data() + n*n), b(B.data(), B.data() + n*n);
+
+        // Built-in references
+        vector<T> C(n * n), y(n);
+        BuiltinBackend<T>::gemm(n, n, n, T(1), a.data(), n, b.data(), n, T(0), C.data(), n, QSMatrix<T>::getThreadCount());
+        BuiltinBackend<T>::gemv(n, n, T(1), a.data(), n, x.data(), T(0), y.data());
+
+        benchmarkGemm<T, BuiltinBackend<T> >(n, a, b, C);
+#if defined(SSC_HAVE_CBLAS)
+        benchmarkGemm<T, CblasBackend<T> >(n, a, b, C);
+#endif
+#if defined(SSC_HAVE_EIGEN)
+        benchmarkGemm<T, EigenBackend<T> >(n, a, b, C);
+#endif
+
+        benchmarkGemv<T, BuiltinBackend<T> >(n, a, x, y);
+#if defined(SSC_HAVE_CBLAS)
+        benchmarkGemv<T, CblasBackend<T> >(n, a, x, y);
+#endif
+#if defined(SSC_HAVE_EIGEN)
+        benchmarkGemv<T, EigenBackend<T> >(n, a, x, y);
+#endif
+
+        // Built-in solve: blocked LU of QSMatrix
+        vector<unsigned> pivots;
+        vector<T> solution;
+        const double seconds = timeCall([&]() { QSMatrix<T> LU(A); LU.luDecompose(pivots); solution = x; LU.luSolve(pivots, solution); });
+        printRow("solve", n, BuiltinBackend<T>::name(), seconds, 2.0 / 3.0 * n * n * n, 0);
+#if defined(SSC_HAVE_CBLAS) && defined(SSC_HAVE_LAPACK)
+        benchmarkSolve<T, CblasBackend<T> >(n, a, x, solution);
+#endif
+#if defined(SSC_HAVE_EIGEN)
+        benchmarkSolve<T, EigenBackend<T> >(n, a, x, solution);
+#endif
+        cout << endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned int maxSize = (argc > 1) ? atoi(argv[1]) : 1024;
+
+    cout << "QSMatrix backend: " << LinearAlgebraBackend<double>::name() << ", built-in threads: " << QSMatrix<double>::getThreadCount() << endl << endl;
+
+    cout << "double" << endl;
+    benchmark<double>(maxSize);
+
+    cout << "float" << endl;
+    benchmark<float>(maxSize);
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file socketLoadGenerator.cpp
+ * @brief Load generator of SocketControllerServer: throughput and latency percentiles.
+ * @details Each client thread opens a connection and keeps "in flight" step requests pipelined on random
+ * controllers; the latency of a request is the time from its send to its reply. Without socket path, a
+ * server with 64 random controllers (nx = 8, ne = nu = 2) runs in this process.
+ *
+ * Usage: socket_load_generator [clients] [requests per client] [in flight] [batch window (us)] [socket path]
+ * (default 4 10000 8 100)
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "socketControllerServer.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <memory>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// Latencies (seconds) of the requests of one client
+vector<double> runClient(const string& path, const unsigned int requests, const unsigned int inFlight, const unsigned int seed)
+{
+    SocketControllerClient<double> client(path);
+    vector<double> latencies;
+    if (!client.isOpen())
+    {
+        return latencies;
+    }
+
+    // Controllers and their number of inputs
+    vector<unsigned int> inputs;
+    unsigned int nx, ne, nu;
+    float t_s;
+    while (client.info(inputs.size(), nx, ne, nu, t_s))
+    {
+        inputs.push_back(ne);
+    }
+    if (inputs.empty())
+    {
+        return latencies;
+    }
+
+    mt19937 generator(seed);
+    uniform_real_distribution<double> distribution(-1, 1);
+    vector<Clock::time_point> sent(requests);
+    vector<double> values;
+    vector<double> u;
+    SocketMessageHeader header;
+    unsigned int next = 0;
+
+    latencies.reserve(requests);
+    while (latencies.size() < requests)
+    {
+        while (next < requests && next - latencies.size() < inFlight)
+        {
+            const unsigned int controller = generator() % inputs.size();
+            values.resize(inputs[controller]);
+            for (unsigned int k=0;k<values.size();k++) values[k] = distribution(generator);
+
+            sent[next] = Clock::now();
+            client.send(controller, next, values.data(), values.size());
+            next++;
+        }
+
+        if (!client.receive(header, u))
+        {
+            break;
+        }
+        latencies.push_back(chrono::duration<double>(Clock::now() - sent[header.tag]).count());
+    }
+
+    return latencies;
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned int clients = (argc > 1) ? atoi(argv[1]) : 4;
+    const unsigned int requests = (argc > 2) ? atoi(argv[2]) : 10000;
+    const unsigned int inFlight = max(1, (argc > 3) ? atoi(argv[3]) : 8);
+    const double window = ((argc > 4) ? atof(argv[4]) : 100) * 1e-6;
+    string path = (argc > 5) ? argv[5] : "";
+
+    // Local server with random controllers
+    unique_ptr<SocketControllerServer<double> > server;
+    thread serverThread;
+    if (path.empty())
+    {
+        path = "/tmp/ssc_load_" + to_string(getpid()) + ".sock";
+        server.reset(new SocketControllerServer<double>(path, window));
+
+        mt19937 generator(1);
+        uniform_real_distribution<double> distribution(-0.1, 0.1);
+        for (unsigned int c=0;c<64;c++)
+        {
+            QSMatrix<double> A(8, 8, 0), B(8, 2, 0), C(2, 8, 0), D(2, 2, 0);
+            for (unsigned int i=0;i<8;i++)
+            {
+                for (unsigned int j=0;j<8;j++) A(i,j) = distribution(generator);
+                for (unsigned int j=0;j<2;j++) B(i,j) = distribution(generator);
+            }
+            for (unsigned int i=0;i<2;i++)
+            {
+                for (unsigned int j=0;j<8;j++) C(i,j) = distribution(generator);
+                for (unsigned int j=0;j<2;j++) D(i,j) = distribution(generator);
+            }
+            server->addController(StateSpaceController<double>(A, B, C, D, 0.001));
+        }
+
+        if (!server->isOpen())
+        {
+            return 1;
+        }
+        SocketControllerServer<double>* running = server.get();
+        serverThread = thread([running]() { running->run(); });
+    }
+
+    vector<vector<double> > latencies(clients);
+    vector<thread> threads;
+
+    const Clock::time_point start = Clock::now();
+    for (unsigned int c=0;c<clients;c++)
+    {
+        threads.push_back(thread([&, c]() { latencies[c] = runClient(path, requests, inFlight, c + 1); }));
+    }
+    for (unsigned int c=0;c<clients;c++) threads[c].join();
+    const double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    vector<double> all;
+    for (unsigned int c=0;c<clients;c++) all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+    sort(all.begin(), all.end());
+
+    cout << clients << " clients, " << inFlight << " requests in flight each, " << all.size() << " replies in " << setprecision(4) << seconds << " s" << endl;
+    cout << "Throughput: " << all.size() / seconds << " steps/s" << endl;
+    if (!all.empty())
+    {
+        const double percentiles[4] = {0.5, 0.99, 0.999, 1};
+        const char* names[4] = {"p50", "p99", "p99.9", "max"};
+        for (int k=0;k<4;k++)
+        {
+            cout << "Latency " << left << setw(6) << names[k] << right << setw(10) << all[min(all.size() - 1, (size_t)(percentiles[k] * all.size()))] * 1e6 << " us" << endl;
+        }
+    }
+
+    if (server)
+    {
+        server->requestStop();
+        serverThread.join();
+        const SocketServerStatistics statistics = server->getStatistics();
+        cout << "Server: " << statistics.batches << " batches, " << statistics.meanBatchSize() << " steps per batch" << endl;
+    }
+
+    return 0;
+}
@@ -16,15 +16,13 @@ QSMatrix<T>::QSMatrix()
 {
     rows = 1;
     cols = 1;
+    mat.resize(1);
 }
 
 // Parameter Constructor                                                                                                                                                      
 template<typename T>
 QSMatrix<T>::QSMatrix(unsigned _rows, unsigned _cols, const T& _initial) {
-  mat.resize(_rows);
-  for (unsigned i=0; i<mat.size(); i++) {
-    mat[i].resize(_cols, _initial);
-  }
+  mat.resize(_rows * _cols, _initial);
   rows = _rows;
   cols = _cols;
 }
@@ -37,6 +35,16 @@ QSMatrix<T>::QSMatrix(const QSMatrix<T>& rhs) {
   cols = rhs.get_cols();
 }
 
+// Move Constructor (the storage of rhs is taken)
+template<typename T>
+QSMatrix<T>::QSMatrix(QSMatrix<T>&& rhs) {
+  mat.swap(rhs.mat);
+  rows = rhs.get_rows();
+  cols = rhs.get_cols();
+  rhs.rows = 0;
+  rhs.cols = 0;
+}
+
 // (Virtual) Destructor                                                                                                                                                       
 template<typename T>
 QSMatrix<T>::~QSMatrix() {}
@@ -47,21 +55,25 @@ QSMatrix<T>& QSMatrix<T>::operator=(const QSMatrix<T>& rhs) {
   if (&rhs == this)
     return *this;
 
-  unsigned new_rows = rhs.get_rows();
-  unsigned new_cols = rhs.get_cols();
+  mat.assign(rhs.mat.begin(), rhs.mat.end());
+  rows = rhs.get_rows();
+  cols = rhs.get_cols();
 
-  mat.resize(new_rows);
-  for (unsigned i=0; i<mat.size(); i++) {
-    mat[i].resize(new_cols);
-  }
+  return *this;
+}
 
-  for (unsigned i=0; i<new_rows; i++) {
-    for (unsigned j=0; j<new_cols; j++) {
-      mat[i][j] = rhs(i, j);
-    }
-  }
-  rows = new_rows;
-  cols = new_cols;
+// Move Assignment Operator
+template<typename T>
+QSMatrix<T>& QSMatrix<T>::operator=(QSMatrix<T>&& rhs) {
+  if (&rhs == this)
+    return *this;
+
+  mat.swap(rhs.mat);
+  rows = rhs.get_rows();
+  cols = rhs.get_cols();
+  rhs.mat.clear();
+  rhs.rows = 0;
+  rhs.cols = 0;
 
   return *this;
 }
@@ -73,7 +85,7 @@ QSMatrix<T> QSMatrix<T>::operator+(const QSMatrix<T>& rhs) const{
 
   for (unsigned i=0; i<rows; i++) {
     for (unsigned j=0; j<cols; j++) {
-      result(i,j) = this->mat[i][j] + rhs(i,j);
+      result(i,j) = this->mat[i*cols + j] + rhs(i,j);
     }
   }
 
@@ -82,13 +94,13 @@ QSMatrix<T> QSMatrix<T>::operator+(const QSMatrix<T>& rhs) const{
 
 // Cumulative addition of this matrix and another                                                                                                                             
 template<typename T>
-QSMatrix<T>& QSMatrix<T>::operator+=(const QSMatrix<T>& rhs) const{
+QSMatrix<T>& QSMatrix<T>::operator+=(const QSMatrix<T>& rhs) {
   unsigned rows = rhs.get_rows();
   unsigned cols = rhs.get_cols();
 
   for (unsigned i=0; i<rows; i++) {
     for (unsigned j=0; j<cols; j++) {
-      this->mat[i][j] += rhs(i,j);
+      this->mat[i*cols + j] += rhs(i,j);
     }
   }
 
@@ -104,7 +116,7 @@ QSMatrix<T> QSMatrix<T>::operator-(const QSMatrix<T>& rhs) const{
 
   for (unsigned i=0; i<rows; i++) {
     for (unsigned j=0; j<cols; j++) {
-      result(i,j) = this->mat[i][j] - rhs(i,j);
+      result(i,j) = this->mat[i*cols + j] - rhs(i,j);
     }
   }
 
@@ -113,13 +125,13 @@ QSMatrix<T> QSMatrix<T>::operator-(const QSMatrix<T>& rhs) const{
 
 // Cumulative subtraction of this matrix and another                                                                                                                          
 template<typename T>
-QSMatrix<T>& QSMatrix<T>::operator-=(const QSMatrix<T>& rhs) const{
+QSMatrix<T>& QSMatrix<T>::operator-=(const QSMatrix<T>& rhs) {
   unsigned rows = rhs.get_rows();
   unsigned cols = rhs.get_cols();
 
   for (unsigned i=0; i<rows; i++) {
     for (unsigned j=0; j<cols; j++) {
-      this->mat[i][j] -= rhs(i,j);
+      this->mat[i*cols + j] -= rhs(i,j);
     }
   }
 
@@ -134,33 +146,28 @@ QSMatrix<T> QSMatrix<T>::operator*(const QSMatrix<T>& rhs) const{
   unsigned res_cols = rhs.get_cols();
   QSMatrix result(res_rows, res_cols, 0.0);
 
-  for (unsigned i=0; i<res_rows; i++) {
-    for (unsigned j=0; j<res_cols; j++) {
-      for (unsigned k=0; k<this->cols; k++) {
-        result(i,j) += this->mat[i][k] * rhs(k,j);
-      }
-    }
-  }
+  LinearAlgebraBackend<T>::gemm(res_rows, res_cols, this->cols, T(1), this->mat.data(), this->cols, rhs.data(), res_cols, T(0), result.data(), res_cols, getThreadCount());
 
   return result;
 }
 
 // Cumulative left multiplication of this matrix and another                                                                                                                  
 template<typename T>
-QSMatrix<T>& QSMatrix<T>::operator*=(const QSMatrix<T>& rhs) const{
+QSMatrix<T>& QSMatrix<T>::operator*=(const QSMatrix<T>& rhs) {
   QSMatrix result = (*this) * rhs;
-  (*this) = result;
+  this->mat.swap(result.mat);
+  this->cols = result.cols;
   return *this;
 }
 
 // Calculate a transpose of this matrix                                                                                                                                       
 template<typename T>
-QSMatrix<T> QSMatrix<T>::transpose() {
-  QSMatrix result(rows, cols, 0.0);
+QSMatrix<T> QSMatrix<T>::transpose() const {
+  QSMatrix result(cols, rows, 0.0);
 
   for (unsigned i=0; i<rows; i++) {
     for (unsigned j=0; j<cols; j++) {
-      result(i,j) = this->mat[j][i];
+      result(j,i) = this->mat[i*cols + j];
     }
   }
 
@@ -174,7 +181,7 @@ QSMatrix<T> QSMatrix<T>::operator+(const T& rhs) const{
 
   for (unsigned i=0; i<rows; i++) {
     for (unsigned j=0; j<cols; j++) {
-      result(i,j) = this->mat[i][j] + rhs;
+      result(i,j) = this->mat[i*cols + j] + rhs;
     }
   }
 
@@ -188,7 +195,7 @@ QSMatrix<T> QSMatrix<T>::operator-(const T& rhs) const{
 
   for (unsigned i=0; i<rows; i++) {
     for (unsigned j=0; j<cols; j++) {
-      result(i,j) = this->mat[i][j] - rhs;
+      result(i,j) = this->mat[i*cols + j] - rhs;
     }
   }
 
@@ -202,7 +209,7 @@ QSMatrix<T> QSMatrix<T>::operator*(const T& rhs) const{
 
   for (unsigned i=0; i<rows; i++) {
     for (unsigned j=0; j<cols; j++) {
-      result(i,j) = this->mat[i][j] * rhs;
+      result(i,j) = this->mat[i*cols + j] * rhs;
     }
   }
 
@@ -216,7 +223,7 @@ QSMatrix<T> QSMatrix<T>::operator/(const T& rhs) const{
 
   for (unsigned i=0; i<rows; i++) {
     for (unsigned j=0; j<cols; j++) {
-      result(i,j) = this->mat[i][j] / rhs;
+      result(i,j) = this->mat[i*cols + j] / rhs;
     }
   }
 
@@ -228,13 +235,7 @@ template<typename T>
 std::vector<T> QSMatrix<T>::operator*(const std::vector<T>& rhs) const{
   std::vector<T> result(rows, 0);
 
-  for (int i=0; i<rows; i++) 
-  {
-    for (int j=0; j<rhs.size(); j++) 
-    {
-      result[i] += this->mat[i][j] * rhs[j];
-    }
-  }
+  LinearAlgebraBackend<T>::gemv(rows, rhs.size(), T(1), this->mat.data(), cols, rhs.data(), T(0), result.data());
 
   return result;
 }
@@ -272,7 +273,7 @@ std::vector<T> QSMatrix<T>::diag_vec() {
   std::vector<T> result(rows, 0.0);
 
   for (unsigned i=0; i<rows; i++) {
-    result[i] = this->mat[i][i];
+    result[i] = this->mat[i*cols + i];
   }
 
   return result;
@@ -281,13 +282,13 @@ std::vector<T> QSMatrix<T>::diag_vec() {
 // Access the individual elements                                                                                                                                             
 template<typename T>
 T& QSMatrix<T>::operator()(const unsigned& row, const unsigned& col){
-  return this->mat[row][col];
+  return this->mat[row*cols + col];
 }
 
 // Access the individual elements (const)                                                                                                                                     
 template<typename T>
 const T& QSMatrix<T>::operator()(const unsigned& row, const unsigned& col) const {
-  return this->mat[row][col];
+  return this->mat[row*cols + col];
 }
 
 // Get the number of rows of the matrix                                                                                                                                       
@@ -330,4 +331,421 @@ std::string QSMatrix<T>::getRepresentation() const
     return buffer.str();
 }
 
+// Raw row-major data
+template<typename T>
+T* QSMatrix<T>::data() {
+  return this->mat.data();
+}
+
+// Raw row-major data (const)
+template<typename T>
+const T* QSMatrix<T>::data() const {
+  return this->mat.data();
+}
+
+// Threads used by the factorizations (0: hardware concurrency)
+template<typename T>
+unsigned QSMatrix<T>::threadCount = 0;
+
+template<typename T>
+unsigned QSMatrix<T>::getThreadCount() {
+  if (threadCount == 0) {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+  return threadCount;
+}
+
+template<typename T>
+void QSMatrix<T>::setThreadCount(unsigned threads) {
+  threadCount = threads;
+}
+
+// Run fn(begin, end) on [begin, end) split over the threads
+template<typename T>
+template<typename F>
+void QSMatrix<T>::parallelFor(unsigned begin, unsigned end, unsigned minChunk, F fn) {
+  if (end <= begin) {
+    return;
+  }
+
+  unsigned n = end - begin;
+  unsigned threads = std::min(getThreadCount(), std::max(1u, n / std::max(1u, minChunk)));
+
+  if (threads <= 1) {
+    fn(begin, end);
+    return;
+  }
+
+  unsigned chunk = (n + threads - 1) / threads;
+  std::vector<std::thread> workers;
+
+  for (unsigned t=1; t<threads; t++) {
+    unsigned b = begin + t*chunk;
+    unsigned e = std::min(end, b + chunk);
+    if (b < e) {
+      workers.push_back(std::thread(fn, b, e));
+    }
+  }
+  fn(begin, std::min(end, begin + chunk));
+
+  for (unsigned t=0; t<workers.size(); t++) {
+    workers[t].join();
+  }
+}
+
+// Block size of the LU factorization
+#define QSMATRIX_BLOCK 64
+
+// Minimum number of multiply-adds of an update before using threads
+#define QSMATRIX_PARALLEL_WORK (1u << 18)
+
+// LU factorization with partial pivoting, in place (P*A = L*U)
+// Right-looking blocked algorithm: panel of QSMATRIX_BLOCK columns, then the trailing matrix is updated
+// by one matrix product (gemm(), spread over the threads for large matrices). pivots[k] is the row swapped with row k.
+// Returns false if the matrix is singular.
+template<typename T>
+bool QSMatrix<T>::luDecompose(std::vector<unsigned>& pivots) {
+  if (rows != cols) {
+    std::cout << "\033[1;31mERROR: LU factorization of a non-square matrix.\033[0m" << std::endl << std::endl;
+    return false;
+  }
+
+  const unsigned n = rows;
+  T* a = this->mat.data();
+  bool regular = true;
+
+  pivots.resize(n);
+
+  for (unsigned k0=0; k0<n; k0+=QSMATRIX_BLOCK) {
+    const unsigned k1 = std::min(n, k0 + QSMATRIX_BLOCK);
+
+    // Panel factorization (columns k0..k1-1)
+    for (unsigned k=k0; k<k1; k++) {
+      unsigned p = k;
+      for (unsigned i=k+1; i<n; i++) {
+        if (std::abs(a[i*n + k]) > std::abs(a[p*n + k])) {
+          p = i;
+        }
+      }
+      pivots[k] = p;
+      if (p != k) {
+        std::swap_ranges(a + k*n, a + (k+1)*n, a + p*n);
+      }
+
+      const T pivot = a[k*n + k];
+      if (pivot == T(0)) {
+        regular = false;
+        continue;
+      }
+
+      for (unsigned i=k+1; i<n; i++) {
+        const T l = (a[i*n + k] /= pivot);
+        if (l == T(0)) continue;
+        for (unsigned j=k+1; j<k1; j++) {
+          a[i*n + j] -= l * a[k*n + j];
+        }
+      }
+    }
+
+    if (k1 == n) {
+      break;
+    }
+
+    // U12 = L11^-1 * A12
+    for (unsigned i=k0+1; i<k1; i++) {
+      for (unsigned p=k0; p<i; p++) {
+        const T l = a[i*n + p];
+        for (unsigned j=k1; j<n; j++) {
+          a[i*n + j] -= l * a[p*n + j];
+        }
+      }
+    }
+
+    // A22 -= L21 * U12
+    gemm<T>(n - k1, n - k1, k1 - k0, T(-1), a + k1*n + k0, n, a + k0*n + k1, n, T(1), a + k1*n + k1, n, getThreadCount());
+  }
+
+  return regular;
+}
+
+// Solve L*U*X = P*B in place on B, this matrix holding the factors of luDecompose()
+template<typename T>
+void QSMatrix<T>::luSolve(const std::vector<unsigned>& pivots, QSMatrix<T>& B) const {
+  const unsigned m = B.get_cols();
+
+  for (unsigned k=0; k<pivots.size(); k++) {
+    if (pivots[k] != k) {
+      std::swap_ranges(B.mat.begin() + k*m, B.mat.begin() + (k+1)*m, B.mat.begin() + pivots[k]*m);
+    }
+  }
+
+  solveLowerTriangular(B, true);
+  solveUpperTriangular(B);
+}
+
+// Solve L*U*x = P*b in place on b
+template<typename T>
+void QSMatrix<T>::luSolve(const std::vector<unsigned>& pivots, std::vector<T>& b) const {
+  QSMatrix<T> B(b.size(), 1, T(0));
+  std::copy(b.begin(), b.end(), B.mat.begin());
+
+  luSolve(pivots, B);
+
+  std::copy(B.mat.begin(), B.mat.end(), b.begin());
+}
+
+// Solve L*X = B in place on B (L: lower part of the first B.rows rows/columns of this matrix)
+// The columns of B are spread over the threads.
+template<typename T>
+void QSMatrix<T>::solveLowerTriangular(QSMatrix<T>& B, bool unitDiagonal) const {
+  const unsigned n = B.get_rows();
+  const unsigned m = B.get_cols();
+  const unsigned minChunk = ((unsigned long)n * n * m < QSMATRIX_PARALLEL_WORK) ? m : 16;
+  T* b = B.mat.data();
+  const QSMatrix<T>& L = *this;
+
+  parallelFor(0, m, minChunk, [&L, b, n, m, unitDiagonal](unsigned begin, unsigned end) {
+    for (unsigned i=0; i<n; i++) {
+      T* bi = b + i*m;
+      for (unsigned p=0; p<i; p++) {
+        const T l = L(i,p);
+        if (l == T(0)) continue;
+        const T* bp = b + p*m;
+        for (unsigned j=begin; j<end; j++) {
+          bi[j] -= l * bp[j];
+        }
+      }
+      if (!unitDiagonal) {
+        for (unsigned j=begin; j<end; j++) {
+          bi[j] /= L(i,i);
+        }
+      }
+    }
+  });
+}
+
+// Solve U*X = B in place on B (U: upper part of the first B.rows rows/columns of this matrix)
+// The columns of B are spread over the threads.
+template<typename T>
+void QSMatrix<T>::solveUpperTriangular(QSMatrix<T>& B) const {
+  const unsigned n = B.get_rows();
+  const unsigned m = B.get_cols();
+  const unsigned minChunk = ((unsigned long)n * n * m < QSMATRIX_PARALLEL_WORK) ? m : 16;
+  T* b = B.mat.data();
+  const QSMatrix<T>& U = *this;
+
+  parallelFor(0, m, minChunk, [&U, b, n, m](unsigned begin, unsigned end) {
+    for (int i=(int)n-1; i>=0; i--) {
+      T* bi = b + i*m;
+      for (unsigned p=i+1; p<n; p++) {
+        const T u = U(i,p);
+        if (u == T(0)) continue;
+        const T* bp = b + p*m;
+        for (unsigned j=begin; j<end; j++) {
+          bi[j] -= u * bp[j];
+        }
+      }
+      for (unsigned j=begin; j<end; j++) {
+        bi[j] /= U(i,i);
+      }
+    }
+  });
+}
+
+// Householder QR factorization, in place (A = Q*R, real matrices)
+// R is stored on and above the diagonal, reflector k (v_k = 1) below the diagonal of column k.
+// The reflectors are applied to the trailing columns by column chunks spread over the threads.
+template<typename T>
+void QSMatrix<T>::qrDecompose(std::vector<T>& tau) {
+  const unsigned m = rows;
+  const unsigned n = cols;
+  const unsigned kmax = std::min(m, n);
+  T* a = this->mat.data();
+
+  tau.assign(kmax, T(0));
+
+  for (unsigned k=0; k<kmax; k++) {
+    T norm = 0;
+    for (unsigned i=k+1; i<m; i++) {
+      norm += a[i*n + k] * a[i*n + k];
+    }
+    if (norm == T(0)) continue;
+
+    const T alpha = a[k*n + k];
+    const T beta = -std::copysign(std::sqrt(alpha*alpha + norm), alpha);
+    const T scale = 1 / (alpha - beta);
+
+    tau[k] = (beta - alpha) / beta;
+    for (unsigned i=k+1; i<m; i++) {
+      a[i*n + k] *= scale;
+    }
+    a[k*n + k] = beta;
+
+    // A(k:m, k+1:n) -= tau * v * (v' * A(k:m, k+1:n))
+    const T t = tau[k];
+    const unsigned minChunk = ((unsigned long)(m - k) * (n - k) < QSMATRIX_PARALLEL_WORK / 4) ? n : 64;
+
+    parallelFor(k+1, n, minChunk, [a, m, n, k, t](unsigned begin, unsigned end) {
+      std::vector<T> w(a + k*n + begin, a + k*n + end);
+      for (unsigned i=k+1; i<m; i++) {
+        const T v = a[i*n + k];
+        for (unsigned j=begin; j<end; j++) w[j-begin] += v * a[i*n + j];
+      }
+      for (unsigned j=begin; j<end; j++) a[k*n + j] -= t * w[j-begin];
+      for (unsigned i=k+1; i<m; i++) {
+        const T tv = t * a[i*n + k];
+        for (unsigned j=begin; j<end; j++) a[i*n + j] -= tv * w[j-begin];
+      }
+    });
+  }
+}
+
+// Explicit Q (rows x min(rows, cols)) of a matrix factorized by qrDecompose()
+template<typename T>
+QSMatrix<T> QSMatrix<T>::qrQ(const std::vector<T>& tau) const {
+  const unsigned m = rows;
+  const unsigned kmax = std::min(rows, cols);
+  QSMatrix<T> Q(m, kmax, T(0));
+
+  for (unsigned k=0; k<kmax; k++) {
+    Q(k,k) = 1;
+  }
+
+  for (int k=(int)kmax-1; k>=0; k--) {
+    if (tau[k] == T(0)) continue;
+
+    for (unsigned j=k; j<kmax; j++) {
+      T w = Q(k,j);
+      for (unsigned i=k+1; i<m; i++) w += (*this)(i,k) * Q(i,j);
+      w *= tau[k];
+
+      Q(k,j) -= w;
+      for (unsigned i=k+1; i<m; i++) Q(i,j) -= (*this)(i,k) * w;
+    }
+  }
+
+  return Q;
+}
+
+// R (min(rows, cols) x cols) of a matrix factorized by qrDecompose()
+template<typename T>
+QSMatrix<T> QSMatrix<T>::qrR() const {
+  const unsigned kmax = std::min(rows, cols);
+  QSMatrix<T> R(kmax, cols, T(0));
+
+  for (unsigned i=0; i<kmax; i++) {
+    for (unsigned j=i; j<cols; j++) {
+      R(i,j) = (*this)(i,j);
+    }
+  }
+
+  return R;
+}
+
+// Solution X of this*X = B (square matrix, LU factorization of a copy by the backend or by luDecompose())
+template<typename T>
+QSMatrix<T> QSMatrix<T>::solve(const QSMatrix<T>& B) const {
+  QSMatrix<T> LU(*this);
+  QSMatrix<T> X(B);
+
+  int status = (rows == cols) ? LinearAlgebraBackend<T>::solve(rows, X.cols, LU.data(), X.data()) : -1;
+
+  if (status < 0) {
+    std::vector<unsigned> pivots;
+    status = LU.luDecompose(pivots) ? 1 : 0;
+    if (status == 1) {
+      LU.luSolve(pivots, X);
+    }
+  }
+
+  if (status == 0) {
+    std::cout << "\033[1;31mERROR: Singular matrix in QSMatrix::solve().\033[0m" << std::endl << std::endl;
+  }
+
+  return X;
+}
+
+// Solution x of this*x = b (square matrix)
+template<typename T>
+std::vector<T> QSMatrix<T>::solve(const std::vector<T>& b) const {
+  QSMatrix<T> B(b.size(), 1, T(0));
+  std::copy(b.begin(), b.end(), B.mat.begin());
+
+  QSMatrix<T> X = solve(B);
+
+  return X.mat;
+}
+
+// Least squares solution X of this*X = B (rows >= cols, QR factorization of a copy)
+template<typename T>
+QSMatrix<T> QSMatrix<T>::leastSquares(const QSMatrix<T>& B) const {
+  if (rows < cols) {
+    std::cout << "\033[1;31mERROR: QSMatrix::leastSquares() needs at least as many rows as columns.\033[0m" << std::endl << std::endl;
+    return QSMatrix<T>(cols, B.get_cols(), T(0));
+  }
+
+  const unsigned m = rows;
+  const unsigned n = cols;
+  const unsigned nb = B.get_cols();
+
+  QSMatrix<T> QR(*this);
+  std::vector<T> tau;
+  QR.qrDecompose(tau);
+
+  // B = Q' * B
+  QSMatrix<T> QtB(B);
+  std::vector<T> w(nb);
+  for (unsigned k=0; k<n; k++) {
+    if (tau[k] == T(0)) continue;
+
+    for (unsigned j=0; j<nb; j++) w[j] = QtB(k,j);
+    for (unsigned i=k+1; i<m; i++) {
+      for (unsigned j=0; j<nb; j++) w[j] += QR(i,k) * QtB(i,j);
+    }
+    for (unsigned j=0; j<nb; j++) QtB(k,j) -= tau[k] * w[j];
+    for (unsigned i=k+1; i<m; i++) {
+      for (unsigned j=0; j<nb; j++) QtB(i,j) -= tau[k] * QR(i,k) * w[j];
+    }
+  }
+
+  // R * X = (Q' * B)(0:n, :)
+  QSMatrix<T> X(n, nb, T(0));
+  std::copy(QtB.mat.begin(), QtB.mat.begin() + n*nb, X.mat.begin());
+  QR.solveUpperTriangular(X);
+
+  return X;
+}
+
+// Inverse of the matrix (LU factorization)
+template<typename T>
+QSMatrix<T> QSMatrix<T>::inverse() const {
+  QSMatrix<T> I(rows, cols, T(0));
+  for (unsigned k=0; k<rows; k++) {
+    I(k,k) = 1;
+  }
+
+  return solve(I);
+}
+
+// Determinant of the matrix (LU factorization)
+template<typename T>
+T QSMatrix<T>::determinant() const {
+  QSMatrix<T> LU(*this);
+  std::vector<unsigned> pivots;
+
+  if (!LU.luDecompose(pivots)) {
+    return T(0);
+  }
+
+  T det = 1;
+  for (unsigned k=0; k<rows; k++) {
+    det *= LU(k,k);
+    if (pivots[k] != k) {
+      det = -det;
+    }
+  }
+
+  return det;
+}
+
 #endif
@@ -14,35 +14,56 @@
 #include <string>  
 #include <sstream>   
 #include <cmath> 
+#include <algorithm>
+#include <thread>
+
+#include "gemm.h"
+#include "linearAlgebraBackend.h"
 
 /**
  * @class QSMatrix
  * @brief Class for matrices and vectors computation.
+ * @details Elements are stored in one contiguous row-major buffer.
+ *
+ * LU (partial pivoting, blocked) and QR (Householder) factorizations work in place. Their trailing updates
+ * are spread over several threads for large matrices (see setThreadCount()).
+ *
+ * Matrix products, matrix/vector products and solve() go through LinearAlgebraBackend (see
+ * linearAlgebraBackend.h): CBLAS/LAPACK or Eigen when selected at configure time, otherwise the packed,
+ * cache-blocked and multithreaded gemm() and the blocked LU of this class.
  ******/
 template <typename T> 
 class QSMatrix {
  private:
-  std::vector<std::vector<T> > mat;
+  std::vector<T> mat;
   unsigned rows;
   unsigned cols;
 
+  static unsigned threadCount;
+
+  // Run fn(begin, end) on [begin, end) split over the threads (chunks of at least minChunk)
+  template <typename F>
+  static void parallelFor(unsigned begin, unsigned end, unsigned minChunk, F fn);
+
  public:
   QSMatrix();
   QSMatrix(unsigned _rows, unsigned _cols, const T& _initial);
   QSMatrix(const QSMatrix<T>& rhs);
+  QSMatrix(QSMatrix<T>&& rhs);
   virtual ~QSMatrix();
 
   // Operator overloading, for "standard" mathematical matrix operations                                                                                                                                                          
   QSMatrix<T>& operator=(const QSMatrix<T>& rhs);
+  QSMatrix<T>& operator=(QSMatrix<T>&& rhs);
 
   // Matrix mathematical operations                                                                                                                                                                                               
   QSMatrix<T> operator+(const QSMatrix<T>& rhs) const;
-  QSMatrix<T>& operator+=(const QSMatrix<T>& rhs) const;
+  QSMatrix<T>& operator+=(const QSMatrix<T>& rhs);
   QSMatrix<T> operator-(const QSMatrix<T>& rhs) const;
-  QSMatrix<T>& operator-=(const QSMatrix<T>& rhs) const;
+  QSMatrix<T>& operator-=(const QSMatrix<T>& rhs);
   QSMatrix<T> operator*(const QSMatrix<T>& rhs) const;
-  QSMatrix<T>& operator*=(const QSMatrix<T>& rhs) const;
-  QSMatrix<T> transpose();
+  QSMatrix<T>& operator*=(const QSMatrix<T>& rhs);
+  QSMatrix<T> transpose() const;
 
   // Matrix/scalar operations                                                                                                                                                                                                     
   QSMatrix<T> operator+(const T& rhs) const;
@@ -66,6 +87,36 @@ class QSMatrix {
   unsigned get_rows() const;
   unsigned get_cols() const;
   
+  // Raw row-major data
+  T* data();
+  const T* data() const;
+
+  // LU factorization with partial pivoting (in place: unit lower L below the diagonal, U above)
+  bool luDecompose(std::vector<unsigned>& pivots);
+  void luSolve(const std::vector<unsigned>& pivots, QSMatrix<T>& B) const;
+  void luSolve(const std::vector<unsigned>& pivots, std::vector<T>& b) const;
+
+  // Householder QR factorization (in place: R above the diagonal, reflectors below)
+  void qrDecompose(std::vector<T>& tau);
+  QSMatrix<T> qrQ(const std::vector<T>& tau) const;
+  QSMatrix<T> qrR() const;
+
+  // Triangular solves (in place on B): lower (optionally unit diagonal) and upper parts of this matrix
+  void solveLowerTriangular(QSMatrix<T>& B, bool unitDiagonal = false) const;
+  void solveUpperTriangular(QSMatrix<T>& B) const;
+
+  // Solution X of this*X = B (square matrix), least squares solution for rows > cols
+  QSMatrix<T> solve(const QSMatrix<T>& B) const;
+  std::vector<T> solve(const std::vector<T>& b) const;
+  QSMatrix<T> leastSquares(const QSMatrix<T>& B) const;
+
+  QSMatrix<T> inverse() const;
+  T determinant() const;
+
+  // Threads used by the factorizations (0: hardware concurrency)
+  static unsigned getThreadCount();
+  static void setThreadCount(unsigned threads);
+
   void print() const;
   std::string getRepresentation() const;
 };
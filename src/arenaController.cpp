@@ -0,0 +1,545 @@
+/**
+ * @file arenaController.cpp
+ * @brief ArenaStateSpaceController class and huge page memory resource (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef ARENACONTROLLER_CPP
+#define ARENACONTROLLER_CPP
+
+#include "arenaController.h"
+
+#include <algorithm>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/**
+ * @brief Huge page size (bytes).
+ ******/
+#define HUGE_PAGE_SIZE (2u << 20)
+
+/**
+ * @brief Constructor.
+ * @param hugePages Use huge pages when possible.
+ ******/
+inline HugePageMemoryResource::HugePageMemoryResource(const bool hugePages):
+m_hugePages(hugePages), m_hugePageBlocks(0), m_transparentBlocks(0), m_regularBlocks(0)
+{
+}
+
+/**
+ * @return Number of blocks mapped with explicit huge pages (MAP_HUGETLB).
+ ******/
+inline unsigned int HugePageMemoryResource::getHugePageBlocks() const
+{
+    return m_hugePageBlocks;
+}
+
+/**
+ * @return Number of blocks mapped with regular pages and madvise(MADV_HUGEPAGE).
+ ******/
+inline unsigned int HugePageMemoryResource::getTransparentHugePageBlocks() const
+{
+    return m_transparentBlocks;
+}
+
+/**
+ * @return Number of blocks mapped with regular pages only.
+ ******/
+inline unsigned int HugePageMemoryResource::getRegularBlocks() const
+{
+    return m_regularBlocks;
+}
+
+/**
+ * @return Mapping size of an allocation (multiple of the huge page size, or of 4 KiB without huge pages).
+ ******/
+inline std::size_t HugePageMemoryResource::mappedSize(const std::size_t bytes) const
+{
+    const std::size_t page = m_hugePages ? HUGE_PAGE_SIZE : 4096;
+
+    return (bytes + page - 1) / page * page;
+}
+
+/**
+ * @brief Maps a block (page aligned, so any alignment up to 4 KiB is honoured).
+ * @details A larger alignment is not guaranteed when huge pages are unavailable: std::bad_alloc is thrown.
+ ******/
+inline void* HugePageMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    if (alignment > 4096)
+    {
+        throw std::bad_alloc();
+    }
+
+    const std::size_t size = mappedSize(std::max(bytes, (std::size_t)1));
+
+#if defined(__linux__)
+    void* p = MAP_FAILED;
+
+#if defined(MAP_HUGETLB)
+    if (m_hugePages)
+    {
+        p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+        {
+            m_hugePageBlocks++;
+            return p;
+        }
+    }
+#endif
+
+    p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+
+#if defined(MADV_HUGEPAGE)
+    if (m_hugePages && madvise(p, size, MADV_HUGEPAGE) == 0)
+    {
+        m_transparentBlocks++;
+        return p;
+    }
+#endif
+
+    m_regularBlocks++;
+    return p;
+#else
+    m_regularBlocks++;
+    return std::pmr::new_delete_resource()->allocate(size, alignment);
+#endif
+}
+
+/**
+ * @brief Unmaps a block.
+ ******/
+inline void HugePageMemoryResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+    const std::size_t size = mappedSize(std::max(bytes, (std::size_t)1));
+
+#if defined(__linux__)
+    (void)alignment;
+    munmap(p, size);
+#else
+    std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+#endif
+}
+
+/**
+ * @return True if both resources are the same object.
+ ******/
+inline bool HugePageMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+/**
+ * @brief Constructor: copy of a controller (matrices and state) into one block, time restarts from 0.
+ * @param controller Controller to copy.
+ * @param resource Memory resource of the block.
+ ******/
+template<typename T>
+ArenaStateSpaceController<T>::ArenaStateSpaceController(const StateSpaceController<T>& controller, std::pmr::memory_resource* resource):
+m_t_s(controller.getTimeStep()), m_i(0), m_t(0)
+{
+    allocate(resource, controller.getNx(), controller.getNe(), controller.getNu());
+
+    copyMatrix(controller.getA(), m_A);
+    copyMatrix(controller.getB(), m_B);
+    copyMatrix(controller.getC(), m_C);
+    copyMatrix(controller.getD(), m_D);
+
+    const std::vector<T> x = controller.getX_i();
+    std::copy(x.begin(), x.end(), m_x_i);
+}
+
+/**
+ * @brief Constructor from matrices (zero state).
+ * @param A Controller A matrix in state space representation.
+ * @param B Controller B matrix in state space representation.
+ * @param C Controller C matrix in state space representation.
+ * @param D Controller D matrix in state space representation.
+ * @param t_s Controller time step (seconds).
+ * @param resource Memory resource of the block.
+ ******/
+template<typename T>
+ArenaStateSpaceController<T>::ArenaStateSpaceController(const QSMatrix<T>& A, const QSMatrix<T>& B, const QSMatrix<T>& C, const QSMatrix<T>& D, const float t_s,
+                                                        std::pmr::memory_resource* resource):
+m_t_s(t_s), m_i(0), m_t(0)
+{
+    allocate(resource, A.get_rows(), B.get_cols(), C.get_rows());
+
+    copyMatrix(A, m_A);
+    copyMatrix(B, m_B);
+    copyMatrix(C, m_C);
+    copyMatrix(D, m_D);
+}
+
+/**
+ * @brief Copy constructor: new block from the resource of the other controller.
+ ******/
+template<typename T>
+ArenaStateSpaceController<T>::ArenaStateSpaceController(const ArenaStateSpaceController<T>& other):
+m_t_s(other.m_t_s), m_i(other.m_i), m_t(other.m_t)
+{
+    allocate(other.m_resource, other.m_nx, other.m_ne, other.m_nu);
+
+    // Same layout: the block is copied at once, then the state pointers follow the other controller
+    std::copy((const char*)other.m_block, (const char*)other.m_block + m_blockSize, (char*)m_block);
+    if (other.m_x_i > other.m_x_ip1)
+    {
+        std::swap(m_x_i, m_x_ip1);
+    }
+}
+
+/**
+ * @brief Move constructor: the block of the other controller is taken, the other one is left empty.
+ ******/
+template<typename T>
+ArenaStateSpaceController<T>::ArenaStateSpaceController(ArenaStateSpaceController<T>&& other) noexcept:
+m_resource(other.m_resource), m_block(other.m_block), m_blockSize(other.m_blockSize),
+m_A(other.m_A), m_B(other.m_B), m_C(other.m_C), m_D(other.m_D),
+m_x_i(other.m_x_i), m_x_ip1(other.m_x_ip1), m_r_i(other.m_r_i), m_y_i(other.m_y_i), m_e_i(other.m_e_i), m_u_i(other.m_u_i),
+m_t_s(other.m_t_s), m_i(other.m_i), m_t(other.m_t), m_nx(other.m_nx), m_ne(other.m_ne), m_nu(other.m_nu)
+{
+    other.m_block = 0;
+    other.m_blockSize = 0;
+    other.m_nx = other.m_ne = other.m_nu = 0;
+}
+
+/**
+ * @brief = operator: the block is reallocated from this controller's resource if the dimensions differ.
+ ******/
+template<typename T>
+ArenaStateSpaceController<T>& ArenaStateSpaceController<T>::operator=(const ArenaStateSpaceController<T>& other)
+{
+    if (&other == this)
+    {
+        return *this;
+    }
+
+    if (!m_block || m_nx != other.m_nx || m_ne != other.m_ne || m_nu != other.m_nu)
+    {
+        if (m_block)
+        {
+            m_resource->deallocate(m_block, m_blockSize, ARENA_ALIGNMENT);
+        }
+        allocate(m_resource, other.m_nx, other.m_ne, other.m_nu);
+    }
+    else if (m_x_i > m_x_ip1)
+    {
+        std::swap(m_x_i, m_x_ip1);
+    }
+
+    std::copy((const char*)other.m_block, (const char*)other.m_block + m_blockSize, (char*)m_block);
+    if (other.m_x_i > other.m_x_ip1)
+    {
+        std::swap(m_x_i, m_x_ip1);
+    }
+
+    m_t_s = other.m_t_s;
+    m_i = other.m_i;
+    m_t = other.m_t;
+
+    return *this;
+}
+
+/**
+ * @brief Destructor: the block is returned to its resource.
+ ******/
+template<typename T>
+ArenaStateSpaceController<T>::~ArenaStateSpaceController()
+{
+    if (m_block)
+    {
+        m_resource->deallocate(m_block, m_blockSize, ARENA_ALIGNMENT);
+    }
+}
+
+/**
+ * @return Size (bytes) of a section of n values, rounded to a cache line.
+ ******/
+template<typename T>
+std::size_t ArenaStateSpaceController<T>::sectionSize(const std::size_t n)
+{
+    return (n * sizeof(T) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+/**
+ * @return Bytes of the block of a controller of these dimensions.
+ ******/
+template<typename T>
+std::size_t ArenaStateSpaceController<T>::blockSize(const unsigned int nx, const unsigned int ne, const unsigned int nu)
+{
+    return sectionSize(nx * nx) + sectionSize(nx * ne) + sectionSize(nu * nx) + sectionSize(nu * ne)
+    + 2 * sectionSize(nx) + 3 * sectionSize(ne) + sectionSize(nu);
+}
+
+/**
+ * @brief Allocates the zeroed block and computes the section pointers.
+ ******/
+template<typename T>
+void ArenaStateSpaceController<T>::allocate(std::pmr::memory_resource* resource, const unsigned int nx, const unsigned int ne, const unsigned int nu)
+{
+    m_resource = resource;
+    m_nx = nx;
+    m_ne = ne;
+    m_nu = nu;
+    m_blockSize = blockSize(nx, ne, nu);
+    m_block = m_resource->allocate(m_blockSize, ARENA_ALIGNMENT);
+
+    char* p = (char*)m_block;
+    T** sections[10] = {&m_A, &m_B, &m_C, &m_D, &m_x_i, &m_x_ip1, &m_r_i, &m_y_i, &m_e_i, &m_u_i};
+    const std::size_t sizes[10] = {(std::size_t)nx * nx, (std::size_t)nx * ne, (std::size_t)nu * nx, (std::size_t)nu * ne, nx, nx, ne, ne, ne, nu};
+
+    for (int k=0;k<10;k++)
+    {
+        *sections[k] = (T*)p;
+        std::fill(*sections[k], *sections[k] + sizes[k], T(0));
+        p += sectionSize(sizes[k]);
+    }
+}
+
+/**
+ * @brief Copies a matrix (row-major) into its section.
+ ******/
+template<typename T>
+void ArenaStateSpaceController<T>::copyMatrix(const QSMatrix<T>& M, T* section)
+{
+    std::copy(M.data(), M.data() + M.get_rows() * M.get_cols(), section);
+}
+
+/**
+ * @brief Computes the controller output and the next state, without allocation.
+ * @param e_i Current error vector (ne values).
+ * @return Controller output vector (nu values, valid until the next step).
+ ******/
+template<typename T>
+const T* ArenaStateSpaceController<T>::step(const T* e_i)
+{
+    if (e_i != m_e_i)
+    {
+        std::copy(e_i, e_i + m_ne, m_e_i);
+    }
+
+    // u_i = C*x_i + D*e_i
+    for (unsigned int row=0;row<m_nu;row++)
+    {
+        const T* c = m_C + row*m_nx;
+        const T* d = m_D + row*m_ne;
+        T sum = 0;
+        for (unsigned int col=0;col<m_nx;col++) sum += c[col] * m_x_i[col];
+        for (unsigned int col=0;col<m_ne;col++) sum += d[col] * m_e_i[col];
+        m_u_i[row] = sum;
+    }
+
+    // x_{i+1} = A*x_i + B*e_i
+    for (unsigned int row=0;row<m_nx;row++)
+    {
+        const T* a = m_A + row*m_nx;
+        const T* b = m_B + row*m_ne;
+        T sum = 0;
+        for (unsigned int col=0;col<m_nx;col++) sum += a[col] * m_x_i[col];
+        for (unsigned int col=0;col<m_ne;col++) sum += b[col] * m_e_i[col];
+        m_x_ip1[row] = sum;
+    }
+    std::swap(m_x_i, m_x_ip1);
+
+    m_t = m_i * m_t_s;
+    m_i++;
+
+    return m_u_i;
+}
+
+/**
+ * @brief Computes the controller output from the reference and the plant output, without allocation.
+ * @param r_i Current reference vector (ne values).
+ * @param y_i Current plant output vector (ne values).
+ * @return Controller output vector (nu values, valid until the next step).
+ ******/
+template<typename T>
+const T* ArenaStateSpaceController<T>::step(const T* r_i, const T* y_i)
+{
+    for (unsigned int k=0;k<m_ne;k++)
+    {
+        m_r_i[k] = r_i[k];
+        m_y_i[k] = y_i[k];
+        m_e_i[k] = r_i[k] - y_i[k];
+    }
+
+    return step(m_e_i);
+}
+
+/**
+ * @brief Computes the current controller output with the error vector and increments time.
+ ******/
+template<typename T>
+std::vector<T> ArenaStateSpaceController<T>::currentOutput(const std::vector<T>& e_i)
+{
+    const T* u = step(e_i.data());
+
+    return std::vector<T>(u, u + m_nu);
+}
+
+/**
+ * @brief Computes the current controller output with the reference and plant output vectors and increments time.
+ ******/
+template<typename T>
+std::vector<T> ArenaStateSpaceController<T>::currentOutput(const std::vector<T>& r_i, const std::vector<T>& y_i)
+{
+    const T* u = step(r_i.data(), y_i.data());
+
+    return std::vector<T>(u, u + m_nu);
+}
+
+/**
+ * @brief Prefetches the block, one cache line at a time.
+ ******/
+template<typename T>
+void ArenaStateSpaceController<T>::prefetch() const
+{
+    for (std::size_t offset=0;offset<m_blockSize;offset+=ARENA_ALIGNMENT)
+    {
+        __builtin_prefetch((const char*)m_block + offset);
+    }
+}
+
+/**
+ * @brief Resets time and state vectors.
+ ******/
+template<typename T>
+void ArenaStateSpaceController<T>::reset()
+{
+    std::fill(m_x_i, m_x_i + m_nx, T(0));
+    std::fill(m_x_ip1, m_x_ip1 + m_nx, T(0));
+
+    m_i = 0;
+    m_t = 0;
+}
+
+/**
+ * @return Current state vector.
+ ******/
+template<typename T>
+std::vector<T> ArenaStateSpaceController<T>::getX_i() const
+{
+    return std::vector<T>(m_x_i, m_x_i + m_nx);
+}
+
+/**
+ * @return Current state vector (nx values in the block).
+ ******/
+template<typename T>
+const T* ArenaStateSpaceController<T>::getState() const
+{
+    return m_x_i;
+}
+
+/**
+ * @return Last controller output (nu values in the block).
+ ******/
+template<typename T>
+const T* ArenaStateSpaceController<T>::getOutput() const
+{
+    return m_u_i;
+}
+
+/**
+ * @return Last reference vector given to step(r, y) (ne values in the block).
+ ******/
+template<typename T>
+const T* ArenaStateSpaceController<T>::getReference() const
+{
+    return m_r_i;
+}
+
+/**
+ * @return Last plant output vector given to step(r, y) (ne values in the block).
+ ******/
+template<typename T>
+const T* ArenaStateSpaceController<T>::getMeasurement() const
+{
+    return m_y_i;
+}
+
+/**
+ * @return Last error vector (ne values in the block).
+ ******/
+template<typename T>
+const T* ArenaStateSpaceController<T>::getError() const
+{
+    return m_e_i;
+}
+
+/**
+ * @return Number of steps since construction or reset.
+ ******/
+template<typename T>
+unsigned int ArenaStateSpaceController<T>::getStepCount() const
+{
+    return m_i;
+}
+
+template<typename T>
+float ArenaStateSpaceController<T>::getTimeStep() const
+{
+    return m_t_s;
+}
+
+template<typename T>
+float ArenaStateSpaceController<T>::getTime() const
+{
+    return m_t;
+}
+
+template<typename T>
+unsigned int ArenaStateSpaceController<T>::getNx() const
+{
+    return m_nx;
+}
+
+template<typename T>
+unsigned int ArenaStateSpaceController<T>::getNe() const
+{
+    return m_ne;
+}
+
+template<typename T>
+unsigned int ArenaStateSpaceController<T>::getNu() const
+{
+    return m_nu;
+}
+
+/**
+ * @return Start of the block.
+ ******/
+template<typename T>
+const void* ArenaStateSpaceController<T>::getBlock() const
+{
+    return m_block;
+}
+
+/**
+ * @return Size of the block (bytes).
+ ******/
+template<typename T>
+std::size_t ArenaStateSpaceController<T>::getBlockSize() const
+{
+    return m_blockSize;
+}
+
+/**
+ * @return Memory resource of the block.
+ ******/
+template<typename T>
+std::pmr::memory_resource* ArenaStateSpaceController<T>::getResource() const
+{
+    return m_resource;
+}
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file arenaController.h
+ * @brief ArenaStateSpaceController class and huge page memory resource (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef ARENACONTROLLER_H
+#define ARENACONTROLLER_H
+
+#include <iostream>
+#include <vector>
+#include <cstddef>
+#include <memory_resource>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+
+/**
+ * @brief Alignment (bytes) of the block and of each of its sections: one cache line.
+ ******/
+#define ARENA_ALIGNMENT 64
+
+/**
+ * @class HugePageMemoryResource
+ * @brief Memory resource mapping its blocks with mmap, backed by huge pages when possible.
+ * @details Each allocation is rounded to the huge page size (2 MiB). Explicit huge pages (MAP_HUGETLB) are
+ * tried first, then transparent huge pages are requested with madvise(MADV_HUGEPAGE). Without huge page
+ * support (or on systems other than Linux) the blocks are regular pages.
+ *
+ * Meant as upstream of a std::pmr::monotonic_buffer_resource or std::pmr::unsynchronized_pool_resource
+ * allocating a whole controller bank in a few large blocks.
+ ******/
+class HugePageMemoryResource : public std::pmr::memory_resource
+{
+    public:
+
+    // hugePages = false: regular pages only
+    HugePageMemoryResource(const bool hugePages = true);
+
+    // Number of blocks mapped with explicit huge pages / with transparent huge pages requested / with regular pages
+    unsigned int getHugePageBlocks() const;
+    unsigned int getTransparentHugePageBlocks() const;
+    unsigned int getRegularBlocks() const;
+
+    protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    // Mapping size of an allocation
+    std::size_t mappedSize(const std::size_t bytes) const;
+
+    bool m_hugePages;
+    unsigned int m_hugePageBlocks, m_transparentBlocks, m_regularBlocks;
+};
+
+/**
+ * @class ArenaStateSpaceController
+ * @brief State-space controller whose matrices, state vectors and scratch are one contiguous block.
+ * @details The block is allocated from a std::pmr::memory_resource (default resource if none is given):
+ *
+ *      | A | B | C | D | x_i | x_{i+1} | r_i | y_i | e_i | u_i |
+ *
+ * Each section is row-major and starts on a cache line (ARENA_ALIGNMENT bytes). A controller is a single
+ * allocation: a bank of controllers taken from one monotonic or pool resource (possibly backed by
+ * HugePageMemoryResource) is contiguous in memory, and step() does not allocate.
+ *
+ * Same equations and time handling as StateSpaceController. The matrices are copied into the block.
+ ******/
+template <typename T>
+class ArenaStateSpaceController
+{
+    public:
+
+    // Copy of a controller (matrices and state, time restarts from 0) into a block of the resource
+    ArenaStateSpaceController(const StateSpaceController<T>& controller, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Constructor from matrices
+    ArenaStateSpaceController(const QSMatrix<T>& A, const QSMatrix<T>& B, const QSMatrix<T>& C, const QSMatrix<T>& D, const float t_s,
+                              std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Copy into a new block of the same resource
+    ArenaStateSpaceController(const ArenaStateSpaceController<T>& other);
+    ArenaStateSpaceController<T>& operator=(const ArenaStateSpaceController<T>& other);
+
+    // The block of the other controller is taken (no allocation)
+    ArenaStateSpaceController(ArenaStateSpaceController<T>&& other) noexcept;
+
+    virtual ~ArenaStateSpaceController();
+
+    // Bytes of the block of a controller of these dimensions
+    static std::size_t blockSize(const unsigned int nx, const unsigned int ne, const unsigned int nu);
+
+    // One step without allocation: writes u_i (nu values, valid until the next step) and returns it
+    const T* step(const T* e_i);
+    const T* step(const T* r_i, const T* y_i);
+
+    // Same interface as StateSpaceController
+    std::vector<T> currentOutput(const std::vector<T>& e_i);
+    std::vector<T> currentOutput(const std::vector<T>& r_i, const std::vector<T>& y_i);
+
+    // Prefetch the whole block into the cache
+    void prefetch() const;
+
+    // Reset time and states (to zero)
+    void reset();
+
+    std::vector<T> getX_i() const;
+    const T* getState() const;
+    const T* getOutput() const;
+    const T* getReference() const;
+    const T* getMeasurement() const;
+    const T* getError() const;
+
+    // Number of steps since construction or reset
+    unsigned int getStepCount() const;
+
+    float getTimeStep() const;
+    float getTime() const;
+    unsigned int getNx() const;
+    unsigned int getNe() const;
+    unsigned int getNu() const;
+
+    // Block and its resource
+    const void* getBlock() const;
+    std::size_t getBlockSize() const;
+    std::pmr::memory_resource* getResource() const;
+
+    protected:
+    // Allocate the block and compute the section pointers
+    void allocate(std::pmr::memory_resource* resource, const unsigned int nx, const unsigned int ne, const unsigned int nu);
+
+    // Copy a matrix into its section
+    static void copyMatrix(const QSMatrix<T>& M, T* section);
+
+    // Size (bytes) of a section of n values, rounded to a cache line
+    static std::size_t sectionSize(const std::size_t n);
+
+    std::pmr::memory_resource* m_resource;
+    void* m_block;
+    std::size_t m_blockSize;
+
+    /**
+     * @brief Sections of the block.
+     ******/
+    T *m_A, *m_B, *m_C, *m_D;
+    T *m_x_i, *m_x_ip1, *m_r_i, *m_y_i, *m_e_i, *m_u_i;
+
+    float m_t_s;
+    unsigned int m_i;
+    float m_t;
+    unsigned int m_nx, m_ne, m_nu;
+};
+
+#include "arenaController.cpp"
+
+#endif  // ARENACONTROLLER_H
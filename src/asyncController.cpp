@@ -0,0 +1,656 @@
+/**
+ * @file asyncController.cpp
+ * @brief Coroutine step API: executor, clocks, measurement channels and awaitable controllers (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef ASYNCCONTROLLER_CPP
+#define ASYNCCONTROLLER_CPP
+
+#include "asyncController.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <exception>
+
+/**
+ * @brief Destructor.
+ ******/
+inline ControllerClock::~ControllerClock()
+{
+}
+
+/**
+ * @brief Constructor: time 0 is now.
+ ******/
+inline SteadyControllerClock::SteadyControllerClock():
+m_origin(std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count())
+{
+}
+
+/**
+ * @return Seconds since construction.
+ ******/
+inline double SteadyControllerClock::now() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() - m_origin;
+}
+
+/**
+ * @brief Sleeps until t.
+ ******/
+inline void SteadyControllerClock::waitUntil(const double t)
+{
+    const double dt = t - now();
+    if (dt > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(dt));
+    }
+}
+
+/**
+ * @brief Constructor.
+ * @param t Initial time (seconds).
+ ******/
+inline FakeControllerClock::FakeControllerClock(const double t):
+m_time(t)
+{
+}
+
+/**
+ * @return Current fake time.
+ ******/
+inline double FakeControllerClock::now() const
+{
+    return m_time;
+}
+
+/**
+ * @brief Jumps to t (never backwards).
+ ******/
+inline void FakeControllerClock::waitUntil(const double t)
+{
+    m_time = std::max(m_time, t);
+}
+
+/**
+ * @brief Moves the time forward by dt.
+ ******/
+inline void FakeControllerClock::advance(const double dt)
+{
+    m_time += dt;
+}
+
+/**
+ * @brief Sets the time.
+ ******/
+inline void FakeControllerClock::set(const double t)
+{
+    m_time = t;
+}
+
+/**
+ * @return Task owning the coroutine.
+ ******/
+inline ControllerTask ControllerTask::promise_type::get_return_object()
+{
+    return ControllerTask(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+/**
+ * @brief The coroutine waits for its executor.
+ ******/
+inline std::suspend_always ControllerTask::promise_type::initial_suspend() noexcept
+{
+    return std::suspend_always();
+}
+
+/**
+ * @brief The finished coroutine is kept until its executor destroys it.
+ ******/
+inline std::suspend_always ControllerTask::promise_type::final_suspend() noexcept
+{
+    return std::suspend_always();
+}
+
+inline void ControllerTask::promise_type::return_void()
+{
+}
+
+inline void ControllerTask::promise_type::unhandled_exception()
+{
+    std::cout << "\033[1;31mERROR: Exception in a controller task\033[0m" << std::endl;
+    std::terminate();
+}
+
+/**
+ * @brief Constructor from the coroutine.
+ ******/
+inline ControllerTask::ControllerTask(std::coroutine_handle<promise_type> handle):
+m_handle(handle)
+{
+}
+
+/**
+ * @brief Move constructor.
+ ******/
+inline ControllerTask::ControllerTask(ControllerTask&& other) noexcept:
+m_handle(other.m_handle)
+{
+    other.m_handle = nullptr;
+}
+
+/**
+ * @brief Destructor: destroys the coroutine if it was not spawned.
+ ******/
+inline ControllerTask::~ControllerTask()
+{
+    if (m_handle)
+    {
+        m_handle.destroy();
+    }
+}
+
+/**
+ * @return Coroutine, no longer owned by this object.
+ ******/
+inline std::coroutine_handle<ControllerTask::promise_type> ControllerTask::release()
+{
+    std::coroutine_handle<promise_type> handle = m_handle;
+    m_handle = nullptr;
+
+    return handle;
+}
+
+/**
+ * @return True if the sleep date is already reached.
+ ******/
+inline bool ControllerExecutor::SleepAwaiter::await_ready() const noexcept
+{
+    return date <= executor->now();
+}
+
+/**
+ * @brief Adds the coroutine to the timers.
+ ******/
+inline void ControllerExecutor::SleepAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    Timer timer;
+    timer.date = date;
+    timer.order = executor->m_timerOrder++;
+    timer.handle = handle;
+    executor->m_timers.push(timer);
+}
+
+inline void ControllerExecutor::SleepAwaiter::await_resume() const noexcept
+{
+}
+
+/**
+ * @return Earliest timer first, then the first one registered.
+ ******/
+inline bool ControllerExecutor::Timer::operator>(const Timer& other) const
+{
+    return (date != other.date) ? date > other.date : order > other.order;
+}
+
+/**
+ * @brief Constructor.
+ * @param clock Clock of the executor (null: steady clock).
+ ******/
+inline ControllerExecutor::ControllerExecutor(ControllerClock* clock):
+m_clock(clock ? clock : &m_steadyClock), m_timerOrder(0)
+{
+}
+
+/**
+ * @brief Destructor: destroys the tasks not finished (waiting on a channel or a timer, or never started).
+ ******/
+inline ControllerExecutor::~ControllerExecutor()
+{
+    for (unsigned int k=0;k<m_tasks.size();k++)
+    {
+        m_tasks[k].destroy();
+    }
+}
+
+/**
+ * @brief Takes the ownership of a task and makes it ready.
+ ******/
+inline void ControllerExecutor::spawn(ControllerTask task)
+{
+    std::coroutine_handle<ControllerTask::promise_type> handle = task.release();
+    if (handle)
+    {
+        m_tasks.push_back(handle);
+        m_ready.push_back(handle);
+    }
+}
+
+/**
+ * @brief Makes a suspended coroutine ready.
+ ******/
+inline void ControllerExecutor::schedule(std::coroutine_handle<> handle)
+{
+    m_ready.push_back(handle);
+}
+
+/**
+ * @brief Resumes a coroutine; a finished task is destroyed.
+ ******/
+inline void ControllerExecutor::resume(std::coroutine_handle<> handle)
+{
+    handle.resume();
+
+    if (handle.done())
+    {
+        for (unsigned int k=0;k<m_tasks.size();k++)
+        {
+            if (m_tasks[k].address() == handle.address())
+            {
+                m_tasks[k] = m_tasks.back();
+                m_tasks.pop_back();
+                handle.destroy();
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs the timers due and the ready coroutines (including those made ready meanwhile) without waiting.
+ * @return Number of resumptions.
+ ******/
+inline unsigned int ControllerExecutor::poll()
+{
+    unsigned int resumed = 0;
+
+    while (true)
+    {
+        const double t = now();
+        while (!m_timers.empty() && m_timers.top().date <= t)
+        {
+            m_ready.push_back(m_timers.top().handle);
+            m_timers.pop();
+        }
+
+        if (m_ready.empty())
+        {
+            return resumed;
+        }
+
+        // Coroutines made ready while running these ones wait for the next pass
+        m_running.swap(m_ready);
+        for (unsigned int k=0;k<m_running.size();k++)
+        {
+            resume(m_running[k]);
+            resumed++;
+        }
+        m_running.clear();
+    }
+}
+
+/**
+ * @brief Runs until nothing is ready nor sleeping, waiting on the clock for the next timer.
+ * @details Coroutines waiting on channels that are not published by a running coroutine stay suspended.
+ * @return Number of resumptions.
+ ******/
+inline unsigned int ControllerExecutor::run()
+{
+    unsigned int resumed = poll();
+
+    while (!m_timers.empty())
+    {
+        m_clock->waitUntil(m_timers.top().date);
+        resumed += poll();
+    }
+
+    return resumed;
+}
+
+/**
+ * @return Awaiter resuming the coroutine when the clock reaches t.
+ ******/
+inline ControllerExecutor::SleepAwaiter ControllerExecutor::sleepUntil(const double t)
+{
+    SleepAwaiter awaiter;
+    awaiter.executor = this;
+    awaiter.date = t;
+
+    return awaiter;
+}
+
+/**
+ * @return Awaiter resuming the coroutine dt seconds from now.
+ ******/
+inline ControllerExecutor::SleepAwaiter ControllerExecutor::sleepFor(const double dt)
+{
+    return sleepUntil(now() + dt);
+}
+
+/**
+ * @return Current time of the executor clock (seconds).
+ ******/
+inline double ControllerExecutor::now() const
+{
+    return m_clock->now();
+}
+
+/**
+ * @return Clock of the executor.
+ ******/
+inline ControllerClock& ControllerExecutor::getClock() const
+{
+    return *m_clock;
+}
+
+/**
+ * @return Number of tasks spawned and not finished.
+ ******/
+inline unsigned int ControllerExecutor::getTaskCount() const
+{
+    return m_tasks.size();
+}
+
+/**
+ * @brief Awaiter of a sample newer than "seen".
+ ******/
+template<typename T>
+MeasurementChannel<T>::Awaiter::Awaiter(MeasurementChannel<T>* channel, const std::uint64_t seen):
+channel(channel), seen(seen), next(0), linked(false)
+{
+}
+
+/**
+ * @brief Copy constructor: the copy is not linked.
+ ******/
+template<typename T>
+MeasurementChannel<T>::Awaiter::Awaiter(const Awaiter& other):
+channel(other.channel), seen(other.seen), next(0), linked(false)
+{
+}
+
+/**
+ * @brief Destructor: a coroutine destroyed while waiting leaves the channel.
+ ******/
+template<typename T>
+MeasurementChannel<T>::Awaiter::~Awaiter()
+{
+    if (linked)
+    {
+        channel->unlink(this);
+    }
+}
+
+/**
+ * @return True if a newer sample is already available.
+ ******/
+template<typename T>
+bool MeasurementChannel<T>::Awaiter::await_ready() const noexcept
+{
+    return channel->m_sequence > seen;
+}
+
+/**
+ * @brief Links the awaiter (in the coroutine frame) into the channel.
+ ******/
+template<typename T>
+void MeasurementChannel<T>::Awaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    this->handle = handle;
+    channel->link(this);
+}
+
+/**
+ * @return Latest sample.
+ ******/
+template<typename T>
+const std::vector<T>& MeasurementChannel<T>::Awaiter::await_resume() const noexcept
+{
+    return channel->m_values;
+}
+
+/**
+ * @brief Constructor.
+ * @param executor Executor resuming the waiting coroutines.
+ * @param size Number of values of a sample.
+ ******/
+template<typename T>
+MeasurementChannel<T>::MeasurementChannel(ControllerExecutor& executor, const unsigned int size):
+m_executor(executor), m_values(size, 0), m_sequence(0), m_time(0), m_waiters(0)
+{
+}
+
+/**
+ * @brief Destructor: waiting coroutines stay suspended (they are destroyed with their executor).
+ ******/
+template<typename T>
+MeasurementChannel<T>::~MeasurementChannel()
+{
+    while (m_waiters)
+    {
+        Awaiter* awaiter = m_waiters;
+        m_waiters = awaiter->next;
+        awaiter->linked = false;
+    }
+}
+
+/**
+ * @brief Stores a sample and schedules the coroutines waiting for it.
+ ******/
+template<typename T>
+void MeasurementChannel<T>::publish(const T* values)
+{
+    std::copy(values, values + m_values.size(), m_values.begin());
+    m_sequence++;
+    m_time = m_executor.now();
+
+    Awaiter* awaiter = m_waiters;
+    m_waiters = 0;
+    while (awaiter)
+    {
+        Awaiter* next = awaiter->next;
+        awaiter->linked = false;
+        awaiter->next = 0;
+        m_executor.schedule(awaiter->handle);
+        awaiter = next;
+    }
+}
+
+/**
+ * @brief Stores a sample (its size must be getSize()).
+ ******/
+template<typename T>
+void MeasurementChannel<T>::publish(const std::vector<T>& values)
+{
+    if (values.size() != m_values.size())
+    {
+        std::cout << "\033[1;31mERROR: Sample of " << values.size() << " values published on a channel of " << m_values.size() << "\033[0m" << std::endl;
+        return;
+    }
+
+    publish(values.data());
+}
+
+/**
+ * @return Awaiter of a sample newer than "seen" (0: any sample).
+ ******/
+template<typename T>
+typename MeasurementChannel<T>::Awaiter MeasurementChannel<T>::next(const std::uint64_t seen)
+{
+    return Awaiter(this, seen);
+}
+
+template<typename T>
+void MeasurementChannel<T>::link(Awaiter* awaiter)
+{
+    awaiter->next = m_waiters;
+    awaiter->linked = true;
+    m_waiters = awaiter;
+}
+
+template<typename T>
+void MeasurementChannel<T>::unlink(Awaiter* awaiter)
+{
+    for (Awaiter** p=&m_waiters;*p;p=&(*p)->next)
+    {
+        if (*p == awaiter)
+        {
+            *p = awaiter->next;
+            break;
+        }
+    }
+    awaiter->linked = false;
+}
+
+/**
+ * @return Latest sample.
+ ******/
+template<typename T>
+const std::vector<T>& MeasurementChannel<T>::getValues() const
+{
+    return m_values;
+}
+
+/**
+ * @return Number of samples published.
+ ******/
+template<typename T>
+std::uint64_t MeasurementChannel<T>::getSequence() const
+{
+    return m_sequence;
+}
+
+/**
+ * @return Executor time of the latest sample.
+ ******/
+template<typename T>
+double MeasurementChannel<T>::getTime() const
+{
+    return m_time;
+}
+
+/**
+ * @return Number of values of a sample.
+ ******/
+template<typename T>
+unsigned int MeasurementChannel<T>::getSize() const
+{
+    return m_values.size();
+}
+
+/**
+ * @return True if the channel has a sample the controller has not used.
+ ******/
+template<typename T>
+bool AsyncController<T>::StepAwaiter::await_ready() const noexcept
+{
+    return sample.await_ready();
+}
+
+template<typename T>
+void AsyncController<T>::StepAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    sample.await_suspend(handle);
+}
+
+/**
+ * @return Controller output computed with the latest sample (output buffer of the AsyncController).
+ ******/
+template<typename T>
+const std::vector<T>& AsyncController<T>::StepAwaiter::await_resume()
+{
+    const std::uint64_t sequence = sample.channel->getSequence();
+    if (controller->m_seen > 0)
+    {
+        controller->m_missed += sequence - controller->m_seen - 1;
+    }
+    controller->m_seen = sequence;
+    controller->m_steps++;
+
+    const std::vector<T>& values = sample.await_resume();
+
+    controller->m_output = reference ? controller->m_controller.currentOutput(*reference, values) : controller->m_controller.currentOutput(values);
+
+    return controller->m_output;
+}
+
+/**
+ * @brief Constructor.
+ * @param controller Controller stepped (not copied).
+ ******/
+template<typename T>
+AsyncController<T>::AsyncController(StateSpaceController<T>& controller):
+m_controller(controller), m_channel(0), m_seen(0), m_steps(0), m_missed(0)
+{
+}
+
+/**
+ * @return Awaiter of a step with the next error sample.
+ ******/
+template<typename T>
+typename AsyncController<T>::StepAwaiter AsyncController<T>::step(MeasurementChannel<T>& e)
+{
+    if (m_channel != &e)
+    {
+        m_channel = &e;
+        m_seen = 0;
+    }
+
+    return StepAwaiter{this, e.next(m_seen), 0};
+}
+
+/**
+ * @return Awaiter of a step with the reference and the next plant output sample.
+ ******/
+template<typename T>
+typename AsyncController<T>::StepAwaiter AsyncController<T>::step(const std::vector<T>& r, MeasurementChannel<T>& y)
+{
+    if (m_channel != &y)
+    {
+        m_channel = &y;
+        m_seen = 0;
+    }
+
+    return StepAwaiter{this, y.next(m_seen), &r};
+}
+
+/**
+ * @return Output of the last step (empty before the first one).
+ ******/
+template<typename T>
+const std::vector<T>& AsyncController<T>::getOutput() const
+{
+    return m_output;
+}
+
+/**
+ * @return Controller stepped.
+ ******/
+template<typename T>
+StateSpaceController<T>& AsyncController<T>::getController() const
+{
+    return m_controller;
+}
+
+/**
+ * @return Number of steps.
+ ******/
+template<typename T>
+unsigned long long AsyncController<T>::getStepCount() const
+{
+    return m_steps;
+}
+
+/**
+ * @return Samples published and never used by a step.
+ ******/
+template<typename T>
+unsigned long long AsyncController<T>::getMissedSamples() const
+{
+    return m_missed;
+}
+
+#endif  // ASYNCCONTROLLER_CPP
@@ -0,0 +1,329 @@
+/**
+ * @file asyncController.h
+ * @brief Coroutine step API: executor, clocks, measurement channels and awaitable controllers (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef ASYNCCONTROLLER_H
+#define ASYNCCONTROLLER_H
+
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <coroutine>
+#include <cstdint>
+
+#include "stateSpaceController.h"
+
+class ControllerExecutor;
+
+/**
+ * @class ControllerClock
+ * @brief Time source of a ControllerExecutor (seconds).
+ ******/
+class ControllerClock
+{
+    public:
+    virtual ~ControllerClock();
+
+    virtual double now() const = 0;
+
+    // Block until the clock reaches t (the executor has nothing to run before)
+    virtual void waitUntil(const double t) = 0;
+};
+
+/**
+ * @class SteadyControllerClock
+ * @brief Monotonic clock (std::chrono::steady_clock), time 0 at construction.
+ ******/
+class SteadyControllerClock : public ControllerClock
+{
+    public:
+    SteadyControllerClock();
+
+    double now() const override;
+    void waitUntil(const double t) override;
+
+    protected:
+    double m_origin;
+};
+
+/**
+ * @class FakeControllerClock
+ * @brief Clock moved by hand (tests, simulations): waiting jumps to the date, advance() moves it forward.
+ ******/
+class FakeControllerClock : public ControllerClock
+{
+    public:
+    FakeControllerClock(const double t = 0);
+
+    double now() const override;
+    void waitUntil(const double t) override;
+
+    void advance(const double dt);
+    void set(const double t);
+
+    protected:
+    double m_time;
+};
+
+/**
+ * @class ControllerTask
+ * @brief Coroutine started by a ControllerExecutor (fire and forget: the executor owns it once spawned).
+ * @details A function returning ControllerTask and using co_await is a control loop:
+ *
+ *      ControllerTask loop(AsyncController<double>& K, MeasurementChannel<double>& y, Actuator& a)
+ *      {
+ *          while (true)
+ *          {
+ *              a.write(co_await K.step(y));
+ *          }
+ *      }
+ *
+ *      executor.spawn(loop(K, y, a));
+ *
+ * The coroutine does not start before the executor runs it. Exceptions terminate the program.
+ ******/
+class ControllerTask
+{
+    public:
+
+    /**
+     * @brief Coroutine promise.
+     ******/
+    struct promise_type
+    {
+        ControllerTask get_return_object();
+        std::suspend_always initial_suspend() noexcept;
+        std::suspend_always final_suspend() noexcept;
+        void return_void();
+        void unhandled_exception();
+    };
+
+    ControllerTask(ControllerTask&& other) noexcept;
+    ControllerTask(const ControllerTask&) = delete;
+    ControllerTask& operator=(const ControllerTask&) = delete;
+
+    // A task never spawned is destroyed with this object
+    ~ControllerTask();
+
+    // Gives up the ownership of the coroutine
+    std::coroutine_handle<promise_type> release();
+
+    protected:
+    ControllerTask(std::coroutine_handle<promise_type> handle);
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/**
+ * @class ControllerExecutor
+ * @brief Single-threaded executor of ControllerTask coroutines.
+ * @details Coroutines are resumed in the order they become ready: when spawned, when a measurement channel
+ * they wait on is published, or when their sleep date is reached on the executor clock. Nothing is
+ * allocated per step: a suspended coroutine is linked by its awaiter (channel waiters) or kept in the
+ * ready queue and timer heap, whose storage is reused.
+ *
+ * From an event loop, publish the channels in the I/O callbacks and call poll(); alone, run() sleeps
+ * (or jumps, with a FakeControllerClock) from timer to timer until no coroutine can make progress.
+ ******/
+class ControllerExecutor
+{
+    public:
+
+    /**
+     * @brief Awaiter of sleepUntil() / sleepFor().
+     ******/
+    struct SleepAwaiter
+    {
+        ControllerExecutor* executor;
+        double date;
+
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept;
+    };
+
+    // Executor on a clock (steady clock of the executor if none), the clock must outlive the executor
+    ControllerExecutor(ControllerClock* clock = 0);
+
+    ControllerExecutor(const ControllerExecutor&) = delete;
+    ControllerExecutor& operator=(const ControllerExecutor&) = delete;
+
+    // Destroys the coroutines not finished
+    virtual ~ControllerExecutor();
+
+    // Take a task: it starts on the next poll()/run()
+    void spawn(ControllerTask task);
+
+    // Resume a coroutine on the next poll()/run()
+    void schedule(std::coroutine_handle<> handle);
+
+    // Run the ready coroutines and the timers due, without waiting; returns the number of resumptions
+    unsigned int poll();
+
+    // poll() and wait for the next timer until nothing is ready nor sleeping; returns the number of resumptions
+    unsigned int run();
+
+    // co_await executor.sleepUntil(t) / sleepFor(dt)
+    SleepAwaiter sleepUntil(const double t);
+    SleepAwaiter sleepFor(const double dt);
+
+    double now() const;
+    ControllerClock& getClock() const;
+
+    // Tasks spawned and not finished
+    unsigned int getTaskCount() const;
+
+    protected:
+
+    /**
+     * @brief Sleeping coroutine.
+     ******/
+    struct Timer
+    {
+        double date;
+        std::uint64_t order;
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const;
+    };
+
+    // Resume a coroutine, destroys it if it is a finished task
+    void resume(std::coroutine_handle<> handle);
+
+    SteadyControllerClock m_steadyClock;
+    ControllerClock* m_clock;
+
+    std::vector<std::coroutine_handle<> > m_ready, m_running;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > m_timers;
+    std::uint64_t m_timerOrder;
+
+    std::vector<std::coroutine_handle<ControllerTask::promise_type> > m_tasks;
+};
+
+/**
+ * @class MeasurementChannel
+ * @brief Latest sample of a measurement vector, awaited by coroutines.
+ * @details publish() stores the sample, increments the sequence and schedules every coroutine waiting for
+ * a sample newer than the one it has seen. Samples published faster than they are consumed are not queued:
+ * a control loop always uses the latest measurement.
+ ******/
+template <typename T>
+class MeasurementChannel
+{
+    public:
+
+    /**
+     * @brief Awaiter of a sample newer than a sequence (linked into the channel while suspended).
+     ******/
+    struct Awaiter
+    {
+        Awaiter(MeasurementChannel<T>* channel, const std::uint64_t seen);
+        Awaiter(const Awaiter& other);
+        ~Awaiter();
+
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> handle);
+        const std::vector<T>& await_resume() const noexcept;
+
+        MeasurementChannel<T>* channel;
+        std::uint64_t seen;
+        std::coroutine_handle<> handle;
+        Awaiter* next;
+        bool linked;
+    };
+
+    MeasurementChannel(ControllerExecutor& executor, const unsigned int size);
+
+    MeasurementChannel(const MeasurementChannel<T>&) = delete;
+    MeasurementChannel<T>& operator=(const MeasurementChannel<T>&) = delete;
+
+    virtual ~MeasurementChannel();
+
+    // New sample (size values), wakes the waiting coroutines
+    void publish(const T* values);
+    void publish(const std::vector<T>& values);
+
+    // co_await channel.next(seen): latest sample once the sequence is above "seen"
+    Awaiter next(const std::uint64_t seen);
+
+    const std::vector<T>& getValues() const;
+    std::uint64_t getSequence() const;
+    double getTime() const;
+    unsigned int getSize() const;
+
+    protected:
+    void link(Awaiter* awaiter);
+    void unlink(Awaiter* awaiter);
+
+    ControllerExecutor& m_executor;
+    std::vector<T> m_values;
+    std::uint64_t m_sequence;
+    double m_time;
+    Awaiter* m_waiters;
+};
+
+/**
+ * @class AsyncController
+ * @brief Awaitable steps of a StateSpaceController fed by measurement channels.
+ * @details co_await controller.step(channel) suspends until the channel has a sample the controller has not
+ * used yet, then computes u_i with it (e_i = sample, or e_i = r_i - sample with a reference). Several loops
+ * can share an executor: one thread multiplexes all of them.
+ *
+ * The controller is not copied: it must outlive the AsyncController. co_await step() gives a reference to
+ * the output buffer of the AsyncController, valid until its next step (u = co_await K.step(y) copies it
+ * into the existing storage of u).
+ ******/
+template <typename T>
+class AsyncController
+{
+    public:
+
+    /**
+     * @brief Awaiter of a step.
+     ******/
+    struct StepAwaiter
+    {
+        AsyncController<T>* controller;
+        typename MeasurementChannel<T>::Awaiter sample;
+        const std::vector<T>* reference;
+
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> handle);
+        const std::vector<T>& await_resume();
+    };
+
+    AsyncController(StateSpaceController<T>& controller);
+
+    // u_i = step with the next error sample
+    StepAwaiter step(MeasurementChannel<T>& e);
+
+    // u_i = step with the reference and the next plant output sample (the reference is read at resumption)
+    StepAwaiter step(const std::vector<T>& r, MeasurementChannel<T>& y);
+
+    StateSpaceController<T>& getController() const;
+
+    // Output of the last step (the buffer returned by co_await step())
+    const std::vector<T>& getOutput() const;
+
+    // Number of steps, and samples published but never used (the loop was too slow)
+    unsigned long long getStepCount() const;
+    unsigned long long getMissedSamples() const;
+
+    protected:
+    StateSpaceController<T>& m_controller;
+    const MeasurementChannel<T>* m_channel;
+    std::uint64_t m_seen;
+    unsigned long long m_steps, m_missed;
+
+    /**
+     * @brief Output of the last step, reused by every step.
+     ******/
+    std::vector<T> m_output;
+};
+
+#include "asyncController.cpp"
+
+#endif  // ASYNCCONTROLLER_H
@@ -0,0 +1,98 @@
+/**
+ * @file checkpointFormat.cpp
+ * @brief Binary checkpoint format of controller state and coefficients (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef CHECKPOINTFORMAT_CPP
+#define CHECKPOINTFORMAT_CPP
+
+#include "checkpointFormat.h"
+
+#include <iostream>
+#include <cstring>
+
+/**
+ * @brief Checksum of a buffer, 8 bytes per multiply (FNV-1a like, with a shift to mix the high bits down).
+ * @param data Buffer.
+ * @param bytes Buffer size.
+ * @param hash Checksum of the previous buffers (default: offset basis).
+ ******/
+inline std::uint64_t checkpointChecksum(const void* data, const std::size_t bytes, std::uint64_t hash)
+{
+    const unsigned char* bytePointer = (const unsigned char*)data;
+    std::size_t k = 0;
+
+    for (;k+8<=bytes;k+=8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytePointer + k, 8);
+        hash = (hash ^ word) * 1099511628211ULL;
+        hash ^= hash >> 29;
+    }
+    for (;k<bytes;k++)
+    {
+        hash = (hash ^ bytePointer[k]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @return Bytes after the header: six vectors, plus the four matrices with coefficients.
+ ******/
+inline std::size_t checkpointPayloadSize(const unsigned int nx, const unsigned int ne, const unsigned int nu, const std::size_t scalarSize, const bool coefficients)
+{
+    std::size_t scalars = 2 * (std::size_t)nx + 3 * (std::size_t)ne + nu;
+    if (coefficients)
+    {
+        scalars += ((std::size_t)nx + nu) * ((std::size_t)nx + ne);
+    }
+
+    return scalars * scalarSize;
+}
+
+/**
+ * @brief Checks a checkpoint before it is restored.
+ * @param buffer Checkpoint.
+ * @param bytes Bytes available in the buffer.
+ * @param scalarSize sizeof(T) of the controller restored.
+ * @return Header of the checkpoint, null (and an error message) if it is invalid.
+ ******/
+inline const CheckpointHeader* checkpointValidate(const void* buffer, const std::size_t bytes, const std::size_t scalarSize)
+{
+    const CheckpointHeader* header = (const CheckpointHeader*)buffer;
+
+    if (!buffer || bytes < sizeof(CheckpointHeader) || header->magic != CHECKPOINT_MAGIC || header->version != CHECKPOINT_VERSION)
+    {
+        std::cout << "\033[1;31mERROR: Not a checkpoint (or unsupported version)\033[0m" << std::endl;
+        return 0;
+    }
+
+    if (header->scalarSize != scalarSize)
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint scalar size (" << header->scalarSize << ") does not match the controller (" << scalarSize << ")\033[0m" << std::endl;
+        return 0;
+    }
+
+    const bool coefficients = (header->flags & CHECKPOINT_COEFFICIENTS) != 0;
+    if (header->payloadSize != checkpointPayloadSize(header->nx, header->ne, header->nu, scalarSize, coefficients)
+        || bytes - sizeof(CheckpointHeader) < header->payloadSize)
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint is truncated\033[0m" << std::endl;
+        return 0;
+    }
+
+    std::uint64_t checksum = checkpointChecksum(header, offsetof(CheckpointHeader, checksum));
+    checksum = checkpointChecksum(header + 1, header->payloadSize, checksum);
+    if (checksum != header->checksum)
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint checksum mismatch\033[0m" << std::endl;
+        return 0;
+    }
+
+    return header;
+}
+
+#endif  // CHECKPOINTFORMAT_CPP
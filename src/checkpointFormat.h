@@ -0,0 +1,64 @@
+/**
+ * @file checkpointFormat.h
+ * @brief Binary checkpoint format of controller state and coefficients (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef CHECKPOINTFORMAT_H
+#define CHECKPOINTFORMAT_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Checkpoint identifier ("SSCCHKP1" read as a little endian integer).
+ ******/
+#define CHECKPOINT_MAGIC 0x31504B4843435353ULL
+
+/**
+ * @brief Version of the checkpoint layout.
+ ******/
+#define CHECKPOINT_VERSION 1
+
+/**
+ * @brief Flag of a checkpoint holding A, B, C, D and the time step.
+ ******/
+#define CHECKPOINT_COEFFICIENTS 1u
+
+/**
+ * @brief Header of a checkpoint, followed by its payload.
+ * @details Payload (scalars of scalarSize bytes, row-major matrices):
+ *
+ *      | x_i | x_{i-1} | r_i | y_i | e_i | u_i | A | B | C | D |
+ *
+ * The matrices are present with CHECKPOINT_COEFFICIENTS only. coefficientHash identifies the matrices and
+ * time step of the controller, so that a state-only checkpoint is never restored into another controller.
+ * checksum covers the header fields before it and the payload.
+ ******/
+struct CheckpointHeader
+{
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t scalarSize;
+    std::uint32_t nx, ne, nu;
+    std::uint32_t flags;
+    std::uint64_t i;            // Step index
+    float t, t_s;               // Time and time step (seconds)
+    std::uint64_t coefficientHash;
+    std::uint64_t payloadSize;  // Bytes after the header
+    std::uint64_t checksum;
+};
+
+// 64 bit checksum of a buffer (continues "hash" to checksum several buffers)
+std::uint64_t checkpointChecksum(const void* data, const std::size_t bytes, std::uint64_t hash = 14695981039346656037ULL);
+
+// Bytes of the payload of a checkpoint
+std::size_t checkpointPayloadSize(const unsigned int nx, const unsigned int ne, const unsigned int nu, const std::size_t scalarSize, const bool coefficients);
+
+// Header of a valid checkpoint of scalars of scalarSize bytes (magic, version, sizes, checksum), null otherwise
+const CheckpointHeader* checkpointValidate(const void* buffer, const std::size_t bytes, const std::size_t scalarSize);
+
+#include "checkpointFormat.cpp"
+
+#endif  // CHECKPOINTFORMAT_H
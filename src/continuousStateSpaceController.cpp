@@ -0,0 +1,461 @@
+/**
+ * @file continuousStateSpaceController.cpp
+ * @brief ContinuousStateSpaceController class source file.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef CONTINUOUSSTATESPACECONTROLLER_CPP
+#define CONTINUOUSSTATESPACECONTROLLER_CPP
+
+#include "continuousStateSpaceController.h"
+
+#include <algorithm>
+
+/**
+ * @brief Constructor using user-generated continuous QSMatrix matrices.
+ * @param Ac Continuous A matrix.
+ * @param Bc Continuous B matrix.
+ * @param Cc Continuous C matrix.
+ * @param Dc Continuous D matrix.
+ * @param t_s Controller time step (seconds).
+ * @param method Discretization method.
+ ******/
+template<typename T>
+ContinuousStateSpaceController<T>::ContinuousStateSpaceController(QSMatrix<T> Ac, QSMatrix<T> Bc, QSMatrix<T> Cc, QSMatrix<T> Dc, const float t_s, const DiscretizationMethod method):
+StateSpaceController<T>(), m_method(method), m_tableMin(0), m_tableMax(0), m_tablePoints(0), m_interpolation(LINEAR_INTERPOLATION)
+{
+    this->m_t_s = t_s;
+    setContinuousModel(Ac, Bc, Cc, Dc);
+}
+
+/**
+ * @brief Constructor using a continuous controller data file.
+ * @details The file has the format of controller.dat (see StateSpaceController::help()) with continuous
+ * matrices. Its time step is the initial time step of the controller.
+ * @param formattedDataFilePath Path of the controller data file.
+ * @param method Discretization method.
+ ******/
+template<typename T>
+ContinuousStateSpaceController<T>::ContinuousStateSpaceController(std::string formattedDataFilePath, const DiscretizationMethod method):
+StateSpaceController<T>(), m_method(method), m_tableMin(0), m_tableMax(0), m_tablePoints(0), m_interpolation(LINEAR_INTERPOLATION)
+{
+    loadContinuousControllerData(formattedDataFilePath);
+}
+
+/**
+ * @brief Destructor.
+ ******/
+template<typename T>
+ContinuousStateSpaceController<T>::~ContinuousStateSpaceController() {}
+
+/**
+ * @brief Modifies the continuous model from a controller data file.
+ * @details Same format as StateSpaceController::loadControllerData(), with continuous matrices.
+ * @param formattedDataFilePath Path of the controller data file.
+ ******/
+template<typename T>
+void ContinuousStateSpaceController<T>::loadContinuousControllerData(std::string formattedDataFilePath)
+{
+    this->loadControllerData(formattedDataFilePath);
+
+    setContinuousModel(this->getA(), this->getB(), this->getC(), this->getD());
+}
+
+/**
+ * @brief Modifies the continuous model and discretizes it with the current time step.
+ * @details The cache is cleared and the time step table computed again. State vectors are reset if the dimensions change.
+ * @param Ac Continuous A matrix.
+ * @param Bc Continuous B matrix.
+ * @param Cc Continuous C matrix.
+ * @param Dc Continuous D matrix.
+ ******/
+template<typename T>
+void ContinuousStateSpaceController<T>::setContinuousModel(QSMatrix<T> Ac, QSMatrix<T> Bc, QSMatrix<T> Cc, QSMatrix<T> Dc)
+{
+    const unsigned int nx = Ac.get_rows();
+    const unsigned int ne = Bc.get_cols();
+    const unsigned int nu = Cc.get_rows();
+
+    // New shared model: copies of the controller keep the previous one
+    std::shared_ptr<StateSpaceRealization<T> > continuous = std::make_shared<StateSpaceRealization<T> >();
+    continuous->A = std::move(Ac);
+    continuous->B = std::move(Bc);
+    continuous->C = std::move(Cc);
+    continuous->D = std::move(Dc);
+    m_continuous = continuous;
+
+    if (this->m_nx != nx || this->m_ne != ne || this->m_nu != nu || this->m_x_i.size() != nx)
+    {
+        this->m_nx = nx;
+        this->m_ne = ne;
+        this->m_nu = nu;
+
+        this->m_x_i.assign(this->m_nx, 0);
+        this->m_x_ib.assign(this->m_nx, 0);
+        this->m_r_i.assign(this->m_ne, 0);
+        this->m_y_i.assign(this->m_ne, 0);
+        this->m_e_i.assign(this->m_ne, 0);
+        this->m_u_i.assign(this->m_nu, 0);
+    }
+
+    this->m_x_next.assign(this->m_nx, 0);
+
+    clearCache();
+    setTimeStep(this->m_t_s);
+    computeTimeStepTable();
+}
+
+/**
+ * @brief Changes the time step and uses the matching discretization.
+ * @details The discretization is computed on the first use of a time step, then read from the cache. When
+ * the cache is full, the cached time step farthest from t_s is dropped. A Tustin state is transformed to the
+ * new time step.
+ * @param t_s Controller time step (seconds).
+ ******/
+template<typename T>
+void ContinuousStateSpaceController<T>::setTimeStep(const float t_s)
+{
+    typename std::map<float, std::shared_ptr<const StateSpaceRealization<T> > >::iterator it = m_cache.find(t_s);
+
+    if (it == m_cache.end())
+    {
+        if (m_cache.size() >= CONTINUOUS_CACHE_SIZE)
+        {
+            typename std::map<float, std::shared_ptr<const StateSpaceRealization<T> > >::iterator last = --m_cache.end();
+            m_cache.erase((t_s - m_cache.begin()->first > last->first - t_s) ? m_cache.begin() : last);
+        }
+
+        std::shared_ptr<const StateSpaceRealization<T> > discrete = std::make_shared<StateSpaceRealization<T> >(
+            continuousToDiscrete(m_continuous->A, m_continuous->B, m_continuous->C, m_continuous->D, t_s, m_method));
+        it = m_cache.insert(std::make_pair(t_s, discrete)).first;
+    }
+
+    if (m_method == TUSTIN && t_s != this->m_t_s)
+    {
+        transformState(TUSTIN, this->m_t_s, TUSTIN, t_s);
+    }
+
+    applyRealization(it->second);
+    this->m_t_s = t_s;
+}
+
+/**
+ * @brief Expresses the state in the coordinates of another discretization.
+ * @details ZOH: x_d = x_c. Tustin: x_d = P*x_c - Bc*t_s/2*e with P = I - Ac*t_s/2. The last error is used for e.
+ * @param fromMethod Method of the current state.
+ * @param fromStep Time step of the current state (seconds).
+ * @param toMethod Method of the new state.
+ * @param toStep Time step of the new state (seconds).
+ ******/
+template<typename T>
+void ContinuousStateSpaceController<T>::transformState(const DiscretizationMethod fromMethod, const float fromStep, const DiscretizationMethod toMethod, const float toStep)
+{
+    if (this->m_x_i.size() != this->m_nx || this->m_e_i.size() != this->m_ne || this->m_nx == 0)
+    {
+        return;
+    }
+
+    const QSMatrix<T>& Ac = m_continuous->A;
+    const std::vector<T> Be = m_continuous->B * this->m_e_i;
+    std::vector<T> x = this->m_x_i;
+
+    if (fromMethod == TUSTIN)
+    {
+        const T h = fromStep / T(2);
+        for (unsigned int k=0;k<this->m_nx;k++) x[k] += h * Be[k];
+        x = (identityMatrix<T>(this->m_nx) - Ac * h).solve(x);
+    }
+    if (toMethod == TUSTIN)
+    {
+        const T h = toStep / T(2);
+        x = (identityMatrix<T>(this->m_nx) - Ac * h) * x;
+        for (unsigned int k=0;k<this->m_nx;k++) x[k] -= h * Be[k];
+    }
+
+    this->m_x_i = x;
+    this->m_atRest = false;
+}
+
+/**
+ * @brief Uses the matrices of a discrete realization as controller matrices.
+ * @details The matrices are not copied: they share the ownership of the realization.
+ ******/
+template<typename T>
+void ContinuousStateSpaceController<T>::applyRealization(const std::shared_ptr<const StateSpaceRealization<T> >& discrete)
+{
+    this->setA(std::shared_ptr<const QSMatrix<T> >(discrete, &discrete->A));
+    this->setB(std::shared_ptr<const QSMatrix<T> >(discrete, &discrete->B));
+    this->setC(std::shared_ptr<const QSMatrix<T> >(discrete, &discrete->C));
+    this->setD(std::shared_ptr<const QSMatrix<T> >(discrete, &discrete->D));
+}
+
+/**
+ * @return Discretization method.
+ ******/
+template<typename T>
+DiscretizationMethod ContinuousStateSpaceController<T>::getMethod() const
+{
+    return m_method;
+}
+
+/**
+ * @details The cache is cleared and the model discretized again with the current time step (and the table time steps).
+ * @param method Discretization method.
+ ******/
+template<typename T>
+void ContinuousStateSpaceController<T>::setMethod(const DiscretizationMethod method)
+{
+    if (method != m_method)
+    {
+        transformState(m_method, this->m_t_s, method, this->m_t_s);
+        m_method = method;
+        if (method == TUSTIN && m_tablePoints > 0)
+        {
+            std::cout << "\033[1;31mERROR: The variable time step mode needs ZOH, the time step table is removed\033[0m" << std::endl;
+        }
+        clearCache();
+        setTimeStep(this->m_t_s);
+        computeTimeStepTable();
+    }
+}
+
+/**
+ * @return Continuous A matrix.
+ ******/
+template<typename T>
+const QSMatrix<T>& ContinuousStateSpaceController<T>::getAc() const
+{
+    return m_continuous->A;
+}
+
+/**
+ * @return Continuous B matrix.
+ ******/
+template<typename T>
+const QSMatrix<T>& ContinuousStateSpaceController<T>::getBc() const
+{
+    return m_continuous->B;
+}
+
+/**
+ * @return Continuous C matrix.
+ ******/
+template<typename T>
+const QSMatrix<T>& ContinuousStateSpaceController<T>::getCc() const
+{
+    return m_continuous->C;
+}
+
+/**
+ * @return Continuous D matrix.
+ ******/
+template<typename T>
+const QSMatrix<T>& ContinuousStateSpaceController<T>::getDc() const
+{
+    return m_continuous->D;
+}
+
+/**
+ * @brief Configures the variable time step mode.
+ * @details The continuous model is discretized for points time steps evenly spread over [dt_min, dt_max].
+ * Intervals outside the range use the closest bound. Only with ZOH: with Tustin an error is printed and no
+ * table is computed.
+ * @param dt_min Smallest time step of the table (seconds).
+ * @param dt_max Largest time step of the table (seconds).
+ * @param points Number of tabulated time steps (0 removes the table).
+ * @param interpolation Nearest tabulated time step or linear interpolation.
+ ******/
+template<typename T>
+void ContinuousStateSpaceController<T>::setTimeStepTable(const float dt_min, const float dt_max, const unsigned int points, const TimeStepInterpolation interpolation)
+{
+    m_tableMin = dt_min;
+    m_tableMax = (points > 1) ? dt_max : dt_min;
+    m_tablePoints = points;
+    m_interpolation = interpolation;
+
+    if (m_method == TUSTIN && points > 0)
+    {
+        std::cout << "\033[1;31mERROR: The variable time step mode needs ZOH (the Tustin state depends on the time step)\033[0m" << std::endl;
+    }
+
+    computeTimeStepTable();
+}
+
+/**
+ * @brief Computes the table entries from the continuous model.
+ ******/
+template<typename T>
+void ContinuousStateSpaceController<T>::computeTimeStepTable()
+{
+    std::shared_ptr<std::vector<StateSpaceRealization<T> > > table = std::make_shared<std::vector<StateSpaceRealization<T> > >();
+    table->reserve(m_tablePoints);
+
+    for (unsigned int k=0;k<m_tablePoints && m_method == ZOH;k++)
+    {
+        float dt = (m_tablePoints > 1) ? m_tableMin + (m_tableMax - m_tableMin) * k / (m_tablePoints - 1) : m_tableMin;
+        table->push_back(continuousToDiscrete(m_continuous->A, m_continuous->B, m_continuous->C, m_continuous->D, dt, m_method));
+    }
+
+    m_table = table;
+}
+
+/**
+ * @return Number of tabulated time steps (0: no table).
+ ******/
+template<typename T>
+unsigned int ContinuousStateSpaceController<T>::getTableSize() const
+{
+    return m_table ? m_table->size() : 0;
+}
+
+/**
+ * @brief Row of the blended matrix (1-w)*M0 + w*M1 times a vector.
+ ******/
+template<typename T>
+T ContinuousStateSpaceController<T>::blendedDot(const QSMatrix<T>& M0, const QSMatrix<T>& M1, const unsigned int row, const T w, const std::vector<T>& v)
+{
+    T sum = 0;
+
+    if (w == 0)
+    {
+        for (unsigned int col=0;col<v.size();col++)
+        {
+            sum += M0(row,col) * v[col];
+        }
+    }
+    else
+    {
+        for (unsigned int col=0;col<v.size();col++)
+        {
+            sum += (M0(row,col) + w * (M1(row,col) - M0(row,col))) * v[col];
+        }
+    }
+
+    return sum;
+}
+
+/**
+ * @brief Computes the current controller output with a measured time step and increments time.
+ * @details The state is first propagated over dt with the error of the previous call (nothing on the first
+ * call), using the time step table, then the output is computed. The current time is increased by dt.
+ * Without table, the exact discretization of dt is computed (slow). At rest (idle mode), the output at rest
+ * is returned while the error stays within the threshold. With Tustin an error is printed and a fixed time
+ * step is made instead.
+ * @param e_i Current error vector.
+ * @param dt Interval since the previous call (seconds).
+ * @return Controller output vector.
+ ******/
+template<typename T>
+std::vector<T> ContinuousStateSpaceController<T>::currentOutput(const std::vector<T>& e_i, const float dt)
+{
+    if (m_method == TUSTIN)
+    {
+        std::cout << "\033[1;31mERROR: The variable time step mode needs ZOH, fixed time step used\033[0m" << std::endl;
+        return this->currentOutput(e_i);
+    }
+
+    if (this->m_atRest)
+    {
+        bool wake = false;
+        for (unsigned int k=0;k<this->m_ne && !wake;k++)
+        {
+            wake = std::abs(e_i[k] - this->m_restError[k]) > this->m_idleThreshold;
+        }
+
+        if (!wake)
+        {
+            this->m_e_i = e_i;
+            this->m_u_i = this->m_restOutput;
+            this->m_t += dt;
+            this->m_i++;
+            this->m_skippedSteps++;
+            this->publishSnapshot();
+            return this->m_u_i;
+        }
+        this->m_atRest = false;
+    }
+
+    StateSpaceRealization<T> exact;
+    const StateSpaceRealization<T>* M0;
+    const StateSpaceRealization<T>* M1;
+    T w = 0;
+
+    if (!m_table || m_table->empty())
+    {
+        exact = continuousToDiscrete(m_continuous->A, m_continuous->B, m_continuous->C, m_continuous->D, dt, m_method);
+        M0 = &exact;
+        M1 = &exact;
+    }
+    else
+    {
+        float position = 0;
+        if (m_tablePoints > 1)
+        {
+            position = (dt - m_tableMin) / (m_tableMax - m_tableMin) * (m_tablePoints - 1);
+            position = std::min((float)(m_tablePoints - 1), std::max(0.0f, position));
+        }
+
+        unsigned int k = (m_interpolation == NEAREST_TIME_STEP) ? (unsigned int)(position + 0.5f) : (unsigned int)position;
+        if (m_interpolation == LINEAR_INTERPOLATION && k + 1 < m_tablePoints)
+        {
+            w = position - k;
+        }
+
+        M0 = &(*m_table)[k];
+        M1 = &(*m_table)[std::min(k + 1, m_tablePoints - 1)];
+    }
+
+    // x_i = A(dt)*x_{i-1} + B(dt)*e_{i-1}
+    const bool propagated = this->m_i > 0;
+    if (propagated)
+    {
+        for (unsigned int row=0;row<this->m_nx;row++)
+        {
+            m_x_next[row] = blendedDot(M0->A, M1->A, row, w, this->m_x_i) + blendedDot(M0->B, M1->B, row, w, this->m_e_i);
+        }
+        this->m_x_ib = this->m_x_i;
+        this->m_x_i.swap(m_x_next);
+
+        this->m_t += dt;
+    }
+
+    // u_i = C*x_i + D*e_i (C and D do not depend on dt with ZOH)
+    this->m_e_i = e_i;
+
+    for (unsigned int row=0;row<this->m_nu;row++)
+    {
+        this->m_u_i[row] = blendedDot(M0->C, M1->C, row, 0, this->m_x_i) + blendedDot(M0->D, M1->D, row, 0, this->m_e_i);
+    }
+
+    this->m_i++;
+
+    if (this->m_idleMode && propagated)
+    {
+        this->detectRest();
+    }
+
+    this->publishSnapshot();
+
+    return this->m_u_i;
+}
+
+/**
+ * @return Number of cached discretizations.
+ ******/
+template<typename T>
+unsigned int ContinuousStateSpaceController<T>::getCacheSize() const
+{
+    return m_cache.size();
+}
+
+/**
+ * @brief Removes all cached discretizations.
+ ******/
+template<typename T>
+void ContinuousStateSpaceController<T>::clearCache()
+{
+    m_cache.clear();
+}
+
+#endif
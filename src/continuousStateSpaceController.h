@@ -0,0 +1,161 @@
+/**
+ * @file continuousStateSpaceController.h
+ * @brief ContinuousStateSpaceController class header.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef CONTINUOUSSTATESPACECONTROLLER_H
+#define CONTINUOUSSTATESPACECONTROLLER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+#include "discretization.h"
+
+/**
+ * @brief Largest number of discretizations cached by time step (the farthest time step is dropped beyond).
+ ******/
+#define CONTINUOUS_CACHE_SIZE 64
+
+/**
+ * @brief Use of the time step table in variable time step mode.
+ * @details NEAREST_TIME_STEP: matrices of the closest tabulated time step.
+ * LINEAR_INTERPOLATION: linear interpolation between the two surrounding time steps.
+ ******/
+enum TimeStepInterpolation
+{
+    NEAREST_TIME_STEP,
+    LINEAR_INTERPOLATION
+};
+
+/**
+ * @class ContinuousStateSpaceController
+ * @brief State-space controller defined by its continuous-time model.
+ * @details The controller is loaded from continuous matrices (Ac, Bc, Cc, Dc) and the discrete A, B, C, D
+ * used by StateSpaceController are computed for the current time step (ZOH or Tustin, see continuousToDiscrete()).
+ *
+ *      K (continuous):
+ *          | dx/dt = Ac*x + Bc*e
+ *          |     u = Cc*x + Dc*e
+ *
+ * Each discretization is cached by time step (up to CONTINUOUS_CACHE_SIZE time steps): switching back to a
+ * time step already used is a lookup. The continuous model, the cached discretizations and the time step
+ * table are shared by the copies of the controller (like A, B, C and D, see StateSpaceController).
+ *
+ * With ZOH the discrete state is the continuous state and is kept when the time step changes. With Tustin
+ * the discrete state is x_d = (I - Ac*t_s/2)*x_c - Bc*t_s/2*e: it is transformed to the new time step (and
+ * between methods) with the last error, which is exact if the error of the next step is the same.
+ *
+ * Variable time step mode (ZOH only, the Tustin state depends on the time step): after setTimeStepTable(),
+ * currentOutput(e_i, dt) uses the measured interval dt since the previous call. The state is propagated over
+ * dt at the beginning of the call (with the error held since the previous call) using matrices read or
+ * interpolated from the table, so no matrix exponential is computed on the hot path, then the output is
+ * computed. The current time accumulates the measured intervals. Snapshots and idle mode work as with
+ * fixed time steps (a state at rest is a fixed point for any dt).
+ * In this mode getX_i() is the state at the last sample: do not mix with fixed time step calls without reset().
+ ******/
+template <typename T>
+class ContinuousStateSpaceController : public StateSpaceController<T>
+{
+    public:
+
+    // Constructor using continuous QSMatrices
+    ContinuousStateSpaceController(QSMatrix<T> Ac, QSMatrix<T> Bc, QSMatrix<T> Cc, QSMatrix<T> Dc, const float t_s, const DiscretizationMethod method = ZOH);
+
+    // Constructor from a data file with the format of controller.dat, continuous matrices inside
+    ContinuousStateSpaceController(std::string formattedDataFilePath, const DiscretizationMethod method = ZOH);
+
+    virtual ~ContinuousStateSpaceController();
+
+    using StateSpaceController<T>::currentOutput;
+
+    // Variable time step: dt is the interval (seconds) since the previous call
+    std::vector<T> currentOutput(const std::vector<T>& e_i, const float dt);
+
+    // Precompute the discretizations of points time steps evenly spread over [dt_min, dt_max]
+    void setTimeStepTable(const float dt_min, const float dt_max, const unsigned int points, const TimeStepInterpolation interpolation = LINEAR_INTERPOLATION);
+
+    // Number of tabulated time steps (0: no table)
+    unsigned int getTableSize() const;
+
+    // Change the continuous model from a data file (the time step of the file is used)
+    void loadContinuousControllerData(std::string formattedDataFilePath);
+
+    // Change the continuous model (the cache is cleared)
+    void setContinuousModel(QSMatrix<T> Ac, QSMatrix<T> Bc, QSMatrix<T> Cc, QSMatrix<T> Dc);
+
+    // Change the time step and use the matching discretization (computed once per time step)
+    virtual void setTimeStep(const float t_s);
+
+    // Discretization method (the cache is cleared when it changes)
+    DiscretizationMethod getMethod() const;
+    void setMethod(const DiscretizationMethod method);
+
+    // Continuous state-space matrices
+    const QSMatrix<T>& getAc() const;
+    const QSMatrix<T>& getBc() const;
+    const QSMatrix<T>& getCc() const;
+    const QSMatrix<T>& getDc() const;
+
+    // Number of cached discretizations
+    unsigned int getCacheSize() const;
+    void clearCache();
+
+    protected:
+    // Use the matrices of a discrete realization as A, B, C, D (shared, not copied)
+    void applyRealization(const std::shared_ptr<const StateSpaceRealization<T> >& discrete);
+
+    // Express the state in the coordinates of another discretization (Tustin states depend on t_s)
+    void transformState(const DiscretizationMethod fromMethod, const float fromStep, const DiscretizationMethod toMethod, const float toStep);
+
+    // Compute the table entries from the continuous model
+    void computeTimeStepTable();
+
+    // Row of (1-w)*M0 + w*M1 times v (M1 is not read when w is 0)
+    static T blendedDot(const QSMatrix<T>& M0, const QSMatrix<T>& M1, const unsigned int row, const T w, const std::vector<T>& v);
+
+    /**
+     * @brief Continuous state-space matrices (shared by the copies of the controller).
+     ******/
+    std::shared_ptr<const StateSpaceRealization<T> > m_continuous;
+
+    /**
+     * @brief Discretization method.
+     ******/
+    DiscretizationMethod m_method;
+
+    /**
+     * @brief Discrete realizations already computed, by time step.
+     ******/
+    std::map<float, std::shared_ptr<const StateSpaceRealization<T> > > m_cache;
+
+    /**
+     * @brief Discretizations of the variable time step mode, for evenly spread time steps.
+     ******/
+    std::shared_ptr<const std::vector<StateSpaceRealization<T> > > m_table;
+
+    /**
+     * @brief Time step range and number of points of the table.
+     ******/
+    float m_tableMin, m_tableMax;
+    unsigned int m_tablePoints;
+
+    /**
+     * @brief Use of the table (nearest time step or interpolation).
+     ******/
+    TimeStepInterpolation m_interpolation;
+
+    /**
+     * @brief Next state vector (variable time step mode).
+     ******/
+    std::vector<T> m_x_next;
+};
+
+#include "continuousStateSpaceController.cpp"
+
+#endif  // CONTINUOUSSTATESPACECONTROLLER_H
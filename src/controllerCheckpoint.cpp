@@ -0,0 +1,483 @@
+/**
+ * @file controllerCheckpoint.cpp
+ * @brief Controller checkpoints written asynchronously to a memory-mapped file or mirrored in shared memory (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef CONTROLLERCHECKPOINT_CPP
+#define CONTROLLERCHECKPOINT_CPP
+
+#include "controllerCheckpoint.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief Constructor: creates the file (two empty slots) and starts the writer thread.
+ * @param path Checkpoint file, overwritten: load() it before if the previous run must be resumed.
+ * @param controller Controller checkpointed (sizes the slots).
+ * @param coefficients True to include the matrices in the checkpoints.
+ * @param sync True to wait for the disk (msync MS_SYNC) in the writer thread.
+ ******/
+template<typename T>
+CheckpointFile<T>::CheckpointFile(const std::string& path, const StateSpaceController<T>& controller, const bool coefficients, const bool sync):
+m_path(path), m_coefficients(coefficients), m_sync(sync), m_base(0), m_size(0),
+m_slotSize((64 + controller.checkpointSize(coefficients) + 63) / 64 * 64),
+m_staging((m_slotSize - 64) / 8), m_writing((m_slotSize - 64) / 8), m_stagingBytes(0), m_sequence(0), m_nextSlot(0),
+m_pending(false), m_busy(false), m_stopping(false), m_written(0), m_dropped(0)
+{
+    m_size = sizeof(CheckpointFileHeader) + 2 * m_slotSize;
+
+    const int fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, m_size) != 0)
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint file " << m_path << " cannot be created\033[0m" << std::endl;
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    m_base = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m_base == MAP_FAILED)
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint file " << m_path << " cannot be mapped\033[0m" << std::endl;
+        m_base = 0;
+        return;
+    }
+
+    CheckpointFileHeader* header = (CheckpointFileHeader*)m_base;
+    header->magic = CHECKPOINT_FILE_MAGIC;
+    header->version = CHECKPOINT_VERSION;
+    header->scalarSize = sizeof(T);
+    header->slotSize = m_slotSize;
+
+    m_writer = std::thread(&CheckpointFile<T>::work, this);
+}
+
+/**
+ * @brief Destructor: writes the pending checkpoint, stops the writer thread and unmaps the file.
+ ******/
+template<typename T>
+CheckpointFile<T>::~CheckpointFile()
+{
+    if (m_writer.joinable())
+    {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_writer.join();
+    }
+
+    if (m_base)
+    {
+        msync(m_base, m_size, MS_SYNC);
+        munmap(m_base, m_size);
+    }
+}
+
+/**
+ * @brief Serializes the controller into the staging buffer, for the writer thread.
+ * @details Called from the control loop: a copy of the state under a mutex only held by the writer to swap
+ * buffers. A checkpoint not yet written is replaced (counted in getDroppedCount()).
+ * @return False if the file is not open or the checkpoint is larger than a slot (dimensions changed).
+ ******/
+template<typename T>
+bool CheckpointFile<T>::checkpoint(const StateSpaceController<T>& controller)
+{
+    const std::size_t bytes = controller.checkpointSize(m_coefficients);
+    if (!m_base || 64 + bytes > m_slotSize)
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint does not fit in " << m_path << "\033[0m" << std::endl;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending)
+        {
+            m_dropped++;
+        }
+        m_stagingBytes = controller.saveCheckpoint(m_staging.data(), m_coefficients);
+        m_pending = true;
+    }
+    m_wake.notify_one();
+
+    return true;
+}
+
+/**
+ * @brief Waits until the last checkpoint taken has been written into the file.
+ ******/
+template<typename T>
+void CheckpointFile<T>::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return !m_pending && !m_busy; });
+}
+
+/**
+ * @brief Writer thread: copies each checkpoint into the older slot, then stamps and msyncs it.
+ ******/
+template<typename T>
+void CheckpointFile<T>::work()
+{
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_wake.wait(lock, [this]() { return m_pending || m_stopping; });
+        if (!m_pending)
+        {
+            break;
+        }
+
+        std::swap(m_staging, m_writing);
+        const std::size_t bytes = m_stagingBytes;
+        m_pending = false;
+        m_busy = true;
+        lock.unlock();
+
+        char* slot = (char*)m_base + sizeof(CheckpointFileHeader) + m_nextSlot * m_slotSize;
+        std::memcpy(slot + 64, m_writing.data(), bytes);
+        std::atomic_thread_fence(std::memory_order_release);
+        *(volatile std::uint64_t*)slot = ++m_sequence;
+
+        char* begin = (char*)((std::uintptr_t)slot / pageSize * pageSize);
+        msync(begin, slot + 64 + bytes - begin, m_sync ? MS_SYNC : MS_ASYNC);
+        m_nextSlot ^= 1;
+
+        lock.lock();
+        m_busy = false;
+        m_written++;
+        m_done.notify_all();
+    }
+}
+
+/**
+ * @brief Restores the newest valid checkpoint of a file (the other slot if the newest is torn).
+ * @param path Checkpoint file written by a CheckpointFile.
+ * @param controller Controller restored (see StateSpaceController::restoreCheckpoint()).
+ * @return False if the file holds no valid checkpoint for this controller.
+ ******/
+template<typename T>
+bool CheckpointFile<T>::load(const std::string& path, StateSpaceController<T>& controller)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || (std::size_t)status.st_size < sizeof(CheckpointFileHeader))
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint file " << path << " cannot be opened\033[0m" << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    const std::size_t size = status.st_size;
+    void* base = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint file " << path << " cannot be mapped\033[0m" << std::endl;
+        return false;
+    }
+
+    const CheckpointFileHeader* header = (const CheckpointFileHeader*)base;
+    bool restored = false;
+    if (header->magic != CHECKPOINT_FILE_MAGIC || header->version != CHECKPOINT_VERSION || header->scalarSize != sizeof(T)
+        || header->slotSize < 64 + sizeof(CheckpointHeader) || size < sizeof(CheckpointFileHeader) + 2 * header->slotSize)
+    {
+        std::cout << "\033[1;31mERROR: " << path << " is not a checkpoint file of this scalar type\033[0m" << std::endl;
+    }
+    else
+    {
+        const char* slots[2] = {(const char*)base + sizeof(CheckpointFileHeader), (const char*)base + sizeof(CheckpointFileHeader) + header->slotSize};
+        const std::uint64_t sequences[2] = {*(const std::uint64_t*)slots[0], *(const std::uint64_t*)slots[1]};
+        const unsigned int newest = (sequences[1] > sequences[0]) ? 1 : 0;
+        const unsigned int order[2] = {newest, newest ^ 1u};
+
+        for (unsigned int k=0;k<2 && !restored;k++)
+        {
+            const char* slot = slots[order[k]];
+            if (sequences[order[k]] != 0)
+            {
+                restored = controller.restoreCheckpoint(slot + 64, header->slotSize - 64);
+            }
+        }
+        if (!restored)
+        {
+            std::cout << "\033[1;31mERROR: " << path << " holds no valid checkpoint\033[0m" << std::endl;
+        }
+    }
+
+    munmap(base, size);
+
+    return restored;
+}
+
+/**
+ * @return True if the file is mapped and the writer runs.
+ ******/
+template<typename T>
+bool CheckpointFile<T>::isOpen() const
+{
+    return m_base != 0;
+}
+
+/**
+ * @return Path of the file.
+ ******/
+template<typename T>
+const std::string& CheckpointFile<T>::getPath() const
+{
+    return m_path;
+}
+
+/**
+ * @return True if the checkpoints include the matrices.
+ ******/
+template<typename T>
+bool CheckpointFile<T>::hasCoefficients() const
+{
+    return m_coefficients;
+}
+
+/**
+ * @return Checkpoints written to the file.
+ ******/
+template<typename T>
+unsigned long long CheckpointFile<T>::getWrittenCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_written;
+}
+
+/**
+ * @return Checkpoints replaced by a newer one before the writer reached them.
+ ******/
+template<typename T>
+unsigned long long CheckpointFile<T>::getDroppedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+/**
+ * @brief Constructor of the primary: creates the segment.
+ * @param name Name of the segment (a leading '/' is added if missing). It must not exist: a segment left
+ * by a primary that crashed is removed with shm_unlink() before starting again.
+ * @param capacity Largest checkpoint published (see StateSpaceController::checkpointSize()).
+ ******/
+template<typename T>
+CheckpointMirror<T>::CheckpointMirror(const std::string& name, const std::size_t capacity):
+m_name((!name.empty() && name[0] == '/') ? name : "/" + name), m_owner(true), m_base(0),
+m_size(sizeof(CheckpointMirrorHeader) + (capacity + 63) / 64 * 64), m_header(0), m_buffer((capacity + 7) / 8)
+{
+    const int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << m_name << " cannot be created: " << std::strerror(errno) << "\033[0m" << std::endl;
+        return;
+    }
+    if (ftruncate(fd, m_size) != 0)
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << m_name << " cannot be sized\033[0m" << std::endl;
+        close(fd);
+        shm_unlink(m_name.c_str());
+        return;
+    }
+
+    m_base = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m_base == MAP_FAILED)
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << m_name << " cannot be mapped\033[0m" << std::endl;
+        m_base = 0;
+        shm_unlink(m_name.c_str());
+        return;
+    }
+
+    m_header = new (m_base) CheckpointMirrorHeader();
+    m_header->magic = CHECKPOINT_MIRROR_MAGIC;
+    m_header->version = CHECKPOINT_VERSION;
+    m_header->scalarSize = sizeof(T);
+    m_header->capacity = m_buffer.size() * 8;
+    m_header->bytes = 0;
+}
+
+/**
+ * @brief Constructor of the standby: maps the segment of the primary (read only).
+ * @param name Name of the segment.
+ ******/
+template<typename T>
+CheckpointMirror<T>::CheckpointMirror(const std::string& name):
+m_name((!name.empty() && name[0] == '/') ? name : "/" + name), m_owner(false), m_base(0), m_size(0), m_header(0)
+{
+    const int fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || (std::size_t)status.st_size < sizeof(CheckpointMirrorHeader))
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << m_name << " cannot be opened\033[0m" << std::endl;
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    m_size = status.st_size;
+    void* base = mmap(0, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << m_name << " cannot be mapped\033[0m" << std::endl;
+        return;
+    }
+
+    const CheckpointMirrorHeader* header = (const CheckpointMirrorHeader*)base;
+    if (header->magic != CHECKPOINT_MIRROR_MAGIC || header->version != CHECKPOINT_VERSION || header->scalarSize != sizeof(T)
+        || m_size < sizeof(CheckpointMirrorHeader) + header->capacity)
+    {
+        std::cout << "\033[1;31mERROR: " << m_name << " is not a checkpoint mirror of this scalar type\033[0m" << std::endl;
+        munmap(base, m_size);
+        return;
+    }
+
+    m_base = base;
+    m_header = (CheckpointMirrorHeader*)base;
+    m_buffer.resize(m_header->capacity / 8);
+}
+
+/**
+ * @brief Destructor: unmaps the segment; the primary also unlinks it.
+ ******/
+template<typename T>
+CheckpointMirror<T>::~CheckpointMirror()
+{
+    if (m_base)
+    {
+        munmap(m_base, m_size);
+        if (m_owner)
+        {
+            shm_unlink(m_name.c_str());
+        }
+    }
+}
+
+/**
+ * @brief Publishes a checkpoint of the controller (primary side, single writer).
+ * @param controller Controller checkpointed.
+ * @param coefficients True to include the matrices (a standby without the controller data can then take over).
+ * @return False if this is not the primary or the checkpoint exceeds the capacity.
+ ******/
+template<typename T>
+bool CheckpointMirror<T>::publish(const StateSpaceController<T>& controller, const bool coefficients)
+{
+    const std::size_t bytes = controller.checkpointSize(coefficients);
+    if (!m_owner || !m_base || bytes > m_header->capacity)
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint cannot be published in " << m_name << "\033[0m" << std::endl;
+        return false;
+    }
+
+    controller.saveCheckpoint(m_buffer.data(), coefficients);
+
+    const std::uint64_t size = bytes;
+    m_header->lock.writeBegin();
+    Seqlock::store(&m_header->bytes, &size, sizeof(size));
+    Seqlock::store(m_header + 1, m_buffer.data(), bytes);
+    m_header->lock.writeEnd();
+
+    return true;
+}
+
+/**
+ * @brief Copies the latest consistent checkpoint and restores it (standby side, or primary).
+ * @param controller Controller taking over (see StateSpaceController::restoreCheckpoint()).
+ * @return False if nothing was published yet, a publication never ends or the checkpoint is rejected.
+ ******/
+template<typename T>
+bool CheckpointMirror<T>::restore(StateSpaceController<T>& controller)
+{
+    if (!m_base)
+    {
+        return false;
+    }
+
+    // Consistent copy, without waiting for a primary that died while publishing
+    std::uint64_t bytes = 0;
+    bool copied = false;
+    for (unsigned int spin=0;spin<CHECKPOINT_MIRROR_READ_SPINS && !copied;spin++)
+    {
+        const std::uint32_t sequence = m_header->lock.getSequence();
+        if (sequence & 1)
+        {
+            SEQLOCK_PAUSE();
+            continue;
+        }
+        Seqlock::load(&bytes, &m_header->bytes, sizeof(bytes));
+        bytes = std::min<std::uint64_t>(bytes, m_header->capacity);
+        Seqlock::load(m_buffer.data(), m_header + 1, bytes);
+        copied = !m_header->lock.readRetry(sequence);
+    }
+    
+    if (!copied)
+    {
+        std::cout << "\033[1;31mERROR: The checkpoint in " << m_name << " is still being published\033[0m" << std::endl;
+        return false;
+    }
+
+    if (bytes == 0)
+    {
+        std::cout << "\033[1;31mERROR: No checkpoint published in " << m_name << "\033[0m" << std::endl;
+        return false;
+    }
+
+    return controller.restoreCheckpoint(m_buffer.data(), bytes);
+}
+
+/**
+ * @return Number of checkpoints published.
+ ******/
+template<typename T>
+std::uint32_t CheckpointMirror<T>::getSequence() const
+{
+    return m_base ? m_header->lock.getSequence() / 2 : 0;
+}
+
+/**
+ * @return True if the segment is mapped.
+ ******/
+template<typename T>
+bool CheckpointMirror<T>::isOpen() const
+{
+    return m_base != 0;
+}
+
+/**
+ * @return Name of the segment.
+ ******/
+template<typename T>
+const std::string& CheckpointMirror<T>::getName() const
+{
+    return m_name;
+}
+
+/**
+ * @return Largest checkpoint the segment holds (bytes).
+ ******/
+template<typename T>
+std::size_t CheckpointMirror<T>::getCapacity() const
+{
+    return m_base ? m_header->capacity : 0;
+}
+
+#endif  // CONTROLLERCHECKPOINT_CPP
@@ -0,0 +1,178 @@
+/**
+ * @file controllerCheckpoint.h
+ * @brief Controller checkpoints written asynchronously to a memory-mapped file or mirrored in shared memory (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef CONTROLLERCHECKPOINT_H
+#define CONTROLLERCHECKPOINT_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "stateSpaceController.h"
+#include "checkpointFormat.h"
+#include "seqlock.h"
+
+/**
+ * @brief Checkpoint file identifier ("SSCCKPF1").
+ ******/
+#define CHECKPOINT_FILE_MAGIC 0x3146504B43435353ULL
+
+/**
+ * @brief Checkpoint mirror identifier ("SSCCKPM1").
+ ******/
+#define CHECKPOINT_MIRROR_MAGIC 0x314D504B43435353ULL
+
+/**
+ * @brief Checks of a mirror being published before restore() gives up (the primary may have died while publishing).
+ ******/
+#define CHECKPOINT_MIRROR_READ_SPINS 1000000
+
+/**
+ * @brief Header of a checkpoint file, followed by two slots of slotSize bytes.
+ * @details A slot is a 64 byte sequence number followed by a checkpoint. Checkpoints are written in turn
+ * into the slot not holding the last one: a crash during a write leaves the other slot valid.
+ ******/
+struct CheckpointFileHeader
+{
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t scalarSize;
+    std::uint64_t slotSize;
+    std::uint64_t reserved[5];
+};
+
+/**
+ * @brief Header of a checkpoint mirror segment, followed by the checkpoint (capacity bytes).
+ ******/
+struct CheckpointMirrorHeader
+{
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t scalarSize;
+    std::uint64_t capacity;
+    alignas(64) Seqlock lock;
+    std::uint64_t bytes;     // Size of the checkpoint published
+};
+
+/**
+ * @class CheckpointFile
+ * @brief Periodic checkpoints of a controller written to a memory-mapped file by a background thread.
+ * @details checkpoint() serializes the controller into a staging buffer and returns: no system call in the
+ * control loop. The writer thread copies the latest checkpoint into the mapped file (alternating between
+ * two slots) and msync()s it (MS_ASYNC unless "sync" is set). If the loop checkpoints faster than the
+ * writer, intermediate checkpoints are dropped, never queued.
+ *
+ * After a restart, CheckpointFile<T>::load() restores the newest valid slot: validation and copies, no
+ * matrix file to parse and no convergence from a zero state.
+ ******/
+template <typename T>
+class CheckpointFile
+{
+    public:
+
+    // File sized for checkpoints of the controller (created or overwritten), with or without its matrices
+    CheckpointFile(const std::string& path, const StateSpaceController<T>& controller, const bool coefficients = false, const bool sync = false);
+
+    CheckpointFile(const CheckpointFile<T>&) = delete;
+    CheckpointFile<T>& operator=(const CheckpointFile<T>&) = delete;
+
+    // Writes the pending checkpoint, stops the writer and unmaps the file
+    virtual ~CheckpointFile();
+
+    // Take a checkpoint (written asynchronously); false if it does not fit in the file
+    bool checkpoint(const StateSpaceController<T>& controller);
+
+    // Wait until the last checkpoint taken is in the file
+    void flush();
+
+    // Restore the newest valid checkpoint of a file
+    static bool load(const std::string& path, StateSpaceController<T>& controller);
+
+    bool isOpen() const;
+    const std::string& getPath() const;
+    bool hasCoefficients() const;
+
+    // Checkpoints written to the file, and replaced by a newer one before being written
+    unsigned long long getWrittenCount() const;
+    unsigned long long getDroppedCount() const;
+
+    protected:
+    // Writer thread
+    void work();
+
+    std::string m_path;
+    bool m_coefficients, m_sync;
+    void* m_base;
+    std::size_t m_size, m_slotSize;
+
+    std::vector<std::uint64_t> m_staging, m_writing;  // Checkpoints (8 byte aligned)
+    std::size_t m_stagingBytes;
+    std::uint64_t m_sequence;
+    unsigned int m_nextSlot;
+
+    std::thread m_writer;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake, m_done;
+    bool m_pending, m_busy, m_stopping;
+    unsigned long long m_written, m_dropped;
+};
+
+/**
+ * @class CheckpointMirror
+ * @brief Latest checkpoint of a controller in POSIX shared memory, for a hot standby process.
+ * @details The primary publishes a checkpoint every few steps (publish(): serialization and a seqlock
+ * protected copy, no system call). The standby maps the same segment and, when it takes over, restore()
+ * copies the latest consistent checkpoint into its own controller: resuming costs a copy and a validation.
+ * The primary fails to start if the segment already exists. If it died in the middle of a publication,
+ * restore() gives up after CHECKPOINT_MIRROR_READ_SPINS checks instead of waiting for it.
+ ******/
+template <typename T>
+class CheckpointMirror
+{
+    public:
+
+    // Primary: creates the segment (it must not exist) for checkpoints of up to "capacity" bytes
+    CheckpointMirror(const std::string& name, const std::size_t capacity);
+
+    // Standby: opens the segment created by the primary
+    CheckpointMirror(const std::string& name);
+
+    CheckpointMirror(const CheckpointMirror<T>&) = delete;
+    CheckpointMirror<T>& operator=(const CheckpointMirror<T>&) = delete;
+
+    // Unmaps the segment (and unlinks it on the primary side)
+    virtual ~CheckpointMirror();
+
+    // Publish a checkpoint; false if it does not fit in the segment
+    bool publish(const StateSpaceController<T>& controller, const bool coefficients = false);
+
+    // Restore the latest checkpoint published; false if none or invalid
+    bool restore(StateSpaceController<T>& controller);
+
+    // Number of checkpoints published
+    std::uint32_t getSequence() const;
+
+    bool isOpen() const;
+    const std::string& getName() const;
+    std::size_t getCapacity() const;
+
+    protected:
+    std::string m_name;
+    bool m_owner;
+    void* m_base;
+    std::size_t m_size;
+    CheckpointMirrorHeader* m_header;
+    std::vector<std::uint64_t> m_buffer;  // Serialization / copy of a checkpoint (8 byte aligned)
+};
+
+#include "controllerCheckpoint.cpp"
+
+#endif  // CONTROLLERCHECKPOINT_H
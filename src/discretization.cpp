@@ -0,0 +1,159 @@
+/**
+ * @file discretization.cpp
+ * @brief Continuous to discrete conversion of state-space models (source).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef DISCRETIZATION_CPP
+#define DISCRETIZATION_CPP
+
+#include "discretization.h"
+
+#include <algorithm>
+
+/**
+ * @brief Identity matrix.
+ * @param n Dimension.
+ ******/
+template<typename T>
+QSMatrix<T> identityMatrix(const unsigned int n)
+{
+    QSMatrix<T> I(n, n, 0);
+
+    for (unsigned int k=0;k<n;k++)
+    {
+        I(k,k) = 1;
+    }
+
+    return I;
+}
+
+/**
+ * @brief Matrix 1-norm.
+ * @return Maximum absolute column sum.
+ ******/
+template<typename T>
+T norm1(const QSMatrix<T>& M)
+{
+    T norm = 0;
+
+    for (unsigned int col=0;col<M.get_cols();col++)
+    {
+        T sum = 0;
+        for (unsigned int row=0;row<M.get_rows();row++)
+        {
+            sum += std::fabs(M(row,col));
+        }
+        norm = std::max(norm, sum);
+    }
+
+    return norm;
+}
+
+/**
+ * @brief Matrix exponential.
+ * @details Scaling and squaring: M is scaled by 2^-s so that its 1-norm is below 0.5, the exponential
+ * of the scaled matrix is given by a [6/6] Pade approximant, then squared s times.
+ * @param M Square matrix.
+ * @return exp(M).
+ ******/
+template<typename T>
+QSMatrix<T> expm(const QSMatrix<T>& M)
+{
+    const unsigned int n = M.get_rows();
+    const int q = 6;
+
+    int s = 0;
+    T norm = norm1(M);
+    if (norm > 0.5)
+    {
+        s = (int)std::ceil(std::log2(norm / 0.5));
+    }
+
+    QSMatrix<T> X = M * (T)std::ldexp(1.0, -s);
+
+    // N = sum c_k X^k, D = sum (-1)^k c_k X^k
+    QSMatrix<T> N = identityMatrix<T>(n);
+    QSMatrix<T> D = identityMatrix<T>(n);
+    QSMatrix<T> power = identityMatrix<T>(n);
+    T c = 1;
+
+    for (int k=1;k<=q;k++)
+    {
+        c = c * (T)(q - k + 1) / (T)(k * (2*q - k + 1));
+        power = power * X;
+
+        N = N + power * c;
+        D = (k % 2 == 0) ? D + power * c : D - power * c;
+    }
+
+    QSMatrix<T> E = D.solve(N);
+
+    for (int k=0;k<s;k++)
+    {
+        E = E * E;
+    }
+
+    return E;
+}
+
+/**
+ * @brief Discretizes a continuous state-space model.
+ * @details ZOH: [Ad Bd; 0 I] = expm([Ac Bc; 0 0] * t_s), Cd = Cc, Dd = Dc.
+ *
+ * TUSTIN: with P = I - Ac*t_s/2, Ad = P^-1 (I + Ac*t_s/2), Bd = P^-1 Bc t_s, Cd = Cc P^-1,
+ * Dd = Dc + Cc P^-1 Bc t_s/2.
+ * @param Ac Continuous A matrix.
+ * @param Bc Continuous B matrix.
+ * @param Cc Continuous C matrix.
+ * @param Dc Continuous D matrix.
+ * @param t_s Time step (seconds).
+ * @param method Discretization method.
+ * @return Discrete realization.
+ ******/
+template<typename T>
+StateSpaceRealization<T> continuousToDiscrete(const QSMatrix<T>& Ac, const QSMatrix<T>& Bc, const QSMatrix<T>& Cc, const QSMatrix<T>& Dc, const float t_s, const DiscretizationMethod method)
+{
+    const unsigned int nx = Ac.get_rows();
+    const unsigned int ne = Bc.get_cols();
+    const T h = t_s;
+
+    StateSpaceRealization<T> discrete;
+
+    if (method == ZOH)
+    {
+        QSMatrix<T> M(nx + ne, nx + ne, 0);
+        for (unsigned int row=0;row<nx;row++)
+        {
+            for (unsigned int col=0;col<nx;col++) M(row,col) = Ac(row,col) * h;
+            for (unsigned int col=0;col<ne;col++) M(row,nx + col) = Bc(row,col) * h;
+        }
+
+        QSMatrix<T> E = expm(M);
+
+        discrete.A = QSMatrix<T>(nx, nx, 0);
+        discrete.B = QSMatrix<T>(nx, ne, 0);
+        for (unsigned int row=0;row<nx;row++)
+        {
+            for (unsigned int col=0;col<nx;col++) discrete.A(row,col) = E(row,col);
+            for (unsigned int col=0;col<ne;col++) discrete.B(row,col) = E(row,nx + col);
+        }
+        discrete.C = Cc;
+        discrete.D = Dc;
+    }
+    else
+    {
+        QSMatrix<T> I = identityMatrix<T>(nx);
+        QSMatrix<T> Pinv = (I - Ac * (h / 2)).inverse();
+
+        discrete.A = Pinv * (I + Ac * (h / 2));
+        discrete.B = (Pinv * Bc) * h;
+        discrete.C = Cc * Pinv;
+        discrete.D = Dc + (Cc * Pinv * Bc) * (h / 2);
+    }
+
+    return discrete;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file discretization.h
+ * @brief Continuous to discrete conversion of state-space models (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef DISCRETIZATION_H
+#define DISCRETIZATION_H
+
+#include <vector>
+#include <cmath>
+
+#include "QSMatrix.h"
+
+/**
+ * @brief Discretization methods.
+ * @details ZOH: zero-order hold (exact for piecewise constant inputs).
+ * TUSTIN: bilinear transform.
+ ******/
+enum DiscretizationMethod
+{
+    ZOH,
+    TUSTIN
+};
+
+/**
+ * @struct StateSpaceRealization
+ * @brief A, B, C, D matrices of a state-space model.
+ ******/
+template <typename T>
+struct StateSpaceRealization
+{
+    QSMatrix<T> A;
+    QSMatrix<T> B;
+    QSMatrix<T> C;
+    QSMatrix<T> D;
+};
+
+// Identity matrix
+template <typename T>
+QSMatrix<T> identityMatrix(const unsigned int n);
+
+// Matrix 1-norm (maximum absolute column sum)
+template <typename T>
+T norm1(const QSMatrix<T>& M);
+
+// Matrix exponential (scaling and squaring with a [6/6] Pade approximant)
+template <typename T>
+QSMatrix<T> expm(const QSMatrix<T>& M);
+
+// Discretization of a continuous model (Ac, Bc, Cc, Dc) with time step t_s
+template <typename T>
+StateSpaceRealization<T> continuousToDiscrete(const QSMatrix<T>& Ac, const QSMatrix<T>& Bc, const QSMatrix<T>& Cc, const QSMatrix<T>& Dc, const float t_s, const DiscretizationMethod method = ZOH);
+
+#include "discretization.cpp"
+
+#endif  // DISCRETIZATION_H
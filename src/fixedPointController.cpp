@@ -0,0 +1,692 @@
+/**
+ * @file fixedPointController.cpp
+ * @brief FixedPointStateSpaceController class source file.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef FIXEDPOINTCONTROLLER_CPP
+#define FIXEDPOINTCONTROLLER_CPP
+
+#include "fixedPointController.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Padding of the matrix rows and vectors (elements), multiple of the AVX2 register width.
+ ******/
+#define FIXED_POINT_PADDING 16
+
+/**
+ * @brief Prints the scaling and the errors of the report.
+ ******/
+inline void QuantizationReport::print() const
+{
+    std::cout << "Fractional bits: A " << fracA << ", B " << fracB << ", C " << fracC << ", D " << fracD
+    << " | e " << fracE << ", x " << fracX << ", u " << fracU << std::endl;
+    std::cout << "Max coefficient error: A " << maxErrorA << ", B " << maxErrorB << ", C " << maxErrorC << ", D " << maxErrorD
+    << " (" << zeroedCoefficients << " coefficients rounded to 0)" << std::endl;
+
+    if (steps > 0)
+    {
+        std::cout << "Versus double reference over " << steps << " steps: max |u error| " << maxOutputError
+        << ", rms u error " << rmsOutputError << ", max |x error| " << maxStateError
+        << ", saturations " << saturations << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+/**
+ * @brief Q15 dot product: exact 64-bit accumulation of 16x16-bit products (guard is always 0).
+ ******/
+inline int64_t fixedPointDot(const int16_t* row, const int16_t* vec, const unsigned int paddedLength, const int guard)
+{
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+
+    for (unsigned int k=0;k<paddedLength;k+=16)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(row + k));
+        __m256i v = _mm256_loadu_si256((const __m256i*)(vec + k));
+        __m256i p = _mm256_madd_epi16(a, v);  // 8 sums of 2 products (32 bits: both operands are within +-32767)
+
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(p)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(p, 1)));
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    int64_t acc = 0;
+
+    for (unsigned int k=0;k<paddedLength;k++)
+    {
+        acc += ((int64_t)row[k] * vec[k]) >> guard;
+    }
+
+    return acc;
+#endif
+}
+
+/**
+ * @brief Q31 dot product: 64-bit products shifted right by "guard" bits so that the sum never overflows.
+ ******/
+inline int64_t fixedPointDot(const int32_t* row, const int32_t* vec, const unsigned int paddedLength, const int guard)
+{
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    const __m256i zero = _mm256_setzero_si256();
+    const __m128i shift = _mm_cvtsi32_si128(guard);
+
+    for (unsigned int k=0;k<paddedLength;k+=4)
+    {
+        __m256i a = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(row + k)));
+        __m256i v = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(vec + k)));
+        __m256i p = _mm256_mul_epi32(a, v);
+
+        // Arithmetic shift of 64-bit lanes (not available in AVX2): ~(~p >> guard) for negative values
+        __m256i sign = _mm256_cmpgt_epi64(zero, p);
+        p = _mm256_xor_si256(_mm256_srl_epi64(_mm256_xor_si256(p, sign), shift), sign);
+
+        acc = _mm256_add_epi64(acc, p);
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    int64_t acc = 0;
+
+    for (unsigned int k=0;k<paddedLength;k++)
+    {
+        acc += ((int64_t)row[k] * vec[k]) >> guard;
+    }
+
+    return acc;
+#endif
+}
+
+/**
+ * @brief Saturating addition of two accumulators.
+ ******/
+inline int64_t fixedPointAdd(const int64_t a, const int64_t b)
+{
+    int64_t result;
+
+    if (__builtin_add_overflow(a, b, &result))
+    {
+        return (a > 0) ? std::numeric_limits<int64_t>::max() : std::numeric_limits<int64_t>::min();
+    }
+
+    return result;
+}
+
+/**
+ * @brief Constructor from a double controller.
+ * @param reference Double controller to convert (kept as reference).
+ * @param e_range Full-scale range of the error signal (|e| <= e_range).
+ * @param x_range Full-scale range of the state vector.
+ * @param u_range Full-scale range of the controller output.
+ ******/
+template<typename Q>
+FixedPointStateSpaceController<Q>::FixedPointStateSpaceController(const StateSpaceController<double>& reference, const double e_range, const double x_range, const double u_range):
+m_reference(reference), m_saturations(0)
+{
+    m_reference.reset();
+    quantizeMatrices();
+    setSignalRanges(e_range, x_range, u_range);
+}
+
+/**
+ * @brief Constructor using generated controller data file.
+ * @details See StateSpaceController::help() for the file format.
+ * @param formattedDataFilePath Path of the controller data file.
+ * @param e_range Full-scale range of the error signal (|e| <= e_range).
+ * @param x_range Full-scale range of the state vector.
+ * @param u_range Full-scale range of the controller output.
+ ******/
+template<typename Q>
+FixedPointStateSpaceController<Q>::FixedPointStateSpaceController(std::string formattedDataFilePath, const double e_range, const double x_range, const double u_range):
+m_reference(formattedDataFilePath), m_saturations(0)
+{
+    quantizeMatrices();
+    setSignalRanges(e_range, x_range, u_range);
+}
+
+/**
+ * @brief Destructor.
+ ******/
+template<typename Q>
+FixedPointStateSpaceController<Q>::~FixedPointStateSpaceController() {}
+
+/**
+ * @brief Number of fractional bits able to represent a value.
+ * @param maxAbs Largest absolute value to represent.
+ * @return Fractional bits (can be negative for values above the word range).
+ ******/
+template<typename Q>
+int FixedPointStateSpaceController<Q>::fracBitsFor(const double maxAbs)
+{
+    const int wordBits = FixedPointTraits<Q>::wordBits;
+
+    if (!(maxAbs > 0) || !std::isfinite(maxAbs))
+    {
+        return wordBits;
+    }
+
+    int intBits = (int)std::floor(std::log2(maxAbs)) + 1;  // maxAbs < 2^intBits
+
+    return std::max(-wordBits, std::min(2*wordBits, wordBits - intBits));
+}
+
+/**
+ * @brief Quantizes a matrix into a padded row-major buffer.
+ ******/
+template<typename Q>
+void FixedPointStateSpaceController<Q>::quantize(const QSMatrix<double>& M, const int frac, std::vector<Q>& packed, const unsigned int stride) const
+{
+    packed.assign(M.get_rows() * stride, 0);
+
+    for (unsigned int row=0;row<M.get_rows();row++)
+    {
+        for (unsigned int col=0;col<M.get_cols();col++)
+        {
+            packed[row*stride + col] = toFixed(M(row,col), frac);
+        }
+    }
+}
+
+/**
+ * @brief Picks the scaling of each matrix from its coefficient range and quantizes it.
+ ******/
+template<typename Q>
+void FixedPointStateSpaceController<Q>::quantizeMatrices()
+{
+    m_nx = m_reference.getNx();
+    m_ne = m_reference.getNe();
+    m_nu = m_reference.getNu();
+    m_t_s = m_reference.getTimeStep();
+    m_i = 0;
+    m_t = 0;
+
+    m_strideX = ((m_nx + FIXED_POINT_PADDING - 1) / FIXED_POINT_PADDING) * FIXED_POINT_PADDING;
+    m_strideE = ((m_ne + FIXED_POINT_PADDING - 1) / FIXED_POINT_PADDING) * FIXED_POINT_PADDING;
+
+    // Q15 products are exact on 64 bits, Q31 products need log2(n) guard bits
+    m_guardX = 0;
+    m_guardE = 0;
+    if (FixedPointTraits<Q>::wordBits > 15)
+    {
+        while ((1u << m_guardX) < m_strideX) m_guardX++;
+        while ((1u << m_guardE) < m_strideE) m_guardE++;
+    }
+
+    const QSMatrix<double>& A = m_reference.getA();
+    const QSMatrix<double>& B = m_reference.getB();
+    const QSMatrix<double>& C = m_reference.getC();
+    const QSMatrix<double>& D = m_reference.getD();
+
+    const QSMatrix<double>* matrices[4] = {&A, &B, &C, &D};
+    int* fracs[4] = {&m_fracA, &m_fracB, &m_fracC, &m_fracD};
+
+    for (int m=0;m<4;m++)
+    {
+        double maxAbs = 0;
+        for (unsigned int row=0;row<matrices[m]->get_rows();row++)
+        {
+            for (unsigned int col=0;col<matrices[m]->get_cols();col++)
+            {
+                maxAbs = std::max(maxAbs, std::fabs((*matrices[m])(row,col)));
+            }
+        }
+        *fracs[m] = fracBitsFor(maxAbs);
+    }
+
+    quantize(A, m_fracA, m_A, m_strideX);
+    quantize(B, m_fracB, m_B, m_strideE);
+    quantize(C, m_fracC, m_C, m_strideX);
+    quantize(D, m_fracD, m_D, m_strideE);
+
+    m_x_i.assign(m_strideX, 0);
+    m_x_ip1.assign(m_strideX, 0);
+    m_e_i.assign(m_strideE, 0);
+    m_u_i.assign(m_nu, 0);
+}
+
+/**
+ * @brief Sets the signal formats from their full-scale range.
+ ******/
+template<typename Q>
+void FixedPointStateSpaceController<Q>::setSignalRanges(const double e_range, const double x_range, const double u_range)
+{
+    m_fracE = fracBitsFor(e_range);
+    m_fracX = fracBitsFor(x_range);
+    m_fracU = fracBitsFor(u_range);
+}
+
+/**
+ * @brief Converts a value to fixed point (round to nearest, saturated).
+ * @param value Value to convert.
+ * @param frac Fractional bits of the format.
+ ******/
+template<typename Q>
+Q FixedPointStateSpaceController<Q>::toFixed(const double value, const int frac) const
+{
+    const double maxValue = (double)FixedPointTraits<Q>::maxValue;
+    double scaled = std::nearbyint(std::ldexp(value, frac));
+
+    if (scaled > maxValue) return (Q)FixedPointTraits<Q>::maxValue;
+    if (scaled < -maxValue) return (Q)(-FixedPointTraits<Q>::maxValue);
+
+    return (Q)scaled;
+}
+
+/**
+ * @brief Converts a fixed-point value to double.
+ * @param value Fixed-point value.
+ * @param frac Fractional bits of the format.
+ ******/
+template<typename Q>
+double FixedPointStateSpaceController<Q>::toDouble(const int64_t value, const int frac) const
+{
+    return std::ldexp((double)value, -frac);
+}
+
+/**
+ * @brief Rescales an accumulator (round to nearest when bits are dropped, saturated otherwise).
+ ******/
+template<typename Q>
+int64_t FixedPointStateSpaceController<Q>::rescale(const int64_t value, const int fromFrac, const int toFrac)
+{
+    int shift = fromFrac - toFrac;
+
+    if (shift > 0)
+    {
+        if (shift > 62) return 0;
+        return fixedPointAdd(value, (int64_t)1 << (shift - 1)) >> shift;
+    }
+    if (shift < 0)
+    {
+        shift = -shift;
+        if (value == 0) return 0;
+        if (shift > 62 || std::llabs(value) > (std::numeric_limits<int64_t>::max() >> shift))
+        {
+            return (value > 0) ? std::numeric_limits<int64_t>::max() : std::numeric_limits<int64_t>::min();
+        }
+        return value * ((int64_t)1 << shift);
+    }
+
+    return value;
+}
+
+/**
+ * @brief Saturates an accumulator to the (symmetric) word range and counts saturations.
+ ******/
+template<typename Q>
+Q FixedPointStateSpaceController<Q>::saturate(const int64_t value)
+{
+    if (value > FixedPointTraits<Q>::maxValue)
+    {
+        m_saturations++;
+        return (Q)FixedPointTraits<Q>::maxValue;
+    }
+    if (value < -FixedPointTraits<Q>::maxValue)
+    {
+        m_saturations++;
+        return (Q)(-FixedPointTraits<Q>::maxValue);
+    }
+
+    return (Q)value;
+}
+
+/**
+ * @brief Dot product of two padded rows.
+ ******/
+template<typename Q>
+int64_t FixedPointStateSpaceController<Q>::dot(const Q* row, const Q* vec, const unsigned int paddedLength, const int guard)
+{
+    return fixedPointDot(row, vec, paddedLength, guard);
+}
+
+/**
+ * @brief Computes the controller output in fixed point and increments time.
+ * @details The errors are saturated to the symmetric range (-32768 in Q15 becomes -32767), so that a pair
+ * of products always fits in 32 bits in the AVX2 kernel.
+ * @param e_i Current error vector, in the error format (see QuantizationReport::fracE).
+ * @return Controller output vector, in the output format (see QuantizationReport::fracU); the previous
+ * output, without step, if e_i has less than ne values.
+ ******/
+template<typename Q>
+const std::vector<Q>& FixedPointStateSpaceController<Q>::currentOutputRaw(const std::vector<Q>& e_i)
+{
+    if (e_i.size() < m_ne)
+    {
+        std::cout << "\033[1;31mERROR: Error vector must have ne = " << m_ne << " values\033[0m" << std::endl;
+        return m_u_i;
+    }
+
+    for (unsigned int k=0;k<m_ne;k++)
+    {
+        m_e_i[k] = (Q)std::max<int64_t>(-FixedPointTraits<Q>::maxValue, e_i[k]);
+    }
+
+    const int fracCx = m_fracC + m_fracX - m_guardX;
+    const int fracDe = m_fracD + m_fracE - m_guardE;
+    const int fracAx = m_fracA + m_fracX - m_guardX;
+    const int fracBe = m_fracB + m_fracE - m_guardE;
+
+    // u_i = C*x_i + D*e_i
+    for (unsigned int row=0;row<m_nu;row++)
+    {
+        int64_t cx = rescale(dot(&m_C[row*m_strideX], m_x_i.data(), m_strideX, m_guardX), fracCx, m_fracU);
+        int64_t de = rescale(dot(&m_D[row*m_strideE], m_e_i.data(), m_strideE, m_guardE), fracDe, m_fracU);
+        m_u_i[row] = saturate(fixedPointAdd(cx, de));
+    }
+
+    // x_{i+1} = A*x_i + B*e_i
+    for (unsigned int row=0;row<m_nx;row++)
+    {
+        int64_t ax = rescale(dot(&m_A[row*m_strideX], m_x_i.data(), m_strideX, m_guardX), fracAx, m_fracX);
+        int64_t be = rescale(dot(&m_B[row*m_strideE], m_e_i.data(), m_strideE, m_guardE), fracBe, m_fracX);
+        m_x_ip1[row] = saturate(fixedPointAdd(ax, be));
+    }
+    m_x_i.swap(m_x_ip1);
+
+    m_t = m_i * m_t_s;
+    m_i++;
+
+    return m_u_i;
+}
+
+/**
+ * @brief Computes the current controller output with the error vector and increments time.
+ * @param e_i Current error vector.
+ * @return Controller output vector (the previous one, without step, if e_i has less than ne values).
+ ******/
+template<typename Q>
+std::vector<double> FixedPointStateSpaceController<Q>::currentOutput(const std::vector<double>& e_i)
+{
+    if (e_i.size() < m_ne)
+    {
+        std::cout << "\033[1;31mERROR: Error vector must have ne = " << m_ne << " values\033[0m" << std::endl;
+    }
+    else
+    {
+        std::vector<Q> e_q(m_ne, 0);
+        for (unsigned int k=0;k<m_ne;k++)
+        {
+            e_q[k] = toFixed(e_i[k], m_fracE);
+        }
+
+        currentOutputRaw(e_q);
+    }
+
+    std::vector<double> u_i(m_nu, 0);
+    for (unsigned int k=0;k<m_nu;k++)
+    {
+        u_i[k] = toDouble(m_u_i[k], m_fracU);
+    }
+
+    return u_i;
+}
+
+/**
+ * @brief Computes the current controller output with the error vector, applies a saturation and increments time.
+ * @param e_i Current error vector.
+ * @param u_min Bottom saturation value.
+ * @param u_max Top saturation value.
+ * @return Controller output vector.
+ ******/
+template<typename Q>
+std::vector<double> FixedPointStateSpaceController<Q>::currentOutput(const std::vector<double>& e_i, const double& u_min, const double& u_max)
+{
+    std::vector<double> u_i = currentOutput(e_i);
+
+    for (unsigned int k=0;k<m_nu;k++)
+    {
+        u_i[k] = std::min(u_max, std::max(u_min, u_i[k]));
+    }
+
+    return u_i;
+}
+
+/**
+ * @brief Computes the current controller output with the reference vector and the plant output vector and increments time.
+ * @param r_i Current reference vector.
+ * @param y_i Current plant output vector.
+ * @return Controller output vector.
+ ******/
+template<typename Q>
+std::vector<double> FixedPointStateSpaceController<Q>::currentOutput(const std::vector<double>& r_i, const std::vector<double>& y_i)
+{
+    return currentOutput(QSMatrix<double>::vectorSubstract(r_i, y_i));
+}
+
+/**
+ * @brief Chooses the signal scaling from the peaks reached by the double reference.
+ * @details The reference is run from a zero state on e_sequence, then e, x and u ranges are set to
+ * headroom times the observed peaks. The controller is reset.
+ * @param e_sequence Representative error sequence (one error vector per step).
+ * @param headroom Margin applied on the observed peaks.
+ ******/
+template<typename Q>
+void FixedPointStateSpaceController<Q>::calibrate(const std::vector<std::vector<double> >& e_sequence, const double headroom)
+{
+    StateSpaceController<double> reference(m_reference);
+    reference.reset();
+
+    double e_peak = 0, x_peak = 0, u_peak = 0;
+
+    for (unsigned int step=0;step<e_sequence.size();step++)
+    {
+        std::vector<double> u_i = reference.currentOutput(e_sequence[step]);
+        std::vector<double> x_i = reference.getX_i();
+
+        for (unsigned int k=0;k<m_ne;k++) e_peak = std::max(e_peak, std::fabs(e_sequence[step][k]));
+        for (unsigned int k=0;k<m_nx;k++) x_peak = std::max(x_peak, std::fabs(x_i[k]));
+        for (unsigned int k=0;k<m_nu;k++) u_peak = std::max(u_peak, std::fabs(u_i[k]));
+    }
+
+    setSignalRanges(headroom * e_peak, headroom * x_peak, headroom * u_peak);
+    reset();
+}
+
+/**
+ * @brief Gives the scaling of the controller and the coefficient rounding errors.
+ * @return Quantization report (output errors are not filled, see compareWithReference()).
+ ******/
+template<typename Q>
+QuantizationReport FixedPointStateSpaceController<Q>::quantizationReport() const
+{
+    QuantizationReport report = QuantizationReport();
+
+    report.fracA = m_fracA;
+    report.fracB = m_fracB;
+    report.fracC = m_fracC;
+    report.fracD = m_fracD;
+    report.fracE = m_fracE;
+    report.fracX = m_fracX;
+    report.fracU = m_fracU;
+
+    const QSMatrix<double>& A = m_reference.getA();
+    const QSMatrix<double>& B = m_reference.getB();
+    const QSMatrix<double>& C = m_reference.getC();
+    const QSMatrix<double>& D = m_reference.getD();
+
+    const QSMatrix<double>* matrices[4] = {&A, &B, &C, &D};
+    const std::vector<Q>* packed[4] = {&m_A, &m_B, &m_C, &m_D};
+    const int fracs[4] = {m_fracA, m_fracB, m_fracC, m_fracD};
+    const unsigned int strides[4] = {m_strideX, m_strideE, m_strideX, m_strideE};
+    double* errors[4] = {&report.maxErrorA, &report.maxErrorB, &report.maxErrorC, &report.maxErrorD};
+
+    for (int m=0;m<4;m++)
+    {
+        for (unsigned int row=0;row<matrices[m]->get_rows();row++)
+        {
+            for (unsigned int col=0;col<matrices[m]->get_cols();col++)
+            {
+                double value = (*matrices[m])(row,col);
+                Q quantized = (*packed[m])[row*strides[m] + col];
+
+                *errors[m] = std::max(*errors[m], std::fabs(value - toDouble(quantized, fracs[m])));
+
+                if (value != 0 && quantized == 0)
+                {
+                    report.zeroedCoefficients++;
+                }
+            }
+        }
+    }
+
+    return report;
+}
+
+/**
+ * @brief Measures the error introduced versus the double reference.
+ * @details Both controllers are reset then run on e_sequence. The controller is reset at the end.
+ * @param e_sequence Error sequence (one error vector per step).
+ * @return Quantization report including output and state errors.
+ ******/
+template<typename Q>
+QuantizationReport FixedPointStateSpaceController<Q>::compareWithReference(const std::vector<std::vector<double> >& e_sequence)
+{
+    StateSpaceController<double> reference(m_reference);
+    reference.reset();
+    reset();
+
+    QuantizationReport report = quantizationReport();
+    double sumSquares = 0;
+
+    for (unsigned int step=0;step<e_sequence.size();step++)
+    {
+        std::vector<double> u_ref = reference.currentOutput(e_sequence[step]);
+        std::vector<double> u_q = currentOutput(e_sequence[step]);
+
+        for (unsigned int k=0;k<m_nu;k++)
+        {
+            double error = std::fabs(u_ref[k] - u_q[k]);
+            report.maxOutputError = std::max(report.maxOutputError, error);
+            sumSquares += error * error;
+        }
+
+        std::vector<double> x_ref = reference.getX_i();
+        std::vector<double> x_q = getX_i();
+        for (unsigned int k=0;k<m_nx;k++)
+        {
+            report.maxStateError = std::max(report.maxStateError, std::fabs(x_ref[k] - x_q[k]));
+        }
+    }
+
+    report.steps = e_sequence.size();
+    report.rmsOutputError = (report.steps > 0 && m_nu > 0) ? std::sqrt(sumSquares / (report.steps * m_nu)) : 0;
+    report.saturations = m_saturations;
+
+    reset();
+
+    return report;
+}
+
+/**
+ * @return Current state vector (converted to double).
+ ******/
+template<typename Q>
+std::vector<double> FixedPointStateSpaceController<Q>::getX_i() const
+{
+    std::vector<double> x_i(m_nx, 0);
+
+    for (unsigned int k=0;k<m_nx;k++)
+    {
+        x_i[k] = toDouble(m_x_i[k], m_fracX);
+    }
+
+    return x_i;
+}
+
+/**
+ * @return Double controller used as reference.
+ ******/
+template<typename Q>
+const StateSpaceController<double>& FixedPointStateSpaceController<Q>::getReference() const
+{
+    return m_reference;
+}
+
+/**
+ * @return Controller time step (seconds).
+ ******/
+template<typename Q>
+float FixedPointStateSpaceController<Q>::getTimeStep() const
+{
+    return m_t_s;
+}
+
+/**
+ * @return Current time (seconds).
+ ******/
+template<typename Q>
+float FixedPointStateSpaceController<Q>::getTime() const
+{
+    return m_t;
+}
+
+/**
+ * @return State vector dimension.
+ ******/
+template<typename Q>
+unsigned int FixedPointStateSpaceController<Q>::getNx() const
+{
+    return m_nx;
+}
+
+/**
+ * @return Error vector dimension.
+ ******/
+template<typename Q>
+unsigned int FixedPointStateSpaceController<Q>::getNe() const
+{
+    return m_ne;
+}
+
+/**
+ * @return Controller output vector dimension.
+ ******/
+template<typename Q>
+unsigned int FixedPointStateSpaceController<Q>::getNu() const
+{
+    return m_nu;
+}
+
+/**
+ * @return Number of saturated results since the last reset.
+ ******/
+template<typename Q>
+unsigned int FixedPointStateSpaceController<Q>::getSaturations() const
+{
+    return m_saturations;
+}
+
+/**
+ * @brief Resets time, state vector and saturation counter.
+ ******/
+template<typename Q>
+void FixedPointStateSpaceController<Q>::reset()
+{
+    std::fill(m_x_i.begin(), m_x_i.end(), 0);
+    std::fill(m_x_ip1.begin(), m_x_ip1.end(), 0);
+    std::fill(m_e_i.begin(), m_e_i.end(), 0);
+    std::fill(m_u_i.begin(), m_u_i.end(), 0);
+
+    m_saturations = 0;
+    m_i = 0;
+    m_t = 0;
+}
+
+#endif
@@ -0,0 +1,211 @@
+/**
+ * @file fixedPointController.h
+ * @brief FixedPointStateSpaceController class header.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef FIXEDPOINTCONTROLLER_H
+#define FIXEDPOINTCONTROLLER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+
+/**
+ * @struct FixedPointTraits
+ * @brief Word size of the supported fixed-point formats (Q15 on int16_t, Q31 on int32_t).
+ ******/
+template <typename Q>
+struct FixedPointTraits;
+
+template <>
+struct FixedPointTraits<int16_t>
+{
+    static constexpr int wordBits = 15;
+    static constexpr int64_t maxValue = 32767;
+};
+
+template <>
+struct FixedPointTraits<int32_t>
+{
+    static constexpr int wordBits = 31;
+    static constexpr int64_t maxValue = 2147483647LL;
+};
+
+/**
+ * @struct QuantizationReport
+ * @brief Scaling chosen by a FixedPointStateSpaceController and error introduced versus the double reference.
+ * @details frac* members are the number of fractional bits of each matrix / signal (value = raw * 2^-frac).
+ * Output and state errors are only filled by FixedPointStateSpaceController::compareWithReference().
+ ******/
+struct QuantizationReport
+{
+    int fracA, fracB, fracC, fracD;
+    int fracE, fracX, fracU;
+
+    double maxErrorA, maxErrorB, maxErrorC, maxErrorD; // Largest coefficient rounding error
+    unsigned int zeroedCoefficients;                    // Non-zero reference coefficients rounded to 0
+
+    unsigned int steps;
+    double maxOutputError;
+    double rmsOutputError;
+    double maxStateError;
+    unsigned int saturations;                           // Saturated results during the comparison
+
+    void print() const;
+};
+
+/**
+ * @class FixedPointStateSpaceController
+ * @brief Fixed-point (Q15 / Q31) version of StateSpaceController.
+ * @details Built from a double StateSpaceController (the reference).
+ *
+ * Each matrix gets its own scaling at load time: the number of fractional bits is the largest one
+ * that still represents the biggest coefficient of the matrix. Signals (e, x, u) use the ranges given
+ * by the user (or measured with calibrate()).
+ *
+ * Each step is a saturating multiply-accumulate: products are accumulated on 64 bits with enough guard
+ * bits to never overflow, then rescaled with rounding and saturated to the word size.
+ * Rows are zero-padded so that the AVX2 integer kernels (compiled when __AVX2__ is defined) have no tail.
+ *
+ * quantizationReport() and compareWithReference() give the error introduced versus the double reference.
+ ******/
+template <typename Q>
+class FixedPointStateSpaceController
+{
+    public:
+
+    // Constructor from a double controller, with the full-scale range of e, x and u
+    FixedPointStateSpaceController(const StateSpaceController<double>& reference, const double e_range, const double x_range, const double u_range);
+
+    // Constructor from controller.dat (see StateSpaceController::help())
+    FixedPointStateSpaceController(std::string formattedDataFilePath, const double e_range, const double x_range, const double u_range);
+
+    virtual ~FixedPointStateSpaceController();
+
+    // Same interface as StateSpaceController (values are converted to/from fixed point)
+    std::vector<double> currentOutput(const std::vector<double>& e_i);
+    std::vector<double> currentOutput(const std::vector<double>& e_i, const double& u_min, const double& u_max);
+    std::vector<double> currentOutput(const std::vector<double>& r_i, const std::vector<double>& y_i);
+
+    // Raw fixed-point step: e_i must be in the error format (fracE), u is returned in the output format (fracU)
+    const std::vector<Q>& currentOutputRaw(const std::vector<Q>& e_i);
+
+    // Choose the signal scaling from the peaks reached by the reference on an error sequence
+    void calibrate(const std::vector<std::vector<double> >& e_sequence, const double headroom = 2);
+
+    // Scaling and coefficient errors
+    QuantizationReport quantizationReport() const;
+
+    // Run the same error sequence through this controller and the reference, from a zero state
+    QuantizationReport compareWithReference(const std::vector<std::vector<double> >& e_sequence);
+
+    // Conversions between double and the formats used by this controller
+    Q toFixed(const double value, const int frac) const;
+    double toDouble(const int64_t value, const int frac) const;
+
+    // Current state vector (converted to double)
+    std::vector<double> getX_i() const;
+
+    const StateSpaceController<double>& getReference() const;
+
+    float getTimeStep() const;
+    float getTime() const;
+    unsigned int getNx() const;
+    unsigned int getNe() const;
+    unsigned int getNu() const;
+
+    // Number of saturated results since the last reset
+    unsigned int getSaturations() const;
+
+    // Reset time and states (to zero)
+    void reset();
+
+    protected:
+    // Quantize the reference matrices (per-matrix scaling) and allocate the padded buffers
+    void quantizeMatrices();
+
+    // Signal formats from their full-scale range
+    void setSignalRanges(const double e_range, const double x_range, const double u_range);
+
+    // Number of fractional bits able to represent maxAbs
+    static int fracBitsFor(const double maxAbs);
+
+    // Dot product of two padded rows, each product shifted right by "guard" bits
+    static int64_t dot(const Q* row, const Q* vec, const unsigned int paddedLength, const int guard);
+
+    // Rescale an accumulator from one format to another (round to nearest)
+    static int64_t rescale(const int64_t value, const int fromFrac, const int toFrac);
+
+    // Saturate to the word size
+    Q saturate(const int64_t value);
+
+    // Quantize a matrix into a padded row-major buffer
+    void quantize(const QSMatrix<double>& M, const int frac, std::vector<Q>& packed, const unsigned int stride) const;
+
+    /**
+     * @brief Double controller used as reference (scaling and error analysis).
+     ******/
+    StateSpaceController<double> m_reference;
+
+    /**
+     * @brief Quantized matrices, row-major with padded rows.
+     ******/
+    std::vector<Q> m_A, m_B, m_C, m_D;
+
+    /**
+     * @brief Row strides (padded state and error dimensions).
+     ******/
+    unsigned int m_strideX, m_strideE;
+
+    /**
+     * @brief Fractional bits of each matrix.
+     ******/
+    int m_fracA, m_fracB, m_fracC, m_fracD;
+
+    /**
+     * @brief Fractional bits of the error, state and output signals.
+     ******/
+    int m_fracE, m_fracX, m_fracU;
+
+    /**
+     * @brief Guard bits of the state (nx products) and error (ne products) accumulations.
+     ******/
+    int m_guardX, m_guardE;
+
+    unsigned int m_nx, m_ne, m_nu;
+
+    float m_t_s;
+    unsigned int m_i;
+    float m_t;
+
+    /**
+     * @brief Number of saturated results since the last reset.
+     ******/
+    unsigned int m_saturations;
+
+    /**
+     * @brief Current and next state, error and output vectors (fixed point, padded).
+     ******/
+    std::vector<Q> m_x_i, m_x_ip1, m_e_i, m_u_i;
+};
+
+/**
+ * @brief Q15 controller (16-bit words).
+ ******/
+typedef FixedPointStateSpaceController<int16_t> Q15StateSpaceController;
+
+/**
+ * @brief Q31 controller (32-bit words).
+ ******/
+typedef FixedPointStateSpaceController<int32_t> Q31StateSpaceController;
+
+#include "fixedPointController.cpp"
+
+#endif  // FIXEDPOINTCONTROLLER_H
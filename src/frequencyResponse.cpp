@@ -0,0 +1,286 @@
+/**
+ * @file frequencyResponse.cpp
+ * @brief FrequencyResponse class source file.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef FREQUENCYRESPONSE_CPP
+#define FREQUENCYRESPONSE_CPP
+
+#include "frequencyResponse.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+/**
+ * @brief Constructor: Hessenberg reduction of A by Householder reflections.
+ * @param controller Controller to analyse.
+ ******/
+template<typename T>
+FrequencyResponse<T>::FrequencyResponse(const StateSpaceController<T>& controller):
+m_H(controller.getA()), m_t_s(controller.getTimeStep()), m_nx(controller.getNx()), m_ne(controller.getNe()), m_nu(controller.getNu())
+{
+    const unsigned int n = m_nx;
+
+    m_Q = QSMatrix<T>(n, n, 0);
+    for (unsigned int k=0;k<n;k++)
+    {
+        m_Q(k,k) = 1;
+    }
+
+    std::vector<T> v(n, 0);
+
+    for (unsigned int k=0;k+2<n;k++)
+    {
+        // Reflection v zeroing H(k+2:n, k)
+        T norm = 0;
+        for (unsigned int i=k+1;i<n;i++)
+        {
+            norm += m_H(i,k) * m_H(i,k);
+        }
+        norm = std::sqrt(norm);
+        if (norm == 0) continue;
+
+        T alpha = (m_H(k+1,k) > 0) ? -norm : norm;
+
+        T vNorm = 0;
+        for (unsigned int i=k+1;i<n;i++)
+        {
+            v[i] = m_H(i,k);
+        }
+        v[k+1] -= alpha;
+        for (unsigned int i=k+1;i<n;i++)
+        {
+            vNorm += v[i] * v[i];
+        }
+        vNorm = std::sqrt(vNorm);
+        if (vNorm == 0) continue;
+        for (unsigned int i=k+1;i<n;i++)
+        {
+            v[i] /= vNorm;
+        }
+
+        // H = (I - 2vv') H
+        for (unsigned int j=k;j<n;j++)
+        {
+            T s = 0;
+            for (unsigned int i=k+1;i<n;i++) s += v[i] * m_H(i,j);
+            for (unsigned int i=k+1;i<n;i++) m_H(i,j) -= 2 * s * v[i];
+        }
+
+        // H = H (I - 2vv'), Q = Q (I - 2vv')
+        for (unsigned int i=0;i<n;i++)
+        {
+            T s = 0, q = 0;
+            for (unsigned int j=k+1;j<n;j++)
+            {
+                s += m_H(i,j) * v[j];
+                q += m_Q(i,j) * v[j];
+            }
+            for (unsigned int j=k+1;j<n;j++)
+            {
+                m_H(i,j) -= 2 * s * v[j];
+                m_Q(i,j) -= 2 * q * v[j];
+            }
+        }
+
+        for (unsigned int i=k+2;i<n;i++)
+        {
+            m_H(i,k) = 0;
+        }
+    }
+
+    m_B = m_Q.transpose() * controller.getB();
+    m_C = controller.getC() * m_Q;
+    m_D = controller.getD();
+}
+
+/**
+ * @brief Destructor.
+ ******/
+template<typename T>
+FrequencyResponse<T>::~FrequencyResponse() {}
+
+/**
+ * @brief Gain at z = exp(j*w*t_s).
+ * @details Solves (zI - H)*X = Q'*B by Gaussian elimination with partial pivoting restricted to the
+ * subdiagonal (O(nx^2) per column), then G = C*Q*X + D.
+ ******/
+template<typename T>
+void FrequencyResponse<T>::evaluateAt(const T w, QSMatrix<std::complex<T> >& G) const
+{
+    typedef std::complex<T> complex;
+
+    const unsigned int n = m_nx;
+    const complex z = std::polar((T)1, w * (T)m_t_s);
+
+    std::vector<complex> M(n * n);
+    std::vector<complex> X(n * m_ne);
+
+    for (unsigned int i=0;i<n;i++)
+    {
+        for (unsigned int j=(i > 0 ? i-1 : 0);j<n;j++)
+        {
+            M[i*n + j] = -m_H(i,j);
+        }
+        M[i*n + i] += z;
+
+        for (unsigned int c=0;c<m_ne;c++)
+        {
+            X[i*m_ne + c] = m_B(i,c);
+        }
+    }
+
+    // Elimination of the subdiagonal
+    for (unsigned int k=0;k+1<n;k++)
+    {
+        if (std::abs(M[(k+1)*n + k]) > std::abs(M[k*n + k]))
+        {
+            for (unsigned int j=k;j<n;j++) std::swap(M[k*n + j], M[(k+1)*n + j]);
+            for (unsigned int c=0;c<m_ne;c++) std::swap(X[k*m_ne + c], X[(k+1)*m_ne + c]);
+        }
+
+        complex factor = M[(k+1)*n + k] / M[k*n + k];
+        if (factor == complex(0)) continue;
+
+        for (unsigned int j=k+1;j<n;j++) M[(k+1)*n + j] -= factor * M[k*n + j];
+        for (unsigned int c=0;c<m_ne;c++) X[(k+1)*m_ne + c] -= factor * X[k*m_ne + c];
+    }
+
+    // Back substitution
+    for (int i=(int)n-1;i>=0;i--)
+    {
+        for (unsigned int c=0;c<m_ne;c++)
+        {
+            complex sum = X[i*m_ne + c];
+            for (unsigned int j=i+1;j<n;j++)
+            {
+                sum -= M[i*n + j] * X[j*m_ne + c];
+            }
+            X[i*m_ne + c] = sum / M[i*n + i];
+        }
+    }
+
+    // G = C*Q*X + D
+    for (unsigned int row=0;row<m_nu;row++)
+    {
+        for (unsigned int c=0;c<m_ne;c++)
+        {
+            complex sum = m_D(row,c);
+            for (unsigned int k=0;k<n;k++)
+            {
+                sum += m_C(row,k) * X[k*m_ne + c];
+            }
+            G(row,c) = sum;
+        }
+    }
+}
+
+/**
+ * @brief Complex gain matrix at an angular frequency.
+ * @param w Angular frequency (rad/s).
+ * @return Gain matrix (nu x ne).
+ ******/
+template<typename T>
+QSMatrix<std::complex<T> > FrequencyResponse<T>::evaluate(const T w) const
+{
+    QSMatrix<std::complex<T> > G(m_nu, m_ne, std::complex<T>(0));
+
+    evaluateAt(w, G);
+
+    return G;
+}
+
+/**
+ * @brief Complex gain matrices at several angular frequencies.
+ * @details Frequencies are split in contiguous blocks evaluated by separate threads.
+ * @param w Angular frequencies (rad/s).
+ * @param threads Number of threads (0: hardware concurrency).
+ * @return Gain matrices (nu x ne), one per frequency.
+ ******/
+template<typename T>
+std::vector<QSMatrix<std::complex<T> > > FrequencyResponse<T>::evaluate(const std::vector<T>& w, unsigned int threads) const
+{
+    std::vector<QSMatrix<std::complex<T> > > G(w.size(), QSMatrix<std::complex<T> >(m_nu, m_ne, std::complex<T>(0)));
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max(1u, std::min(threads, (unsigned int)w.size()));
+
+    const unsigned int block = (w.size() + threads - 1) / std::max(1u, threads);
+    std::vector<std::thread> workers;
+
+    for (unsigned int t=1;t<threads;t++)
+    {
+        workers.push_back(std::thread([this, &w, &G, t, block]() {
+            for (unsigned int k=t*block;k<std::min((unsigned int)w.size(), (t+1)*block);k++)
+            {
+                evaluateAt(w[k], G[k]);
+            }
+        }));
+    }
+
+    for (unsigned int k=0;k<std::min((unsigned int)w.size(), block);k++)
+    {
+        evaluateAt(w[k], G[k]);
+    }
+
+    for (unsigned int t=0;t<workers.size();t++)
+    {
+        workers[t].join();
+    }
+
+    return G;
+}
+
+/**
+ * @brief Logarithmically spaced angular frequencies.
+ * @param w_min First angular frequency (rad/s, > 0).
+ * @param w_max Last angular frequency (rad/s).
+ * @param n Number of frequencies.
+ ******/
+template<typename T>
+std::vector<T> FrequencyResponse<T>::logspace(const T w_min, const T w_max, const unsigned int n)
+{
+    std::vector<T> w(n, w_min);
+
+    for (unsigned int k=1;k<n;k++)
+    {
+        w[k] = w_min * std::pow(w_max / w_min, (T)k / (T)(n - 1));
+    }
+
+    return w;
+}
+
+/**
+ * @return Nyquist angular frequency pi/t_s (rad/s).
+ ******/
+template<typename T>
+T FrequencyResponse<T>::getNyquistFrequency() const
+{
+    return (T)M_PI / (T)m_t_s;
+}
+
+/**
+ * @return Hessenberg form of A.
+ ******/
+template<typename T>
+QSMatrix<T> FrequencyResponse<T>::getHessenberg() const
+{
+    return m_H;
+}
+
+/**
+ * @return Orthogonal transformation Q (A = Q*H*Q').
+ ******/
+template<typename T>
+QSMatrix<T> FrequencyResponse<T>::getQ() const
+{
+    return m_Q;
+}
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file frequencyResponse.h
+ * @brief FrequencyResponse class header.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef FREQUENCYRESPONSE_H
+#define FREQUENCYRESPONSE_H
+
+#include <iostream>
+#include <vector>
+#include <complex>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+
+/**
+ * @class FrequencyResponse
+ * @brief Frequency response G(z) = C*(zI - A)^-1*B + D of a StateSpaceController, with z = exp(j*w*t_s).
+ * @details A is reduced once to the Hessenberg form H = Q'*A*Q (Householder reflections) when the object is
+ * built. Each frequency then only needs the solution of a Hessenberg system, O(nx^2) per error input.
+ *
+ * evaluate() on a frequency vector spreads the frequencies over several threads.
+ ******/
+template <typename T>
+class FrequencyResponse
+{
+    public:
+
+    // Hessenberg reduction of the controller (copied)
+    FrequencyResponse(const StateSpaceController<T>& controller);
+
+    virtual ~FrequencyResponse();
+
+    // Complex gain matrix (nu x ne) at the angular frequency w (rad/s)
+    QSMatrix<std::complex<T> > evaluate(const T w) const;
+
+    // Complex gain matrices at several angular frequencies (threads = 0: hardware concurrency)
+    std::vector<QSMatrix<std::complex<T> > > evaluate(const std::vector<T>& w, unsigned int threads = 0) const;
+
+    // n logarithmically spaced angular frequencies from w_min to w_max (rad/s)
+    static std::vector<T> logspace(const T w_min, const T w_max, const unsigned int n);
+
+    // Nyquist angular frequency pi/t_s (rad/s)
+    T getNyquistFrequency() const;
+
+    // Hessenberg form of A and orthogonal transformation (A = Q*H*Q')
+    QSMatrix<T> getHessenberg() const;
+    QSMatrix<T> getQ() const;
+
+    protected:
+    // Gain at z = exp(j*w*t_s), written in G (nu x ne)
+    void evaluateAt(const T w, QSMatrix<std::complex<T> >& G) const;
+
+    /**
+     * @brief Hessenberg form of A.
+     ******/
+    QSMatrix<T> m_H;
+
+    /**
+     * @brief Orthogonal transformation (A = Q*H*Q').
+     ******/
+    QSMatrix<T> m_Q;
+
+    /**
+     * @brief Q'*B, C*Q and D.
+     ******/
+    QSMatrix<T> m_B, m_C, m_D;
+
+    float m_t_s;
+    unsigned int m_nx, m_ne, m_nu;
+};
+
+#include "frequencyResponse.cpp"
+
+#endif  // FREQUENCYRESPONSE_H
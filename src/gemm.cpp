@@ -0,0 +1,389 @@
+/**
+ * @file gemm.cpp
+ * @brief Packed, cache-blocked matrix product (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef GEMM_CPP
+#define GEMM_CPP
+
+#include "gemm.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Cache blocking: rows of A (multiple of every MR), depth, and columns of B (multiple of every NR)
+ * of the packed blocks. A KC x NC panel of B stays in L2/L3, an MC x KC block of A in L2.
+ ******/
+#define GEMM_MC 96
+#define GEMM_KC 256
+#define GEMM_NC 1024
+
+/**
+ * @brief Products with fewer multiply-adds use a plain loop (packing is not worth it).
+ ******/
+#define GEMM_SMALL_WORK 8192
+
+/**
+ * @brief Minimum multiply-adds per thread.
+ ******/
+#define GEMM_THREAD_WORK (1u << 20)
+
+/**
+ * @brief Generic micro-kernel.
+ ******/
+template<typename T>
+void GemmKernel<T>::multiply(const unsigned int kc, const T* Ap, const T* Bp, T* C, const unsigned int ldc)
+{
+    T acc[MR * NR];
+    for (unsigned int i=0;i<MR*NR;i++) acc[i] = T(0);
+
+    for (unsigned int p=0;p<kc;p++)
+    {
+        for (unsigned int i=0;i<MR;i++)
+        {
+            const T a = Ap[i];
+            for (unsigned int j=0;j<NR;j++)
+            {
+                acc[i*NR + j] += a * Bp[j];
+            }
+        }
+        Ap += MR;
+        Bp += NR;
+    }
+
+    for (unsigned int i=0;i<MR;i++)
+    {
+        for (unsigned int j=0;j<NR;j++)
+        {
+            C[i*ldc + j] += acc[i*NR + j];
+        }
+    }
+}
+
+#if defined(__AVX512F__)
+
+/**
+ * @brief AVX-512 double micro-kernel (4 x 16, 8 accumulators).
+ ******/
+template<>
+struct GemmKernel<double>
+{
+    enum { MR = 4, NR = 16 };
+
+    static void multiply(const unsigned int kc, const double* Ap, const double* Bp, double* C, const unsigned int ldc)
+    {
+        __m512d c[MR][2];
+        for (unsigned int i=0;i<MR;i++) c[i][0] = c[i][1] = _mm512_setzero_pd();
+
+        for (unsigned int p=0;p<kc;p++)
+        {
+            const __m512d b0 = _mm512_loadu_pd(Bp);
+            const __m512d b1 = _mm512_loadu_pd(Bp + 8);
+            for (unsigned int i=0;i<MR;i++)
+            {
+                const __m512d a = _mm512_set1_pd(Ap[i]);
+                c[i][0] = _mm512_fmadd_pd(a, b0, c[i][0]);
+                c[i][1] = _mm512_fmadd_pd(a, b1, c[i][1]);
+            }
+            Ap += MR;
+            Bp += NR;
+        }
+
+        for (unsigned int i=0;i<MR;i++)
+        {
+            _mm512_storeu_pd(C + i*ldc, _mm512_add_pd(_mm512_loadu_pd(C + i*ldc), c[i][0]));
+            _mm512_storeu_pd(C + i*ldc + 8, _mm512_add_pd(_mm512_loadu_pd(C + i*ldc + 8), c[i][1]));
+        }
+    }
+};
+
+/**
+ * @brief AVX-512 float micro-kernel (4 x 32, 8 accumulators).
+ ******/
+template<>
+struct GemmKernel<float>
+{
+    enum { MR = 4, NR = 32 };
+
+    static void multiply(const unsigned int kc, const float* Ap, const float* Bp, float* C, const unsigned int ldc)
+    {
+        __m512 c[MR][2];
+        for (unsigned int i=0;i<MR;i++) c[i][0] = c[i][1] = _mm512_setzero_ps();
+
+        for (unsigned int p=0;p<kc;p++)
+        {
+            const __m512 b0 = _mm512_loadu_ps(Bp);
+            const __m512 b1 = _mm512_loadu_ps(Bp + 16);
+            for (unsigned int i=0;i<MR;i++)
+            {
+                const __m512 a = _mm512_set1_ps(Ap[i]);
+                c[i][0] = _mm512_fmadd_ps(a, b0, c[i][0]);
+                c[i][1] = _mm512_fmadd_ps(a, b1, c[i][1]);
+            }
+            Ap += MR;
+            Bp += NR;
+        }
+
+        for (unsigned int i=0;i<MR;i++)
+        {
+            _mm512_storeu_ps(C + i*ldc, _mm512_add_ps(_mm512_loadu_ps(C + i*ldc), c[i][0]));
+            _mm512_storeu_ps(C + i*ldc + 16, _mm512_add_ps(_mm512_loadu_ps(C + i*ldc + 16), c[i][1]));
+        }
+    }
+};
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+/**
+ * @brief AVX2 double micro-kernel (4 x 8, 8 accumulators).
+ ******/
+template<>
+struct GemmKernel<double>
+{
+    enum { MR = 4, NR = 8 };
+
+    static void multiply(const unsigned int kc, const double* Ap, const double* Bp, double* C, const unsigned int ldc)
+    {
+        __m256d c[MR][2];
+        for (unsigned int i=0;i<MR;i++) c[i][0] = c[i][1] = _mm256_setzero_pd();
+
+        for (unsigned int p=0;p<kc;p++)
+        {
+            const __m256d b0 = _mm256_loadu_pd(Bp);
+            const __m256d b1 = _mm256_loadu_pd(Bp + 4);
+            for (unsigned int i=0;i<MR;i++)
+            {
+                const __m256d a = _mm256_broadcast_sd(Ap + i);
+                c[i][0] = _mm256_fmadd_pd(a, b0, c[i][0]);
+                c[i][1] = _mm256_fmadd_pd(a, b1, c[i][1]);
+            }
+            Ap += MR;
+            Bp += NR;
+        }
+
+        for (unsigned int i=0;i<MR;i++)
+        {
+            _mm256_storeu_pd(C + i*ldc, _mm256_add_pd(_mm256_loadu_pd(C + i*ldc), c[i][0]));
+            _mm256_storeu_pd(C + i*ldc + 4, _mm256_add_pd(_mm256_loadu_pd(C + i*ldc + 4), c[i][1]));
+        }
+    }
+};
+
+/**
+ * @brief AVX2 float micro-kernel (4 x 16, 8 accumulators).
+ ******/
+template<>
+struct GemmKernel<float>
+{
+    enum { MR = 4, NR = 16 };
+
+    static void multiply(const unsigned int kc, const float* Ap, const float* Bp, float* C, const unsigned int ldc)
+    {
+        __m256 c[MR][2];
+        for (unsigned int i=0;i<MR;i++) c[i][0] = c[i][1] = _mm256_setzero_ps();
+
+        for (unsigned int p=0;p<kc;p++)
+        {
+            const __m256 b0 = _mm256_loadu_ps(Bp);
+            const __m256 b1 = _mm256_loadu_ps(Bp + 8);
+            for (unsigned int i=0;i<MR;i++)
+            {
+                const __m256 a = _mm256_broadcast_ss(Ap + i);
+                c[i][0] = _mm256_fmadd_ps(a, b0, c[i][0]);
+                c[i][1] = _mm256_fmadd_ps(a, b1, c[i][1]);
+            }
+            Ap += MR;
+            Bp += NR;
+        }
+
+        for (unsigned int i=0;i<MR;i++)
+        {
+            _mm256_storeu_ps(C + i*ldc, _mm256_add_ps(_mm256_loadu_ps(C + i*ldc), c[i][0]));
+            _mm256_storeu_ps(C + i*ldc + 8, _mm256_add_ps(_mm256_loadu_ps(C + i*ldc + 8), c[i][1]));
+        }
+    }
+};
+
+#endif
+
+/**
+ * @brief Single-threaded blocked product C += alpha*A*B.
+ * @details Goto/BLIS loop order: KC x NC panels of B and MC x KC blocks of alpha*A are packed (zero-padded
+ * to whole micro-tiles), then the micro-kernel sweeps the MR x NR tiles of C. Edge tiles are computed in a
+ * local tile and only their valid part is added to C.
+ ******/
+template<typename T>
+void gemmBlocked(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+                 const T* B, const unsigned int ldb, T* C, const unsigned int ldc)
+{
+    const unsigned int MR = GemmKernel<T>::MR;
+    const unsigned int NR = GemmKernel<T>::NR;
+
+    // Packing buffers sized for this product (whole micro-tiles), not for the largest blocks
+    const unsigned int kcMax = std::min(k, (unsigned int)GEMM_KC);
+    const unsigned int mcMax = (std::min(m, (unsigned int)GEMM_MC) + MR - 1) / MR * MR;
+    const unsigned int ncMax = (std::min(n, (unsigned int)GEMM_NC) + NR - 1) / NR * NR;
+    std::vector<T> Ap(mcMax * kcMax);
+    std::vector<T> Bp(kcMax * ncMax);
+    T tile[GemmKernel<T>::MR * GemmKernel<T>::NR];
+
+    for (unsigned int jc=0;jc<n;jc+=GEMM_NC)
+    {
+        const unsigned int nc = std::min(n - jc, (unsigned int)GEMM_NC);
+
+        for (unsigned int pc=0;pc<k;pc+=GEMM_KC)
+        {
+            const unsigned int kc = std::min(k - pc, (unsigned int)GEMM_KC);
+
+            // Pack B(pc:pc+kc, jc:jc+nc) in panels of NR columns
+            for (unsigned int jr=0;jr<nc;jr+=NR)
+            {
+                T* bp = &Bp[jr * kc];
+                const unsigned int nr = std::min(nc - jr, NR);
+                for (unsigned int p=0;p<kc;p++)
+                {
+                    const T* b = B + (pc + p)*ldb + jc + jr;
+                    for (unsigned int j=0;j<nr;j++) bp[j] = b[j];
+                    for (unsigned int j=nr;j<NR;j++) bp[j] = T(0);
+                    bp += NR;
+                }
+            }
+
+            for (unsigned int ic=0;ic<m;ic+=GEMM_MC)
+            {
+                const unsigned int mc = std::min(m - ic, (unsigned int)GEMM_MC);
+
+                // Pack alpha*A(ic:ic+mc, pc:pc+kc) in panels of MR rows
+                for (unsigned int ir=0;ir<mc;ir+=MR)
+                {
+                    T* ap = &Ap[ir * kc];
+                    const unsigned int mr = std::min(mc - ir, MR);
+                    for (unsigned int p=0;p<kc;p++)
+                    {
+                        for (unsigned int i=0;i<mr;i++) ap[i] = alpha * A[(ic + ir + i)*lda + pc + p];
+                        for (unsigned int i=mr;i<MR;i++) ap[i] = T(0);
+                        ap += MR;
+                    }
+                }
+
+                for (unsigned int jr=0;jr<nc;jr+=NR)
+                {
+                    const unsigned int nr = std::min(nc - jr, NR);
+                    for (unsigned int ir=0;ir<mc;ir+=MR)
+                    {
+                        const unsigned int mr = std::min(mc - ir, MR);
+                        T* c = C + (ic + ir)*ldc + jc + jr;
+
+                        if (mr == MR && nr == NR)
+                        {
+                            GemmKernel<T>::multiply(kc, &Ap[ir * kc], &Bp[jr * kc], c, ldc);
+                        }
+                        else
+                        {
+                            for (unsigned int i=0;i<MR*NR;i++) tile[i] = T(0);
+                            GemmKernel<T>::multiply(kc, &Ap[ir * kc], &Bp[jr * kc], tile, NR);
+                            for (unsigned int i=0;i<mr;i++)
+                            {
+                                for (unsigned int j=0;j<nr;j++) c[i*ldc + j] += tile[i*NR + j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Matrix product C = alpha*A*B + beta*C.
+ * @details Small products use a plain row-major loop. Larger ones use the packed blocked product; the
+ * output is split in row (or column, for wide results) ranges of whole micro-tiles, one per thread, so that
+ * threads never write the same tile.
+ * @param threads Number of threads (0: hardware concurrency).
+ ******/
+template<typename T>
+void gemm(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+          const T* B, const unsigned int ldb, const T beta, T* C, const unsigned int ldc, unsigned int threads)
+{
+    if (beta != T(1))
+    {
+        for (unsigned int i=0;i<m;i++)
+        {
+            for (unsigned int j=0;j<n;j++)
+            {
+                C[i*ldc + j] = (beta == T(0)) ? T(0) : beta * C[i*ldc + j];
+            }
+        }
+    }
+
+    if (m == 0 || n == 0 || k == 0 || alpha == T(0)) return;
+
+    const unsigned long long work = (unsigned long long)m * n * k;
+
+    if (work <= GEMM_SMALL_WORK)
+    {
+        for (unsigned int i=0;i<m;i++)
+        {
+            for (unsigned int p=0;p<k;p++)
+            {
+                const T a = alpha * A[i*lda + p];
+                for (unsigned int j=0;j<n;j++)
+                {
+                    C[i*ldc + j] += a * B[p*ldb + j];
+                }
+            }
+        }
+        return;
+    }
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = (unsigned int)std::min((unsigned long long)threads, std::max(1ull, work / GEMM_THREAD_WORK));
+
+    // Split the larger output dimension in ranges of whole micro-tiles
+    const bool splitRows = (m >= n);
+    const unsigned int size = splitRows ? m : n;
+    const unsigned int granule = splitRows ? (unsigned int)GemmKernel<T>::MR : (unsigned int)GemmKernel<T>::NR;
+    const unsigned int tiles = (size + granule - 1) / granule;
+
+    threads = std::min(threads, tiles);
+    if (threads <= 1)
+    {
+        gemmBlocked(m, n, k, alpha, A, lda, B, ldb, C, ldc);
+        return;
+    }
+
+    const unsigned int chunk = ((tiles + threads - 1) / threads) * granule;
+    std::vector<std::thread> workers;
+
+    for (unsigned int t=0;t<threads;t++)
+    {
+        const unsigned int begin = t * chunk;
+        if (begin >= size) break;
+        const unsigned int count = std::min(size - begin, chunk);
+
+        if (splitRows)
+        {
+            workers.push_back(std::thread(gemmBlocked<T>, count, n, k, alpha, A + begin*lda, lda, B, ldb, C + begin*ldc, ldc));
+        }
+        else
+        {
+            workers.push_back(std::thread(gemmBlocked<T>, m, count, k, alpha, A, lda, B + begin, ldb, C + begin, ldc));
+        }
+    }
+
+    for (unsigned int t=0;t<workers.size();t++)
+    {
+        workers[t].join();
+    }
+}
+
+#endif
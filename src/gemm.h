@@ -0,0 +1,42 @@
+/**
+ * @file gemm.h
+ * @brief Packed, cache-blocked matrix product (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <vector>
+#include <thread>
+
+/**
+ * @struct GemmKernel
+ * @brief Register-blocked micro-kernel: C(MR x NR) += Ap * Bp over kc packed steps.
+ * @details Ap holds MR elements per step (one per row), Bp holds NR elements per step (one per column).
+ * The generic kernel is plain C++; float and double have AVX2/FMA and AVX-512 kernels, compiled when
+ * __AVX2__ and __FMA__ or __AVX512F__ are defined (see the SSC_NATIVE_ARCH CMake option).
+ ******/
+template <typename T>
+struct GemmKernel
+{
+    enum { MR = 4, NR = 4 };
+
+    static void multiply(const unsigned int kc, const T* Ap, const T* Bp, T* C, const unsigned int ldc);
+};
+
+// C = alpha*A*B + beta*C (row-major, m x k times k x n, leading dimensions lda, ldb, ldc)
+// threads = 0: hardware concurrency
+template <typename T>
+void gemm(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+          const T* B, const unsigned int ldb, const T beta, T* C, const unsigned int ldc, unsigned int threads = 0);
+
+// Single-threaded blocked product C += alpha*A*B
+template <typename T>
+void gemmBlocked(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+                 const T* B, const unsigned int ldb, T* C, const unsigned int ldc);
+
+#include "gemm.cpp"
+
+#endif  // GEMM_H
@@ -0,0 +1,258 @@
+/**
+ * @file interconnection.cpp
+ * @brief Series, parallel, feedback and append interconnections of state-space controllers (source).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef INTERCONNECTION_CPP
+#define INTERCONNECTION_CPP
+
+#include "interconnection.h"
+#include "discretization.h"
+
+/**
+ * @brief Copies a block into a matrix at (row, col).
+ ******/
+template<typename T>
+void interconnectionPlace(QSMatrix<T>& M, const QSMatrix<T>& block, const unsigned int row, const unsigned int col)
+{
+    for (unsigned int r=0;r<block.get_rows();r++)
+    {
+        for (unsigned int c=0;c<block.get_cols();c++)
+        {
+            M(row + r, col + c) = block(r, c);
+        }
+    }
+}
+
+/**
+ * @brief Checks the time steps of two interconnected controllers.
+ * @return False (and an error message) if they differ.
+ ******/
+template<typename T>
+bool interconnectionTimeSteps(const StateSpaceController<T>& first, const StateSpaceController<T>& second)
+{
+    if (first.getTimeStep() != second.getTimeStep())
+    {
+        std::cout << "\033[1;31mERROR: Interconnected controllers must have the same time step (" << first.getTimeStep()
+                  << " s and " << second.getTimeStep() << " s)\033[0m" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Builds the controller of an interconnection, reduced if requested.
+ ******/
+template<typename T>
+StateSpaceController<T> interconnectionResult(QSMatrix<T> A, QSMatrix<T> B, QSMatrix<T> C, QSMatrix<T> D, const float t_s, const bool minimal)
+{
+    StateSpaceController<T> controller(std::move(A), std::move(B), std::move(C), std::move(D), t_s);
+
+    return minimal ? minimalRealization(controller) : controller;
+}
+
+/**
+ * @brief Series interconnection: the output of "first" is the error of "second".
+ * @details
+ *
+ *      A = | A1     0  |   B = | B1    |   C = | D2*C1  C2 |   D = D2*D1
+ *          | B2*C1  A2 |       | B2*D1 |
+ *
+ * @param first Controller receiving e (nu1 = ne2).
+ * @param second Controller producing u.
+ * @param minimal True to remove the states without effect (pole/zero cancellations).
+ * @return Equivalent controller.
+ ******/
+template<typename T>
+StateSpaceController<T> series(const StateSpaceController<T>& first, const StateSpaceController<T>& second, const bool minimal)
+{
+    if (first.getNu() != second.getNe())
+    {
+        std::cout << "\033[1;31mERROR: Series interconnection needs nu of the first controller (" << first.getNu()
+                  << ") = ne of the second (" << second.getNe() << ")\033[0m" << std::endl;
+        return first;
+    }
+    if (!interconnectionTimeSteps(first, second))
+    {
+        return first;
+    }
+
+    const unsigned int n1 = first.getNx(), n2 = second.getNx();
+    QSMatrix<T> A(n1 + n2, n1 + n2, 0), B(n1 + n2, first.getNe(), 0), C(second.getNu(), n1 + n2, 0);
+
+    interconnectionPlace(A, first.getA(), 0, 0);
+    interconnectionPlace(A, second.getB() * first.getC(), n1, 0);
+    interconnectionPlace(A, second.getA(), n1, n1);
+    interconnectionPlace(B, first.getB(), 0, 0);
+    interconnectionPlace(B, second.getB() * first.getD(), n1, 0);
+    interconnectionPlace(C, second.getD() * first.getC(), 0, 0);
+    interconnectionPlace(C, second.getC(), 0, n1);
+
+    return interconnectionResult(A, B, C, second.getD() * first.getD(), first.getTimeStep(), minimal);
+}
+
+/**
+ * @brief Parallel interconnection: both controllers receive e, their outputs are added.
+ * @details A = diag(A1, A2), B = [B1; B2], C = [C1 C2], D = D1 + D2.
+ * @param first First controller.
+ * @param second Second controller (same ne and nu).
+ * @param minimal True to remove the states without effect.
+ * @return Equivalent controller.
+ ******/
+template<typename T>
+StateSpaceController<T> parallel(const StateSpaceController<T>& first, const StateSpaceController<T>& second, const bool minimal)
+{
+    if (first.getNe() != second.getNe() || first.getNu() != second.getNu())
+    {
+        std::cout << "\033[1;31mERROR: Parallel interconnection needs controllers with the same ne and nu\033[0m" << std::endl;
+        return first;
+    }
+    if (!interconnectionTimeSteps(first, second))
+    {
+        return first;
+    }
+
+    const unsigned int n1 = first.getNx(), n2 = second.getNx();
+    QSMatrix<T> A(n1 + n2, n1 + n2, 0), B(n1 + n2, first.getNe(), 0), C(first.getNu(), n1 + n2, 0);
+
+    interconnectionPlace(A, first.getA(), 0, 0);
+    interconnectionPlace(A, second.getA(), n1, n1);
+    interconnectionPlace(B, first.getB(), 0, 0);
+    interconnectionPlace(B, second.getB(), n1, 0);
+    interconnectionPlace(C, first.getC(), 0, 0);
+    interconnectionPlace(C, second.getC(), 0, n1);
+
+    return interconnectionResult(A, B, C, first.getD() + second.getD(), first.getTimeStep(), minimal);
+}
+
+/**
+ * @brief Feedback interconnection: u = forward(v), v = e + sign*feedbackPath(u).
+ * @details The algebraic loop through D1 and D2 is solved once: with E = (I - sign*D1*D2)^-1,
+ *
+ *      u  = E*C1*x1 + sign*E*D1*C2*x2 + E*D1*e
+ *      v  = e + sign*(C2*x2 + D2*u)
+ *      x1' = A1*x1 + B1*v,  x2' = A2*x2 + B2*u
+ *
+ * @param forward Forward controller (ne1 = nu2, nu1 = ne2).
+ * @param feedbackPath Controller in the feedback path.
+ * @param sign -1 for negative feedback, +1 for positive feedback.
+ * @param minimal True to remove the states without effect.
+ * @return Equivalent controller (e -> u).
+ ******/
+template<typename T>
+StateSpaceController<T> feedback(const StateSpaceController<T>& forward, const StateSpaceController<T>& feedbackPath, const int sign, const bool minimal)
+{
+    if (forward.getNu() != feedbackPath.getNe() || feedbackPath.getNu() != forward.getNe())
+    {
+        std::cout << "\033[1;31mERROR: Feedback interconnection needs nu1 = ne2 and nu2 = ne1\033[0m" << std::endl;
+        return forward;
+    }
+    if (!interconnectionTimeSteps(forward, feedbackPath))
+    {
+        return forward;
+    }
+
+    const unsigned int n1 = forward.getNx(), n2 = feedbackPath.getNx(), ne = forward.getNe(), nu = forward.getNu();
+    const T s = (sign < 0) ? T(-1) : T(1);
+
+    const QSMatrix<T> loop = identityMatrix<T>(nu) - forward.getD() * feedbackPath.getD() * s;
+    if (std::abs(loop.determinant()) <= std::numeric_limits<T>::epsilon())
+    {
+        std::cout << "\033[1;31mERROR: Feedback interconnection is not well-posed (I - sign*D1*D2 is singular)\033[0m" << std::endl;
+        return forward;
+    }
+
+    // u = Ux * [x1; x2] + Ue * e
+    QSMatrix<T> Ux(nu, n1 + n2, 0);
+    interconnectionPlace(Ux, loop.solve(forward.getC()), 0, 0);
+    interconnectionPlace(Ux, loop.solve(forward.getD() * feedbackPath.getC()) * s, 0, n1);
+    const QSMatrix<T> Ue = loop.solve(forward.getD());
+
+    // v = Vx * [x1; x2] + Ve * e
+    QSMatrix<T> Vx = feedbackPath.getD() * Ux * s;
+    QSMatrix<T> C2(ne, n1 + n2, 0);
+    interconnectionPlace(C2, feedbackPath.getC() * s, 0, n1);
+    Vx = Vx + C2;
+    const QSMatrix<T> Ve = identityMatrix<T>(ne) + feedbackPath.getD() * Ue * s;
+
+    QSMatrix<T> A(n1 + n2, n1 + n2, 0), B(n1 + n2, ne, 0);
+    QSMatrix<T> A1(n1, n1 + n2, 0), A2(n2, n1 + n2, 0);
+    interconnectionPlace(A1, forward.getA(), 0, 0);
+    interconnectionPlace(A2, feedbackPath.getA(), 0, n1);
+
+    interconnectionPlace(A, A1 + forward.getB() * Vx, 0, 0);
+    interconnectionPlace(A, A2 + feedbackPath.getB() * Ux, n1, 0);
+    interconnectionPlace(B, forward.getB() * Ve, 0, 0);
+    interconnectionPlace(B, feedbackPath.getB() * Ue, n1, 0);
+
+    return interconnectionResult(A, B, Ux, Ue, forward.getTimeStep(), minimal);
+}
+
+/**
+ * @brief Appends two independent controllers: errors and outputs are stacked.
+ * @details A = diag(A1, A2), B = diag(B1, B2), C = diag(C1, C2), D = diag(D1, D2).
+ * @param first Controller of the first ne1 errors and nu1 outputs.
+ * @param second Controller of the last ne2 errors and nu2 outputs.
+ * @param minimal True to remove the states without effect.
+ * @return Equivalent controller.
+ ******/
+template<typename T>
+StateSpaceController<T> append(const StateSpaceController<T>& first, const StateSpaceController<T>& second, const bool minimal)
+{
+    if (!interconnectionTimeSteps(first, second))
+    {
+        return first;
+    }
+
+    const unsigned int n1 = first.getNx(), n2 = second.getNx();
+    const unsigned int ne1 = first.getNe(), ne2 = second.getNe(), nu1 = first.getNu(), nu2 = second.getNu();
+    QSMatrix<T> A(n1 + n2, n1 + n2, 0), B(n1 + n2, ne1 + ne2, 0), C(nu1 + nu2, n1 + n2, 0), D(nu1 + nu2, ne1 + ne2, 0);
+
+    interconnectionPlace(A, first.getA(), 0, 0);
+    interconnectionPlace(A, second.getA(), n1, n1);
+    interconnectionPlace(B, first.getB(), 0, 0);
+    interconnectionPlace(B, second.getB(), n1, ne1);
+    interconnectionPlace(C, first.getC(), 0, 0);
+    interconnectionPlace(C, second.getC(), nu1, n1);
+    interconnectionPlace(D, first.getD(), 0, 0);
+    interconnectionPlace(D, second.getD(), nu1, ne1);
+
+    return interconnectionResult(A, B, C, D, first.getTimeStep(), minimal);
+}
+
+/**
+ * @brief Minimal realization: keeps the controllable and observable part of a stable controller.
+ * @details States with a Hankel singular value below tolerance * the largest one are uncontrollable or
+ * unobservable (up to the tolerance) and removed by balanced truncation (see modelReduction.h); the
+ * input/output behaviour is kept within twice the sum of the removed values. An unstable controller is
+ * returned unchanged.
+ * @param controller Controller.
+ * @param tolerance Relative Hankel singular value below which a state is removed.
+ * @return Minimal controller (balanced realization), or the controller itself.
+ ******/
+template<typename T>
+StateSpaceController<T> minimalRealization(const StateSpaceController<T>& controller, const T tolerance)
+{
+    const std::vector<T> sigma = hankelSingularValues(controller);
+    if (sigma.empty())
+    {
+        return controller;
+    }
+
+    unsigned int order = 0;
+    while (order < sigma.size() && sigma[order] > tolerance * sigma[0])
+    {
+        order++;
+    }
+    if (order == controller.getNx())
+    {
+        return controller;
+    }
+
+    return balancedTruncation(controller, order);
+}
+
+#endif  // INTERCONNECTION_CPP
@@ -0,0 +1,51 @@
+/**
+ * @file interconnection.h
+ * @brief Series, parallel, feedback and append interconnections of state-space controllers (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef INTERCONNECTION_H
+#define INTERCONNECTION_H
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <limits>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+#include "modelReduction.h"
+
+/*
+ * Each operation returns one controller whose A, B, C, D realize the interconnection (state [x1; x2],
+ * time restarting from 0): it is stepped with a single currentOutput() instead of one per controller and
+ * the vectors copied between them. Both controllers must have the same time step. On a dimension mismatch
+ * an error is printed and the first controller is returned.
+ *
+ * With minimal = true, the result goes through minimalRealization().
+ */
+
+// u = second(first(e)): e -> first -> second -> u
+template <typename T>
+StateSpaceController<T> series(const StateSpaceController<T>& first, const StateSpaceController<T>& second, const bool minimal = false);
+
+// u = first(e) + second(e)
+template <typename T>
+StateSpaceController<T> parallel(const StateSpaceController<T>& first, const StateSpaceController<T>& second, const bool minimal = false);
+
+// u = forward(e + sign*feedbackPath(u)) (sign = -1: negative feedback)
+template <typename T>
+StateSpaceController<T> feedback(const StateSpaceController<T>& forward, const StateSpaceController<T>& feedbackPath, const int sign = -1, const bool minimal = false);
+
+// [u1; u2] = [first(e1); second(e2)] (block diagonal)
+template <typename T>
+StateSpaceController<T> append(const StateSpaceController<T>& first, const StateSpaceController<T>& second, const bool minimal = false);
+
+// Removes the states with a Hankel singular value below tolerance * the largest one (stable controllers)
+template <typename T>
+StateSpaceController<T> minimalRealization(const StateSpaceController<T>& controller, const T tolerance = std::sqrt(std::numeric_limits<T>::epsilon()));
+
+#include "interconnection.cpp"
+
+#endif  // INTERCONNECTION_H
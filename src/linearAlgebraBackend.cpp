@@ -0,0 +1,334 @@
+/**
+ * @file linearAlgebraBackend.cpp
+ * @brief Linear algebra backends of QSMatrix (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef LINEARALGEBRABACKEND_CPP
+#define LINEARALGEBRABACKEND_CPP
+
+#include "linearAlgebraBackend.h"
+
+#include <cstddef>
+
+#if defined(SSC_HAVE_CBLAS)
+#include <cblas.h>
+#endif
+
+#if defined(SSC_HAVE_EIGEN)
+#include <Eigen/Dense>
+#endif
+
+#if defined(SSC_HAVE_LAPACK)
+// LAPACK (Fortran interface, column-major)
+extern "C"
+{
+    void dgetrf_(const int* m, const int* n, double* a, const int* lda, int* ipiv, int* info);
+    void dgetrs_(const char* trans, const int* n, const int* nrhs, const double* a, const int* lda, const int* ipiv,
+                 double* b, const int* ldb, int* info, std::size_t transLength);
+    void sgetrf_(const int* m, const int* n, float* a, const int* lda, int* ipiv, int* info);
+    void sgetrs_(const char* trans, const int* n, const int* nrhs, const float* a, const int* lda, const int* ipiv,
+                 float* b, const int* ldb, int* info, std::size_t transLength);
+}
+#endif
+
+/**
+ * @return Backend name.
+ ******/
+template<typename T>
+const char* BuiltinBackend<T>::name()
+{
+    return "built-in";
+}
+
+/**
+ * @brief C = alpha*A*B + beta*C with the packed, cache-blocked gemm().
+ ******/
+template<typename T>
+void BuiltinBackend<T>::gemm(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+                             const T* B, const unsigned int ldb, const T beta, T* C, const unsigned int ldc, const unsigned int threads)
+{
+    ::gemm<T>(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, threads);
+}
+
+/**
+ * @brief y = alpha*A*x + beta*y (row dot products).
+ ******/
+template<typename T>
+void BuiltinBackend<T>::gemv(const unsigned int m, const unsigned int n, const T alpha, const T* A, const unsigned int lda,
+                             const T* x, const T beta, T* y)
+{
+    for (unsigned int i=0;i<m;i++)
+    {
+        T sum = T(0);
+        for (unsigned int j=0;j<n;j++)
+        {
+            sum += A[i*lda + j] * x[j];
+        }
+        y[i] = (beta == T(0)) ? alpha * sum : alpha * sum + beta * y[i];
+    }
+}
+
+/**
+ * @brief No solver: QSMatrix uses its own blocked LU.
+ ******/
+template<typename T>
+int BuiltinBackend<T>::solve(const unsigned int, const unsigned int, T*, T*)
+{
+    return -1;
+}
+
+#if defined(SSC_HAVE_CBLAS)
+
+/**
+ * @brief CBLAS double backend (dgemm, dgemv; dgetrf/dgetrs when LAPACK is available).
+ ******/
+template<>
+struct CblasBackend<double>
+{
+    static const char* name()
+    {
+        return "cblas";
+    }
+
+    static void gemm(const unsigned int m, const unsigned int n, const unsigned int k, const double alpha, const double* A, const unsigned int lda,
+                     const double* B, const unsigned int ldb, const double beta, double* C, const unsigned int ldc, const unsigned int = 0)
+    {
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    static void gemv(const unsigned int m, const unsigned int n, const double alpha, const double* A, const unsigned int lda,
+                     const double* x, const double beta, double* y)
+    {
+        cblas_dgemv(CblasRowMajor, CblasNoTrans, m, n, alpha, A, lda, x, 1, beta, y, 1);
+    }
+
+    static int solve(const unsigned int n, const unsigned int nrhs, double* A, double* B)
+    {
+#if defined(SSC_HAVE_LAPACK)
+        // The row-major A is the column-major A': factorize A' and solve with its transpose
+        const int N = n, NRHS = nrhs;
+        const char trans = 'T';
+        int info = 0;
+        std::vector<int> pivots(n);
+        std::vector<double> X(n * nrhs);
+
+        dgetrf_(&N, &N, A, &N, &pivots[0], &info);
+        if (info > 0) return 0;
+
+        for (unsigned int i=0;i<n;i++)
+        {
+            for (unsigned int j=0;j<nrhs;j++) X[j*n + i] = B[i*nrhs + j];
+        }
+        dgetrs_(&trans, &N, &NRHS, A, &N, &pivots[0], &X[0], &N, &info, 1);
+        for (unsigned int i=0;i<n;i++)
+        {
+            for (unsigned int j=0;j<nrhs;j++) B[i*nrhs + j] = X[j*n + i];
+        }
+
+        return (info == 0) ? 1 : 0;
+#else
+        return BuiltinBackend<double>::solve(n, nrhs, A, B);
+#endif
+    }
+};
+
+/**
+ * @brief CBLAS float backend (sgemm, sgemv; sgetrf/sgetrs when LAPACK is available).
+ ******/
+template<>
+struct CblasBackend<float>
+{
+    static const char* name()
+    {
+        return "cblas";
+    }
+
+    static void gemm(const unsigned int m, const unsigned int n, const unsigned int k, const float alpha, const float* A, const unsigned int lda,
+                     const float* B, const unsigned int ldb, const float beta, float* C, const unsigned int ldc, const unsigned int = 0)
+    {
+        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    static void gemv(const unsigned int m, const unsigned int n, const float alpha, const float* A, const unsigned int lda,
+                     const float* x, const float beta, float* y)
+    {
+        cblas_sgemv(CblasRowMajor, CblasNoTrans, m, n, alpha, A, lda, x, 1, beta, y, 1);
+    }
+
+    static int solve(const unsigned int n, const unsigned int nrhs, float* A, float* B)
+    {
+#if defined(SSC_HAVE_LAPACK)
+        const int N = n, NRHS = nrhs;
+        const char trans = 'T';
+        int info = 0;
+        std::vector<int> pivots(n);
+        std::vector<float> X(n * nrhs);
+
+        sgetrf_(&N, &N, A, &N, &pivots[0], &info);
+        if (info > 0) return 0;
+
+        for (unsigned int i=0;i<n;i++)
+        {
+            for (unsigned int j=0;j<nrhs;j++) X[j*n + i] = B[i*nrhs + j];
+        }
+        sgetrs_(&trans, &N, &NRHS, A, &N, &pivots[0], &X[0], &N, &info, 1);
+        for (unsigned int i=0;i<n;i++)
+        {
+            for (unsigned int j=0;j<nrhs;j++) B[i*nrhs + j] = X[j*n + i];
+        }
+
+        return (info == 0) ? 1 : 0;
+#else
+        return BuiltinBackend<float>::solve(n, nrhs, A, B);
+#endif
+    }
+};
+
+#endif
+
+#if defined(SSC_HAVE_EIGEN)
+
+/**
+ * @return Backend name.
+ ******/
+template<typename T>
+const char* EigenBackend<T>::name()
+{
+    return "eigen";
+}
+
+/**
+ * @brief C = alpha*A*B + beta*C on Eigen maps of the row-major buffers.
+ ******/
+template<typename T>
+void EigenBackend<T>::gemm(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+                           const T* B, const unsigned int ldb, const T beta, T* C, const unsigned int ldc, const unsigned int)
+{
+    typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+
+    Eigen::Map<const Matrix, 0, Eigen::OuterStride<> > a(A, m, k, Eigen::OuterStride<>(lda));
+    Eigen::Map<const Matrix, 0, Eigen::OuterStride<> > b(B, k, n, Eigen::OuterStride<>(ldb));
+    Eigen::Map<Matrix, 0, Eigen::OuterStride<> > c(C, m, n, Eigen::OuterStride<>(ldc));
+
+    if (beta == T(0)) c.setZero();
+    else if (beta != T(1)) c *= beta;
+
+    c.noalias() += alpha * a * b;
+}
+
+/**
+ * @brief y = alpha*A*x + beta*y on Eigen maps.
+ ******/
+template<typename T>
+void EigenBackend<T>::gemv(const unsigned int m, const unsigned int n, const T alpha, const T* A, const unsigned int lda,
+                           const T* x, const T beta, T* y)
+{
+    typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+    typedef Eigen::Matrix<T, Eigen::Dynamic, 1> Vector;
+
+    Eigen::Map<const Matrix, 0, Eigen::OuterStride<> > a(A, m, n, Eigen::OuterStride<>(lda));
+    Eigen::Map<const Vector> xv(x, n);
+    Eigen::Map<Vector> yv(y, m);
+
+    if (beta == T(0)) yv.setZero();
+    else if (beta != T(1)) yv *= beta;
+
+    yv.noalias() += alpha * a * xv;
+}
+
+/**
+ * @brief A*X = B with Eigen's partial pivoting LU.
+ ******/
+template<typename T>
+int EigenBackend<T>::solve(const unsigned int n, const unsigned int nrhs, T* A, T* B)
+{
+    typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+
+    Eigen::Map<Matrix> a(A, n, n);
+    Eigen::Map<Matrix> b(B, n, nrhs);
+
+    Eigen::PartialPivLU<Eigen::Ref<Matrix> > lu(a);
+
+    for (unsigned int k=0;k<n;k++)
+    {
+        if (lu.matrixLU()(k,k) == T(0)) return 0;
+    }
+
+    b = lu.solve(b).eval();
+
+    return 1;
+}
+
+#endif
+
+/**
+ * @brief Backend selected at configure time.
+ ******/
+#if defined(SSC_BACKEND_CBLAS) && defined(SSC_HAVE_CBLAS)
+#define LINALG_SELECTED_BACKEND CblasBackend
+#elif defined(SSC_BACKEND_EIGEN) && defined(SSC_HAVE_EIGEN)
+#define LINALG_SELECTED_BACKEND EigenBackend
+#else
+#define LINALG_SELECTED_BACKEND BuiltinBackend
+#endif
+
+/**
+ * @return Name of the selected backend.
+ ******/
+template<typename T>
+const char* LinearAlgebraBackend<T>::name()
+{
+    return LINALG_SELECTED_BACKEND<T>::name();
+}
+
+/**
+ * @brief C = alpha*A*B + beta*C (selected backend above LINALG_BACKEND_SMALL_WORK).
+ ******/
+template<typename T>
+void LinearAlgebraBackend<T>::gemm(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+                                   const T* B, const unsigned int ldb, const T beta, T* C, const unsigned int ldc, const unsigned int threads)
+{
+    if ((unsigned long long)m * n * k <= LINALG_BACKEND_SMALL_WORK)
+    {
+        BuiltinBackend<T>::gemm(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, threads);
+    }
+    else
+    {
+        LINALG_SELECTED_BACKEND<T>::gemm(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, threads);
+    }
+}
+
+/**
+ * @brief y = alpha*A*x + beta*y (selected backend above LINALG_BACKEND_SMALL_WORK).
+ ******/
+template<typename T>
+void LinearAlgebraBackend<T>::gemv(const unsigned int m, const unsigned int n, const T alpha, const T* A, const unsigned int lda,
+                                   const T* x, const T beta, T* y)
+{
+    if ((unsigned long long)m * n <= LINALG_BACKEND_SMALL_WORK)
+    {
+        BuiltinBackend<T>::gemv(m, n, alpha, A, lda, x, beta, y);
+    }
+    else
+    {
+        LINALG_SELECTED_BACKEND<T>::gemv(m, n, alpha, A, lda, x, beta, y);
+    }
+}
+
+/**
+ * @brief A*X = B (selected backend above LINALG_BACKEND_SMALL_WORK, -1: use the QSMatrix LU).
+ ******/
+template<typename T>
+int LinearAlgebraBackend<T>::solve(const unsigned int n, const unsigned int nrhs, T* A, T* B)
+{
+    if ((unsigned long long)n * n * (n + nrhs) <= LINALG_BACKEND_SMALL_WORK)
+    {
+        return BuiltinBackend<T>::solve(n, nrhs, A, B);
+    }
+
+    return LINALG_SELECTED_BACKEND<T>::solve(n, nrhs, A, B);
+}
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file linearAlgebraBackend.h
+ * @brief Linear algebra backends of QSMatrix (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef LINEARALGEBRABACKEND_H
+#define LINEARALGEBRABACKEND_H
+
+#include <vector>
+
+#include "gemm.h"
+
+/**
+ * @brief Backend policies: row-major GEMM, GEMV and dense solve on raw buffers.
+ * @details Every backend provides:
+ * - name()
+ * - gemm(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, threads): C = alpha*A*B + beta*C
+ * - gemv(m, n, alpha, A, lda, x, beta, y): y = alpha*A*x + beta*y
+ * - solve(n, nrhs, A, B): A*X = B, A (n x n) is overwritten by its factors and B (n x nrhs) by X.
+ *   Returns 1 if solved, 0 if A is singular, -1 if the backend has no solver (QSMatrix then uses its own LU).
+ *
+ * BuiltinBackend uses the kernels of this library. CblasBackend (SSC_HAVE_CBLAS, solve with
+ * SSC_HAVE_LAPACK) and EigenBackend (SSC_HAVE_EIGEN) are compiled when CMake finds the libraries; their
+ * float/double versions call the library, other scalar types fall back to the built-in kernels.
+ *
+ * LinearAlgebraBackend is the backend used by QSMatrix, chosen at configure time by the
+ * SSC_LINALG_BACKEND CMake option (SSC_BACKEND_CBLAS or SSC_BACKEND_EIGEN defined, built-in otherwise).
+ * Small problems always use the built-in kernels: a library call costs more than a controller-sized product.
+ ******/
+
+template <typename T>
+struct BuiltinBackend
+{
+    static const char* name();
+
+    static void gemm(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+                     const T* B, const unsigned int ldb, const T beta, T* C, const unsigned int ldc, const unsigned int threads = 0);
+
+    static void gemv(const unsigned int m, const unsigned int n, const T alpha, const T* A, const unsigned int lda,
+                     const T* x, const T beta, T* y);
+
+    static int solve(const unsigned int n, const unsigned int nrhs, T* A, T* B);
+};
+
+#if defined(SSC_HAVE_CBLAS)
+
+template <typename T>
+struct CblasBackend : public BuiltinBackend<T> {};
+
+template <>
+struct CblasBackend<double>;
+
+template <>
+struct CblasBackend<float>;
+
+#endif
+
+#if defined(SSC_HAVE_EIGEN)
+
+template <typename T>
+struct EigenBackend
+{
+    static const char* name();
+
+    static void gemm(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+                     const T* B, const unsigned int ldb, const T beta, T* C, const unsigned int ldc, const unsigned int threads = 0);
+
+    static void gemv(const unsigned int m, const unsigned int n, const T alpha, const T* A, const unsigned int lda,
+                     const T* x, const T beta, T* y);
+
+    static int solve(const unsigned int n, const unsigned int nrhs, T* A, T* B);
+};
+
+#endif
+
+/**
+ * @brief Products and systems below this size (multiply-adds) stay on the built-in kernels.
+ ******/
+#define LINALG_BACKEND_SMALL_WORK 8192
+
+template <typename T>
+struct LinearAlgebraBackend
+{
+    static const char* name();
+
+    static void gemm(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T* A, const unsigned int lda,
+                     const T* B, const unsigned int ldb, const T beta, T* C, const unsigned int ldc, const unsigned int threads = 0);
+
+    static void gemv(const unsigned int m, const unsigned int n, const T alpha, const T* A, const unsigned int lda,
+                     const T* x, const T beta, T* y);
+
+    static int solve(const unsigned int n, const unsigned int nrhs, T* A, T* B);
+};
+
+#include "linearAlgebraBackend.cpp"
+
+#endif  // LINEARALGEBRABACKEND_H
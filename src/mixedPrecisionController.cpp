@@ -0,0 +1,526 @@
+/**
+ * @file mixedPrecisionController.cpp
+ * @brief MixedPrecisionStateSpaceController class source file.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef MIXEDPRECISIONCONTROLLER_CPP
+#define MIXEDPRECISIONCONTROLLER_CPP
+
+#include "mixedPrecisionController.h"
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * @brief Constructor from a double controller.
+ * @param reference Double controller (copied as shadow).
+ * @param resyncInterval Number of steps between two resynchronizations.
+ * @param driftThreshold Drift estimate triggering an early resynchronization (0 to disable).
+ ******/
+template<typename T>
+MixedPrecisionStateSpaceController<T>::MixedPrecisionStateSpaceController(const StateSpaceController<double>& reference, const unsigned int resyncInterval, const double driftThreshold):
+m_shadow(reference), m_resyncInterval(std::max(1u, resyncInterval)), m_driftThreshold(driftThreshold)
+{
+    convertMatrices();
+    reset();
+}
+
+/**
+ * @brief Constructor using generated controller data file.
+ * @details See StateSpaceController::help() for the file format.
+ * @param formattedDataFilePath Path of the controller data file.
+ * @param resyncInterval Number of steps between two resynchronizations.
+ * @param driftThreshold Drift estimate triggering an early resynchronization (0 to disable).
+ ******/
+template<typename T>
+MixedPrecisionStateSpaceController<T>::MixedPrecisionStateSpaceController(std::string formattedDataFilePath, const unsigned int resyncInterval, const double driftThreshold):
+m_shadow(formattedDataFilePath), m_resyncInterval(std::max(1u, resyncInterval)), m_driftThreshold(driftThreshold)
+{
+    convertMatrices();
+    reset();
+}
+
+/**
+ * @brief Destructor.
+ ******/
+template<typename T>
+MixedPrecisionStateSpaceController<T>::~MixedPrecisionStateSpaceController() {}
+
+/**
+ * @brief Infinity norm of the rounding error of a matrix.
+ ******/
+template<typename T>
+double MixedPrecisionStateSpaceController<T>::roundingNorm(const QSMatrix<double>& M, const std::vector<T>& converted)
+{
+    double norm = 0;
+
+    for (unsigned int row=0;row<M.get_rows();row++)
+    {
+        double rowSum = 0;
+        for (unsigned int col=0;col<M.get_cols();col++)
+        {
+            rowSum += std::fabs(M(row,col) - (double)converted[row*M.get_cols() + col]);
+        }
+        norm = std::max(norm, rowSum);
+    }
+
+    return norm;
+}
+
+/**
+ * @brief Converts the shadow matrices to T (row-major) and computes the rounding norms of A and B.
+ ******/
+template<typename T>
+void MixedPrecisionStateSpaceController<T>::convertMatrices()
+{
+    m_nx = m_shadow.getNx();
+    m_ne = m_shadow.getNe();
+    m_nu = m_shadow.getNu();
+    m_t_s = m_shadow.getTimeStep();
+
+    const QSMatrix<double>& A = m_shadow.getA();
+    const QSMatrix<double>& B = m_shadow.getB();
+    const QSMatrix<double>& C = m_shadow.getC();
+    const QSMatrix<double>& D = m_shadow.getD();
+
+    const QSMatrix<double>* matrices[4] = {&A, &B, &C, &D};
+    std::vector<T>* converted[4] = {&m_A, &m_B, &m_C, &m_D};
+
+    for (int m=0;m<4;m++)
+    {
+        const unsigned int cols = matrices[m]->get_cols();
+        converted[m]->assign(matrices[m]->get_rows() * cols, 0);
+
+        for (unsigned int row=0;row<matrices[m]->get_rows();row++)
+        {
+            for (unsigned int col=0;col<cols;col++)
+            {
+                (*converted[m])[row*cols + col] = (T)(*matrices[m])(row,col);
+            }
+        }
+    }
+
+    m_dA = roundingNorm(A, m_A);
+    m_dB = roundingNorm(B, m_B);
+
+    computeResponse();
+
+    m_window.assign(m_resyncInterval * m_ne, 0);
+    m_xSync.assign(m_nx, 0);
+    m_x_i.assign(m_nx, 0);
+    m_x_ip1.assign(m_nx, 0);
+    m_e_i.assign(m_ne, 0);
+    m_u_i.assign(m_nu, 0);
+}
+
+/**
+ * @brief Computes the powers A^(2^j) (up to the highest bit of resyncInterval) and the blocks A^p*B.
+ * @details O(log2(K)*nx^3 + K*nx^2*ne) once per interval change.
+ ******/
+template<typename T>
+void MixedPrecisionStateSpaceController<T>::computeResponse()
+{
+    const QSMatrix<double>& A = m_shadow.getA();
+    const QSMatrix<double>& B = m_shadow.getB();
+
+    m_powers.clear();
+    m_powers.push_back(A);
+    while ((m_resyncInterval >> m_powers.size()) != 0)
+    {
+        m_powers.push_back(m_powers.back() * m_powers.back());
+    }
+
+    // Block p = A*block (p-1), block 0 = B
+    const unsigned int block = m_nx * m_ne;
+    m_response.assign(m_resyncInterval * block, 0);
+    for (unsigned int row=0;row<m_nx;row++)
+    {
+        for (unsigned int col=0;col<m_ne;col++)
+        {
+            m_response[row*m_ne + col] = B(row,col);
+        }
+    }
+    for (unsigned int p=1;p<m_resyncInterval;p++)
+    {
+        const double* previous = &m_response[(p-1)*block];
+        double* current = &m_response[p*block];
+        for (unsigned int row=0;row<m_nx;row++)
+        {
+            for (unsigned int k=0;k<m_nx;k++)
+            {
+                const double a = A(row,k);
+                for (unsigned int col=0;col<m_ne;col++)
+                {
+                    current[row*m_ne + col] += a * previous[k*m_ne + col];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Compensated dot product (Neumaier summation), added to a running sum and compensation.
+ ******/
+template<typename T>
+void MixedPrecisionStateSpaceController<T>::accumulate(const T* row, const T* vec, const unsigned int length, T& sum, T& compensation)
+{
+    for (unsigned int k=0;k<length;k++)
+    {
+        T product = row[k] * vec[k];
+        T total = sum + product;
+
+        if (std::fabs(sum) >= std::fabs(product))
+        {
+            compensation += (sum - total) + product;
+        }
+        else
+        {
+            compensation += (product - total) + sum;
+        }
+        sum = total;
+    }
+}
+
+/**
+ * @brief Computes the current controller output with the error vector and increments time.
+ * @details Triggers a resynchronization after the step if the interval is reached or the drift estimate is above the threshold.
+ * @param e_i Current error vector.
+ * @return Controller output vector.
+ ******/
+template<typename T>
+std::vector<double> MixedPrecisionStateSpaceController<T>::currentOutput(const std::vector<double>& e_i)
+{
+    double e_norm = 0;
+    double x_norm = 0;
+
+    for (unsigned int k=0;k<m_ne;k++)
+    {
+        m_e_i[k] = (T)e_i[k];
+        m_window[m_windowSteps*m_ne + k] = e_i[k];
+        e_norm = std::max(e_norm, std::fabs(e_i[k]));
+    }
+
+    // u_i = C*x_i + D*e_i
+    std::vector<double> u_i(m_nu, 0);
+    for (unsigned int row=0;row<m_nu;row++)
+    {
+        T sum = 0, compensation = 0;
+        accumulate(&m_C[row*m_nx], m_x_i.data(), m_nx, sum, compensation);
+        accumulate(&m_D[row*m_ne], m_e_i.data(), m_ne, sum, compensation);
+        m_u_i[row] = sum + compensation;
+        u_i[row] = m_u_i[row];
+    }
+
+    // x_{i+1} = A*x_i + B*e_i
+    double x_next_norm = 0;
+    for (unsigned int row=0;row<m_nx;row++)
+    {
+        T sum = 0, compensation = 0;
+        accumulate(&m_A[row*m_nx], m_x_i.data(), m_nx, sum, compensation);
+        accumulate(&m_B[row*m_ne], m_e_i.data(), m_ne, sum, compensation);
+        m_x_ip1[row] = sum + compensation;
+
+        x_norm = std::max(x_norm, (double)std::fabs(m_x_i[row]));
+        x_next_norm = std::max(x_next_norm, (double)std::fabs(m_x_ip1[row]));
+    }
+    m_x_i.swap(m_x_ip1);
+
+    m_drift += m_dA * x_norm + m_dB * e_norm + std::numeric_limits<T>::epsilon() * x_next_norm;
+
+    m_t = m_i * m_t_s;
+    m_i++;
+    m_windowSteps++;
+
+    if (m_windowSteps >= m_resyncInterval || (m_driftThreshold > 0 && m_drift > m_driftThreshold))
+    {
+        resynchronize();
+    }
+
+    return u_i;
+}
+
+/**
+ * @brief Computes the current controller output with the error vector, applies a saturation and increments time.
+ * @param e_i Current error vector.
+ * @param u_min Bottom saturation value.
+ * @param u_max Top saturation value.
+ * @return Controller output vector.
+ ******/
+template<typename T>
+std::vector<double> MixedPrecisionStateSpaceController<T>::currentOutput(const std::vector<double>& e_i, const double& u_min, const double& u_max)
+{
+    std::vector<double> u_i = currentOutput(e_i);
+
+    for (unsigned int k=0;k<m_nu;k++)
+    {
+        u_i[k] = std::min(u_max, std::max(u_min, u_i[k]));
+    }
+
+    return u_i;
+}
+
+/**
+ * @brief Computes the current controller output with the reference vector and the plant output vector and increments time.
+ * @param r_i Current reference vector.
+ * @param y_i Current plant output vector.
+ * @return Controller output vector.
+ ******/
+template<typename T>
+std::vector<double> MixedPrecisionStateSpaceController<T>::currentOutput(const std::vector<double>& r_i, const std::vector<double>& y_i)
+{
+    return currentOutput(QSMatrix<double>::vectorSubstract(r_i, y_i));
+}
+
+/**
+ * @brief Computes the double state from the recorded errors and overwrites the low-precision state.
+ * @details x_w = A^w*x_0 + sum_{j<w} A^(w-1-j)*B*e_j, with A^w applied bit by bit from the cached powers
+ * (popcount(w) matrix/vector products) and the sum read from the cached blocks (w*nx*ne multiply-adds).
+ * Records the deviation (infinity norm) between both states before overwriting.
+ ******/
+template<typename T>
+void MixedPrecisionStateSpaceController<T>::resynchronize()
+{
+    const unsigned int w = m_windowSteps;
+
+    std::vector<double> x_shadow = m_xSync;
+    for (unsigned int j=0;j<m_powers.size();j++)
+    {
+        if ((w >> j) & 1u)
+        {
+            x_shadow = m_powers[j] * x_shadow;
+        }
+    }
+
+    const unsigned int block = m_nx * m_ne;
+    for (unsigned int step=0;step<w;step++)
+    {
+        const double* response = &m_response[(w-1-step)*block];
+        const double* e = &m_window[step*m_ne];
+        for (unsigned int row=0;row<m_nx;row++)
+        {
+            double sum = 0;
+            for (unsigned int col=0;col<m_ne;col++)
+            {
+                sum += response[row*m_ne + col] * e[col];
+            }
+            x_shadow[row] += sum;
+        }
+    }
+    m_xSync = x_shadow;
+
+    m_lastDeviation = 0;
+    for (unsigned int k=0;k<m_nx;k++)
+    {
+        m_lastDeviation = std::max(m_lastDeviation, std::fabs((double)m_x_i[k] - x_shadow[k]));
+        m_x_i[k] = (T)x_shadow[k];
+    }
+    m_maxDeviation = std::max(m_maxDeviation, m_lastDeviation);
+
+    m_windowSteps = 0;
+    m_drift = 0;
+    m_resyncCount++;
+}
+
+/**
+ * @return Number of steps between two resynchronizations.
+ ******/
+template<typename T>
+unsigned int MixedPrecisionStateSpaceController<T>::getResyncInterval() const
+{
+    return m_resyncInterval;
+}
+
+/**
+ * @details The recorded errors are replayed first if they do not fit in the new interval.
+ * @param resyncInterval Number of steps between two resynchronizations (0 is replaced by 1).
+ ******/
+template<typename T>
+void MixedPrecisionStateSpaceController<T>::setResyncInterval(const unsigned int resyncInterval)
+{
+    if (m_windowSteps >= resyncInterval)
+    {
+        resynchronize();
+    }
+
+    m_resyncInterval = std::max(1u, resyncInterval);
+    m_window.resize(m_resyncInterval * m_ne, 0);
+    computeResponse();
+}
+
+/**
+ * @return Drift estimate triggering an early resynchronization (0: disabled).
+ ******/
+template<typename T>
+double MixedPrecisionStateSpaceController<T>::getDriftThreshold() const
+{
+    return m_driftThreshold;
+}
+
+/**
+ * @param driftThreshold Drift estimate triggering an early resynchronization (0 to disable).
+ ******/
+template<typename T>
+void MixedPrecisionStateSpaceController<T>::setDriftThreshold(const double driftThreshold)
+{
+    m_driftThreshold = driftThreshold;
+}
+
+/**
+ * @return Deviation between the low-precision and double states at the last resynchronization.
+ ******/
+template<typename T>
+double MixedPrecisionStateSpaceController<T>::getLastDeviation() const
+{
+    return m_lastDeviation;
+}
+
+/**
+ * @return Largest deviation between the low-precision and double states since reset.
+ ******/
+template<typename T>
+double MixedPrecisionStateSpaceController<T>::getMaxDeviation() const
+{
+    return m_maxDeviation;
+}
+
+/**
+ * @return Drift estimate since the last resynchronization.
+ ******/
+template<typename T>
+double MixedPrecisionStateSpaceController<T>::getDriftEstimate() const
+{
+    return m_drift;
+}
+
+/**
+ * @return Number of resynchronizations since reset.
+ ******/
+template<typename T>
+unsigned int MixedPrecisionStateSpaceController<T>::getResyncCount() const
+{
+    return m_resyncCount;
+}
+
+/**
+ * @return Double multiply-adds of a resynchronization every resyncInterval steps, divided by the interval.
+ ******/
+template<typename T>
+double MixedPrecisionStateSpaceController<T>::getResyncCostPerStep() const
+{
+    unsigned int bits = 0;
+    for (unsigned int k=m_resyncInterval;k!=0;k>>=1)
+    {
+        bits += k & 1u;
+    }
+
+    return ((double)bits * m_nx * m_nx + (double)m_resyncInterval * m_nx * m_ne) / m_resyncInterval;
+}
+
+/**
+ * @return T multiply-adds of a step ((nx + nu) x (nx + ne)).
+ ******/
+template<typename T>
+unsigned int MixedPrecisionStateSpaceController<T>::getStepCost() const
+{
+    return (m_nx + m_nu) * (m_nx + m_ne);
+}
+
+/**
+ * @return Double state at the last resynchronization.
+ ******/
+template<typename T>
+const std::vector<double>& MixedPrecisionStateSpaceController<T>::getSynchronizedState() const
+{
+    return m_xSync;
+}
+
+/**
+ * @return Current state vector (low precision, converted to double).
+ ******/
+template<typename T>
+std::vector<double> MixedPrecisionStateSpaceController<T>::getX_i() const
+{
+    return std::vector<double>(m_x_i.begin(), m_x_i.end());
+}
+
+/**
+ * @return Double controller the matrices come from (its state is not stepped, see getSynchronizedState()).
+ ******/
+template<typename T>
+const StateSpaceController<double>& MixedPrecisionStateSpaceController<T>::getShadow() const
+{
+    return m_shadow;
+}
+
+/**
+ * @return Controller time step (seconds).
+ ******/
+template<typename T>
+float MixedPrecisionStateSpaceController<T>::getTimeStep() const
+{
+    return m_t_s;
+}
+
+/**
+ * @return Current time (seconds).
+ ******/
+template<typename T>
+float MixedPrecisionStateSpaceController<T>::getTime() const
+{
+    return m_t;
+}
+
+/**
+ * @return State vector dimension.
+ ******/
+template<typename T>
+unsigned int MixedPrecisionStateSpaceController<T>::getNx() const
+{
+    return m_nx;
+}
+
+/**
+ * @return Error vector dimension.
+ ******/
+template<typename T>
+unsigned int MixedPrecisionStateSpaceController<T>::getNe() const
+{
+    return m_ne;
+}
+
+/**
+ * @return Controller output vector dimension.
+ ******/
+template<typename T>
+unsigned int MixedPrecisionStateSpaceController<T>::getNu() const
+{
+    return m_nu;
+}
+
+/**
+ * @brief Resets time, states, shadow and resynchronization statistics.
+ ******/
+template<typename T>
+void MixedPrecisionStateSpaceController<T>::reset()
+{
+    m_shadow.reset();
+    std::fill(m_xSync.begin(), m_xSync.end(), 0);
+
+    std::fill(m_x_i.begin(), m_x_i.end(), 0);
+    std::fill(m_x_ip1.begin(), m_x_ip1.end(), 0);
+    std::fill(m_e_i.begin(), m_e_i.end(), 0);
+    std::fill(m_u_i.begin(), m_u_i.end(), 0);
+
+    m_windowSteps = 0;
+    m_drift = 0;
+    m_lastDeviation = 0;
+    m_maxDeviation = 0;
+    m_resyncCount = 0;
+
+    m_i = 0;
+    m_t = 0;
+}
+
+#endif
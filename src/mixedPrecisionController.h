@@ -0,0 +1,170 @@
+/**
+ * @file mixedPrecisionController.h
+ * @brief MixedPrecisionStateSpaceController class header.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef MIXEDPRECISIONCONTROLLER_H
+#define MIXEDPRECISIONCONTROLLER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+
+/**
+ * @class MixedPrecisionStateSpaceController
+ * @brief State-space controller stepping in low precision (float) with double-precision resynchronization.
+ * @details Matrices and state are stored in T (float) and each step is a T matrix-vector product with
+ * compensated (Neumaier) accumulation over (nx + nu) x (nx + ne) coefficients of sizeof(T) bytes.
+ *
+ * The errors applied since the last synchronization are recorded and, every resyncInterval steps K (or as
+ * soon as the drift estimate exceeds driftThreshold), the double state after these w steps is computed
+ * without stepping a double controller:
+ *
+ *      x_w = A^w * x_0 + sum_{j<w} A^(w-1-j)*B * e_j
+ *
+ * with A^w applied from the cached powers A^(2^j) and the blocks A^p*B (p < K) computed once. The T state
+ * is then overwritten by the double state. A resynchronization costs popcount(w)*nx^2 + w*nx*ne double
+ * multiply-adds, i.e. nx*ne + log2(K)*nx^2/K per step instead of a full double step; the blocks take
+ * K*nx*ne doubles of memory. getResyncCostPerStep() reports this cost for the current interval.
+ * The deviation observed at each resynchronization is available with getLastDeviation() / getMaxDeviation().
+ *
+ * The drift estimate is the sum, since the last resynchronization, of the error introduced by the
+ * rounding of A and B to T on each step (||A - A_T|| * ||x|| + ||B - B_T|| * ||e||) plus the T rounding of x.
+ ******/
+template <typename T>
+class MixedPrecisionStateSpaceController
+{
+    public:
+
+    // Constructor from a double controller (copied as shadow)
+    MixedPrecisionStateSpaceController(const StateSpaceController<double>& reference, const unsigned int resyncInterval, const double driftThreshold = 0);
+
+    // Constructor from controller.dat (see StateSpaceController::help())
+    MixedPrecisionStateSpaceController(std::string formattedDataFilePath, const unsigned int resyncInterval, const double driftThreshold = 0);
+
+    virtual ~MixedPrecisionStateSpaceController();
+
+    // Same interface as StateSpaceController
+    std::vector<double> currentOutput(const std::vector<double>& e_i);
+    std::vector<double> currentOutput(const std::vector<double>& e_i, const double& u_min, const double& u_max);
+    std::vector<double> currentOutput(const std::vector<double>& r_i, const std::vector<double>& y_i);
+
+    // Compute the double state from the recorded errors and overwrite the low-precision state
+    void resynchronize();
+
+    // Resynchronization parameters (an interval of 0 is replaced by 1)
+    unsigned int getResyncInterval() const;
+    void setResyncInterval(const unsigned int resyncInterval);
+    double getDriftThreshold() const;
+    void setDriftThreshold(const double driftThreshold);
+
+    // Deviation (infinity norm of x_T - x_double) observed at the last resynchronization / since reset
+    double getLastDeviation() const;
+    double getMaxDeviation() const;
+
+    // Current drift estimate (since the last resynchronization)
+    double getDriftEstimate() const;
+
+    // Number of resynchronizations since reset
+    unsigned int getResyncCount() const;
+
+    // Double multiply-adds of the resynchronization per step (amortized over the interval) and of a T step
+    double getResyncCostPerStep() const;
+    unsigned int getStepCost() const;
+
+    // Current state vector (low precision, converted to double)
+    std::vector<double> getX_i() const;
+
+    // Double state at the last resynchronization
+    const std::vector<double>& getSynchronizedState() const;
+
+    // Double controller the matrices come from (not stepped)
+    const StateSpaceController<double>& getShadow() const;
+
+    float getTimeStep() const;
+    float getTime() const;
+    unsigned int getNx() const;
+    unsigned int getNe() const;
+    unsigned int getNu() const;
+
+    // Reset time, states, shadow and statistics (to zero)
+    void reset();
+
+    protected:
+    // Convert the shadow matrices to T and compute the rounding norms
+    void convertMatrices();
+
+    // Compute the powers A^(2^j) and the blocks A^p*B (p < resyncInterval) of the resynchronization
+    void computeResponse();
+
+    // Compensated dot product (Neumaier summation), added to sum and compensation
+    static void accumulate(const T* row, const T* vec, const unsigned int length, T& sum, T& compensation);
+
+    // Infinity norm of (M - M_T), M_T being the row-major T copy of M
+    static double roundingNorm(const QSMatrix<double>& M, const std::vector<T>& converted);
+
+    /**
+     * @brief Double controller the matrices come from.
+     ******/
+    StateSpaceController<double> m_shadow;
+
+    /**
+     * @brief Double state at the last resynchronization.
+     ******/
+    std::vector<double> m_xSync;
+
+    /**
+     * @brief A^(2^j) for the bits of resyncInterval, and A^p*B for p < resyncInterval (nx x ne blocks, row-major).
+     ******/
+    std::vector<QSMatrix<double> > m_powers;
+    std::vector<double> m_response;
+
+    /**
+     * @brief Low-precision matrices (row-major).
+     ******/
+    std::vector<T> m_A, m_B, m_C, m_D;
+
+    /**
+     * @brief Infinity norms of the rounding errors of A and B.
+     ******/
+    double m_dA, m_dB;
+
+    /**
+     * @brief Errors applied since the last resynchronization (row-major, one row per step).
+     ******/
+    std::vector<double> m_window;
+
+    unsigned int m_windowSteps;
+    unsigned int m_resyncInterval;
+    double m_driftThreshold;
+    double m_drift;
+    double m_lastDeviation;
+    double m_maxDeviation;
+    unsigned int m_resyncCount;
+
+    unsigned int m_nx, m_ne, m_nu;
+
+    float m_t_s;
+    unsigned int m_i;
+    float m_t;
+
+    /**
+     * @brief Current and next state, error and output vectors (low precision).
+     ******/
+    std::vector<T> m_x_i, m_x_ip1, m_e_i, m_u_i;
+};
+
+/**
+ * @brief Float stepping with double resynchronization.
+ ******/
+typedef MixedPrecisionStateSpaceController<float> MixedPrecisionController;
+
+#include "mixedPrecisionController.cpp"
+
+#endif  // MIXEDPRECISIONCONTROLLER_H
@@ -0,0 +1,430 @@
+/**
+ * @file modelReduction.cpp
+ * @brief Balanced truncation of state-space controllers (source).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef MODELREDUCTION_CPP
+#define MODELREDUCTION_CPP
+
+#include "modelReduction.h"
+#include "discretization.h"
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * @brief Prints the Hankel singular values, the orders and the error bound.
+ ******/
+template<typename T>
+void BalancedTruncationReport<T>::print() const
+{
+    if (!success)
+    {
+        std::cout << "Balanced truncation failed (unstable controller?)" << std::endl << std::endl;
+        return;
+    }
+
+    std::cout << "Hankel singular values:";
+    for (unsigned int k=0;k<hankelSingularValues.size();k++)
+    {
+        std::cout << " " << hankelSingularValues[k];
+    }
+    std::cout << std::endl;
+
+    std::cout << "Order " << originalOrder << " -> " << reducedOrder << ", H infinity error bound: " << errorBound << std::endl << std::endl;
+}
+
+/**
+ * @brief Solves the discrete Lyapunov equation A*X*A' - X + Q = 0.
+ * @details Smith doubling iteration: X_{k+1} = X_k + A^(2^k) X_k A^(2^k)', X_0 = Q.
+ * @param A Stable square matrix (spectral radius < 1).
+ * @param Q Symmetric matrix.
+ * @param X Solution.
+ * @return False if the iteration does not converge (A not stable).
+ ******/
+template<typename T>
+bool discreteLyapunov(const QSMatrix<T>& A, const QSMatrix<T>& Q, QSMatrix<T>& X)
+{
+    const T tolerance = 10 * std::numeric_limits<T>::epsilon();
+
+    X = Q;
+    QSMatrix<T> Ak(A);
+
+    for (int iteration=0;iteration<64;iteration++)
+    {
+        QSMatrix<T> increment = Ak * X * Ak.transpose();
+        X = X + increment;
+        Ak = Ak * Ak;
+
+        T norm = norm1(X);
+        if (!std::isfinite(norm))
+        {
+            return false;
+        }
+        if (norm1(increment) <= tolerance * norm)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Eigen decomposition of a symmetric matrix (cyclic Jacobi): S = V*diag(eigenvalues)*V'.
+ * @param S Symmetric matrix.
+ * @param eigenvalues Eigenvalues (not sorted).
+ * @param V Orthogonal matrix of the eigenvectors (columns).
+ ******/
+template<typename T>
+void symmetricEigen(const QSMatrix<T>& S, std::vector<T>& eigenvalues, QSMatrix<T>& V)
+{
+    const unsigned int n = S.get_rows();
+    const T tolerance = std::numeric_limits<T>::epsilon();
+
+    QSMatrix<T> A(S);
+    V = identityMatrix<T>(n);
+
+    for (int sweep=0;sweep<100;sweep++)
+    {
+        T offDiagonal = 0, diagonal = 0;
+        for (unsigned int p=0;p<n;p++)
+        {
+            diagonal += A(p,p) * A(p,p);
+            for (unsigned int q=p+1;q<n;q++) offDiagonal += A(p,q) * A(p,q);
+        }
+        if (offDiagonal <= tolerance * tolerance * diagonal)
+        {
+            break;
+        }
+
+        for (unsigned int p=0;p<n;p++)
+        {
+            for (unsigned int q=p+1;q<n;q++)
+            {
+                if (A(p,q) == 0) continue;
+
+                T theta = (A(q,q) - A(p,p)) / (2 * A(p,q));
+                T t = ((theta >= 0) ? 1 : -1) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+                T c = 1 / std::sqrt(t * t + 1);
+                T s = t * c;
+
+                for (unsigned int k=0;k<n;k++)
+                {
+                    T akp = A(k,p), akq = A(k,q);
+                    A(k,p) = c * akp - s * akq;
+                    A(k,q) = s * akp + c * akq;
+                }
+                for (unsigned int k=0;k<n;k++)
+                {
+                    T apk = A(p,k), aqk = A(q,k);
+                    A(p,k) = c * apk - s * aqk;
+                    A(q,k) = s * apk + c * aqk;
+                }
+                for (unsigned int k=0;k<n;k++)
+                {
+                    T vkp = V(k,p), vkq = V(k,q);
+                    V(k,p) = c * vkp - s * vkq;
+                    V(k,q) = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    eigenvalues.resize(n);
+    for (unsigned int k=0;k<n;k++)
+    {
+        eigenvalues[k] = A(k,k);
+    }
+}
+
+/**
+ * @brief Singular value decomposition (one-sided Jacobi): M = U*diag(sigma)*V'.
+ * @param M Matrix (m x n).
+ * @param U Left singular vectors (m x n, columns).
+ * @param sigma Singular values (decreasing order).
+ * @param V Right singular vectors (n x n, columns).
+ ******/
+template<typename T>
+void singularValueDecomposition(const QSMatrix<T>& M, QSMatrix<T>& U, std::vector<T>& sigma, QSMatrix<T>& V)
+{
+    const unsigned int m = M.get_rows();
+    const unsigned int n = M.get_cols();
+    const T tolerance = std::numeric_limits<T>::epsilon();
+
+    QSMatrix<T> W = M.transpose();  // Rows of W are the columns of M
+    QSMatrix<T> Vt = identityMatrix<T>(n);  // Rows of Vt are the columns of V
+
+    for (int sweep=0;sweep<100;sweep++)
+    {
+        bool rotated = false;
+
+        for (unsigned int i=0;i<n;i++)
+        {
+            for (unsigned int j=i+1;j<n;j++)
+            {
+                T alpha = 0, beta = 0, gamma = 0;
+                for (unsigned int k=0;k<m;k++)
+                {
+                    alpha += W(i,k) * W(i,k);
+                    beta += W(j,k) * W(j,k);
+                    gamma += W(i,k) * W(j,k);
+                }
+
+                if (std::fabs(gamma) <= tolerance * std::sqrt(alpha * beta) || gamma == 0)
+                {
+                    continue;
+                }
+                rotated = true;
+
+                T zeta = (beta - alpha) / (2 * gamma);
+                T t = ((zeta >= 0) ? 1 : -1) / (std::fabs(zeta) + std::sqrt(1 + zeta * zeta));
+                T c = 1 / std::sqrt(1 + t * t);
+                T s = c * t;
+
+                for (unsigned int k=0;k<m;k++)
+                {
+                    T wi = W(i,k), wj = W(j,k);
+                    W(i,k) = c * wi - s * wj;
+                    W(j,k) = s * wi + c * wj;
+                }
+                for (unsigned int k=0;k<n;k++)
+                {
+                    T vi = Vt(i,k), vj = Vt(j,k);
+                    Vt(i,k) = c * vi - s * vj;
+                    Vt(j,k) = s * vi + c * vj;
+                }
+            }
+        }
+
+        if (!rotated)
+        {
+            break;
+        }
+    }
+
+    // Singular values, sorted in decreasing order
+    std::vector<T> norms(n, 0);
+    std::vector<unsigned int> order(n);
+    for (unsigned int i=0;i<n;i++)
+    {
+        for (unsigned int k=0;k<m;k++) norms[i] += W(i,k) * W(i,k);
+        norms[i] = std::sqrt(norms[i]);
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&norms](unsigned int a, unsigned int b) {
+        return norms[a] > norms[b];
+    });
+
+    sigma.resize(n);
+    U = QSMatrix<T>(m, n, 0);
+    V = QSMatrix<T>(n, n, 0);
+    for (unsigned int col=0;col<n;col++)
+    {
+        unsigned int i = order[col];
+        sigma[col] = norms[i];
+
+        for (unsigned int k=0;k<m;k++) U(k,col) = (norms[i] > 0) ? W(i,k) / norms[i] : 0;
+        for (unsigned int k=0;k<n;k++) V(k,col) = Vt(i,k);
+    }
+}
+
+/**
+ * @brief Square root factor L of a symmetric positive semi-definite matrix: P = L*L'.
+ ******/
+template<typename T>
+QSMatrix<T> gramianFactor(const QSMatrix<T>& P)
+{
+    std::vector<T> eigenvalues;
+    QSMatrix<T> V;
+    symmetricEigen(P, eigenvalues, V);
+
+    QSMatrix<T> L(V);
+    for (unsigned int col=0;col<eigenvalues.size();col++)
+    {
+        T scale = std::sqrt(std::max((T)0, eigenvalues[col]));
+        for (unsigned int row=0;row<L.get_rows();row++)
+        {
+            L(row,col) *= scale;
+        }
+    }
+
+    return L;
+}
+
+/**
+ * @brief Gramian factors of a controller and SVD of Lq'*Lp (square root balanced truncation).
+ * @return False if a Lyapunov equation cannot be solved (unstable controller).
+ ******/
+template<typename T>
+bool balancedFactors(const StateSpaceController<T>& controller, QSMatrix<T>& Lp, QSMatrix<T>& Lq, QSMatrix<T>& U, std::vector<T>& sigma, QSMatrix<T>& V)
+{
+    const QSMatrix<T>& A = controller.getA();
+    const QSMatrix<T>& B = controller.getB();
+    const QSMatrix<T>& C = controller.getC();
+
+    QSMatrix<T> P, Q;
+    if (!discreteLyapunov(A, B * B.transpose(), P) || !discreteLyapunov(A.transpose(), C.transpose() * C, Q))
+    {
+        std::cout << "\033[1;31mERROR: Balanced truncation needs a stable controller (Lyapunov equations do not converge).\033[0m" << std::endl << std::endl;
+        return false;
+    }
+
+    Lp = gramianFactor(P);
+    Lq = gramianFactor(Q);
+
+    singularValueDecomposition(Lq.transpose() * Lp, U, sigma, V);
+
+    return true;
+}
+
+/**
+ * @brief Hankel singular values of a controller.
+ * @param controller Stable controller.
+ * @return Hankel singular values in decreasing order (empty if the controller is not stable).
+ ******/
+template<typename T>
+std::vector<T> hankelSingularValues(const StateSpaceController<T>& controller)
+{
+    QSMatrix<T> Lp, Lq, U, V;
+    std::vector<T> sigma;
+
+    if (!balancedFactors(controller, Lp, Lq, U, sigma, V))
+    {
+        sigma.clear();
+    }
+
+    return sigma;
+}
+
+/**
+ * @brief Projects the controller on its r most controllable and observable balanced states.
+ ******/
+template<typename T>
+StateSpaceController<T> balancedProjection(const StateSpaceController<T>& controller, const QSMatrix<T>& Lp, const QSMatrix<T>& Lq, const QSMatrix<T>& U, const std::vector<T>& sigma, const QSMatrix<T>& V, unsigned int order, BalancedTruncationReport<T>* report)
+{
+    const unsigned int n = controller.getNx();
+
+    // Only states with a non-negligible Hankel singular value can be balanced
+    unsigned int rank = 0;
+    while (rank < sigma.size() && sigma[rank] > sigma[0] * n * std::numeric_limits<T>::epsilon())
+    {
+        rank++;
+    }
+    order = std::max(1u, std::min(order, rank));
+
+    // T_left = S^-1/2 U' Lq' (order x n), T_right = Lp V S^-1/2 (n x order)
+    QSMatrix<T> left(order, n, 0);
+    QSMatrix<T> right(n, order, 0);
+    const QSMatrix<T> LqT = Lq.transpose();
+
+    for (unsigned int r=0;r<order;r++)
+    {
+        T scale = 1 / std::sqrt(sigma[r]);
+
+        for (unsigned int col=0;col<n;col++)
+        {
+            T sumLeft = 0, sumRight = 0;
+            for (unsigned int k=0;k<n;k++)
+            {
+                sumLeft += U(k,r) * LqT(k,col);
+                sumRight += Lp(col,k) * V(k,r);
+            }
+            left(r,col) = sumLeft * scale;
+            right(col,r) = sumRight * scale;
+        }
+    }
+
+    StateSpaceController<T> reduced(left * controller.getA() * right, left * controller.getB(), controller.getC() * right, controller.getD(), controller.getTimeStep());
+
+    if (report)
+    {
+        report->hankelSingularValues = sigma;
+        report->originalOrder = n;
+        report->reducedOrder = order;
+        report->errorBound = 0;
+        for (unsigned int k=order;k<sigma.size();k++)
+        {
+            report->errorBound += 2 * sigma[k];
+        }
+        report->success = true;
+    }
+
+    return reduced;
+}
+
+/**
+ * @brief Fills the report of a failed reduction.
+ ******/
+template<typename T>
+void balancedTruncationFailure(const StateSpaceController<T>& controller, BalancedTruncationReport<T>* report)
+{
+    if (report)
+    {
+        report->hankelSingularValues.clear();
+        report->originalOrder = controller.getNx();
+        report->reducedOrder = controller.getNx();
+        report->errorBound = 0;
+        report->success = false;
+    }
+}
+
+/**
+ * @brief Reduces a controller to a given order by balanced truncation.
+ * @details The controller must be stable. The reduced order is limited to the number of non-negligible
+ * Hankel singular values. If the controller is not stable, a copy of it is returned.
+ * @param controller Controller to reduce.
+ * @param order Order (state dimension) of the reduced controller.
+ * @param report Optional report (Hankel singular values, H infinity error bound).
+ * @return Reduced controller (same time step, zero state).
+ ******/
+template<typename T>
+StateSpaceController<T> balancedTruncation(const StateSpaceController<T>& controller, const unsigned int order, BalancedTruncationReport<T>* report)
+{
+    QSMatrix<T> Lp, Lq, U, V;
+    std::vector<T> sigma;
+
+    if (!balancedFactors(controller, Lp, Lq, U, sigma, V))
+    {
+        balancedTruncationFailure(controller, report);
+        return controller;
+    }
+
+    return balancedProjection(controller, Lp, Lq, U, sigma, V, order, report);
+}
+
+/**
+ * @brief Reduces a controller to the smallest order whose H infinity error bound is below maxError.
+ * @details The bound is twice the sum of the truncated Hankel singular values.
+ * If the controller is not stable, a copy of it is returned.
+ * @param controller Controller to reduce.
+ * @param maxError Largest H infinity error bound accepted.
+ * @param report Optional report (Hankel singular values, H infinity error bound).
+ * @return Reduced controller (same time step, zero state).
+ ******/
+template<typename T>
+StateSpaceController<T> balancedTruncationErrorBound(const StateSpaceController<T>& controller, const T maxError, BalancedTruncationReport<T>* report)
+{
+    QSMatrix<T> Lp, Lq, U, V;
+    std::vector<T> sigma;
+
+    if (!balancedFactors(controller, Lp, Lq, U, sigma, V))
+    {
+        balancedTruncationFailure(controller, report);
+        return controller;
+    }
+
+    unsigned int order = sigma.size();
+    T bound = 0;
+    while (order > 1 && bound + 2 * sigma[order - 1] <= maxError)
+    {
+        bound += 2 * sigma[order - 1];
+        order--;
+    }
+
+    return balancedProjection(controller, Lp, Lq, U, sigma, V, order, report);
+}
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * @file modelReduction.h
+ * @brief Balanced truncation of state-space controllers (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef MODELREDUCTION_H
+#define MODELREDUCTION_H
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+
+/**
+ * @struct BalancedTruncationReport
+ * @brief Result of a balanced truncation.
+ * @details errorBound is the H infinity bound of the reduction error: twice the sum of the truncated
+ * Hankel singular values.
+ ******/
+template <typename T>
+struct BalancedTruncationReport
+{
+    std::vector<T> hankelSingularValues;  // Decreasing order
+    unsigned int originalOrder;
+    unsigned int reducedOrder;
+    T errorBound;
+    bool success;
+
+    void print() const;
+};
+
+// Solution X of the discrete Lyapunov equation A*X*A' - X + Q = 0 (A must be stable)
+template <typename T>
+bool discreteLyapunov(const QSMatrix<T>& A, const QSMatrix<T>& Q, QSMatrix<T>& X);
+
+// Eigenvalues and eigenvectors (columns of V) of a symmetric matrix (cyclic Jacobi)
+template <typename T>
+void symmetricEigen(const QSMatrix<T>& S, std::vector<T>& eigenvalues, QSMatrix<T>& V);
+
+// Singular value decomposition M = U*diag(sigma)*V' (one-sided Jacobi), decreasing singular values
+template <typename T>
+void singularValueDecomposition(const QSMatrix<T>& M, QSMatrix<T>& U, std::vector<T>& sigma, QSMatrix<T>& V);
+
+// Hankel singular values of a controller (decreasing order)
+template <typename T>
+std::vector<T> hankelSingularValues(const StateSpaceController<T>& controller);
+
+// Reduced controller of the given order
+template <typename T>
+StateSpaceController<T> balancedTruncation(const StateSpaceController<T>& controller, const unsigned int order, BalancedTruncationReport<T>* report = 0);
+
+// Smallest reduced controller whose H infinity error bound is below maxError
+template <typename T>
+StateSpaceController<T> balancedTruncationErrorBound(const StateSpaceController<T>& controller, const T maxError, BalancedTruncationReport<T>* report = 0);
+
+#include "modelReduction.cpp"
+
+#endif  // MODELREDUCTION_H
@@ -0,0 +1,409 @@
+/**
+ * @file multiRateController.cpp
+ * @brief MultiRateController class source file.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef MULTIRATECONTROLLER_CPP
+#define MULTIRATECONTROLLER_CPP
+
+#include "multiRateController.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Longest hyperperiod (base ticks) for which the schedule is tabulated.
+ ******/
+#define MULTIRATE_MAX_SCHEDULE 4096
+
+/**
+ * @brief Constructor.
+ * @param t_base Base time step (seconds).
+ ******/
+template<typename T>
+MultiRateController<T>::MultiRateController(const float t_base):
+m_t_base(t_base), m_tick(0), m_hyperperiod(1), m_scheduleValid(false)
+{
+}
+
+/**
+ * @brief Destructor.
+ ******/
+template<typename T>
+MultiRateController<T>::~MultiRateController() {}
+
+/**
+ * @brief Registers a controller.
+ * @details A warning is displayed if the time step of the controller is not divisor * base time step.
+ * @param controller Controller (not copied, must outlive this object).
+ * @param divisor The controller steps every divisor base ticks (0 is replaced by 1).
+ * @return Index of the controller.
+ ******/
+template<typename T>
+unsigned int MultiRateController<T>::addController(StateSpaceController<T>* controller, const unsigned int divisor)
+{
+    return addEntry(controller, -1, divisor, *controller);
+}
+
+/**
+ * @brief Registers a copy of a controller in the bank.
+ * @details The copy (matrices and state) is an ArenaStateSpaceController allocated from the arena of this
+ * object, after the previous ones: it steps without allocation and its output is written in place.
+ * @param controller Controller to copy.
+ * @param divisor The controller steps every divisor base ticks (0 is replaced by 1).
+ * @return Index of the controller.
+ ******/
+template<typename T>
+unsigned int MultiRateController<T>::addControllerCopy(const StateSpaceController<T>& controller, const unsigned int divisor)
+{
+    m_bank.push_back(ArenaStateSpaceController<T>(controller, &m_arena));
+
+    return addEntry(0, m_bank.size() - 1, divisor, controller);
+}
+
+/**
+ * @brief Adds an entry and checks the time step of its controller.
+ ******/
+template<typename T>
+unsigned int MultiRateController<T>::addEntry(StateSpaceController<T>* controller, const int bank, const unsigned int divisor, const StateSpaceController<T>& model)
+{
+    Entry entry;
+    entry.controller = controller;
+    entry.bank = bank;
+    entry.divisor = std::max(1u, divisor);
+    entry.r.assign(model.getNe(), 0);
+    entry.y.assign(model.getNe(), 0);
+    entry.u.assign(model.getNu(), 0);
+
+    const float t_s = entry.divisor * m_t_base;
+    if (std::fabs(model.getTimeStep() - t_s) > 1e-6f * t_s)
+    {
+        std::cout << "\033[1;33mWARNING: Controller time step (" << model.getTimeStep() << " s) differs from its rate in the multi-rate controller ("
+        << t_s << " s).\033[0m" << std::endl << std::endl;
+    }
+
+    m_entries.push_back(entry);
+    m_scheduleValid = false;
+
+    return m_entries.size() - 1;
+}
+
+/**
+ * @brief Uses the output of a controller as reference of another one.
+ * @param from Index of the source controller.
+ * @param fromOutput Output of the source controller.
+ * @param to Index of the destination controller.
+ * @param toInput Reference input of the destination controller.
+ * @param transition Rate transition (see RateTransition).
+ ******/
+template<typename T>
+void MultiRateController<T>::connect(const unsigned int from, const unsigned int fromOutput, const unsigned int to, const unsigned int toInput, const RateTransition transition)
+{
+    if (from >= m_entries.size() || to >= m_entries.size() || fromOutput >= m_entries[from].u.size() || toInput >= m_entries[to].r.size())
+    {
+        std::cout << "\033[1;31mERROR: Invalid connection in the multi-rate controller.\033[0m" << std::endl << std::endl;
+        return;
+    }
+
+    Connection connection;
+    connection.from = from;
+    connection.fromOutput = fromOutput;
+    connection.to = to;
+    connection.toInput = toInput;
+    connection.transition = transition;
+    connection.value = m_entries[from].u[fromOutput];
+    connection.sum = 0;
+    connection.count = 0;
+
+    m_connections.push_back(connection);
+    m_entries[from].outputs.push_back(m_connections.size() - 1);
+    m_entries[to].inputs.push_back(m_connections.size() - 1);
+}
+
+/**
+ * @param index Index of the controller.
+ * @param r Reference vector, ne values (inputs driven by a connection are overwritten).
+ ******/
+template<typename T>
+void MultiRateController<T>::setReference(const unsigned int index, const std::vector<T>& r)
+{
+    if (index >= m_entries.size() || r.size() != m_entries[index].r.size())
+    {
+        std::cout << "\033[1;31mERROR: Invalid reference in the multi-rate controller.\033[0m" << std::endl << std::endl;
+        return;
+    }
+
+    std::copy(r.begin(), r.end(), m_entries[index].r.begin());
+}
+
+/**
+ * @param index Index of the controller.
+ * @param y Measured plant output vector, ne values.
+ ******/
+template<typename T>
+void MultiRateController<T>::setMeasurement(const unsigned int index, const std::vector<T>& y)
+{
+    if (index >= m_entries.size() || y.size() != m_entries[index].y.size())
+    {
+        std::cout << "\033[1;31mERROR: Invalid measurement in the multi-rate controller.\033[0m" << std::endl << std::endl;
+        return;
+    }
+
+    std::copy(y.begin(), y.end(), m_entries[index].y.begin());
+}
+
+/**
+ * @brief Computes the controllers due on each tick of the hyperperiod (slowest first).
+ ******/
+template<typename T>
+void MultiRateController<T>::computeSchedule()
+{
+    // Least common multiple of the divisors
+    unsigned long hyperperiod = 1;
+    for (unsigned int k=0;k<m_entries.size() && hyperperiod <= MULTIRATE_MAX_SCHEDULE;k++)
+    {
+        unsigned long a = hyperperiod, b = m_entries[k].divisor;
+        while (b != 0)
+        {
+            unsigned long t = a % b;
+            a = b;
+            b = t;
+        }
+        hyperperiod = hyperperiod / a * m_entries[k].divisor;
+    }
+
+    m_schedule.clear();
+
+    if (hyperperiod <= MULTIRATE_MAX_SCHEDULE)
+    {
+        m_hyperperiod = hyperperiod;
+        m_schedule.resize(m_hyperperiod);
+
+        for (unsigned int tick=0;tick<m_hyperperiod;tick++)
+        {
+            dueControllers(tick, m_schedule[tick]);
+        }
+    }
+    else
+    {
+        m_hyperperiod = 0;
+    }
+
+    m_scheduleValid = true;
+}
+
+/**
+ * @brief Controllers due on a tick, slowest first (registration order for equal rates).
+ ******/
+template<typename T>
+void MultiRateController<T>::dueControllers(const unsigned long tick, std::vector<unsigned int>& due) const
+{
+    due.clear();
+
+    for (unsigned int k=0;k<m_entries.size();k++)
+    {
+        if (tick % m_entries[k].divisor == 0)
+        {
+            due.push_back(k);
+        }
+    }
+
+    std::stable_sort(due.begin(), due.end(), [this](unsigned int a, unsigned int b) {
+        return m_entries[a].divisor > m_entries[b].divisor;
+    });
+}
+
+/**
+ * @brief Steps all controllers due on the current base tick then increments the tick.
+ * @details For each due controller: references driven by connections are updated (held value or
+ * average since its last step), the controller steps with e = r - y, then its outgoing connections are updated.
+ * Bank controllers step in place (no allocation).
+ * @return Number of controllers stepped.
+ ******/
+template<typename T>
+unsigned int MultiRateController<T>::tick()
+{
+    if (!m_scheduleValid)
+    {
+        computeSchedule();
+    }
+
+    const std::vector<unsigned int>* due = &m_due;
+    if (m_hyperperiod > 0)
+    {
+        due = &m_schedule[m_tick % m_hyperperiod];
+    }
+    else
+    {
+        dueControllers(m_tick, m_due);
+    }
+
+    for (unsigned int k=0;k<due->size();k++)
+    {
+        Entry& entry = m_entries[(*due)[k]];
+
+        for (unsigned int c=0;c<entry.inputs.size();c++)
+        {
+            Connection& connection = m_connections[entry.inputs[c]];
+
+            if (connection.transition == AVERAGE && connection.count > 0)
+            {
+                entry.r[connection.toInput] = connection.sum / (T)connection.count;
+            }
+            else
+            {
+                entry.r[connection.toInput] = connection.value;
+            }
+            connection.sum = 0;
+            connection.count = 0;
+        }
+
+        if (entry.bank >= 0)
+        {
+            const T* u = m_bank[entry.bank].step(entry.r.data(), entry.y.data());
+            std::copy(u, u + entry.u.size(), entry.u.begin());
+        }
+        else
+        {
+            entry.u = entry.controller->currentOutput(entry.r, entry.y);
+        }
+
+        for (unsigned int c=0;c<entry.outputs.size();c++)
+        {
+            Connection& connection = m_connections[entry.outputs[c]];
+
+            connection.value = entry.u[connection.fromOutput];
+            connection.sum += connection.value;
+            connection.count++;
+        }
+    }
+
+    m_tick++;
+
+    return due->size();
+}
+
+/**
+ * @param index Index of the controller.
+ * @return Last output of the controller.
+ ******/
+template<typename T>
+const std::vector<T>& MultiRateController<T>::getOutput(const unsigned int index) const
+{
+    return m_entries[index].u;
+}
+
+/**
+ * @param index Index of the controller.
+ * @return Current state vector of the controller.
+ ******/
+template<typename T>
+std::vector<T> MultiRateController<T>::getX_i(const unsigned int index) const
+{
+    const Entry& entry = m_entries[index];
+
+    return (entry.bank >= 0) ? m_bank[entry.bank].getX_i() : entry.controller->getX_i();
+}
+
+/**
+ * @param index Index of the controller.
+ * @return True if the controller steps on the next call to tick().
+ ******/
+template<typename T>
+bool MultiRateController<T>::isDue(const unsigned int index) const
+{
+    return m_tick % m_entries[index].divisor == 0;
+}
+
+/**
+ * @return Number of registered controllers.
+ ******/
+template<typename T>
+unsigned int MultiRateController<T>::getControllerCount() const
+{
+    return m_entries.size();
+}
+
+/**
+ * @param index Index of the controller.
+ * @return Number of base ticks between two steps of the controller.
+ ******/
+template<typename T>
+unsigned int MultiRateController<T>::getDivisor(const unsigned int index) const
+{
+    return m_entries[index].divisor;
+}
+
+/**
+ * @return Hyperperiod (base ticks), 0 if too long to be tabulated.
+ ******/
+template<typename T>
+unsigned int MultiRateController<T>::getHyperperiod() const
+{
+    if (!m_scheduleValid)
+    {
+        const_cast<MultiRateController<T>*>(this)->computeSchedule();
+    }
+
+    return m_hyperperiod;
+}
+
+/**
+ * @return Base time step (seconds).
+ ******/
+template<typename T>
+float MultiRateController<T>::getBaseTimeStep() const
+{
+    return m_t_base;
+}
+
+/**
+ * @return Current time (seconds).
+ ******/
+template<typename T>
+float MultiRateController<T>::getTime() const
+{
+    return m_tick * m_t_base;
+}
+
+/**
+ * @return Current base tick.
+ ******/
+template<typename T>
+unsigned long MultiRateController<T>::getTick() const
+{
+    return m_tick;
+}
+
+/**
+ * @brief Resets the tick, the rate transitions and all controllers.
+ ******/
+template<typename T>
+void MultiRateController<T>::reset()
+{
+    m_tick = 0;
+
+    for (unsigned int k=0;k<m_entries.size();k++)
+    {
+        if (m_entries[k].bank >= 0)
+        {
+            m_bank[m_entries[k].bank].reset();
+        }
+        else
+        {
+            m_entries[k].controller->reset();
+        }
+        std::fill(m_entries[k].u.begin(), m_entries[k].u.end(), 0);
+    }
+
+    for (unsigned int c=0;c<m_connections.size();c++)
+    {
+        m_connections[c].value = 0;
+        m_connections[c].sum = 0;
+        m_connections[c].count = 0;
+    }
+}
+
+#endif
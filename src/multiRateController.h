@@ -0,0 +1,167 @@
+/**
+ * @file multiRateController.h
+ * @brief MultiRateController class header.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef MULTIRATECONTROLLER_H
+#define MULTIRATECONTROLLER_H
+
+#include <iostream>
+#include <vector>
+#include <memory_resource>
+
+#include "stateSpaceController.h"
+#include "arenaController.h"
+
+/**
+ * @brief Rate transition of a connection between two controllers.
+ * @details HOLD: the last output of the source is used (zero-order hold / sampling).
+ * AVERAGE: the mean of the source outputs since the last step of the destination is used
+ * (useful from a fast controller to a slower one, same as HOLD otherwise).
+ ******/
+enum RateTransition
+{
+    HOLD,
+    AVERAGE
+};
+
+/**
+ * @class MultiRateController
+ * @brief Composition of StateSpaceController objects running at integer multiples of a base tick.
+ * @details Each controller is registered with a divisor: it steps every divisor base ticks (its time step
+ * should be divisor * base time step). Controllers use the comparator (e = r - y): measurements y and
+ * references r are set by the user, or references come from the output of another controller through
+ * connect() with a rate transition (cascade loops).
+ *
+ * The controllers due on each tick of the hyperperiod (least common multiple of the divisors) are computed
+ * once, slowest first so that inner loops use the reference computed on the same tick: tick() only walks
+ * a precomputed list.
+ *
+ * Controllers registered with addController() are not copied: they must outlive the MultiRateController,
+ * and step through StateSpaceController::currentOutput() (with their idle mode and snapshots).
+ * Controllers registered with addControllerCopy() are copied into a bank of ArenaStateSpaceController taken from one
+ * monotonic arena: the controllers due on a tick step from contiguous blocks without allocation, their
+ * outputs written in place (register them slowest first so that each tick walks the bank forward).
+ ******/
+template <typename T>
+class MultiRateController
+{
+    public:
+
+    // Constructor with the base time step (seconds)
+    MultiRateController(const float t_base);
+
+    virtual ~MultiRateController();
+
+    // Register a controller stepping every divisor base ticks, returns its index
+    unsigned int addController(StateSpaceController<T>* controller, const unsigned int divisor);
+
+    // Register a copy of a controller in the bank (allocation-free steps, time restarting from 0), returns its index
+    unsigned int addControllerCopy(const StateSpaceController<T>& controller, const unsigned int divisor);
+
+    // Reference input toInput of controller "to" is output fromOutput of controller "from"
+    void connect(const unsigned int from, const unsigned int fromOutput, const unsigned int to, const unsigned int toInput, const RateTransition transition = HOLD);
+
+    // External reference and measurement of a controller (used on its next step, ne values)
+    void setReference(const unsigned int index, const std::vector<T>& r);
+    void setMeasurement(const unsigned int index, const std::vector<T>& y);
+
+    // Step all controllers due on the current base tick, returns the number of steps
+    unsigned int tick();
+
+    // Last output and current state of a controller
+    const std::vector<T>& getOutput(const unsigned int index) const;
+    std::vector<T> getX_i(const unsigned int index) const;
+
+    // Is the controller due on the current base tick?
+    bool isDue(const unsigned int index) const;
+
+    unsigned int getControllerCount() const;
+    unsigned int getDivisor(const unsigned int index) const;
+    unsigned int getHyperperiod() const;
+    float getBaseTimeStep() const;
+
+    // Current time (seconds) and base tick
+    float getTime() const;
+    unsigned long getTick() const;
+
+    // Reset the tick, transitions and all controllers
+    void reset();
+
+    protected:
+    // Add an entry (controller or bank index) and check its time step
+    unsigned int addEntry(StateSpaceController<T>* controller, const int bank, const unsigned int divisor, const StateSpaceController<T>& model);
+
+    // Compute the controllers due on each tick of the hyperperiod
+    void computeSchedule();
+
+    // Controllers due on a tick (slowest first)
+    void dueControllers(const unsigned long tick, std::vector<unsigned int>& due) const;
+
+    /**
+     * @struct Entry
+     * @brief Registered controller with its inputs and last output.
+     ******/
+    struct Entry
+    {
+        StateSpaceController<T>* controller;
+        int bank;                           // Index in m_bank (copied controller), -1 for a registered pointer
+        unsigned int divisor;
+        std::vector<T> r;
+        std::vector<T> y;
+        std::vector<T> u;
+        std::vector<unsigned int> inputs;   // Connections ending on this controller
+        std::vector<unsigned int> outputs;  // Connections starting from this controller
+    };
+
+    /**
+     * @struct Connection
+     * @brief Output of a controller used as reference of another one.
+     ******/
+    struct Connection
+    {
+        unsigned int from, fromOutput, to, toInput;
+        RateTransition transition;
+        T value;
+        T sum;
+        unsigned int count;
+    };
+
+    /**
+     * @brief Base time step (seconds).
+     ******/
+    float m_t_base;
+
+    /**
+     * @brief Current base tick.
+     ******/
+    unsigned long m_tick;
+
+    std::vector<Entry> m_entries;
+    std::vector<Connection> m_connections;
+
+    /**
+     * @brief Arena of the copied controllers and their bank (contiguous blocks in registration order).
+     ******/
+    std::pmr::monotonic_buffer_resource m_arena;
+    std::vector<ArenaStateSpaceController<T> > m_bank;
+
+    /**
+     * @brief Hyperperiod (base ticks) and controllers due on each of its ticks (0 if not tabulated).
+     ******/
+    unsigned int m_hyperperiod;
+    std::vector<std::vector<unsigned int> > m_schedule;
+
+    /**
+     * @brief Due controllers when the hyperperiod is too long to be tabulated.
+     ******/
+    std::vector<unsigned int> m_due;
+
+    bool m_scheduleValid;
+};
+
+#include "multiRateController.cpp"
+
+#endif  // MULTIRATECONTROLLER_H
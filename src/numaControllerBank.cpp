@@ -0,0 +1,440 @@
+/**
+ * @file numaControllerBank.cpp
+ * @brief NumaControllerBank class source file.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef NUMACONTROLLERBANK_CPP
+#define NUMACONTROLLERBANK_CPP
+
+#include "numaControllerBank.h"
+
+#include <algorithm>
+#include <chrono>
+
+/**
+ * @return Controller steps per second (0 before the first step).
+ ******/
+inline double ShardStatistics::controllerStepsPerSecond() const
+{
+    return (totalSeconds > 0) ? controllers * (double)steps / totalSeconds : 0;
+}
+
+/**
+ * @brief Shard constructor: empty, its worker is started by the bank.
+ ******/
+template<typename T>
+NumaControllerBank<T>::Shard::Shard(const unsigned int node, const std::vector<unsigned int>& cpus, const bool bind):
+cpus(cpus), upstream(node, bind), pool(&upstream),
+controllers(&pool), inputs(&pool), outputs(&pool), inputOffsets(&pool), outputOffsets(&pool), snapshots(&pool), coefficients(0),
+pending(false), stopping(false)
+{
+    statistics.node = node;
+    statistics.controllers = 0;
+    statistics.pinned = false;
+    statistics.bound = upstream.isBound();
+    statistics.mappedBytes = 0;
+    statistics.steps = 0;
+    statistics.totalSeconds = statistics.lastSeconds = statistics.maxSeconds = 0;
+}
+
+/**
+ * @brief Constructor: starts the workers (workersPerNode per node, pinned to the CPUs of their node).
+ * @param topology NUMA nodes (see NumaTopology::detect() and NumaTopology::singleNode()).
+ * @param workersPerNode Shards per node.
+ * @param bind Bind the memory of each shard to its node when libnuma is available (first-touch placement otherwise).
+ ******/
+template<typename T>
+NumaControllerBank<T>::NumaControllerBank(const NumaTopology& topology, const unsigned int workersPerNode, const bool bind):
+m_topology(topology), m_snapshots(false)
+{
+    if (m_topology.getNodeCount() == 0)
+    {
+        std::cout << "\033[1;31mERROR: Empty NUMA topology, a single node is used\033[0m" << std::endl;
+        m_topology = NumaTopology::singleNode();
+    }
+
+    for (unsigned int n=0;n<m_topology.getNodeCount();n++)
+    {
+        const NumaNode& node = m_topology.getNode(n);
+
+        for (unsigned int w=0;w<std::max(1u, workersPerNode);w++)
+        {
+            m_shards.push_back(std::unique_ptr<Shard>(new Shard(node.id, node.cpus, bind)));
+            Shard* shard = m_shards.back().get();
+            shard->worker = std::thread(&NumaControllerBank<T>::work, shard);
+        }
+    }
+}
+
+/**
+ * @brief Destructor: stops the workers, then the shards release their memory.
+ ******/
+template<typename T>
+NumaControllerBank<T>::~NumaControllerBank()
+{
+    for (unsigned int s=0;s<m_shards.size();s++)
+    {
+        Shard& shard = *m_shards[s];
+
+        // The controllers are destroyed by their worker, like they were built
+        post(shard, [&shard]() {
+            shard.snapshots.clear();
+            shard.controllers.clear();
+            shard.controllers.shrink_to_fit();
+        });
+        wait(shard);
+
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.stopping = true;
+        }
+        shard.wake.notify_one();
+        shard.worker.join();
+    }
+}
+
+/**
+ * @brief Worker loop: pins itself to the CPUs of the node, then runs the tasks posted to the shard.
+ ******/
+template<typename T>
+void NumaControllerBank<T>::work(Shard* shard)
+{
+    const bool pinned = NumaTopology::pinCurrentThread(shard->cpus);
+
+    std::unique_lock<std::mutex> lock(shard->mutex);
+    shard->statistics.pinned = pinned;
+
+    while (true)
+    {
+        shard->wake.wait(lock, [shard]() { return shard->pending || shard->stopping; });
+        if (shard->pending)
+        {
+            shard->task();
+            shard->task = nullptr;
+            shard->pending = false;
+            shard->done.notify_one();
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Gives a task to the worker of a shard (returns immediately).
+ ******/
+template<typename T>
+void NumaControllerBank<T>::post(Shard& shard, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.task = task;
+        shard.pending = true;
+    }
+    shard.wake.notify_one();
+}
+
+/**
+ * @brief Waits for the task of a shard.
+ ******/
+template<typename T>
+void NumaControllerBank<T>::wait(Shard& shard)
+{
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    shard.done.wait(lock, [&shard]() { return !shard.pending; });
+}
+
+/**
+ * @brief Copies a controller into the shard holding the fewest coefficients.
+ * @return Index of the controller in the bank.
+ ******/
+template<typename T>
+unsigned int NumaControllerBank<T>::add(const StateSpaceController<T>& controller)
+{
+    unsigned int best = 0;
+    for (unsigned int s=1;s<m_shards.size();s++)
+    {
+        if (m_shards[s]->coefficients < m_shards[best]->coefficients) best = s;
+    }
+
+    return add(controller, best);
+}
+
+/**
+ * @brief Copies a controller into a shard. The copy and the growth of the shard buffers are done by its worker.
+ * @param controller Controller to copy (matrices and state, time restarts from 0).
+ * @param shard Index of the shard.
+ * @return Index of the controller in the bank.
+ ******/
+template<typename T>
+unsigned int NumaControllerBank<T>::add(const StateSpaceController<T>& controller, const unsigned int shard)
+{
+    if (shard >= m_shards.size())
+    {
+        std::cout << "\033[1;31mERROR: Shard " << shard << " does not exist (" << m_shards.size() << " shards)\033[0m" << std::endl;
+        return add(controller);
+    }
+
+    Shard& s = *m_shards[shard];
+    const unsigned int local = s.controllers.size();
+
+    const bool snapshots = m_snapshots;
+    post(s, [&s, &controller, snapshots]() {
+        s.controllers.emplace_back(controller, &s.pool);
+        s.inputOffsets.push_back(s.inputs.size());
+        s.outputOffsets.push_back(s.outputs.size());
+        s.inputs.resize(s.inputs.size() + controller.getNe(), T(0));
+        s.outputs.resize(s.outputs.size() + controller.getNu(), T(0));
+        if (snapshots) addSnapshot(s, s.controllers.size() - 1);
+        s.statistics.controllers = s.controllers.size();
+        s.statistics.mappedBytes = s.upstream.getMappedBytes();
+    });
+    wait(s);
+
+    const unsigned int nx = controller.getNx(), ne = controller.getNe(), nu = controller.getNu();
+    s.coefficients += (std::size_t)(nx + nu) * (nx + ne);
+
+    m_shardOf.push_back(shard);
+    m_localIndex.push_back(local);
+
+    return m_shardOf.size() - 1;
+}
+
+/**
+ * @return Error vector (ne values) of a controller, used by the next step. Invalidated by add().
+ ******/
+template<typename T>
+T* NumaControllerBank<T>::input(const unsigned int index)
+{
+    Shard& s = *m_shards[m_shardOf[index]];
+
+    return s.inputs.data() + s.inputOffsets[m_localIndex[index]];
+}
+
+/**
+ * @return Output (nu values) of a controller computed by the last step. Invalidated by add().
+ ******/
+template<typename T>
+const T* NumaControllerBank<T>::output(const unsigned int index) const
+{
+    const Shard& s = *m_shards[m_shardOf[index]];
+
+    return s.outputs.data() + s.outputOffsets[m_localIndex[index]];
+}
+
+/**
+ * @brief Steps the controllers of a shard with their inputs and records the duration.
+ ******/
+template<typename T>
+void NumaControllerBank<T>::stepShard(Shard& shard)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (unsigned int k=0;k<shard.controllers.size();k++)
+    {
+        ArenaStateSpaceController<T>& controller = shard.controllers[k];
+        const T* u = controller.step(shard.inputs.data() + shard.inputOffsets[k]);
+        std::copy(u, u + controller.getNu(), shard.outputs.data() + shard.outputOffsets[k]);
+        if (!shard.snapshots.empty()) publishSnapshot(shard, k);
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ShardStatistics& statistics = shard.statistics;
+    statistics.steps++;
+    statistics.totalSeconds += seconds;
+    statistics.lastSeconds = seconds;
+    statistics.maxSeconds = std::max(statistics.maxSeconds, seconds);
+}
+
+/**
+ * @brief Steps every controller once: each worker steps its shard, returns when all shards are done.
+ ******/
+template<typename T>
+void NumaControllerBank<T>::step()
+{
+    for (unsigned int s=0;s<m_shards.size();s++)
+    {
+        Shard& shard = *m_shards[s];
+        if (!shard.controllers.empty()) post(shard, [&shard]() { stepShard(shard); });
+    }
+
+    for (unsigned int s=0;s<m_shards.size();s++)
+    {
+        wait(*m_shards[s]);
+    }
+}
+
+/**
+ * @brief Resets time and states of every controller, and clears the input and output buffers.
+ ******/
+template<typename T>
+void NumaControllerBank<T>::reset()
+{
+    for (unsigned int s=0;s<m_shards.size();s++)
+    {
+        Shard& shard = *m_shards[s];
+        post(shard, [&shard]() {
+            for (unsigned int k=0;k<shard.controllers.size();k++)
+            {
+                shard.controllers[k].reset();
+                if (!shard.snapshots.empty()) publishSnapshot(shard, k);
+            }
+            std::fill(shard.inputs.begin(), shard.inputs.end(), T(0));
+            std::fill(shard.outputs.begin(), shard.outputs.end(), T(0));
+        });
+    }
+
+    for (unsigned int s=0;s<m_shards.size();s++)
+    {
+        wait(*m_shards[s]);
+    }
+}
+
+/**
+ * @brief Creates the snapshot buffer of a controller (in the memory of the shard) and publishes its state.
+ ******/
+template<typename T>
+void NumaControllerBank<T>::addSnapshot(Shard& shard, const unsigned int local)
+{
+    const ArenaStateSpaceController<T>& controller = shard.controllers[local];
+
+    shard.snapshots.push_back(std::unique_ptr<SnapshotBuffer<T> >(
+        new SnapshotBuffer<T>(controller.getNx(), controller.getNe(), controller.getNu(), &shard.pool)));
+    publishSnapshot(shard, local);
+}
+
+/**
+ * @brief Publishes the state of a controller of the shard.
+ ******/
+template<typename T>
+void NumaControllerBank<T>::publishSnapshot(Shard& shard, const unsigned int local)
+{
+    const ArenaStateSpaceController<T>& controller = shard.controllers[local];
+
+    shard.snapshots[local]->publish(controller.getStepCount(), controller.getTime(), controller.getReference(), controller.getMeasurement(),
+                                    controller.getError(), controller.getOutput(), controller.getState());
+}
+
+/**
+ * @brief Every worker creates the snapshot buffers of its controllers; controllers added later get one too.
+ ******/
+template<typename T>
+void NumaControllerBank<T>::enableSnapshots()
+{
+    if (m_snapshots)
+    {
+        return;
+    }
+
+    for (unsigned int s=0;s<m_shards.size();s++)
+    {
+        Shard& shard = *m_shards[s];
+        post(shard, [&shard]() {
+            for (unsigned int k=0;k<shard.controllers.size();k++) addSnapshot(shard, k);
+        });
+    }
+
+    for (unsigned int s=0;s<m_shards.size();s++)
+    {
+        wait(*m_shards[s]);
+    }
+
+    m_snapshots = true;
+}
+
+/**
+ * @brief Copies the state of a controller after its last step, without blocking its worker.
+ * @return False if snapshots are not enabled.
+ ******/
+template<typename T>
+bool NumaControllerBank<T>::readSnapshot(const unsigned int index, ControllerSnapshot<T>& snapshot) const
+{
+    if (!m_snapshots)
+    {
+        return false;
+    }
+
+    m_shards[m_shardOf[index]]->snapshots[m_localIndex[index]]->read(snapshot);
+
+    return true;
+}
+
+/**
+ * @return Number of controllers.
+ ******/
+template<typename T>
+unsigned int NumaControllerBank<T>::getControllerCount() const
+{
+    return m_shardOf.size();
+}
+
+/**
+ * @return Number of shards (nodes * workers per node).
+ ******/
+template<typename T>
+unsigned int NumaControllerBank<T>::getShardCount() const
+{
+    return m_shards.size();
+}
+
+/**
+ * @return Shard of a controller.
+ ******/
+template<typename T>
+unsigned int NumaControllerBank<T>::getShardOf(const unsigned int index) const
+{
+    return m_shardOf[index];
+}
+
+/**
+ * @return Topology used by the bank.
+ ******/
+template<typename T>
+const NumaTopology& NumaControllerBank<T>::getTopology() const
+{
+    return m_topology;
+}
+
+/**
+ * @return Step statistics of a shard.
+ ******/
+template<typename T>
+ShardStatistics NumaControllerBank<T>::getStatistics(const unsigned int shard) const
+{
+    std::lock_guard<std::mutex> lock(m_shards[shard]->mutex);
+
+    return m_shards[shard]->statistics;
+}
+
+/**
+ * @return Step statistics of every shard.
+ ******/
+template<typename T>
+std::vector<ShardStatistics> NumaControllerBank<T>::getStatistics() const
+{
+    std::vector<ShardStatistics> statistics;
+    for (unsigned int s=0;s<m_shards.size();s++) statistics.push_back(getStatistics(s));
+
+    return statistics;
+}
+
+/**
+ * @brief Clears the step counters and times of every shard.
+ ******/
+template<typename T>
+void NumaControllerBank<T>::resetStatistics()
+{
+    for (unsigned int s=0;s<m_shards.size();s++)
+    {
+        std::lock_guard<std::mutex> lock(m_shards[s]->mutex);
+        ShardStatistics& statistics = m_shards[s]->statistics;
+        statistics.steps = 0;
+        statistics.totalSeconds = statistics.lastSeconds = statistics.maxSeconds = 0;
+    }
+}
+
+#endif  // NUMACONTROLLERBANK_CPP
@@ -0,0 +1,159 @@
+/**
+ * @file numaControllerBank.h
+ * @brief NumaControllerBank class header.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef NUMACONTROLLERBANK_H
+#define NUMACONTROLLERBANK_H
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "stateSpaceController.h"
+#include "arenaController.h"
+#include "numaTopology.h"
+#include "stateSnapshot.h"
+
+/**
+ * @brief Step statistics of a shard.
+ ******/
+struct ShardStatistics
+{
+    unsigned int node;          // Identifier of the NUMA node of the shard
+    unsigned int controllers;   // Controllers of the shard
+    bool pinned;                // Worker restricted to the CPUs of the node
+    bool bound;                 // Memory bound to the node (first-touch placement otherwise)
+    std::size_t mappedBytes;    // Memory mapped by the shard
+
+    unsigned long long steps;   // Bank steps run by the shard
+    double totalSeconds;        // Time spent stepping
+    double lastSeconds;         // Duration of the last step
+    double maxSeconds;          // Longest step
+
+    // Controller steps per second (0 before the first step)
+    double controllerStepsPerSecond() const;
+};
+
+/**
+ * @class NumaControllerBank
+ * @brief Bank of controllers split into shards, each one stepped by a worker on a NUMA node and stored in the memory of that node.
+ * @details Every node of the topology gets workersPerNode shards. The worker of a shard is a thread
+ * restricted to the CPUs of its node, and it performs every allocation of the shard: the controllers
+ * (ArenaStateSpaceController, matrices, states and scratch in one block), their input and output buffers
+ * and the arrays holding them come from a pool over a NodeMemoryResource. Pages are bound to the node with
+ * libnuma (SSC_HAVE_LIBNUMA) or placed by first touch of the worker, so coefficients are never read
+ * across the interconnect.
+ *
+ * Usage: add() controllers (copied into a shard), write their errors with input(), step() the whole bank
+ * (shards in parallel), read output(). input()/output() pointers are invalidated by add().
+ * With enableSnapshots(), every worker publishes (i, t, r, y, e, u, x) of its controllers after each step:
+ * readSnapshot() can then be called from monitoring threads while the bank steps.
+ * Not thread-safe: add(), step() and the statistics are called from one thread.
+ ******/
+template <typename T>
+class NumaControllerBank
+{
+    public:
+
+    // Shards on every node of the topology; bind = false: first-touch placement only
+    NumaControllerBank(const NumaTopology& topology = NumaTopology::detect(), const unsigned int workersPerNode = 1, const bool bind = true);
+
+    NumaControllerBank(const NumaControllerBank<T>&) = delete;
+    NumaControllerBank<T>& operator=(const NumaControllerBank<T>&) = delete;
+
+    virtual ~NumaControllerBank();
+
+    // Copy a controller into the shard with the least coefficients (or into a given shard), returns its index
+    unsigned int add(const StateSpaceController<T>& controller);
+    unsigned int add(const StateSpaceController<T>& controller, const unsigned int shard);
+
+    // Error vector (ne values) used by the next step, and output (nu values) of the last step of a controller
+    T* input(const unsigned int index);
+    const T* output(const unsigned int index) const;
+
+    // Step every controller once, shards in parallel
+    void step();
+
+    // Reset time and states of every controller
+    void reset();
+
+    // Publish a snapshot of every controller after each step (call before the monitoring threads start)
+    void enableSnapshots();
+
+    // Consistent copy of the state of a controller after its last step (thread-safe, false if disabled)
+    bool readSnapshot(const unsigned int index, ControllerSnapshot<T>& snapshot) const;
+
+    unsigned int getControllerCount() const;
+    unsigned int getShardCount() const;
+    unsigned int getShardOf(const unsigned int index) const;
+    const NumaTopology& getTopology() const;
+
+    // Step statistics
+    ShardStatistics getStatistics(const unsigned int shard) const;
+    std::vector<ShardStatistics> getStatistics() const;
+    void resetStatistics();
+
+    protected:
+
+    /**
+     * @brief Shard: controllers and buffers of one worker, allocated by the worker from its node.
+     ******/
+    struct Shard
+    {
+        Shard(const unsigned int node, const std::vector<unsigned int>& cpus, const bool bind);
+
+        std::vector<unsigned int> cpus;
+        NodeMemoryResource upstream;
+        std::pmr::unsynchronized_pool_resource pool;
+
+        std::pmr::vector<ArenaStateSpaceController<T> > controllers;
+        std::pmr::vector<T> inputs, outputs;
+        std::pmr::vector<unsigned int> inputOffsets, outputOffsets;
+        std::pmr::vector<std::unique_ptr<SnapshotBuffer<T> > > snapshots;
+        std::size_t coefficients;
+
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable wake, done;
+        std::function<void()> task;
+        bool pending, stopping;
+
+        ShardStatistics statistics;
+    };
+
+    // Loop of the worker of a shard
+    static void work(Shard* shard);
+
+    // Run tasks on the workers of shards and wait for them
+    static void post(Shard& shard, std::function<void()> task);
+    static void wait(Shard& shard);
+
+    // Step of the controllers of a shard (on its worker)
+    static void stepShard(Shard& shard);
+
+    // Snapshot buffer of a controller of a shard, and its publication (on its worker)
+    static void addSnapshot(Shard& shard, const unsigned int local);
+    static void publishSnapshot(Shard& shard, const unsigned int local);
+
+    NumaTopology m_topology;
+    std::vector<std::unique_ptr<Shard> > m_shards;
+
+    /**
+     * @brief Shard and position in the shard of each controller.
+     ******/
+    std::vector<unsigned int> m_shardOf, m_localIndex;
+
+    bool m_snapshots;
+};
+
+#include "numaControllerBank.cpp"
+
+#endif  // NUMACONTROLLERBANK_H
@@ -0,0 +1,350 @@
+/**
+ * @file numaTopology.cpp
+ * @brief NUMA topology detection, thread pinning and node-local memory resource (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef NUMATOPOLOGY_CPP
+#define NUMATOPOLOGY_CPP
+
+#include "numaTopology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <new>
+#include <cctype>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(SSC_HAVE_LIBNUMA)
+#include <numa.h>
+#endif
+
+/**
+ * @brief Constructor: empty topology.
+ ******/
+inline NumaTopology::NumaTopology():
+m_source("single node")
+{
+}
+
+/**
+ * @return Topology of the host: libnuma if the project is built with it, then sysfs, then a single node.
+ ******/
+inline NumaTopology NumaTopology::detect()
+{
+#if defined(SSC_HAVE_LIBNUMA)
+    if (numa_available() >= 0)
+    {
+        NumaTopology topology;
+        topology.m_source = "libnuma";
+
+        struct bitmask* cpus = numa_allocate_cpumask();
+        for (int node=0;node<=numa_max_node();node++)
+        {
+            if (!numa_bitmask_isbitset(numa_all_nodes_ptr, node) || numa_node_to_cpus(node, cpus) != 0)
+            {
+                continue;
+            }
+
+            NumaNode n;
+            n.id = node;
+            for (unsigned int cpu=0;cpu<cpus->size;cpu++)
+            {
+                if (numa_bitmask_isbitset(cpus, cpu)) n.cpus.push_back(cpu);
+            }
+            if (!n.cpus.empty()) topology.m_nodes.push_back(n);   // Memory-only nodes are not used
+        }
+        numa_free_cpumask(cpus);
+
+        if (!topology.m_nodes.empty())
+        {
+            return topology;
+        }
+    }
+#endif
+
+    return fromSysfs();
+}
+
+/**
+ * @brief Reads the online nodes and their cpulist from a sysfs directory.
+ * @param path Node directory (/sys/devices/system/node).
+ * @return Topology read, or a single node if the directory cannot be read.
+ ******/
+inline NumaTopology NumaTopology::fromSysfs(const std::string& path)
+{
+    NumaTopology topology;
+    topology.m_source = "sysfs";
+
+    std::ifstream online((path + "/online").c_str());
+    std::string list;
+
+    if (online && std::getline(online, list))
+    {
+        const std::vector<unsigned int> ids = parseList(list);
+
+        for (unsigned int k=0;k<ids.size();k++)
+        {
+            std::ostringstream name;
+            name << path << "/node" << ids[k] << "/cpulist";
+
+            std::ifstream cpulist(name.str().c_str());
+            std::string cpus;
+
+            NumaNode n;
+            n.id = ids[k];
+            if (cpulist && std::getline(cpulist, cpus)) n.cpus = parseList(cpus);
+            if (!n.cpus.empty()) topology.m_nodes.push_back(n);
+        }
+    }
+
+    if (topology.m_nodes.empty())
+    {
+        return singleNode();
+    }
+
+    return topology;
+}
+
+/**
+ * @brief Single node topology (no NUMA support, or testing).
+ * @param cpuCount Number of CPUs of the node (0: hardware concurrency).
+ ******/
+inline NumaTopology NumaTopology::singleNode(unsigned int cpuCount)
+{
+    if (cpuCount == 0)
+    {
+        cpuCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    NumaTopology topology;
+    NumaNode n;
+    n.id = 0;
+    for (unsigned int cpu=0;cpu<cpuCount;cpu++) n.cpus.push_back(cpu);
+    topology.m_nodes.push_back(n);
+
+    return topology;
+}
+
+/**
+ * @brief Parses a kernel list of ranges ("0-3,8,10-11\n").
+ * @return Values of the list in increasing order (empty if malformed).
+ ******/
+inline std::vector<unsigned int> NumaTopology::parseList(const std::string& list)
+{
+    std::vector<unsigned int> values;
+    std::istringstream stream(list);
+    std::string range;
+
+    while (std::getline(stream, range, ','))
+    {
+        range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+        if (range.empty()) continue;
+
+        unsigned int first = 0, last = 0;
+        char dash = 0;
+        std::istringstream r(range);
+
+        if (!(r >> first))
+        {
+            return std::vector<unsigned int>();
+        }
+        last = first;
+        if (r >> dash && (dash != '-' || !(r >> last) || last < first))
+        {
+            return std::vector<unsigned int>();
+        }
+
+        for (unsigned int v=first;v<=last;v++) values.push_back(v);
+    }
+
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    return values;
+}
+
+/**
+ * @return Number of nodes.
+ ******/
+inline unsigned int NumaTopology::getNodeCount() const
+{
+    return m_nodes.size();
+}
+
+/**
+ * @return Node of index "index" (not its identifier).
+ ******/
+inline const NumaNode& NumaTopology::getNode(const unsigned int index) const
+{
+    return m_nodes[index];
+}
+
+/**
+ * @return All nodes.
+ ******/
+inline const std::vector<NumaNode>& NumaTopology::getNodes() const
+{
+    return m_nodes;
+}
+
+/**
+ * @return Index of the node holding the CPU, 0 if no node holds it.
+ ******/
+inline unsigned int NumaTopology::nodeOfCpu(const unsigned int cpu) const
+{
+    for (unsigned int k=0;k<m_nodes.size();k++)
+    {
+        if (std::binary_search(m_nodes[k].cpus.begin(), m_nodes[k].cpus.end(), cpu))
+        {
+            return k;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @return Source of the topology: "libnuma", "sysfs" or "single node".
+ ******/
+inline const std::string& NumaTopology::getSource() const
+{
+    return m_source;
+}
+
+/**
+ * @brief Restricts the calling thread to a set of CPUs.
+ * @return True if the affinity is set (false on other systems or if the CPUs are not allowed).
+ ******/
+inline bool NumaTopology::pinCurrentThread(const std::vector<unsigned int>& cpus)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned int k=0;k<cpus.size();k++)
+    {
+        if (cpus[k] < CPU_SETSIZE) CPU_SET(cpus[k], &set);
+    }
+
+    return !cpus.empty() && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+/**
+ * @brief Constructor.
+ * @param node Identifier of the node.
+ * @param bind Bind the blocks to the node when libnuma is available (first-touch placement otherwise).
+ ******/
+inline NodeMemoryResource::NodeMemoryResource(const unsigned int node, const bool bind):
+m_node(node), m_bind(false), m_mappedBytes(0)
+{
+#if defined(SSC_HAVE_LIBNUMA)
+    m_bind = bind && numa_available() >= 0;
+#else
+    (void)bind;
+#endif
+}
+
+/**
+ * @return Identifier of the node.
+ ******/
+inline unsigned int NodeMemoryResource::getNode() const
+{
+    return m_node;
+}
+
+/**
+ * @return True if the blocks are bound to the node, false if they are placed on first touch.
+ ******/
+inline bool NodeMemoryResource::isBound() const
+{
+    return m_bind;
+}
+
+/**
+ * @return Bytes currently mapped.
+ ******/
+inline std::size_t NodeMemoryResource::getMappedBytes() const
+{
+    return m_mappedBytes;
+}
+
+/**
+ * @return Mapping size of an allocation (multiple of 4 KiB).
+ ******/
+inline std::size_t NodeMemoryResource::mappedSize(const std::size_t bytes)
+{
+    return (std::max(bytes, (std::size_t)1) + 4095) / 4096 * 4096;
+}
+
+/**
+ * @brief Maps a block (page aligned), bound to the node if requested. Pages are not touched.
+ * @details An alignment above 4 KiB cannot be honoured by a mapping: std::bad_alloc is thrown.
+ ******/
+inline void* NodeMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    const std::size_t size = mappedSize(bytes);
+
+#if defined(__linux__)
+    if (alignment > 4096)
+    {
+        throw std::bad_alloc();
+    }
+
+    void* p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+
+#if defined(SSC_HAVE_LIBNUMA)
+    if (m_bind)
+    {
+        numa_tonode_memory(p, size, m_node);
+    }
+#endif
+#else
+    void* p = std::pmr::new_delete_resource()->allocate(size, alignment);
+#endif
+
+    m_mappedBytes += size;
+    return p;
+}
+
+/**
+ * @brief Unmaps a block.
+ ******/
+inline void NodeMemoryResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+    const std::size_t size = mappedSize(bytes);
+
+#if defined(__linux__)
+    (void)alignment;
+    munmap(p, size);
+#else
+    std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+#endif
+
+    m_mappedBytes -= size;
+}
+
+/**
+ * @return True if both resources are the same object.
+ ******/
+inline bool NodeMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+#endif  // NUMATOPOLOGY_CPP
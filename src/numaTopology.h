@@ -0,0 +1,109 @@
+/**
+ * @file numaTopology.h
+ * @brief NUMA topology detection, thread pinning and node-local memory resource (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef NUMATOPOLOGY_H
+#define NUMATOPOLOGY_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * @brief NUMA node: its identifier and the CPUs attached to it.
+ ******/
+struct NumaNode
+{
+    unsigned int id;
+    std::vector<unsigned int> cpus;
+};
+
+/**
+ * @class NumaTopology
+ * @brief NUMA nodes of the host.
+ * @details detect() asks libnuma when the project is built with it (SSC_HAVE_LIBNUMA), then reads
+ * /sys/devices/system/node (online node list and cpulist of each node). If neither works (no NUMA
+ * support, other systems) the host is one node holding every CPU, which is also what singleNode() builds
+ * to run NUMA-aware code on a workstation.
+ ******/
+class NumaTopology
+{
+    public:
+
+    // Empty topology (no node)
+    NumaTopology();
+
+    // Topology of the host (libnuma, then sysfs, then a single node)
+    static NumaTopology detect();
+
+    // Topology read from a sysfs node directory (single node if it cannot be read)
+    static NumaTopology fromSysfs(const std::string& path = "/sys/devices/system/node");
+
+    // One node 0 with cpuCount CPUs (0: hardware concurrency)
+    static NumaTopology singleNode(unsigned int cpuCount = 0);
+
+    // Parse a kernel CPU/node list ("0-3,8,10-11")
+    static std::vector<unsigned int> parseList(const std::string& list);
+
+    unsigned int getNodeCount() const;
+    const NumaNode& getNode(const unsigned int index) const;
+    const std::vector<NumaNode>& getNodes() const;
+
+    // Index of the node holding a CPU (0 if unknown)
+    unsigned int nodeOfCpu(const unsigned int cpu) const;
+
+    // Where the topology comes from: "libnuma", "sysfs" or "single node"
+    const std::string& getSource() const;
+
+    // Pin the calling thread to a set of CPUs, returns false if not supported or refused
+    static bool pinCurrentThread(const std::vector<unsigned int>& cpus);
+
+    protected:
+    std::vector<NumaNode> m_nodes;
+    std::string m_source;
+};
+
+/**
+ * @class NodeMemoryResource
+ * @brief Memory resource mapping its blocks for one NUMA node.
+ * @details Blocks are anonymous mappings rounded to 4 KiB pages. With libnuma and explicit binding, the
+ * mapping is bound to the node (numa_tonode_memory) before any page is touched. Otherwise the pages are
+ * placed by the kernel on first touch: the resource must then be used (and its memory first written) by
+ * a thread running on the node, as NumaControllerBank does from its pinned workers.
+ *
+ * Not thread-safe: meant as upstream of a std::pmr::unsynchronized_pool_resource owned by one thread.
+ ******/
+class NodeMemoryResource : public std::pmr::memory_resource
+{
+    public:
+
+    // bind = false: first-touch placement only
+    NodeMemoryResource(const unsigned int node, const bool bind = true);
+
+    unsigned int getNode() const;
+
+    // True if the blocks are explicitly bound to the node (libnuma available and binding requested)
+    bool isBound() const;
+
+    // Bytes currently mapped
+    std::size_t getMappedBytes() const;
+
+    protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    static std::size_t mappedSize(const std::size_t bytes);
+
+    unsigned int m_node;
+    bool m_bind;
+    std::size_t m_mappedBytes;
+};
+
+#include "numaTopology.cpp"
+
+#endif  // NUMATOPOLOGY_H
@@ -0,0 +1,192 @@
+/**
+ * @file seqlock.cpp
+ * @brief Sequence locks for torn-free reads without blocking the writer (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef SEQLOCK_CPP
+#define SEQLOCK_CPP
+
+#include "seqlock.h"
+
+#include <cstring>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEQLOCK_PAUSE() _mm_pause()
+#else
+#define SEQLOCK_PAUSE() std::this_thread::yield()
+#endif
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Seqlock needs a lock-free 32 bit atomic");
+
+/**
+ * @brief Constructor: sequence 0 (no write).
+ ******/
+inline Seqlock::Seqlock():
+m_sequence(0)
+{
+}
+
+/**
+ * @brief Starts a write: the sequence becomes odd, readers will retry.
+ ******/
+inline void Seqlock::writeBegin()
+{
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+/**
+ * @brief Ends a write: the sequence becomes even, the payload is published.
+ ******/
+inline void Seqlock::writeEnd()
+{
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/**
+ * @return True if the write lock is taken (sequence was even and is now odd).
+ ******/
+inline bool Seqlock::tryLock()
+{
+    std::uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+
+    if ((sequence & 1) || !m_sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Takes the write lock, spinning while another writer holds it.
+ ******/
+inline void Seqlock::lock()
+{
+    while (!tryLock())
+    {
+        SEQLOCK_PAUSE();
+    }
+}
+
+/**
+ * @brief Releases the write lock and publishes the payload.
+ ******/
+inline void Seqlock::unlock()
+{
+    writeEnd();
+}
+
+/**
+ * @return Even sequence at the start of a read (spins while a write is in progress).
+ ******/
+inline std::uint32_t Seqlock::readBegin() const
+{
+    std::uint32_t sequence = m_sequence.load(std::memory_order_acquire);
+
+    while (sequence & 1)
+    {
+        SEQLOCK_PAUSE();
+        sequence = m_sequence.load(std::memory_order_acquire);
+    }
+
+    return sequence;
+}
+
+/**
+ * @return True if a write happened since readBegin(): the copy may be torn and must be made again.
+ ******/
+inline bool Seqlock::readRetry(const std::uint32_t sequence) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return m_sequence.load(std::memory_order_relaxed) != sequence;
+}
+
+/**
+ * @return Current sequence.
+ ******/
+inline std::uint32_t Seqlock::getSequence() const
+{
+    return m_sequence.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Copies a payload inside a write section.
+ ******/
+inline void Seqlock::store(void* destination, const void* source, const std::size_t bytes)
+{
+    std::memcpy(destination, source, bytes);
+}
+
+/**
+ * @brief Copies a payload inside a read section (volatile source: the compiler must read it again on retry).
+ ******/
+inline void Seqlock::load(void* destination, const volatile void* source, const std::size_t bytes)
+{
+    std::memcpy(destination, const_cast<const void*>(source), bytes);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+/**
+ * @brief Constructor: value initialized payload.
+ ******/
+template<typename P>
+SeqlockValue<P>::SeqlockValue():
+m_value()
+{
+}
+
+/**
+ * @brief Constructor with an initial value.
+ ******/
+template<typename P>
+SeqlockValue<P>::SeqlockValue(const P& value):
+m_value(value)
+{
+}
+
+/**
+ * @brief Publishes a new value (single writer, never blocks).
+ ******/
+template<typename P>
+void SeqlockValue<P>::write(const P& value)
+{
+    m_lock.writeBegin();
+    Seqlock::store(&m_value, &value, sizeof(P));
+    m_lock.writeEnd();
+}
+
+/**
+ * @return Consistent copy of the last value published (retries while it is being written).
+ ******/
+template<typename P>
+P SeqlockValue<P>::read() const
+{
+    P value;
+    std::uint32_t sequence;
+
+    do
+    {
+        sequence = m_lock.readBegin();
+        Seqlock::load(&value, &m_value, sizeof(P));
+    } while (m_lock.readRetry(sequence));
+
+    return value;
+}
+
+/**
+ * @return Number of values published with write().
+ ******/
+template<typename P>
+std::uint32_t SeqlockValue<P>::getVersion() const
+{
+    return m_lock.getSequence() / 2;
+}
+
+#endif  // SEQLOCK_CPP
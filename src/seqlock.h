@@ -0,0 +1,88 @@
+/**
+ * @file seqlock.h
+ * @brief Sequence locks for torn-free reads without blocking the writer (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @class Seqlock
+ * @brief Sequence counter protecting a payload stored next to it.
+ * @details The writer makes the counter odd (writeBegin), updates the payload, then makes it even again
+ * (writeEnd). A reader takes the counter (readBegin, waits while it is odd), copies the payload, then
+ * checks the counter did not move (readRetry); otherwise it copies again. Readers never block the writer
+ * and never write to the shared cache line.
+ *
+ * Several writers serialize with lock()/unlock() (the counter is then also a spin lock).
+ * The counter is a lock-free 32 bit atomic and the object is standard layout: it can be placed in memory
+ * shared between processes. Payloads are copied with store()/load().
+ ******/
+class Seqlock
+{
+    public:
+
+    Seqlock();
+
+    // Single writer
+    void writeBegin();
+    void writeEnd();
+
+    // Several writers (spins while another writer holds the lock)
+    void lock();
+    bool tryLock();
+    void unlock();
+
+    // Reader: sequence to pass to readRetry(), true if the copy must be made again
+    std::uint32_t readBegin() const;
+    bool readRetry(const std::uint32_t sequence) const;
+
+    // Current sequence (even: stable, odd: being written); number of writes = sequence / 2
+    std::uint32_t getSequence() const;
+
+    // Payload copies inside a write or a read section
+    static void store(void* destination, const void* source, const std::size_t bytes);
+    static void load(void* destination, const volatile void* source, const std::size_t bytes);
+
+    protected:
+    std::atomic<std::uint32_t> m_sequence;
+};
+
+/**
+ * @class SeqlockValue
+ * @brief Trivially copyable value published by one writer and read torn-free by any number of readers.
+ ******/
+template <typename P>
+class SeqlockValue
+{
+    static_assert(std::is_trivially_copyable<P>::value, "SeqlockValue needs a trivially copyable type");
+
+    public:
+
+    SeqlockValue();
+    SeqlockValue(const P& value);
+
+    // Publish a new value (single writer)
+    void write(const P& value);
+
+    // Consistent copy of the last value published
+    P read() const;
+
+    // Number of values published
+    std::uint32_t getVersion() const;
+
+    protected:
+    Seqlock m_lock;
+    P m_value;
+};
+
+#include "seqlock.cpp"
+
+#endif  // SEQLOCK_H
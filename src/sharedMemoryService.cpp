@@ -0,0 +1,660 @@
+/**
+ * @file sharedMemoryService.cpp
+ * @brief Shared memory controller service and client (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef SHAREDMEMORYSERVICE_CPP
+#define SHAREDMEMORYSERVICE_CPP
+
+#include "sharedMemoryService.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <new>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+/**
+ * @brief Size rounded to a cache line.
+ ******/
+inline std::size_t shmServiceAlign(const std::size_t bytes)
+{
+    return (bytes + 63) / 64 * 64;
+}
+
+/**
+ * @brief Segment name with its leading '/'.
+ ******/
+inline std::string shmServiceName(const std::string& name)
+{
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+/**
+ * @brief Sleeps while *word == value (at most timeoutSeconds if positive). Shared futex: works across processes.
+ ******/
+inline void shmServiceWait(std::atomic<std::uint32_t>* word, const std::uint32_t value, const double timeoutSeconds)
+{
+#if defined(__linux__)
+    struct timespec timeout;
+    timeout.tv_sec = (time_t)timeoutSeconds;
+    timeout.tv_nsec = (long)((timeoutSeconds - timeout.tv_sec) * 1e9);
+
+    syscall(SYS_futex, (std::uint32_t*)word, FUTEX_WAIT, value, (timeoutSeconds >= 0) ? &timeout : 0, 0, 0);
+#else
+    if (word->load() == value)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    (void)timeoutSeconds;
+#endif
+}
+
+/**
+ * @brief Wakes the process sleeping on a futex word.
+ ******/
+inline void shmServiceWake(std::atomic<std::uint32_t>* word)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, (std::uint32_t*)word, FUTEX_WAKE, INT_MAX, 0, 0, 0);
+#else
+    (void)word;
+#endif
+}
+
+/**
+ * @return Bytes of the segment: header, slot table, then for each controller its slot, mailbox, result and block.
+ ******/
+template<typename T>
+std::size_t SharedMemoryControllerService<T>::segmentSize(const std::vector<StateSpaceController<T> >& controllers)
+{
+    std::size_t size = shmServiceAlign(sizeof(ShmServiceHeader)) + shmServiceAlign(controllers.size() * sizeof(std::uint64_t));
+
+    for (unsigned int k=0;k<controllers.size();k++)
+    {
+        const unsigned int nx = controllers[k].getNx(), ne = controllers[k].getNe(), nu = controllers[k].getNu();
+
+        size += shmServiceAlign(sizeof(ShmServiceSlot)) + shmServiceAlign(2 * ne * sizeof(T))
+        + shmServiceAlign(sizeof(ShmServiceResult) + nu * sizeof(T)) + ArenaStateSpaceController<T>::blockSize(nx, ne, nu);
+    }
+
+    return size;
+}
+
+/**
+ * @brief Constructor: creates the segment and copies the controllers into it.
+ * @param name Name of the segment (a leading '/' is added if missing). It must not exist: a segment left
+ * by a server that crashed is removed with shm_unlink() (e.g. rm /dev/shm/name) before starting again.
+ * @param controllers Controllers served (matrices and state copied, time restarts from 0).
+ ******/
+template<typename T>
+SharedMemoryControllerService<T>::SharedMemoryControllerService(const std::string& name, const std::vector<StateSpaceController<T> >& controllers):
+m_name(shmServiceName(name)), m_base(0), m_size(segmentSize(controllers)), m_header(0)
+{
+    const int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << m_name << " cannot be created: " << std::strerror(errno) << "\033[0m" << std::endl;
+        return;
+    }
+    if (ftruncate(fd, m_size) != 0)
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << m_name << " cannot be sized\033[0m" << std::endl;
+        close(fd);
+        shm_unlink(m_name.c_str());
+        return;
+    }
+
+    m_base = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m_base == MAP_FAILED)
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << m_name << " cannot be mapped\033[0m" << std::endl;
+        m_base = 0;
+        shm_unlink(m_name.c_str());
+        return;
+    }
+
+    char* base = (char*)m_base;
+    m_header = new (base) ShmServiceHeader();
+    m_header->magic = SHM_SERVICE_MAGIC;
+    m_header->version = SHM_SERVICE_VERSION;
+    m_header->scalarSize = sizeof(T);
+    m_header->controllerCount = controllers.size();
+    m_header->segmentSize = m_size;
+    m_header->slotTableOffset = shmServiceAlign(sizeof(ShmServiceHeader));
+
+    std::uint64_t* table = (std::uint64_t*)(base + m_header->slotTableOffset);
+    std::size_t offset = m_header->slotTableOffset + shmServiceAlign(controllers.size() * sizeof(std::uint64_t));
+    unsigned int maxNe = 0;
+
+    m_controllers.reserve(controllers.size());
+    for (unsigned int k=0;k<controllers.size();k++)
+    {
+        const StateSpaceController<T>& controller = controllers[k];
+        const unsigned int nx = controller.getNx(), ne = controller.getNe(), nu = controller.getNu();
+
+        table[k] = offset;
+        ShmServiceSlot* slot = new (base + offset) ShmServiceSlot();
+        slot->nx = nx;
+        slot->ne = ne;
+        slot->nu = nu;
+        slot->t_s = controller.getTimeStep();
+        slot->mailboxOffset = offset + shmServiceAlign(sizeof(ShmServiceSlot));
+        slot->resultOffset = slot->mailboxOffset + shmServiceAlign(2 * ne * sizeof(T));
+        slot->blockOffset = slot->resultOffset + shmServiceAlign(sizeof(ShmServiceResult) + nu * sizeof(T));
+        slot->blockSize = ArenaStateSpaceController<T>::blockSize(nx, ne, nu);
+        offset = slot->blockOffset + slot->blockSize;
+
+        // The block of the controller is its place in the segment
+        m_resources.push_back(std::unique_ptr<std::pmr::monotonic_buffer_resource>(
+            new std::pmr::monotonic_buffer_resource(base + slot->blockOffset, slot->blockSize, std::pmr::null_memory_resource())));
+        m_controllers.push_back(ArenaStateSpaceController<T>(controller, m_resources.back().get()));
+
+        m_slots.push_back(slot);
+        maxNe = std::max(maxNe, ne);
+    }
+
+    m_mailbox.resize(2 * maxNe);
+    m_header->ready.store(1, std::memory_order_release);
+}
+
+/**
+ * @brief Destructor: unmaps and removes the segment (clients keep their mapping until they close it).
+ ******/
+template<typename T>
+SharedMemoryControllerService<T>::~SharedMemoryControllerService()
+{
+    m_controllers.clear();
+    m_resources.clear();
+
+    if (m_base)
+    {
+        m_header->ready.store(0, std::memory_order_release);
+        munmap(m_base, m_size);
+        shm_unlink(m_name.c_str());
+    }
+}
+
+/**
+ * @return True if the segment is created.
+ ******/
+template<typename T>
+bool SharedMemoryControllerService<T>::isOpen() const
+{
+    return m_base != 0;
+}
+
+/**
+ * @brief Steps every submitted controller with its mailbox and publishes the outputs.
+ * @details A mailbox still being written after SHM_SERVICE_READ_SPINS checks is left pending for the next call.
+ * @return Number of controllers stepped.
+ ******/
+template<typename T>
+unsigned int SharedMemoryControllerService<T>::processPending()
+{
+    unsigned int steps = 0;
+
+    for (unsigned int k=0;k<m_slots.size();k++)
+    {
+        ShmServiceSlot* slot = m_slots[k];
+        if (!slot->pending.load(std::memory_order_relaxed) || !slot->pending.exchange(0, std::memory_order_acq_rel))
+        {
+            continue;
+        }
+
+        // Consistent copy of r_i and y_i, without waiting for a writer that may never finish
+        const volatile T* mailbox = (const T*)((char*)m_base + slot->mailboxOffset);
+        bool copied = false;
+        for (unsigned int spin=0;spin<SHM_SERVICE_READ_SPINS && !copied;spin++)
+        {
+            const std::uint32_t sequence = slot->mailbox.getSequence();
+            if (sequence & 1)
+            {
+                SEQLOCK_PAUSE();
+                continue;
+            }
+            Seqlock::load(m_mailbox.data(), mailbox, 2 * slot->ne * sizeof(T));
+            copied = !slot->mailbox.readRetry(sequence);
+        }
+        if (!copied)
+        {
+            slot->pending.store(1, std::memory_order_release);
+            continue;
+        }
+
+        ArenaStateSpaceController<T>& controller = m_controllers[k];
+        const T* u = controller.step(m_mailbox.data(), m_mailbox.data() + slot->ne);
+
+        char* result = (char*)m_base + slot->resultOffset;
+        ShmServiceResult head;
+        head.step = ((const ShmServiceResult*)result)->step + 1;
+        head.time = controller.getTime();
+
+        slot->result.writeBegin();
+        Seqlock::store(result, &head, sizeof(head));
+        Seqlock::store(result + sizeof(head), u, slot->nu * sizeof(T));
+        slot->result.writeEnd();
+
+        steps++;
+    }
+
+    return steps;
+}
+
+/**
+ * @brief Waits for submissions and processes them.
+ * @param timeoutSeconds Longest wait (negative: until a submission or a stop request).
+ * @param spins Doorbell checks before sleeping on the futex.
+ * @return Number of controllers stepped (0 after a timeout or a stop request).
+ ******/
+template<typename T>
+unsigned int SharedMemoryControllerService<T>::serve(const double timeoutSeconds, const unsigned int spins)
+{
+    if (!m_base)
+    {
+        return 0;
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    while (!m_header->stop.load(std::memory_order_acquire))
+    {
+        const std::uint32_t seen = m_header->doorbell.load(std::memory_order_acquire);
+
+        const unsigned int steps = processPending();
+        if (steps > 0)
+        {
+            return steps;
+        }
+
+        unsigned int k = 0;
+        while (k < spins && m_header->doorbell.load(std::memory_order_acquire) == seen)
+        {
+            SEQLOCK_PAUSE();
+            k++;
+        }
+
+        double remaining = -1;
+        if (timeoutSeconds >= 0)
+        {
+            remaining = timeoutSeconds - std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (remaining <= 0)
+            {
+                return processPending();
+            }
+        }
+
+        if (k == spins)
+        {
+            // Clients only call FUTEX_WAKE when they see the server sleeping
+            m_header->sleeping.store(1, std::memory_order_seq_cst);
+            if (m_header->doorbell.load(std::memory_order_seq_cst) == seen && !m_header->stop.load())
+            {
+                shmServiceWait(&m_header->doorbell, seen, remaining);
+            }
+            m_header->sleeping.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Serves the clients until requestStop().
+ ******/
+template<typename T>
+void SharedMemoryControllerService<T>::run(const unsigned int spins)
+{
+    if (!m_base)
+    {
+        return;
+    }
+
+    m_header->stop.store(0);
+    while (!m_header->stop.load(std::memory_order_acquire))
+    {
+        serve(-1, spins);
+    }
+}
+
+/**
+ * @brief Makes serve() and run() return (can be called from another thread or a signal handler).
+ ******/
+template<typename T>
+void SharedMemoryControllerService<T>::requestStop()
+{
+    if (m_base)
+    {
+        m_header->stop.store(1, std::memory_order_seq_cst);
+        m_header->doorbell.fetch_add(1, std::memory_order_seq_cst);
+        shmServiceWake(&m_header->doorbell);
+    }
+}
+
+/**
+ * @return Number of controllers.
+ ******/
+template<typename T>
+unsigned int SharedMemoryControllerService<T>::getControllerCount() const
+{
+    return m_controllers.size();
+}
+
+/**
+ * @return Name of the segment.
+ ******/
+template<typename T>
+const std::string& SharedMemoryControllerService<T>::getName() const
+{
+    return m_name;
+}
+
+/**
+ * @return Size of the segment (bytes).
+ ******/
+template<typename T>
+std::size_t SharedMemoryControllerService<T>::getSegmentSize() const
+{
+    return m_size;
+}
+
+/**
+ * @return Controller (its block is in the segment).
+ ******/
+template<typename T>
+const ArenaStateSpaceController<T>& SharedMemoryControllerService<T>::getController(const unsigned int index) const
+{
+    return m_controllers[index];
+}
+
+/**
+ * @brief Constructor: maps the segment and checks its layout.
+ * @param name Name of the segment (a leading '/' is added if missing).
+ ******/
+template<typename T>
+SharedMemoryControllerClient<T>::SharedMemoryControllerClient(const std::string& name):
+m_base(0), m_size(0), m_header(0)
+{
+    const std::string segment = shmServiceName(name);
+    const int fd = shm_open(segment.c_str(), O_RDWR, 0);
+    struct stat status;
+
+    if (fd < 0 || fstat(fd, &status) != 0 || (std::size_t)status.st_size < sizeof(ShmServiceHeader))
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << segment << " cannot be opened\033[0m" << std::endl;
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    m_size = status.st_size;
+    void* base = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        std::cout << "\033[1;31mERROR: Shared memory segment " << segment << " cannot be mapped\033[0m" << std::endl;
+        return;
+    }
+
+    ShmServiceHeader* header = (ShmServiceHeader*)base;
+    if (header->magic != SHM_SERVICE_MAGIC || header->version != SHM_SERVICE_VERSION || header->scalarSize != sizeof(T)
+        || header->segmentSize != m_size || !header->ready.load(std::memory_order_acquire))
+    {
+        std::cout << "\033[1;31mERROR: " << segment << " is not a ready controller service segment of this version and scalar type\033[0m" << std::endl;
+        munmap(base, m_size);
+        return;
+    }
+
+    // Every offset read from the segment must stay inside the mapping
+    const std::size_t size = m_size;
+    auto inside = [size](const std::uint64_t offset, const std::uint64_t bytes)
+    {
+        return offset <= size && bytes <= size - offset;
+    };
+
+    bool valid = header->slotTableOffset % alignof(std::uint64_t) == 0
+        && inside(header->slotTableOffset, (std::uint64_t)header->controllerCount * sizeof(std::uint64_t));
+    std::vector<ShmServiceSlot*> slots;
+    for (unsigned int k=0;valid && k<header->controllerCount;k++)
+    {
+        const std::uint64_t offset = ((const std::uint64_t*)((char*)base + header->slotTableOffset))[k];
+        valid = offset % alignof(ShmServiceSlot) == 0 && inside(offset, sizeof(ShmServiceSlot));
+        if (!valid)
+        {
+            break;
+        }
+
+        ShmServiceSlot* slot = (ShmServiceSlot*)((char*)base + offset);
+        valid = slot->mailboxOffset % alignof(T) == 0 && inside(slot->mailboxOffset, 2 * (std::uint64_t)slot->ne * sizeof(T))
+            && slot->resultOffset % alignof(ShmServiceResult) == 0 && inside(slot->resultOffset, sizeof(ShmServiceResult) + (std::uint64_t)slot->nu * sizeof(T))
+            && inside(slot->blockOffset, slot->blockSize);
+        slots.push_back(slot);
+    }
+
+    if (!valid)
+    {
+        std::cout << "\033[1;31mERROR: " << segment << " has a slot table outside of the segment\033[0m" << std::endl;
+        munmap(base, m_size);
+        return;
+    }
+
+    m_base = base;
+    m_header = header;
+    m_slots = slots;
+}
+
+/**
+ * @brief Destructor: unmaps the segment.
+ ******/
+template<typename T>
+SharedMemoryControllerClient<T>::~SharedMemoryControllerClient()
+{
+    if (m_base)
+    {
+        munmap(m_base, m_size);
+    }
+}
+
+/**
+ * @return True if the segment is mapped and valid.
+ ******/
+template<typename T>
+bool SharedMemoryControllerClient<T>::isOpen() const
+{
+    return m_base != 0;
+}
+
+/**
+ * @brief Writes r_i and/or y_i (null pointers are left unchanged) in the mailbox, under its lock.
+ ******/
+template<typename T>
+void SharedMemoryControllerClient<T>::writeMailbox(const unsigned int index, const T* r_i, const T* y_i)
+{
+    ShmServiceSlot* slot = m_slots[index];
+    T* mailbox = (T*)((char*)m_base + slot->mailboxOffset);
+
+    slot->mailbox.lock();
+    if (r_i) Seqlock::store(mailbox, r_i, slot->ne * sizeof(T));
+    if (y_i) Seqlock::store(mailbox + slot->ne, y_i, slot->ne * sizeof(T));
+    slot->mailbox.unlock();
+}
+
+/**
+ * @brief Writes the reference (ne values) of a controller.
+ ******/
+template<typename T>
+void SharedMemoryControllerClient<T>::setReference(const unsigned int index, const T* r_i)
+{
+    writeMailbox(index, r_i, 0);
+}
+
+/**
+ * @brief Writes the measurement (ne values) of a controller.
+ ******/
+template<typename T>
+void SharedMemoryControllerClient<T>::setMeasurement(const unsigned int index, const T* y_i)
+{
+    writeMailbox(index, 0, y_i);
+}
+
+/**
+ * @brief Writes the reference and the measurement of a controller and submits it.
+ ******/
+template<typename T>
+void SharedMemoryControllerClient<T>::write(const unsigned int index, const T* r_i, const T* y_i)
+{
+    writeMailbox(index, r_i, y_i);
+    submit(index);
+}
+
+/**
+ * @brief Marks the controller pending and rings the doorbell (futex call only if the server sleeps).
+ ******/
+template<typename T>
+void SharedMemoryControllerClient<T>::submit(const unsigned int index)
+{
+    m_slots[index]->pending.store(1, std::memory_order_release);
+    m_header->doorbell.fetch_add(1, std::memory_order_seq_cst);
+
+    if (m_header->sleeping.load(std::memory_order_seq_cst))
+    {
+        shmServiceWake(&m_header->doorbell);
+    }
+}
+
+/**
+ * @brief Reads the last output of a controller (no system call).
+ * @details The result is checked at most SHM_SERVICE_READ_SPINS times: a server that died inside its
+ * write section must not stall the client.
+ * @param u_i Output (nu values, not valid when 0 is returned).
+ * @param time If not null, controller time of the output (seconds).
+ * @return Step count of the output (0: the controller has not stepped yet, or the result was still being
+ * written after SHM_SERVICE_READ_SPINS checks).
+ ******/
+template<typename T>
+std::uint64_t SharedMemoryControllerClient<T>::readOutput(const unsigned int index, T* u_i, double* time) const
+{
+    const ShmServiceSlot* slot = m_slots[index];
+    const volatile char* result = (const char*)m_base + slot->resultOffset;
+    ShmServiceResult head;
+    bool copied = false;
+
+    for (unsigned int spin=0;spin<SHM_SERVICE_READ_SPINS && !copied;spin++)
+    {
+        const std::uint32_t sequence = slot->result.getSequence();
+        if (sequence & 1)
+        {
+            SEQLOCK_PAUSE();
+            continue;
+        }
+        Seqlock::load(&head, result, sizeof(head));
+        Seqlock::load(u_i, result + sizeof(head), slot->nu * sizeof(T));
+        copied = !slot->result.readRetry(sequence);
+    }
+
+    if (!copied)
+    {
+        return 0;
+    }
+
+    if (time)
+    {
+        *time = head.time;
+    }
+
+    return head.step;
+}
+
+/**
+ * @brief Spins (then yields) until the controller has stepped after afterStep.
+ * @return Step count of the output read, 0 after timeoutSeconds.
+ ******/
+template<typename T>
+std::uint64_t SharedMemoryControllerClient<T>::waitOutput(const unsigned int index, const std::uint64_t afterStep, T* u_i, const double timeoutSeconds) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (unsigned int k=0;;k++)
+    {
+        const std::uint64_t step = readOutput(index, u_i);
+        if (step > afterStep)
+        {
+            return step;
+        }
+
+        if (k < 1000)
+        {
+            SEQLOCK_PAUSE();
+        }
+        else
+        {
+            if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeoutSeconds)
+            {
+                return 0;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
+
+/**
+ * @return Number of controllers.
+ ******/
+template<typename T>
+unsigned int SharedMemoryControllerClient<T>::getControllerCount() const
+{
+    return m_slots.size();
+}
+
+/**
+ * @return Number of states of a controller.
+ ******/
+template<typename T>
+unsigned int SharedMemoryControllerClient<T>::getNx(const unsigned int index) const
+{
+    return m_slots[index]->nx;
+}
+
+/**
+ * @return Number of inputs (errors) of a controller.
+ ******/
+template<typename T>
+unsigned int SharedMemoryControllerClient<T>::getNe(const unsigned int index) const
+{
+    return m_slots[index]->ne;
+}
+
+/**
+ * @return Number of outputs of a controller.
+ ******/
+template<typename T>
+unsigned int SharedMemoryControllerClient<T>::getNu(const unsigned int index) const
+{
+    return m_slots[index]->nu;
+}
+
+/**
+ * @return Time step of a controller (seconds).
+ ******/
+template<typename T>
+float SharedMemoryControllerClient<T>::getTimeStep(const unsigned int index) const
+{
+    return m_slots[index]->t_s;
+}
+
+#endif  // SHAREDMEMORYSERVICE_CPP
@@ -0,0 +1,206 @@
+/**
+ * @file sharedMemoryService.h
+ * @brief Shared memory controller service and client (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef SHAREDMEMORYSERVICE_H
+#define SHAREDMEMORYSERVICE_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <memory_resource>
+#include <atomic>
+#include <cstdint>
+
+#include "stateSpaceController.h"
+#include "arenaController.h"
+#include "seqlock.h"
+
+/**
+ * @brief Identification of a service segment ("SSCSHM01") and version of its layout.
+ ******/
+#define SHM_SERVICE_MAGIC 0x31304D4853435353ULL
+#define SHM_SERVICE_VERSION 1
+
+/**
+ * @brief Checks of a mailbox being written before the server skips it until the next round (a client
+ * that died inside its write section must not stall the server), and of a result being written before
+ * a client read gives up.
+ ******/
+#define SHM_SERVICE_READ_SPINS 1000
+
+/**
+ * @brief Segment header (offset 0).
+ * @details Offsets are in bytes from the start of the segment, every structure and array starts on a
+ * cache line. The slot table (controllerCount uint64_t) gives the offset of each ShmServiceSlot.
+ ******/
+struct ShmServiceHeader
+{
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t scalarSize;       // sizeof(T) of the controllers
+    std::uint32_t controllerCount;
+    std::uint32_t reserved;
+    std::uint64_t segmentSize;
+    std::uint64_t slotTableOffset;
+    std::atomic<std::uint32_t> ready;       // 1 once the server has built the segment
+
+    alignas(64) std::atomic<std::uint32_t> doorbell;   // Futex word, incremented by every submission
+    std::atomic<std::uint32_t> sleeping;               // 1 while the server waits on the futex
+    std::atomic<std::uint32_t> stop;                   // 1 when the server is asked to stop
+};
+
+/**
+ * @brief Controller slot: dimensions, offsets of its arrays and synchronization words.
+ * @details
+ * - mailbox (mailboxOffset): r_i then y_i (2*ne values), written by clients under the mailbox lock;
+ * - result (resultOffset): ShmServiceResult then u_i (nu values), published by the server under the result seqlock;
+ * - block (blockOffset): ArenaStateSpaceController block of the controller (A | B | C | D | states | scratch).
+ ******/
+struct ShmServiceSlot
+{
+    std::uint32_t nx, ne, nu;
+    float t_s;
+    std::uint64_t mailboxOffset;
+    std::uint64_t resultOffset;
+    std::uint64_t blockOffset;
+    std::uint64_t blockSize;
+
+    alignas(64) std::atomic<std::uint32_t> pending;   // 1 when the mailbox was submitted and not stepped yet
+    alignas(64) Seqlock mailbox;
+    alignas(64) Seqlock result;
+};
+
+/**
+ * @brief Head of a result.
+ ******/
+struct ShmServiceResult
+{
+    std::uint64_t step;   // Number of steps of the controller (0: no output yet)
+    double time;          // Controller time of the output (seconds)
+};
+
+/**
+ * @class SharedMemoryControllerService
+ * @brief Controllers stepped by one process for clients in other processes, through a POSIX shared memory segment.
+ * @details The server creates the segment (shm_open) with a fixed layout (see ShmServiceHeader) and copies
+ * the controllers into it. A client writes r/y into the mailbox of a controller and submits it: the
+ * submission increments the doorbell and only makes a futex call if the server sleeps. The server steps
+ * every submitted controller with the content of its mailbox and publishes u through a seqlock, so a
+ * client reading its result makes no system call.
+ *
+ * serve() spins on the doorbell before sleeping on the futex (FUTEX_WAKE/FUTEX_WAIT, Linux; short
+ * sleeps elsewhere). A mailbox still being written after SHM_SERVICE_READ_SPINS checks stays pending and
+ * is skipped until the next round. The segment is removed when the service is destroyed; creating a
+ * service fails if the segment already exists.
+ ******/
+template <typename T>
+class SharedMemoryControllerService
+{
+    public:
+
+    // Create the segment "name" (e.g. "/ssc") holding copies of the controllers (time restarts from 0)
+    SharedMemoryControllerService(const std::string& name, const std::vector<StateSpaceController<T> >& controllers);
+
+    SharedMemoryControllerService(const SharedMemoryControllerService<T>&) = delete;
+    SharedMemoryControllerService<T>& operator=(const SharedMemoryControllerService<T>&) = delete;
+
+    virtual ~SharedMemoryControllerService();
+
+    bool isOpen() const;
+
+    // Step every submitted controller, returns the number of steps (never blocks)
+    unsigned int processPending();
+
+    // Wait for submissions (spins first, then sleeps), process them; returns the steps (0: timeout or stop)
+    unsigned int serve(const double timeoutSeconds = -1, const unsigned int spins = 2000);
+
+    // serve() until requestStop()
+    void run(const unsigned int spins = 2000);
+    void requestStop();
+
+    // Bytes of a segment holding these controllers
+    static std::size_t segmentSize(const std::vector<StateSpaceController<T> >& controllers);
+
+    unsigned int getControllerCount() const;
+    const std::string& getName() const;
+    std::size_t getSegmentSize() const;
+    const ArenaStateSpaceController<T>& getController(const unsigned int index) const;
+
+    protected:
+    std::string m_name;
+    void* m_base;
+    std::size_t m_size;
+    ShmServiceHeader* m_header;
+    std::vector<ShmServiceSlot*> m_slots;
+
+    /**
+     * @brief Controllers (blocks in the segment) and the resources handing out their blocks.
+     ******/
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource> > m_resources;
+    std::vector<ArenaStateSpaceController<T> > m_controllers;
+
+    /**
+     * @brief Copy of a mailbox (r_i then y_i).
+     ******/
+    std::vector<T> m_mailbox;
+};
+
+/**
+ * @class SharedMemoryControllerClient
+ * @brief Access of a process to the controllers of a SharedMemoryControllerService.
+ * @details Mailbox writes take a per controller spin lock (several clients may feed the same controller,
+ * e.g. a sensor driver writes y and the supervisor writes r). Outputs are read with the result seqlock.
+ ******/
+template <typename T>
+class SharedMemoryControllerClient
+{
+    public:
+
+    // Open the segment "name" created by a service (check isOpen())
+    SharedMemoryControllerClient(const std::string& name);
+
+    SharedMemoryControllerClient(const SharedMemoryControllerClient<T>&) = delete;
+    SharedMemoryControllerClient<T>& operator=(const SharedMemoryControllerClient<T>&) = delete;
+
+    virtual ~SharedMemoryControllerClient();
+
+    bool isOpen() const;
+
+    // Write the reference and/or the measurement (ne values) of a controller in its mailbox
+    void setReference(const unsigned int index, const T* r_i);
+    void setMeasurement(const unsigned int index, const T* y_i);
+    void write(const unsigned int index, const T* r_i, const T* y_i);
+
+    // Ask the server to step the controller with its mailbox
+    void submit(const unsigned int index);
+
+    // Last output (nu values) of a controller; returns its step count (0: no output yet)
+    std::uint64_t readOutput(const unsigned int index, T* u_i, double* time = 0) const;
+
+    // Spin until the controller has made more than afterStep steps; returns the step count (0: timeout)
+    std::uint64_t waitOutput(const unsigned int index, const std::uint64_t afterStep, T* u_i, const double timeoutSeconds = 1) const;
+
+    unsigned int getControllerCount() const;
+    unsigned int getNx(const unsigned int index) const;
+    unsigned int getNe(const unsigned int index) const;
+    unsigned int getNu(const unsigned int index) const;
+    float getTimeStep(const unsigned int index) const;
+
+    protected:
+    // Mailbox write under the lock of the slot
+    void writeMailbox(const unsigned int index, const T* r_i, const T* y_i);
+
+    void* m_base;
+    std::size_t m_size;
+    ShmServiceHeader* m_header;
+    std::vector<ShmServiceSlot*> m_slots;
+};
+
+#include "sharedMemoryService.cpp"
+
+#endif  // SHAREDMEMORYSERVICE_H
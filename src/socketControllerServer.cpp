@@ -0,0 +1,821 @@
+/**
+ * @file socketControllerServer.cpp
+ * @brief Batching Unix domain socket controller server and its client (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef SOCKETCONTROLLERSERVER_CPP
+#define SOCKETCONTROLLERSERVER_CPP
+
+#include "socketControllerServer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cerrno>
+#include <fstream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+#if !defined(SOCK_CLOEXEC)
+#define SOCK_CLOEXEC 0
+#endif
+
+/**
+ * @brief epoll identifiers of the listening socket, of the stop eventfd and of the batching timer.
+ * Connections use the following identifiers.
+ ******/
+#define SOCKET_LISTEN_ID 0
+#define SOCKET_WAKE_ID 1
+#define SOCKET_TIMER_ID 2
+#define SOCKET_FIRST_CONNECTION_ID 3
+
+/**
+ * @return Mean number of steps per batch.
+ ******/
+inline double SocketServerStatistics::meanBatchSize() const
+{
+    return batches ? (double)steps / batches : 0;
+}
+
+/**
+ * @brief Fills a Unix domain socket address, false if the path is too long.
+ ******/
+inline bool socketAddress(const std::string& path, struct sockaddr_un& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    return true;
+}
+
+/**
+ * @brief Constructor: listens on the socket path.
+ * @param path Socket path (an existing file is removed).
+ * @param batchWindowSeconds Requests received within this time after the first one of a batch are stepped together.
+ * @param maxBatch A batch is stepped at once when it reaches this number of requests.
+ ******/
+template<typename T>
+SocketControllerServer<T>::SocketControllerServer(const std::string& path, const double batchWindowSeconds, const unsigned int maxBatch):
+m_path(path), m_listen(-1), m_epoll(-1), m_timer(-1), m_wake(-1), m_window(batchWindowSeconds), m_maxBatch(std::max(1u, maxBatch)), m_stop(false),
+m_nextId(SOCKET_FIRST_CONNECTION_ID), m_timerArmed(false)
+{
+    m_statistics.requests = m_statistics.steps = m_statistics.batches = m_statistics.errors = 0;
+    m_statistics.connections = 0;
+
+#if defined(__linux__)
+    struct sockaddr_un address;
+    if (!socketAddress(path, address))
+    {
+        std::cout << "\033[1;31mERROR: Socket path " << path << " is too long\033[0m" << std::endl;
+        return;
+    }
+
+    unlink(path.c_str());
+    m_listen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (m_listen < 0 || m_epoll < 0 || m_timer < 0 || m_wake < 0
+        || bind(m_listen, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(m_listen, SOMAXCONN) != 0)
+    {
+        std::cout << "\033[1;31mERROR: Cannot listen on " << path << ": " << std::strerror(errno) << "\033[0m" << std::endl;
+        if (m_listen >= 0) ::close(m_listen);
+        m_listen = -1;
+        return;
+    }
+
+    const int fds[3] = {m_listen, m_wake, m_timer};
+    const std::uint64_t ids[3] = {SOCKET_LISTEN_ID, SOCKET_WAKE_ID, SOCKET_TIMER_ID};
+    for (int k=0;k<3;k++)
+    {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = ids[k];
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, fds[k], &event);
+    }
+#else
+    std::cout << "\033[1;31mERROR: The socket controller server needs Linux (epoll), " << path << " is not served\033[0m" << std::endl;
+#endif
+}
+
+/**
+ * @brief Destructor: closes the connections and removes the socket file.
+ ******/
+template<typename T>
+SocketControllerServer<T>::~SocketControllerServer()
+{
+    while (!m_connections.empty())
+    {
+        close(m_connections.begin()->first);
+    }
+
+    if (m_listen >= 0)
+    {
+        ::close(m_listen);
+        unlink(m_path.c_str());
+    }
+    if (m_epoll >= 0) ::close(m_epoll);
+    if (m_timer >= 0) ::close(m_timer);
+    if (m_wake >= 0) ::close(m_wake);
+
+    m_controllers.clear();
+}
+
+/**
+ * @return True if the server listens.
+ ******/
+template<typename T>
+bool SocketControllerServer<T>::isOpen() const
+{
+    return m_listen >= 0;
+}
+
+/**
+ * @brief Registers a copy of a controller (matrices and state, time restarts from 0).
+ * @return Index of the controller (used by the requests).
+ ******/
+template<typename T>
+unsigned int SocketControllerServer<T>::addController(const StateSpaceController<T>& controller)
+{
+    m_controllers.push_back(ArenaStateSpaceController<T>(controller, &m_pool));
+
+    return m_controllers.size() - 1;
+}
+
+/**
+ * @brief Registers a controller read from a data file (see StateSpaceController::loadControllerData()).
+ * @return Index of the controller, -1 if the file cannot be read.
+ ******/
+template<typename T>
+int SocketControllerServer<T>::loadController(const std::string& formattedDataFilePath)
+{
+    // loadControllerData() keeps the default controller when the file cannot be opened
+    if (!std::ifstream(formattedDataFilePath.c_str()))
+    {
+        std::cout << "\033[1;31mERROR: No controller read from " << formattedDataFilePath << "\033[0m" << std::endl;
+        return -1;
+    }
+
+    StateSpaceController<T> controller;
+    controller.loadControllerData(formattedDataFilePath);
+
+    return addController(controller);
+}
+
+/**
+ * @brief Runs one round of the event loop: accepts, reads, steps the batches due and writes the replies.
+ * @param timeoutSeconds Longest wait for an event (negative: no limit).
+ * @return Number of controller steps made.
+ ******/
+template<typename T>
+unsigned int SocketControllerServer<T>::serve(const double timeoutSeconds)
+{
+    if (m_listen < 0)
+    {
+        return 0;
+    }
+
+    const unsigned long long steps = m_statistics.steps;
+#if defined(__linux__)
+    struct epoll_event events[64];
+    const int timeout = (timeoutSeconds < 0) ? -1 : (int)std::ceil(timeoutSeconds * 1000);
+
+    const int n = epoll_wait(m_epoll, events, 64, timeout);
+    for (int k=0;k<n;k++)
+    {
+        const std::uint64_t id = events[k].data.u64;
+        std::uint64_t counter;
+
+        if (id == SOCKET_LISTEN_ID)
+        {
+            accept();
+        }
+        else if (id == SOCKET_WAKE_ID)
+        {
+            if (::read(m_wake, &counter, sizeof(counter)) > 0) m_stop = true;
+        }
+        else if (id == SOCKET_TIMER_ID)
+        {
+            if (::read(m_timer, &counter, sizeof(counter)) > 0 && m_timerArmed)
+            {
+                m_timerArmed = false;
+                stepBatch();
+            }
+        }
+        else
+        {
+            if (events[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLRDHUP))
+            {
+                read(id);
+            }
+            if ((events[k].events & EPOLLOUT) && m_connections.count(id))
+            {
+                flush(id);
+            }
+        }
+    }
+#else
+    (void)timeoutSeconds;
+#endif
+
+    // Without window, a batch is what this round has read
+    if (m_window <= 0 && !m_batch.empty())
+    {
+        stepBatch();
+    }
+
+    return m_statistics.steps - steps;
+}
+
+/**
+ * @brief Serves the clients until requestStop().
+ ******/
+template<typename T>
+void SocketControllerServer<T>::run()
+{
+    m_stop = false;
+    while (!m_stop && m_listen >= 0)
+    {
+        serve(-1);
+    }
+}
+
+/**
+ * @brief Makes run() return (thread-safe: writes to an eventfd).
+ ******/
+template<typename T>
+void SocketControllerServer<T>::requestStop()
+{
+    const std::uint64_t one = 1;
+    if (m_wake >= 0 && ::write(m_wake, &one, sizeof(one)) < 0)
+    {
+        std::cout << "\033[1;31mERROR: Cannot wake the socket server\033[0m" << std::endl;
+    }
+}
+
+/**
+ * @brief Accepts every pending connection.
+ ******/
+template<typename T>
+void SocketControllerServer<T>::accept()
+{
+#if defined(__linux__)
+    while (true)
+    {
+        const int fd = accept4(m_listen, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        const std::uint64_t id = m_nextId++;
+        Connection& connection = m_connections[id];
+        connection.fd = fd;
+        connection.written = 0;
+        connection.waitingWritable = false;
+
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = id;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+
+        m_statistics.connections = m_connections.size();
+    }
+#endif
+}
+
+/**
+ * @brief Reads everything available on a connection and parses the complete messages.
+ ******/
+template<typename T>
+void SocketControllerServer<T>::read(const std::uint64_t id)
+{
+    typename std::map<std::uint64_t, Connection>::iterator it = m_connections.find(id);
+    if (it == m_connections.end())
+    {
+        return;
+    }
+
+    Connection& connection = it->second;
+    bool closed = false;
+    char buffer[65536];
+
+    while (true)
+    {
+        const ssize_t bytes = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (bytes > 0)
+        {
+            connection.input.insert(connection.input.end(), buffer, buffer + bytes);
+        }
+        else
+        {
+            closed = (bytes == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR));
+            if (bytes == 0 || errno != EINTR) break;
+        }
+    }
+
+    parse(id);
+
+    if (closed)
+    {
+        close(id);
+    }
+}
+
+/**
+ * @brief Handles the complete messages received on a connection: info replies, step requests added to the batch.
+ ******/
+template<typename T>
+void SocketControllerServer<T>::parse(const std::uint64_t id)
+{
+    std::vector<char>& input = m_connections[id].input;
+    std::size_t offset = 0;
+
+    while (input.size() - offset >= sizeof(SocketMessageHeader))
+    {
+        SocketMessageHeader header;
+        std::memcpy(&header, input.data() + offset, sizeof(header));
+
+        const std::size_t bytes = sizeof(header) + header.count * sizeof(T);
+        if (input.size() - offset < bytes)
+        {
+            break;
+        }
+
+        const char* values = input.data() + offset + sizeof(header);
+        offset += bytes;
+        m_statistics.requests++;
+
+        if (header.controller >= m_controllers.size())
+        {
+            reply(id, header, SOCKET_UNKNOWN_CONTROLLER, 0, 0);
+        }
+        else if (header.type == SOCKET_INFO)
+        {
+            const ArenaStateSpaceController<T>& controller = m_controllers[header.controller];
+            const T info[4] = {(T)controller.getNx(), (T)controller.getNe(), (T)controller.getNu(), (T)controller.getTimeStep()};
+            reply(id, header, SOCKET_OK, info, 4);
+        }
+        else if (header.type != SOCKET_STEP)
+        {
+            reply(id, header, SOCKET_BAD_TYPE, 0, 0);
+        }
+        else if (header.count != m_controllers[header.controller].getNe() && header.count != 2 * m_controllers[header.controller].getNe())
+        {
+            reply(id, header, SOCKET_BAD_SIZE, 0, 0);
+        }
+        else
+        {
+            Request request;
+            request.connection = id;
+            request.header = header;
+            request.values = m_batchValues.size();
+            m_batchValues.resize(m_batchValues.size() + header.count);
+            std::memcpy(m_batchValues.data() + request.values, values, header.count * sizeof(T));
+            m_batch.push_back(request);
+
+            if (m_batch.size() >= m_maxBatch)
+            {
+                stepBatch();
+            }
+            else if (m_window > 0 && !m_timerArmed)
+            {
+                armTimer();
+            }
+        }
+    }
+
+    input.erase(input.begin(), input.begin() + offset);
+    flush(id);
+}
+
+/**
+ * @brief Starts the batching window.
+ ******/
+template<typename T>
+void SocketControllerServer<T>::armTimer()
+{
+#if defined(__linux__)
+    struct itimerspec timer;
+    std::memset(&timer, 0, sizeof(timer));
+    timer.it_value.tv_sec = (time_t)m_window;
+    timer.it_value.tv_nsec = std::max(1L, (long)((m_window - timer.it_value.tv_sec) * 1e9));
+
+    timerfd_settime(m_timer, 0, &timer, 0);
+#endif
+    m_timerArmed = true;
+}
+
+/**
+ * @brief Steps the batch grouped by controller (arrival order within a controller) and sends the replies.
+ * @return Number of steps.
+ ******/
+template<typename T>
+unsigned int SocketControllerServer<T>::stepBatch()
+{
+    if (m_timerArmed)
+    {
+#if defined(__linux__)
+        struct itimerspec timer;
+        std::memset(&timer, 0, sizeof(timer));
+        timerfd_settime(m_timer, 0, &timer, 0);
+#endif
+        m_timerArmed = false;
+    }
+
+    m_order.resize(m_batch.size());
+    for (unsigned int k=0;k<m_order.size();k++) m_order[k] = k;
+    std::stable_sort(m_order.begin(), m_order.end(), [this](const unsigned int a, const unsigned int b) {
+        return m_batch[a].header.controller < m_batch[b].header.controller;
+    });
+
+    for (unsigned int k=0;k<m_order.size();k++)
+    {
+        const Request& request = m_batch[m_order[k]];
+        ArenaStateSpaceController<T>& controller = m_controllers[request.header.controller];
+        const T* values = m_batchValues.data() + request.values;
+
+        const T* u = (request.header.count == controller.getNe()) ? controller.step(values) : controller.step(values, values + controller.getNe());
+
+        // The connection may have been closed since the request: the controller still steps
+        if (m_connections.count(request.connection))
+        {
+            reply(request.connection, request.header, SOCKET_OK, u, controller.getNu());
+        }
+    }
+
+    const unsigned int steps = m_batch.size();
+    m_statistics.steps += steps;
+    m_statistics.batches++;
+
+    // Send the replies, once per connection
+    std::vector<std::uint64_t> connections;
+    for (unsigned int k=0;k<m_batch.size();k++) connections.push_back(m_batch[k].connection);
+    std::sort(connections.begin(), connections.end());
+    connections.erase(std::unique(connections.begin(), connections.end()), connections.end());
+
+    m_batch.clear();
+    m_batchValues.clear();
+
+    for (unsigned int k=0;k<connections.size();k++)
+    {
+        if (m_connections.count(connections[k])) flush(connections[k]);
+    }
+
+    return steps;
+}
+
+/**
+ * @brief Queues a reply on a connection (sent by flush()).
+ * @details More than SOCKET_MAX_VALUES values do not fit in a message: a SOCKET_BAD_SIZE error is queued instead.
+ ******/
+template<typename T>
+void SocketControllerServer<T>::reply(const std::uint64_t id, const SocketMessageHeader& request, const std::int32_t status, const T* values, const unsigned int count)
+{
+    if (count > SOCKET_MAX_VALUES)
+    {
+        std::cout << "\033[1;31mERROR: Reply of " << count << " values exceeds " << SOCKET_MAX_VALUES << " (controller " << request.controller << ")\033[0m" << std::endl;
+        reply(id, request, SOCKET_BAD_SIZE, 0, 0);
+        return;
+    }
+
+    std::vector<char>& output = m_connections[id].output;
+
+    SocketMessageHeader header = request;
+    header.status = status;
+    header.count = count;
+
+    const std::size_t offset = output.size();
+    output.resize(offset + sizeof(header) + count * sizeof(T));
+    std::memcpy(output.data() + offset, &header, sizeof(header));
+    if (count) std::memcpy(output.data() + offset + sizeof(header), values, count * sizeof(T));
+
+    if (status != SOCKET_OK)
+    {
+        m_statistics.errors++;
+    }
+}
+
+/**
+ * @brief Writes the queued replies of a connection; waits for EPOLLOUT if the socket is full.
+ ******/
+template<typename T>
+void SocketControllerServer<T>::flush(const std::uint64_t id)
+{
+    Connection& connection = m_connections[id];
+
+    while (connection.written < connection.output.size())
+    {
+        const ssize_t bytes = send(connection.fd, connection.output.data() + connection.written, connection.output.size() - connection.written, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (bytes > 0)
+        {
+            connection.written += bytes;
+        }
+        else if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            if (bytes < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                // Closed by the event loop (EPOLLHUP): the connection may be in use by the caller
+                connection.output.clear();
+                connection.written = 0;
+                shutdown(connection.fd, SHUT_RDWR);
+                return;
+            }
+
+            if (!connection.waitingWritable)
+            {
+#if defined(__linux__)
+                struct epoll_event event;
+                event.events = EPOLLIN | EPOLLRDHUP | EPOLLOUT;
+                event.data.u64 = id;
+                epoll_ctl(m_epoll, EPOLL_CTL_MOD, connection.fd, &event);
+#endif
+                connection.waitingWritable = true;
+            }
+            return;
+        }
+    }
+
+    connection.output.clear();
+    connection.written = 0;
+
+    if (connection.waitingWritable)
+    {
+#if defined(__linux__)
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = id;
+        epoll_ctl(m_epoll, EPOLL_CTL_MOD, connection.fd, &event);
+#endif
+        connection.waitingWritable = false;
+    }
+}
+
+/**
+ * @brief Closes a connection (its pending requests still step, their replies are dropped).
+ ******/
+template<typename T>
+void SocketControllerServer<T>::close(const std::uint64_t id)
+{
+    typename std::map<std::uint64_t, Connection>::iterator it = m_connections.find(id);
+    if (it == m_connections.end())
+    {
+        return;
+    }
+
+#if defined(__linux__)
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, it->second.fd, 0);
+#endif
+    ::close(it->second.fd);
+    m_connections.erase(it);
+    m_statistics.connections = m_connections.size();
+}
+
+/**
+ * @return Number of controllers.
+ ******/
+template<typename T>
+unsigned int SocketControllerServer<T>::getControllerCount() const
+{
+    return m_controllers.size();
+}
+
+/**
+ * @return Registered controller.
+ ******/
+template<typename T>
+const ArenaStateSpaceController<T>& SocketControllerServer<T>::getController(const unsigned int index) const
+{
+    return m_controllers[index];
+}
+
+/**
+ * @return Socket path.
+ ******/
+template<typename T>
+const std::string& SocketControllerServer<T>::getPath() const
+{
+    return m_path;
+}
+
+/**
+ * @return Counters of the server.
+ ******/
+template<typename T>
+SocketServerStatistics SocketControllerServer<T>::getStatistics() const
+{
+    return m_statistics;
+}
+
+/**
+ * @brief Constructor: connects to a server.
+ * @param path Socket path of the server.
+ ******/
+template<typename T>
+SocketControllerClient<T>::SocketControllerClient(const std::string& path):
+m_fd(-1), m_tag(0)
+{
+    struct sockaddr_un address;
+    if (!socketAddress(path, address))
+    {
+        std::cout << "\033[1;31mERROR: Socket path " << path << " is too long\033[0m" << std::endl;
+        return;
+    }
+
+    m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0 || connect(m_fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+    {
+        std::cout << "\033[1;31mERROR: Cannot connect to " << path << ": " << std::strerror(errno) << "\033[0m" << std::endl;
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+/**
+ * @brief Destructor: closes the connection.
+ ******/
+template<typename T>
+SocketControllerClient<T>::~SocketControllerClient()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+}
+
+/**
+ * @return True if connected.
+ ******/
+template<typename T>
+bool SocketControllerClient<T>::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+/**
+ * @brief Sends a header and its values in one write.
+ ******/
+template<typename T>
+bool SocketControllerClient<T>::sendMessage(const SocketMessageHeader& header, const T* values)
+{
+    std::vector<char> message(sizeof(header) + header.count * sizeof(T));
+    std::memcpy(message.data(), &header, sizeof(header));
+    if (header.count) std::memcpy(message.data() + sizeof(header), values, header.count * sizeof(T));
+
+    std::size_t sent = 0;
+    while (sent < message.size())
+    {
+        const ssize_t bytes = ::send(m_fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes <= 0) return false;
+        sent += bytes;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads exactly "bytes" bytes.
+ ******/
+template<typename T>
+bool SocketControllerClient<T>::readAll(void* data, const std::size_t bytes)
+{
+    std::size_t received = 0;
+    while (received < bytes)
+    {
+        const ssize_t n = recv(m_fd, (char*)data + received, bytes - received, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        received += n;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Asks the dimensions and the time step of a controller (waits for the reply).
+ * @return False if the controller does not exist or the connection failed.
+ ******/
+template<typename T>
+bool SocketControllerClient<T>::info(const unsigned int controller, unsigned int& nx, unsigned int& ne, unsigned int& nu, float& t_s)
+{
+    SocketMessageHeader header;
+    header.type = SOCKET_INFO;
+    header.count = 0;
+    header.controller = controller;
+    header.tag = m_tag++;
+    header.status = 0;
+
+    SocketMessageHeader answer;
+    if (m_fd < 0 || !sendMessage(header, 0) || !receive(answer, m_values) || answer.status != SOCKET_OK || m_values.size() != 4)
+    {
+        return false;
+    }
+
+    nx = m_values[0];
+    ne = m_values[1];
+    nu = m_values[2];
+    t_s = m_values[3];
+
+    return true;
+}
+
+/**
+ * @brief Sends a step request without waiting for the reply.
+ * @param tag Copied into the reply.
+ * @param values e_i (ne values) or r_i then y_i (2*ne values).
+ * @return False if the message is not sent (connection closed, more than SOCKET_MAX_VALUES values).
+ ******/
+template<typename T>
+bool SocketControllerClient<T>::send(const unsigned int controller, const std::uint32_t tag, const T* values, const unsigned int count)
+{
+    if (count > SOCKET_MAX_VALUES)
+    {
+        std::cout << "\033[1;31mERROR: Request of " << count << " values exceeds " << SOCKET_MAX_VALUES << "\033[0m" << std::endl;
+        return false;
+    }
+
+    SocketMessageHeader header;
+    header.type = SOCKET_STEP;
+    header.count = count;
+    header.controller = controller;
+    header.tag = tag;
+    header.status = 0;
+
+    return m_fd >= 0 && sendMessage(header, values);
+}
+
+/**
+ * @brief Waits for the next reply.
+ * @param header Header of the reply (tag of the request, status).
+ * @param u_i Values of the reply.
+ * @return False if the connection is closed.
+ ******/
+template<typename T>
+bool SocketControllerClient<T>::receive(SocketMessageHeader& header, std::vector<T>& u_i)
+{
+    if (m_fd < 0 || !readAll(&header, sizeof(header)))
+    {
+        return false;
+    }
+
+    u_i.resize(header.count);
+
+    return header.count == 0 || readAll(u_i.data(), header.count * sizeof(T));
+}
+
+/**
+ * @brief Synchronous step with the error vector (do not mix with pipelined send()/receive()).
+ * @return Controller output, empty on error.
+ ******/
+template<typename T>
+std::vector<T> SocketControllerClient<T>::step(const unsigned int controller, const std::vector<T>& e_i)
+{
+    SocketMessageHeader header;
+    std::vector<T> u_i;
+
+    if (!send(controller, m_tag++, e_i.data(), e_i.size()) || !receive(header, u_i) || header.status != SOCKET_OK)
+    {
+        return std::vector<T>();
+    }
+
+    return u_i;
+}
+
+/**
+ * @brief Synchronous step with the reference and the plant output (do not mix with pipelined send()/receive()).
+ * @return Controller output, empty on error.
+ ******/
+template<typename T>
+std::vector<T> SocketControllerClient<T>::step(const unsigned int controller, const std::vector<T>& r_i, const std::vector<T>& y_i)
+{
+    std::vector<T> values(r_i);
+    values.insert(values.end(), y_i.begin(), y_i.end());
+
+    return step(controller, values);
+}
+
+#endif  // SOCKETCONTROLLERSERVER_CPP
@@ -0,0 +1,220 @@
+/**
+ * @file socketControllerServer.h
+ * @brief Batching Unix domain socket controller server and its client (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef SOCKETCONTROLLERSERVER_H
+#define SOCKETCONTROLLERSERVER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory_resource>
+#include <cstdint>
+
+#include "stateSpaceController.h"
+#include "arenaController.h"
+
+/**
+ * @brief Most values in one message (SocketMessageHeader::count is 16 bit).
+ ******/
+#define SOCKET_MAX_VALUES 65535
+
+/**
+ * @brief Message types.
+ * @details SOCKET_STEP: request with ne values (e_i) or 2*ne values (r_i then y_i), reply with nu values (u_i).
+ * SOCKET_INFO: request without values, reply with 4 values: nx, ne, nu and the time step.
+ ******/
+enum SocketMessageType
+{
+    SOCKET_STEP = 1,
+    SOCKET_INFO = 2
+};
+
+/**
+ * @brief Reply status.
+ ******/
+enum SocketStatus
+{
+    SOCKET_OK = 0,
+    SOCKET_UNKNOWN_CONTROLLER = -1,
+    SOCKET_BAD_SIZE = -2,
+    SOCKET_BAD_TYPE = -3
+};
+
+/**
+ * @brief Header of every request and reply (host byte order), followed by "count" values of type T.
+ * @details The tag is chosen by the client and copied into the reply: requests can be pipelined and
+ * replies of different controllers may come back in another order.
+ ******/
+struct SocketMessageHeader
+{
+    std::uint16_t type;
+    std::uint16_t count;
+    std::uint32_t controller;
+    std::uint32_t tag;
+    std::int32_t status;
+};
+
+/**
+ * @brief Counters of a server.
+ ******/
+struct SocketServerStatistics
+{
+    unsigned long long requests;   // Messages received
+    unsigned long long steps;      // Controller steps
+    unsigned long long batches;    // Batches stepped
+    unsigned long long errors;     // Error replies
+    unsigned int connections;      // Open connections
+
+    // Mean number of steps per batch
+    double meanBatchSize() const;
+};
+
+/**
+ * @class SocketControllerServer
+ * @brief Registry of controllers stepped on behalf of clients connected to a Unix domain socket.
+ * @details One thread runs the epoll loop (serve() or run()). Step requests arriving within the batching
+ * window (timerfd armed by the first request of a batch) or up to maxBatch requests are stepped together,
+ * grouped by controller, then the replies are queued on their connections and written as soon as the
+ * sockets accept them (EPOLLOUT when a client reads slowly): the loop never blocks on a client.
+ *
+ * Controllers are copied into ArenaStateSpaceController blocks of one pool: a step does not allocate.
+ * Requests of the same controller are stepped in their order of arrival. A reply of more than
+ * SOCKET_MAX_VALUES values is replaced by a SOCKET_BAD_SIZE error.
+ *
+ * The server needs Linux (epoll, eventfd, timerfd): elsewhere it does not open. The client only uses POSIX sockets.
+ ******/
+template <typename T>
+class SocketControllerServer
+{
+    public:
+
+    // Listen on the socket path (replaced if it exists); window 0: a batch is what one epoll round read
+    SocketControllerServer(const std::string& path, const double batchWindowSeconds = 100e-6, const unsigned int maxBatch = 256);
+
+    SocketControllerServer(const SocketControllerServer<T>&) = delete;
+    SocketControllerServer<T>& operator=(const SocketControllerServer<T>&) = delete;
+
+    virtual ~SocketControllerServer();
+
+    bool isOpen() const;
+
+    // Register a copy of a controller, or a controller read with loadControllerData(); returns its index (-1: file not read)
+    unsigned int addController(const StateSpaceController<T>& controller);
+    int loadController(const std::string& formattedDataFilePath);
+
+    // One round of the event loop (waits at most timeoutSeconds, negative: no limit), returns the steps made
+    unsigned int serve(const double timeoutSeconds = -1);
+
+    // serve() until requestStop() (callable from another thread)
+    void run();
+    void requestStop();
+
+    unsigned int getControllerCount() const;
+    const ArenaStateSpaceController<T>& getController(const unsigned int index) const;
+    const std::string& getPath() const;
+    SocketServerStatistics getStatistics() const;
+
+    protected:
+
+    /**
+     * @brief Client connection: partial input message and queued replies.
+     ******/
+    struct Connection
+    {
+        int fd;
+        std::vector<char> input;
+        std::vector<char> output;
+        std::size_t written;
+        bool waitingWritable;
+    };
+
+    /**
+     * @brief Step request of the current batch (values in m_batchValues).
+     ******/
+    struct Request
+    {
+        std::uint64_t connection;
+        SocketMessageHeader header;
+        std::size_t values;
+    };
+
+    void accept();
+    void read(const std::uint64_t id);
+    void parse(const std::uint64_t id);
+    void reply(const std::uint64_t id, const SocketMessageHeader& request, const std::int32_t status, const T* values, const unsigned int count);
+    void flush(const std::uint64_t id);
+    void close(const std::uint64_t id);
+
+    // Step the requests of the batch and send the replies
+    unsigned int stepBatch();
+    void armTimer();
+
+    std::string m_path;
+    int m_listen, m_epoll, m_timer, m_wake;
+    double m_window;
+    unsigned int m_maxBatch;
+    bool m_stop;
+
+    std::pmr::unsynchronized_pool_resource m_pool;
+    std::vector<ArenaStateSpaceController<T> > m_controllers;
+
+    std::map<std::uint64_t, Connection> m_connections;
+    std::uint64_t m_nextId;
+
+    std::vector<Request> m_batch;
+    std::vector<T> m_batchValues;
+    std::vector<unsigned int> m_order;
+    bool m_timerArmed;
+
+    SocketServerStatistics m_statistics;
+};
+
+/**
+ * @class SocketControllerClient
+ * @brief Blocking client of a SocketControllerServer (requests can be pipelined with send() / receive()).
+ ******/
+template <typename T>
+class SocketControllerClient
+{
+    public:
+
+    // Connect to the socket path
+    SocketControllerClient(const std::string& path);
+
+    SocketControllerClient(const SocketControllerClient<T>&) = delete;
+    SocketControllerClient<T>& operator=(const SocketControllerClient<T>&) = delete;
+
+    virtual ~SocketControllerClient();
+
+    bool isOpen() const;
+
+    // Dimensions and time step of a controller (false if unknown)
+    bool info(const unsigned int controller, unsigned int& nx, unsigned int& ne, unsigned int& nu, float& t_s);
+
+    // Send a step request: ne values (e_i) or 2*ne values (r_i then y_i)
+    bool send(const unsigned int controller, const std::uint32_t tag, const T* values, const unsigned int count);
+
+    // Next reply (waits for it), its values are written in u_i
+    bool receive(SocketMessageHeader& header, std::vector<T>& u_i);
+
+    // Synchronous step: send and wait for the reply (empty vector on error)
+    std::vector<T> step(const unsigned int controller, const std::vector<T>& e_i);
+    std::vector<T> step(const unsigned int controller, const std::vector<T>& r_i, const std::vector<T>& y_i);
+
+    protected:
+    bool sendMessage(const SocketMessageHeader& header, const T* values);
+    bool readAll(void* data, const std::size_t bytes);
+
+    int m_fd;
+    std::uint32_t m_tag;
+    std::vector<T> m_values;
+};
+
+#include "socketControllerServer.cpp"
+
+#endif  // SOCKETCONTROLLERSERVER_H
@@ -0,0 +1,548 @@
+/**
+ * @file stateEstimator.cpp
+ * @brief Steady-state Kalman / Luenberger state estimators and their fusion with a controller (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef STATEESTIMATOR_CPP
+#define STATEESTIMATOR_CPP
+
+#include "stateEstimator.h"
+#include "discretization.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+/**
+ * @brief Solves the filter discrete algebraic Riccati equation.
+ * @details Structured doubling algorithm on the dual (control) form, A_0 = A', G_0 = C'*R^-1*C, H_0 = Q:
+ *
+ *      W = I + G_k*H_k
+ *      A_{k+1} = A_k*W^-1*A_k,  G_{k+1} = G_k + A_k*W^-1*G_k*A_k',  H_{k+1} = H_k + A_k'*H_k*W^-1*A_k
+ *
+ * H_k converges quadratically to P when (A, C) is detectable and (A, Q) stabilizable.
+ * @param A Plant state matrix (nx x nx).
+ * @param C Plant output matrix (ny x nx).
+ * @param Q Process noise covariance (nx x nx, symmetric positive semidefinite).
+ * @param R Measurement noise covariance (ny x ny, symmetric positive definite).
+ * @param P Solution: steady-state a priori covariance.
+ * @return False if the iteration does not converge.
+ ******/
+template<typename T>
+bool discreteRiccati(const QSMatrix<T>& A, const QSMatrix<T>& C, const QSMatrix<T>& Q, const QSMatrix<T>& R, QSMatrix<T>& P)
+{
+    const T tolerance = 10 * std::numeric_limits<T>::epsilon();
+    const unsigned int nx = A.get_rows();
+    const QSMatrix<T> I = identityMatrix<T>(nx);
+
+    QSMatrix<T> Ak = A.transpose();
+    QSMatrix<T> G = C.transpose() * R.solve(C);
+    P = Q;
+
+    for (int iteration=0;iteration<64;iteration++)
+    {
+        const QSMatrix<T> W = I + G * P;
+        const QSMatrix<T> WAk = W.solve(Ak);          // W^-1*A_k
+        const QSMatrix<T> WG = W.solve(G);            // W^-1*G_k
+
+        const QSMatrix<T> increment = Ak.transpose() * P * WAk;
+        G = G + Ak * WG * Ak.transpose();
+        Ak = Ak * WAk;
+        P = P + increment;
+
+        const T norm = norm1(P);
+        if (!std::isfinite(norm))
+        {
+            return false;
+        }
+        if (norm1(increment) <= tolerance * norm)
+        {
+            P = (P + P.transpose()) * T(0.5);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Steady-state Kalman gain of the measurement update.
+ * @param A Plant state matrix.
+ * @param C Plant output matrix.
+ * @param Q Process noise covariance.
+ * @param R Measurement noise covariance.
+ * @param L Gain (nx x ny): L = P*C'*(C*P*C' + R)^-1.
+ * @param P If not null, steady-state a priori covariance.
+ * @return False if the Riccati equation has no stabilizing solution found.
+ ******/
+template<typename T>
+bool kalmanGain(const QSMatrix<T>& A, const QSMatrix<T>& C, const QSMatrix<T>& Q, const QSMatrix<T>& R, QSMatrix<T>& L, QSMatrix<T>* P)
+{
+    QSMatrix<T> covariance;
+    if (!discreteRiccati(A, C, Q, R, covariance))
+    {
+        return false;
+    }
+
+    // L' = S^-1*C*P with S = C*P*C' + R symmetric
+    const QSMatrix<T> S = C * covariance * C.transpose() + R;
+    L = S.solve(C * covariance).transpose();
+
+    if (P)
+    {
+        *P = covariance;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Constructor with a given gain.
+ * @param A Plant state matrix (nx x nx).
+ * @param B Plant input matrix (nx x nu).
+ * @param C Plant output matrix (ny x nx).
+ * @param D Plant feedthrough matrix (ny x nu).
+ * @param L Estimator gain (nx x ny), applied to the innovation in correct().
+ ******/
+template<typename T>
+StateEstimator<T>::StateEstimator(QSMatrix<T> A, QSMatrix<T> B, QSMatrix<T> C, QSMatrix<T> D, QSMatrix<T> L):
+m_A(std::move(A)), m_B(std::move(B)), m_C(std::move(C)), m_D(std::move(D)), m_L(std::move(L)),
+m_nx(m_A.get_rows()), m_nu(m_B.get_cols()), m_ny(m_C.get_rows()),
+m_prediction(m_nx, 0), m_estimate(m_nx, 0), m_innovation(m_ny, 0)
+{
+    if (m_L.get_rows() != m_nx || m_L.get_cols() != m_ny)
+    {
+        std::cout << "\033[1;31mERROR: Estimator gain must be " << m_nx << "x" << m_ny << "\033[0m" << std::endl;
+    }
+}
+
+/**
+ * @brief Steady-state Kalman filter (gain computed once, see kalmanGain()).
+ * @param success If not null, false when the Riccati equation did not converge (the gain is then zero).
+ ******/
+template<typename T>
+StateEstimator<T> StateEstimator<T>::kalman(const QSMatrix<T>& A, const QSMatrix<T>& B, const QSMatrix<T>& C, const QSMatrix<T>& D,
+                                            const QSMatrix<T>& Q, const QSMatrix<T>& R, bool* success)
+{
+    QSMatrix<T> L(A.get_rows(), C.get_rows(), 0);
+    const bool converged = kalmanGain(A, C, Q, R, L);
+    if (!converged)
+    {
+        std::cout << "\033[1;31mERROR: Riccati equation did not converge (plant not detectable?)\033[0m" << std::endl;
+        L = QSMatrix<T>(A.get_rows(), C.get_rows(), 0);
+    }
+    if (success)
+    {
+        *success = converged;
+    }
+
+    return StateEstimator<T>(A, B, C, D, L);
+}
+
+/**
+ * @brief Measurement update: x_{i|i} = x_{i|i-1} + L*(y_i - C*x_{i|i-1} - D*u_i).
+ * @param y_i Measured plant output.
+ * @param u_i Plant input of the same step.
+ ******/
+template<typename T>
+void StateEstimator<T>::correct(const std::vector<T>& y_i, const std::vector<T>& u_i)
+{
+    const std::vector<T> Cx = m_C * m_prediction;
+    const std::vector<T> Du = m_D * u_i;
+    for (unsigned int k=0;k<m_ny;k++)
+    {
+        m_innovation[k] = y_i[k] - Cx[k] - Du[k];
+    }
+
+    m_estimate = QSMatrix<T>::vectorAdd(m_prediction, m_L * m_innovation);
+}
+
+/**
+ * @brief Time update: x_{i+1|i} = A*x_{i|i} + B*u_i.
+ * @param u_i Plant input.
+ ******/
+template<typename T>
+void StateEstimator<T>::predict(const std::vector<T>& u_i)
+{
+    m_prediction = QSMatrix<T>::vectorAdd(m_A * m_estimate, m_B * u_i);
+}
+
+/**
+ * @brief Measurement and time updates of a step.
+ * @return Estimate x_{i|i}.
+ ******/
+template<typename T>
+std::vector<T> StateEstimator<T>::update(const std::vector<T>& y_i, const std::vector<T>& u_i)
+{
+    correct(y_i, u_i);
+    predict(u_i);
+
+    return m_estimate;
+}
+
+/**
+ * @return Estimate after the last correction x_{i|i}.
+ ******/
+template<typename T>
+const std::vector<T>& StateEstimator<T>::getEstimate() const
+{
+    return m_estimate;
+}
+
+/**
+ * @return Prediction of the next state x_{i+1|i} (x_{i|i-1} between predict() and correct()).
+ ******/
+template<typename T>
+const std::vector<T>& StateEstimator<T>::getPrediction() const
+{
+    return m_prediction;
+}
+
+/**
+ * @return Innovation of the last correction.
+ ******/
+template<typename T>
+const std::vector<T>& StateEstimator<T>::getInnovation() const
+{
+    return m_innovation;
+}
+
+/**
+ * @brief Restarts the estimator.
+ * @param x0 Prediction of the next state (zero if empty).
+ ******/
+template<typename T>
+void StateEstimator<T>::reset(const std::vector<T>& x0)
+{
+    m_prediction = x0.empty() ? std::vector<T>(m_nx, 0) : x0;
+    m_estimate = m_prediction;
+    std::fill(m_innovation.begin(), m_innovation.end(), T(0));
+}
+
+/**
+ * @return Plant state matrix.
+ ******/
+template<typename T>
+const QSMatrix<T>& StateEstimator<T>::getA() const
+{
+    return m_A;
+}
+
+/**
+ * @return Plant input matrix.
+ ******/
+template<typename T>
+const QSMatrix<T>& StateEstimator<T>::getB() const
+{
+    return m_B;
+}
+
+/**
+ * @return Plant output matrix.
+ ******/
+template<typename T>
+const QSMatrix<T>& StateEstimator<T>::getC() const
+{
+    return m_C;
+}
+
+/**
+ * @return Plant feedthrough matrix.
+ ******/
+template<typename T>
+const QSMatrix<T>& StateEstimator<T>::getD() const
+{
+    return m_D;
+}
+
+/**
+ * @return Estimator gain L.
+ ******/
+template<typename T>
+const QSMatrix<T>& StateEstimator<T>::getGain() const
+{
+    return m_L;
+}
+
+/**
+ * @return Plant state dimension.
+ ******/
+template<typename T>
+unsigned int StateEstimator<T>::getNx() const
+{
+    return m_nx;
+}
+
+/**
+ * @return Plant input dimension.
+ ******/
+template<typename T>
+unsigned int StateEstimator<T>::getNu() const
+{
+    return m_nu;
+}
+
+/**
+ * @return Plant output dimension.
+ ******/
+template<typename T>
+unsigned int StateEstimator<T>::getNy() const
+{
+    return m_ny;
+}
+
+/**
+ * @brief Copies a matrix in row-major order.
+ ******/
+template<typename T>
+std::vector<T> estimatorRowMajor(const QSMatrix<T>& M)
+{
+    return std::vector<T>(M.data(), M.data() + M.get_rows() * M.get_cols());
+}
+
+/**
+ * @brief Constructor: packs the controller matrices and copies the estimator matrices.
+ * @details The controller starts from its current state, the estimator from its current prediction.
+ * @param controller Controller (e = r - y, ne = plant outputs, nu = plant inputs).
+ * @param estimator Estimator of the plant.
+ ******/
+template<typename T>
+EstimatedController<T>::EstimatedController(const StateSpaceController<T>& controller, const StateEstimator<T>& estimator):
+m_nx(controller.getNx()), m_nxe(estimator.getNx()), m_ne(controller.getNe()), m_nu(controller.getNu()),
+m_t_s(controller.getTimeStep()), m_i(0), m_t(0), m_valid(false)
+{
+    if (estimator.getNy() != m_ne || estimator.getNu() != m_nu)
+    {
+        std::cout << "\033[1;31mERROR: Controller (ne = " << m_ne << ", nu = " << m_nu << ") does not match the estimator (ny = "
+                  << estimator.getNy() << ", nu = " << estimator.getNu() << ")\033[0m" << std::endl;
+        return;
+    }
+
+    // [C_K D_K; A_K B_K]
+    const unsigned int cols = m_nx + m_ne;
+    m_K.assign((m_nu + m_nx) * cols, T(0));
+    for (unsigned int row=0;row<m_nu;row++)
+    {
+        for (unsigned int col=0;col<m_nx;col++) m_K[row * cols + col] = controller.getC()(row, col);
+        for (unsigned int col=0;col<m_ne;col++) m_K[row * cols + m_nx + col] = controller.getD()(row, col);
+    }
+    for (unsigned int row=0;row<m_nx;row++)
+    {
+        for (unsigned int col=0;col<m_nx;col++) m_K[(m_nu + row) * cols + col] = controller.getA()(row, col);
+        for (unsigned int col=0;col<m_ne;col++) m_K[(m_nu + row) * cols + m_nx + col] = controller.getB()(row, col);
+    }
+
+    m_A = estimatorRowMajor(estimator.getA());
+    m_B = estimatorRowMajor(estimator.getB());
+    m_C = estimatorRowMajor(estimator.getC());
+    m_D = estimatorRowMajor(estimator.getD());
+    m_L = estimatorRowMajor(estimator.getGain());
+
+    m_z.assign(cols, T(0));
+    m_out.assign(m_nu + m_nx, T(0));
+    const std::vector<T> x = controller.getX_i();
+    std::copy(x.begin(), x.end(), m_z.begin());
+    std::copy(x.begin(), x.end(), m_out.begin() + m_nu);
+    m_estimate = estimator.getEstimate();
+    m_prediction = estimator.getPrediction();
+    m_innovation.assign(m_ne, T(0));
+    m_valid = true;
+}
+
+/**
+ * @brief One step of the controller and the estimator.
+ * @details [u_i; x_{i+1}] in one pass over the packed controller, then the innovation, x_{i|i} and x_{i+1|i}.
+ * @param r_i Current reference vector (ne values).
+ * @param y_i Current plant output vector (ne values).
+ * @return Controller output vector (nu values, valid until the next step).
+ ******/
+template<typename T>
+const T* EstimatedController<T>::step(const T* r_i, const T* y_i)
+{
+    if (!m_valid)
+    {
+        return m_out.data();
+    }
+
+    T* x = m_z.data();
+    T* e = x + m_nx;
+    T* u = m_out.data();
+    for (unsigned int k=0;k<m_ne;k++) e[k] = r_i[k] - y_i[k];
+
+    const unsigned int cols = m_nx + m_ne;
+    const T* k = m_K.data();
+    for (unsigned int row=0;row<m_nu+m_nx;row++, k+=cols)
+    {
+        T sum = 0;
+        for (unsigned int col=0;col<cols;col++) sum += k[col] * x[col];
+        u[row] = sum;
+    }
+    std::copy(u + m_nu, u + m_nu + m_nx, x);
+
+    // Innovation y_i - C*x_{i|i-1} - D*u_i
+    T* xp = m_prediction.data();
+    for (unsigned int row=0;row<m_ne;row++)
+    {
+        const T* c = m_C.data() + row * m_nxe;
+        const T* d = m_D.data() + row * m_nu;
+        T sum = y_i[row];
+        for (unsigned int col=0;col<m_nxe;col++) sum -= c[col] * xp[col];
+        for (unsigned int col=0;col<m_nu;col++) sum -= d[col] * u[col];
+        m_innovation[row] = sum;
+    }
+
+    // x_{i|i} = x_{i|i-1} + L*innovation
+    for (unsigned int row=0;row<m_nxe;row++)
+    {
+        const T* l = m_L.data() + row * m_ne;
+        T sum = xp[row];
+        for (unsigned int col=0;col<m_ne;col++) sum += l[col] * m_innovation[col];
+        m_estimate[row] = sum;
+    }
+
+    // x_{i+1|i} = A*x_{i|i} + B*u_i
+    for (unsigned int row=0;row<m_nxe;row++)
+    {
+        const T* a = m_A.data() + row * m_nxe;
+        const T* b = m_B.data() + row * m_nu;
+        T sum = 0;
+        for (unsigned int col=0;col<m_nxe;col++) sum += a[col] * m_estimate[col];
+        for (unsigned int col=0;col<m_nu;col++) sum += b[col] * u[col];
+        xp[row] = sum;
+    }
+
+    m_t = m_i * m_t_s;
+    m_i++;
+
+    return u;
+}
+
+/**
+ * @brief Same as step(), with vectors.
+ * @return Controller output vector.
+ ******/
+template<typename T>
+std::vector<T> EstimatedController<T>::currentOutput(const std::vector<T>& r_i, const std::vector<T>& y_i)
+{
+    const T* u = step(r_i.data(), y_i.data());
+
+    return std::vector<T>(u, u + (m_valid ? m_nu : 0));
+}
+
+/**
+ * @return Controller state for the next step (nx values).
+ ******/
+template<typename T>
+const T* EstimatedController<T>::getState() const
+{
+    return m_z.data();
+}
+
+/**
+ * @return Estimate x_{i|i} of the last step.
+ ******/
+template<typename T>
+const T* EstimatedController<T>::getEstimate() const
+{
+    return m_estimate.data();
+}
+
+/**
+ * @return Prediction x_{i+1|i}.
+ ******/
+template<typename T>
+const T* EstimatedController<T>::getPrediction() const
+{
+    return m_prediction.data();
+}
+
+/**
+ * @return Controller output of the last step.
+ ******/
+template<typename T>
+const T* EstimatedController<T>::getOutput() const
+{
+    return m_out.data();
+}
+
+/**
+ * @brief Resets time, controller state, estimate and prediction.
+ ******/
+template<typename T>
+void EstimatedController<T>::reset()
+{
+    std::fill(m_z.begin(), m_z.end(), T(0));
+    std::fill(m_out.begin(), m_out.end(), T(0));
+    std::fill(m_estimate.begin(), m_estimate.end(), T(0));
+    std::fill(m_prediction.begin(), m_prediction.end(), T(0));
+    std::fill(m_innovation.begin(), m_innovation.end(), T(0));
+    m_i = 0;
+    m_t = 0;
+}
+
+/**
+ * @return Time step (seconds).
+ ******/
+template<typename T>
+float EstimatedController<T>::getTimeStep() const
+{
+    return m_t_s;
+}
+
+/**
+ * @return Current time (seconds).
+ ******/
+template<typename T>
+float EstimatedController<T>::getTime() const
+{
+    return m_t;
+}
+
+/**
+ * @return Controller state dimension.
+ ******/
+template<typename T>
+unsigned int EstimatedController<T>::getNx() const
+{
+    return m_nx;
+}
+
+/**
+ * @return Estimator state dimension.
+ ******/
+template<typename T>
+unsigned int EstimatedController<T>::getEstimatorNx() const
+{
+    return m_nxe;
+}
+
+/**
+ * @return Error (and plant output) dimension.
+ ******/
+template<typename T>
+unsigned int EstimatedController<T>::getNe() const
+{
+    return m_ne;
+}
+
+/**
+ * @return Controller output (and plant input) dimension.
+ ******/
+template<typename T>
+unsigned int EstimatedController<T>::getNu() const
+{
+    return m_nu;
+}
+
+/**
+ * @return False if the controller and the estimator dimensions do not match.
+ ******/
+template<typename T>
+bool EstimatedController<T>::isValid() const
+{
+    return m_valid;
+}
+
+#endif  // STATEESTIMATOR_CPP
@@ -0,0 +1,151 @@
+/**
+ * @file stateEstimator.h
+ * @brief Steady-state Kalman / Luenberger state estimators and their fusion with a controller (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef STATEESTIMATOR_H
+#define STATEESTIMATOR_H
+
+#include <iostream>
+#include <vector>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+
+// Solution P of the filter Riccati equation P = A*P*A' - A*P*C'*(C*P*C' + R)^-1*C*P*A' + Q (structured doubling)
+template <typename T>
+bool discreteRiccati(const QSMatrix<T>& A, const QSMatrix<T>& C, const QSMatrix<T>& Q, const QSMatrix<T>& R, QSMatrix<T>& P);
+
+// Steady-state Kalman gain L = P*C'*(C*P*C' + R)^-1 of the measurement update (P: a priori covariance)
+template <typename T>
+bool kalmanGain(const QSMatrix<T>& A, const QSMatrix<T>& C, const QSMatrix<T>& Q, const QSMatrix<T>& R, QSMatrix<T>& L, QSMatrix<T>* P = 0);
+
+/**
+ * @class StateEstimator
+ * @brief Constant gain state estimator of a discrete plant (steady-state Kalman filter or Luenberger observer).
+ * @details Plant model and estimator, with u_i the plant input and y_i the measured plant output:
+ *
+ *          | x_{i+1} = A*x_i + B*u_i
+ *          |     y_i = C*x_i + D*u_i
+ *
+ *      correct:  x_{i|i}   = x_{i|i-1} + L*(y_i - C*x_{i|i-1} - D*u_i)
+ *      predict:  x_{i+1|i} = A*x_{i|i} + B*u_i
+ *
+ * The gain L (nx x ny) is given (Luenberger: A - A*L*C stable) or computed once from the noise covariances
+ * (kalman(): steady-state Kalman gain, no covariance propagation at run time).
+ ******/
+template <typename T>
+class StateEstimator
+{
+    public:
+
+    // Estimator with a given gain L
+    StateEstimator(QSMatrix<T> A, QSMatrix<T> B, QSMatrix<T> C, QSMatrix<T> D, QSMatrix<T> L);
+
+    // Steady-state Kalman filter for process noise covariance Q and measurement noise covariance R
+    static StateEstimator<T> kalman(const QSMatrix<T>& A, const QSMatrix<T>& B, const QSMatrix<T>& C, const QSMatrix<T>& D,
+                                    const QSMatrix<T>& Q, const QSMatrix<T>& R, bool* success = 0);
+
+    // Measurement update with y_i and the input u_i applied at the same step
+    void correct(const std::vector<T>& y_i, const std::vector<T>& u_i);
+
+    // Time update with the input u_i
+    void predict(const std::vector<T>& u_i);
+
+    // correct() then predict(); returns x_{i|i}
+    std::vector<T> update(const std::vector<T>& y_i, const std::vector<T>& u_i);
+
+    // Estimate after the last correction x_{i|i}, prediction x_{i+1|i}, last innovation y_i - C*x_{i|i-1} - D*u_i
+    const std::vector<T>& getEstimate() const;
+    const std::vector<T>& getPrediction() const;
+    const std::vector<T>& getInnovation() const;
+
+    // Restart from a predicted state (zero if empty)
+    void reset(const std::vector<T>& x0 = std::vector<T>());
+
+    const QSMatrix<T>& getA() const;
+    const QSMatrix<T>& getB() const;
+    const QSMatrix<T>& getC() const;
+    const QSMatrix<T>& getD() const;
+    const QSMatrix<T>& getGain() const;
+
+    unsigned int getNx() const;
+    unsigned int getNu() const;
+    unsigned int getNy() const;
+
+    protected:
+    QSMatrix<T> m_A, m_B, m_C, m_D, m_L;
+    unsigned int m_nx, m_nu, m_ny;
+
+    std::vector<T> m_prediction;  // x_{i|i-1}, then x_{i+1|i}
+    std::vector<T> m_estimate;    // x_{i|i}
+    std::vector<T> m_innovation;
+};
+
+/**
+ * @class EstimatedController
+ * @brief Controller and estimator of its plant stepped together.
+ * @details The controller K computes u_i from e_i = r_i - y_i and the estimator uses the same y_i and u_i:
+ *
+ *      | u_i         |   | C_K  D_K |   | x_i |
+ *      | x_{i+1} (K) | = | A_K  B_K | * | e_i |                (packed, one pass)
+ *
+ *      x_{i|i}   = x_{i|i-1} + L*(y_i - C*x_{i|i-1} - D*u_i)
+ *      x_{i+1|i} = A*x_{i|i} + B*u_i
+ *
+ * Each block reads only its own coefficients (no zero blocks, the estimate is chained into the prediction),
+ * so a step costs the same multiply-adds as stepping the controller and a StateEstimator separately, without
+ * their vector temporaries: y_i is read once and u_i is used in place by the estimator.
+ ******/
+template <typename T>
+class EstimatedController
+{
+    public:
+
+    // The controller error dimension must equal the plant output dimension and its output the plant input
+    EstimatedController(const StateSpaceController<T>& controller, const StateEstimator<T>& estimator);
+
+    // One fused step: returns u_i (nu values, valid until the next step)
+    const T* step(const T* r_i, const T* y_i);
+    std::vector<T> currentOutput(const std::vector<T>& r_i, const std::vector<T>& y_i);
+
+    // Controller state x_{i+1}, estimate x_{i|i} and prediction x_{i+1|i} after the last step
+    const T* getState() const;
+    const T* getEstimate() const;
+    const T* getPrediction() const;
+    const T* getOutput() const;
+
+    // Reset time, controller state and prediction (to zero)
+    void reset();
+
+    float getTimeStep() const;
+    float getTime() const;
+    unsigned int getNx() const;         // Controller states
+    unsigned int getEstimatorNx() const;
+    unsigned int getNe() const;
+    unsigned int getNu() const;
+
+    // False if the dimensions of the controller and the estimator do not match
+    bool isValid() const;
+
+    protected:
+    unsigned int m_nx, m_nxe, m_ne, m_nu;
+    std::vector<T> m_K;                         // [C_K D_K; A_K B_K] (row-major)
+    std::vector<T> m_A, m_B, m_C, m_D, m_L;     // Estimator matrices (row-major)
+    std::vector<T> m_z;             // [x_i; e_i]
+    std::vector<T> m_out;           // [u_i; x_{i+1}]
+    std::vector<T> m_estimate;      // x_{i|i}
+    std::vector<T> m_prediction;    // x_{i|i-1}, then x_{i+1|i}
+    std::vector<T> m_innovation;    // y_i - C*x_{i|i-1} - D*u_i
+
+    float m_t_s;
+    unsigned int m_i;
+    float m_t;
+    bool m_valid;
+};
+
+#include "stateEstimator.cpp"
+
+#endif  // STATEESTIMATOR_H
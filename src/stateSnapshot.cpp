@@ -0,0 +1,127 @@
+/**
+ * @file stateSnapshot.cpp
+ * @brief Controller state snapshots published through a seqlock (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef STATESNAPSHOT_CPP
+#define STATESNAPSHOT_CPP
+
+#include "stateSnapshot.h"
+
+#include <algorithm>
+
+/**
+ * @brief Constructor: zero snapshot.
+ * @param nx State vector dimension.
+ * @param ne Error vector dimension.
+ * @param nu Controller output vector dimension.
+ * @param resource Memory resource of the values.
+ ******/
+template<typename T>
+SnapshotBuffer<T>::SnapshotBuffer(const unsigned int nx, const unsigned int ne, const unsigned int nu, std::pmr::memory_resource* resource):
+m_i(0), m_t(0), m_nx(nx), m_ne(ne), m_nu(nu), m_values(3 * ne + nu + nx, T(0), resource)
+{
+}
+
+/**
+ * @brief Publishes the state after a step (wait-free for the writer).
+ ******/
+template<typename T>
+void SnapshotBuffer<T>::publish(const unsigned long long i, const float t, const T* r, const T* y, const T* e, const T* u, const T* x)
+{
+    T* values = m_values.data();
+
+    m_lock.writeBegin();
+    m_i = i;
+    m_t = t;
+    if (r) Seqlock::store(values, r, m_ne * sizeof(T));
+    else std::fill(values, values + m_ne, T(0));
+    if (y) Seqlock::store(values + m_ne, y, m_ne * sizeof(T));
+    else std::fill(values + m_ne, values + 2 * m_ne, T(0));
+    Seqlock::store(values + 2 * m_ne, e, m_ne * sizeof(T));
+    Seqlock::store(values + 3 * m_ne, u, m_nu * sizeof(T));
+    Seqlock::store(values + 3 * m_ne + m_nu, x, m_nx * sizeof(T));
+    m_lock.writeEnd();
+}
+
+/**
+ * @brief Copies the latest snapshot, again if a step published during the copy.
+ ******/
+template<typename T>
+void SnapshotBuffer<T>::read(ControllerSnapshot<T>& snapshot) const
+{
+    snapshot.r.resize(m_ne);
+    snapshot.y.resize(m_ne);
+    snapshot.e.resize(m_ne);
+    snapshot.u.resize(m_nu);
+    snapshot.x.resize(m_nx);
+
+    const volatile T* values = m_values.data();
+    std::uint32_t sequence;
+
+    do
+    {
+        sequence = m_lock.readBegin();
+        Seqlock::load(&snapshot.i, &m_i, sizeof(m_i));
+        Seqlock::load(&snapshot.t, &m_t, sizeof(m_t));
+        Seqlock::load(snapshot.r.data(), values, m_ne * sizeof(T));
+        Seqlock::load(snapshot.y.data(), values + m_ne, m_ne * sizeof(T));
+        Seqlock::load(snapshot.e.data(), values + 2 * m_ne, m_ne * sizeof(T));
+        Seqlock::load(snapshot.u.data(), values + 3 * m_ne, m_nu * sizeof(T));
+        Seqlock::load(snapshot.x.data(), values + 3 * m_ne + m_nu, m_nx * sizeof(T));
+    } while (m_lock.readRetry(sequence));
+
+    snapshot.version = sequence / 2;
+}
+
+/**
+ * @return Consistent copy of the latest snapshot.
+ ******/
+template<typename T>
+ControllerSnapshot<T> SnapshotBuffer<T>::read() const
+{
+    ControllerSnapshot<T> snapshot;
+    read(snapshot);
+
+    return snapshot;
+}
+
+/**
+ * @return Number of snapshots published.
+ ******/
+template<typename T>
+std::uint32_t SnapshotBuffer<T>::getVersion() const
+{
+    return m_lock.getSequence() / 2;
+}
+
+/**
+ * @return State vector dimension.
+ ******/
+template<typename T>
+unsigned int SnapshotBuffer<T>::getNx() const
+{
+    return m_nx;
+}
+
+/**
+ * @return Error vector dimension.
+ ******/
+template<typename T>
+unsigned int SnapshotBuffer<T>::getNe() const
+{
+    return m_ne;
+}
+
+/**
+ * @return Controller output vector dimension.
+ ******/
+template<typename T>
+unsigned int SnapshotBuffer<T>::getNu() const
+{
+    return m_nu;
+}
+
+#endif  // STATESNAPSHOT_CPP
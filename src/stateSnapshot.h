@@ -0,0 +1,70 @@
+/**
+ * @file stateSnapshot.h
+ * @brief Controller state snapshots published through a seqlock (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef STATESNAPSHOT_H
+#define STATESNAPSHOT_H
+
+#include <vector>
+#include <cstdint>
+#include <memory_resource>
+
+#include "seqlock.h"
+
+/**
+ * @brief Copy of the state of a controller after a step.
+ ******/
+template <typename T>
+struct ControllerSnapshot
+{
+    unsigned long long i;   // Number of steps
+    float t;                // Controller time (seconds)
+    std::vector<T> r, y, e, u, x;
+    std::uint32_t version;  // Number of snapshots published when this one was read
+};
+
+/**
+ * @class SnapshotBuffer
+ * @brief Latest state of a controller, published by its stepping thread and read torn-free by monitors.
+ * @details publish() never blocks nor allocates. read() copies the snapshot and retries if a step
+ * published meanwhile: monitoring threads polling every controller do not slow the control loops down.
+ * The values are stored as r | y | e | u | x in memory of the given resource.
+ ******/
+template <typename T>
+class SnapshotBuffer
+{
+    public:
+
+    SnapshotBuffer(const unsigned int nx, const unsigned int ne, const unsigned int nu, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    SnapshotBuffer(const SnapshotBuffer<T>&) = delete;
+    SnapshotBuffer<T>& operator=(const SnapshotBuffer<T>&) = delete;
+
+    // Single writer; r and y may be null (comparator not used: zeros)
+    void publish(const unsigned long long i, const float t, const T* r, const T* y, const T* e, const T* u, const T* x);
+
+    // Consistent copy of the latest snapshot (the vectors of "snapshot" are reused)
+    void read(ControllerSnapshot<T>& snapshot) const;
+    ControllerSnapshot<T> read() const;
+
+    // Number of snapshots published
+    std::uint32_t getVersion() const;
+
+    unsigned int getNx() const;
+    unsigned int getNe() const;
+    unsigned int getNu() const;
+
+    protected:
+    Seqlock m_lock;
+    unsigned long long m_i;
+    float m_t;
+    unsigned int m_nx, m_ne, m_nu;
+    std::pmr::vector<T> m_values;
+};
+
+#include "stateSnapshot.cpp"
+
+#endif  // STATESNAPSHOT_H
@@ -16,7 +16,7 @@
  * @details Construct a StateSpaceController object with basic matrices.
  ******/
 template<typename T>
-StateSpaceController<T>::StateSpaceController() : m_A(1,1,0), m_B(1,1,0), m_C(1,1,0), m_D(1,1,1), m_t_s(1),m_i(0),m_t(0),m_nx(m_A.get_rows()),m_ne(m_B.get_cols()),m_nu(m_C.get_rows()), m_x_i(m_nx,0), m_x_ib(m_nx,0),m_r_i(m_ne,0),m_y_i(m_ne,0),m_e_i(m_ne,0),m_u_i(m_nu,0)
+StateSpaceController<T>::StateSpaceController() : m_A(std::make_shared<QSMatrix<T> >(1,1,0)), m_B(std::make_shared<QSMatrix<T> >(1,1,0)), m_C(std::make_shared<QSMatrix<T> >(1,1,0)), m_D(std::make_shared<QSMatrix<T> >(1,1,1)), m_t_s(1),m_i(0),m_t(0),m_nx(m_A->get_rows()),m_ne(m_B->get_cols()),m_nu(m_C->get_rows()), m_x_i(m_nx,0), m_x_ib(m_nx,0),m_r_i(m_ne,0),m_y_i(m_ne,0),m_e_i(m_ne,0),m_u_i(m_nu,0), m_idleMode(false), m_idleTolerance(0), m_idleThreshold(0), m_atRest(false), m_restSteps(0), m_restRate(1), m_skippedSteps(0)
 {
 }
 
@@ -31,7 +31,7 @@ StateSpaceController<T>::StateSpaceController() : m_A(1,1,0), m_B(1,1,0), m_C(1,
  ******/
 template<typename T>
 StateSpaceController<T>::StateSpaceController(QSMatrix<T> A, QSMatrix<T> B, QSMatrix<T> C, QSMatrix<T> D, const float t_s):
-m_A(A), m_B(B), m_C(C), m_D(D), m_t_s(t_s), m_i(0),m_t(0),m_nx(m_A.get_rows()),m_ne(m_B.get_cols()),m_nu(m_C.get_rows()), m_x_i(m_nx,0), m_x_ib(m_nx,0),m_r_i(m_ne,0),m_y_i(m_ne,0),m_e_i(m_ne,0),m_u_i(m_nu,0)
+m_A(std::make_shared<QSMatrix<T> >(std::move(A))), m_B(std::make_shared<QSMatrix<T> >(std::move(B))), m_C(std::make_shared<QSMatrix<T> >(std::move(C))), m_D(std::make_shared<QSMatrix<T> >(std::move(D))), m_t_s(t_s), m_i(0),m_t(0),m_nx(m_A->get_rows()),m_ne(m_B->get_cols()),m_nu(m_C->get_rows()), m_x_i(m_nx,0), m_x_ib(m_nx,0),m_r_i(m_ne,0),m_y_i(m_ne,0),m_e_i(m_ne,0),m_u_i(m_nu,0), m_idleMode(false), m_idleTolerance(0), m_idleThreshold(0), m_atRest(false), m_restSteps(0), m_restRate(1), m_skippedSteps(0)
 {
     /*
      * Init a controller represented by a state-space model
@@ -86,7 +86,7 @@ m_A(A), m_B(B), m_C(C), m_D(D), m_t_s(t_s), m_i(0),m_t(0),m_nx(m_A.get_rows()),m
  * @param formattedDataFilePath Path of the controller data file.
  ******/
 template<typename T>
-StateSpaceController<T>::StateSpaceController(std::string formattedDataFilePath):m_i(0),m_t(0)
+StateSpaceController<T>::StateSpaceController(std::string formattedDataFilePath):m_i(0),m_t(0), m_idleMode(false), m_idleTolerance(0), m_idleThreshold(0), m_atRest(false), m_restSteps(0), m_restRate(1), m_skippedSteps(0)
 {
     m_i = 0;
     m_t = 0;
@@ -97,16 +97,20 @@ StateSpaceController<T>::StateSpaceController(std::string formattedDataFilePath)
 // Constructeur de copie
 /**
  * @brief Copy constructor.
+ * @details A, B, C and D are shared with the other controller, only the state vectors are copied.
  * @param other Another StateSpaceController object.
  ******/
 template<typename T>
 StateSpaceController<T>::StateSpaceController(StateSpaceController<T> const& other):
-m_A(other.m_A), m_B(other.m_B), m_C(other.m_C), m_D(other.m_D),m_i(other.m_i),m_t(other.m_t), m_t_s(other.m_t_s),m_nx(other.m_nx),m_ne(other.m_ne),m_nu(other.m_nu), m_x_i(other.m_x_i), m_x_ib(other.m_x_ib),m_r_i(other.m_r_i),m_y_i(other.m_y_i),m_e_i(other.m_e_i),m_u_i(other.m_u_i)
+m_A(other.m_A), m_B(other.m_B), m_C(other.m_C), m_D(other.m_D),m_i(other.m_i),m_t(other.m_t), m_t_s(other.m_t_s),m_nx(other.m_nx),m_ne(other.m_ne),m_nu(other.m_nu), m_x_i(other.m_x_i), m_x_ib(other.m_x_ib),m_r_i(other.m_r_i),m_y_i(other.m_y_i),m_e_i(other.m_e_i),m_u_i(other.m_u_i),
+m_idleMode(other.m_idleMode), m_idleTolerance(other.m_idleTolerance), m_idleThreshold(other.m_idleThreshold), m_atRest(other.m_atRest), m_restSteps(other.m_restSteps), m_restRate(other.m_restRate), m_restA(other.m_restA), m_skippedSteps(other.m_skippedSteps),
+m_restError(other.m_restError), m_restOutput(other.m_restOutput)
 {
 }
 
 /**
  * @brief = operator.
+ * @details A, B, C and D are shared with the other controller, only the state vectors are copied.
  * @param controller Another StateSpaceController object.
  ******/
 template<typename T>
@@ -137,6 +141,17 @@ StateSpaceController<T>& StateSpaceController<T>::operator=(const StateSpaceCont
         
     m_u_i = controller.m_u_i;
     
+    m_idleMode = controller.m_idleMode;
+    m_idleTolerance = controller.m_idleTolerance;
+    m_idleThreshold = controller.m_idleThreshold;
+    m_atRest = controller.m_atRest;
+    m_restSteps = controller.m_restSteps;
+    m_restRate = controller.m_restRate;
+    m_restA = controller.m_restA;
+    m_skippedSteps = controller.m_skippedSteps;
+    m_restError = controller.m_restError;
+    m_restOutput = controller.m_restOutput;
+    
     return *this;
 }
 
@@ -227,16 +242,14 @@ void StateSpaceController<T>::loadControllerData(std::string formattedDataFilePa
         std::vector<T> u_i(m_nu,0);
         
         m_u_i = u_i;
+        
+        m_atRest = false;
 
 
         QSMatrix<T> A(m_nx,m_nx,0);
         QSMatrix<T> B(m_nx,m_ne,0);
         QSMatrix<T> C(m_nu,m_nx,0);
         QSMatrix<T> D(m_nu,m_ne,0);
-        m_A = A;
-        m_B = B;
-        m_C = C;
-        m_D = D;
         
         
         for (int row=0;row<m_nx;row++)
@@ -244,7 +257,7 @@ void StateSpaceController<T>::loadControllerData(std::string formattedDataFilePa
             for (int col=0;col<m_nx;col++)
             {
                 std::getline(readStream, line);
-                m_A(row,col) = std::stod(line);
+                A(row,col) = std::stod(line);
             }
         }
         for (int row=0;row<m_nx;row++)
@@ -252,7 +265,7 @@ void StateSpaceController<T>::loadControllerData(std::string formattedDataFilePa
             for (int col=0;col<m_ne;col++)
             {
                 std::getline(readStream, line);
-                m_B(row,col) = std::stod(line);
+                B(row,col) = std::stod(line);
             }
         }
         for (int row=0;row<m_nu;row++)
@@ -260,7 +273,7 @@ void StateSpaceController<T>::loadControllerData(std::string formattedDataFilePa
             for (int col=0;col<m_nx;col++)
             {
                 std::getline(readStream, line);
-                m_C(row,col) = std::stod(line);
+                C(row,col) = std::stod(line);
             }
         }
         for (int row=0;row<m_nu;row++)
@@ -268,9 +281,15 @@ void StateSpaceController<T>::loadControllerData(std::string formattedDataFilePa
             for (int col=0;col<m_ne;col++)
             {
                 std::getline(readStream, line);
-                m_D(row,col) = std::stod(line);
+                D(row,col) = std::stod(line);
             }
         }
+        
+        // New matrices: controllers sharing the previous ones are not modified
+        setA(std::move(A));
+        setB(std::move(B));
+        setC(std::move(C));
+        setD(std::move(D));
     }
     else
     {
@@ -338,72 +357,166 @@ void StateSpaceController<T>::help() // ne pas remettre "static"
  * @return Controller A matrix in state space representation.
  ******/
 template<typename T>
-QSMatrix<T> StateSpaceController<T>::getA() const
+const QSMatrix<T>& StateSpaceController<T>::getA() const
 {
-	return m_A;
+	return *m_A;
 }
 
 /**
+ * @details The matrix is moved into a new shared storage: controllers sharing the previous one keep it.
  * @param A Controller A matrix in state space representation.
  ******/
 template<typename T>
 void StateSpaceController<T>::setA(QSMatrix<T> A)
 {
-	m_A = A;
+	m_A = std::make_shared<QSMatrix<T> >(std::move(A));
+    m_atRest = false;
+}
+
+/**
+ * @return Shared controller A matrix.
+ ******/
+template<typename T>
+std::shared_ptr<const QSMatrix<T> > StateSpaceController<T>::getSharedA() const
+{
+    return m_A;
+}
+
+/**
+ * @param A Shared controller A matrix (not copied).
+ ******/
+template<typename T>
+void StateSpaceController<T>::setA(std::shared_ptr<const QSMatrix<T> > A)
+{
+    m_A = std::move(A);
+    m_atRest = false;
 }
 
 /**
  * @return Controller B matrix in state space representation.
  ******/
 template<typename T>
-QSMatrix<T> StateSpaceController<T>::getB() const
+const QSMatrix<T>& StateSpaceController<T>::getB() const
 {
-	return m_B;
+	return *m_B;
 }
 
 /**
+ * @details The matrix is moved into a new shared storage: controllers sharing the previous one keep it.
  * @param B Controller B matrix in state space representation.
  ******/
 template<typename T>
 void StateSpaceController<T>::setB(QSMatrix<T> B)
 {
-	m_B = B;
+	m_B = std::make_shared<QSMatrix<T> >(std::move(B));
+    m_atRest = false;
+}
+
+/**
+ * @return Shared controller B matrix.
+ ******/
+template<typename T>
+std::shared_ptr<const QSMatrix<T> > StateSpaceController<T>::getSharedB() const
+{
+    return m_B;
+}
+
+/**
+ * @param B Shared controller B matrix (not copied).
+ ******/
+template<typename T>
+void StateSpaceController<T>::setB(std::shared_ptr<const QSMatrix<T> > B)
+{
+    m_B = std::move(B);
+    m_atRest = false;
 }
 
 /**
  * @return Controller C matrix in state space representation.
  ******/
 template<typename T>
-QSMatrix<T> StateSpaceController<T>::getC() const
+const QSMatrix<T>& StateSpaceController<T>::getC() const
 {
-	return m_C;
+	return *m_C;
 }
 
 /**
+ * @details The matrix is moved into a new shared storage: controllers sharing the previous one keep it.
  * @param C Controller C matrix in state space representation.
  ******/
 template<typename T>
 void StateSpaceController<T>::setC(QSMatrix<T> C)
 {
-	m_C = C;
+	m_C = std::make_shared<QSMatrix<T> >(std::move(C));
+    m_atRest = false;
+}
+
+/**
+ * @return Shared controller C matrix.
+ ******/
+template<typename T>
+std::shared_ptr<const QSMatrix<T> > StateSpaceController<T>::getSharedC() const
+{
+    return m_C;
+}
+
+/**
+ * @param C Shared controller C matrix (not copied).
+ ******/
+template<typename T>
+void StateSpaceController<T>::setC(std::shared_ptr<const QSMatrix<T> > C)
+{
+    m_C = std::move(C);
+    m_atRest = false;
 }
 
 /**
  * @return Controller D matrix in state space representation.
  ******/
 template<typename T>
-QSMatrix<T> StateSpaceController<T>::getD() const
+const QSMatrix<T>& StateSpaceController<T>::getD() const
 {
-	return m_D;
+	return *m_D;
 }
 
 /**
+ * @details The matrix is moved into a new shared storage: controllers sharing the previous one keep it.
  * @param D Controller D matrix in state space representation.
  ******/
 template<typename T>
 void StateSpaceController<T>::setD(QSMatrix<T> D)
 {
-	m_D = D;
+	m_D = std::make_shared<QSMatrix<T> >(std::move(D));
+    m_atRest = false;
+}
+
+/**
+ * @return Shared controller D matrix.
+ ******/
+template<typename T>
+std::shared_ptr<const QSMatrix<T> > StateSpaceController<T>::getSharedD() const
+{
+    return m_D;
+}
+
+/**
+ * @param D Shared controller D matrix (not copied).
+ ******/
+template<typename T>
+void StateSpaceController<T>::setD(std::shared_ptr<const QSMatrix<T> > D)
+{
+    m_D = std::move(D);
+    m_atRest = false;
+}
+
+/**
+ * @param other Another StateSpaceController object.
+ * @return True if A, B, C and D of both controllers are the same storage.
+ ******/
+template<typename T>
+bool StateSpaceController<T>::sharesMatricesWith(const StateSpaceController<T>& other) const
+{
+    return m_A == other.m_A && m_B == other.m_B && m_C == other.m_C && m_D == other.m_D;
 }
 
 /**
@@ -425,6 +538,8 @@ float StateSpaceController<T>::getTimeStep() const
 }
 
 /**
+ * @details Only the time step is changed: A, B, C and D are not re-discretized.
+ * Use ContinuousStateSpaceController to get matrices matching the new time step.
  * @param t_s Controller time step (seconds).
  ******/
 template<typename T>
@@ -481,19 +596,19 @@ void StateSpaceController<T>::printStateSpace() const
     << std::endl;
     
     std::cout << "A = " << std::endl;
-    m_A.print();
+    m_A->print();
     std::cout << std::endl;
     
     std::cout << "B = " << std::endl;
-    m_B.print();
+    m_B->print();
     std::cout << std::endl;
     
     std::cout << "C = " << std::endl;
-    m_C.print();
+    m_C->print();
     std::cout << std::endl;
     
     std::cout << "D = " << std::endl;
-    m_D.print();
+    m_D->print();
     std::cout << std::endl;
 }
 
@@ -511,19 +626,19 @@ std::string StateSpaceController<T>::getStateSpace() const
     buffer << "Time step = " << m_t_s << " s" << std::endl << std::endl;
     
     buffer << "A = " << std::endl;
-    buffer << m_A.getRepresentation();
+    buffer << m_A->getRepresentation();
     buffer << std::endl;
     
     buffer << "B = " << std::endl;
-    buffer << m_B.getRepresentation();
+    buffer << m_B->getRepresentation();
     buffer << std::endl;
     
     buffer << "C = " << std::endl;
-    buffer << m_C.getRepresentation();
+    buffer << m_C->getRepresentation();
     buffer << std::endl;
     
     buffer << "D = " << std::endl;
-    buffer << m_D.getRepresentation();
+    buffer << m_D->getRepresentation();
     buffer << std::endl;
     
     return buffer.str();
@@ -607,17 +722,284 @@ std::vector<T> StateSpaceController<T>::currentOutput(const std::vector<T>& e_i)
      * 
      * e_i : system error between global system output y_i and reference r_i
      */
-    m_e_i = e_i;    // Update error signal
+    computeOutput(e_i);
     
-    // Update controller output
-    // m_u_i = m_C * m_x_i + m_D * m_e_i;
-    m_u_i = QSMatrix<T>::vectorAdd(m_C * m_x_i, m_D * m_e_i);
+    publishSnapshot();
     
-    nextState();  // Update next iteration state signal
+    return m_u_i;
+}
+
+/**
+ * @brief Catches up missed steps with a constant error.
+ * @details x_{i+n} = A^n*x_i + (I + A + ... + A^(n-1))*B*e is applied for each bit of n = k - 1 from the cached
+ * powers, then the last step is computed normally: state, signals, output, step index and time are those of
+ * k currentOutput(e_hold) calls (up to rounding), for O(log k) matrix/vector products.
+ * @param k Number of steps.
+ * @param e_hold Error vector held during the k steps.
+ * @return Controller output vector of the last step.
+ ******/
+template<typename T>
+std::vector<T> StateSpaceController<T>::advance(const unsigned int k, const std::vector<T>& e_hold)
+{
+    if (k == 0)
+    {
+        return m_u_i;
+    }
+    
+    m_atRest = false;
+    
+    const unsigned int skipped = k - 1;
+    unsigned int levels = 0;
+    while (levels < 32 && (skipped >> levels) != 0)
+    {
+        levels++;
+    }
+    extendPowerCache(levels);
+    
+    for (unsigned int j=0;j<levels;j++)
+    {
+        if ((skipped >> j) & 1u)
+        {
+            m_x_i = QSMatrix<T>::vectorAdd(m_powers[j] * m_x_i, m_powerSums[j] * e_hold);
+        }
+    }
+    m_i += skipped;
+    
+    computeOutput(e_hold);
+    
+    publishSnapshot();
     
     return m_u_i;
 }
 
+/**
+ * @brief Computes the powers used by advance() ahead of time (matrix products, O(nx^3) each).
+ * @param maxSteps Largest gap that advance() will catch up without extending the cache.
+ ******/
+template<typename T>
+void StateSpaceController<T>::prepareAdvance(const unsigned int maxSteps)
+{
+    const unsigned int skipped = (maxSteps > 0) ? maxSteps - 1 : 0;
+    unsigned int levels = 0;
+    while (levels < 32 && (skipped >> levels) != 0)
+    {
+        levels++;
+    }
+    
+    extendPowerCache(levels);
+}
+
+/**
+ * @brief Extends the cache of A^(2^j) and (I + A + ... + A^(2^j - 1))*B.
+ * @details A^(2^(j+1)) = A^(2^j)*A^(2^j) and S_{j+1} = A^(2^j)*S_j + S_j. The cache is dropped first if A or B
+ * has been replaced since it was computed (setters, loadControllerData(), = operator, restoreCheckpoint()).
+ * @param levels Number of powers needed.
+ ******/
+template<typename T>
+void StateSpaceController<T>::extendPowerCache(const unsigned int levels)
+{
+    if (m_powerA != m_A || m_powerB != m_B)
+    {
+        m_powers.clear();
+        m_powerSums.clear();
+        m_powerA = m_A;
+        m_powerB = m_B;
+    }
+    
+    if (levels > 0 && m_powers.empty())
+    {
+        m_powers.push_back(*m_A);
+        m_powerSums.push_back(*m_B);
+    }
+    
+    while (m_powers.size() < levels)
+    {
+        const QSMatrix<T>& power = m_powers.back();
+        QSMatrix<T> sum = power * m_powerSums.back() + m_powerSums.back();
+        QSMatrix<T> square = power * power;
+        
+        m_powerSums.push_back(std::move(sum));
+        m_powers.push_back(std::move(square));
+    }
+}
+
+/**
+ * @brief Packed [A B; C D] (row-major) read by rollout().
+ * @details Built on the first rollout and again only when A, B, C or D has been replaced since (shared
+ * storage identity, like the advance() cache).
+ ******/
+template<typename T>
+const std::vector<T>& StateSpaceController<T>::packedMatrix() const
+{
+    if (isCachedFrom(m_packedA, m_A) && isCachedFrom(m_packedB, m_B) && isCachedFrom(m_packedC, m_C) && isCachedFrom(m_packedD, m_D) && !m_packed.empty())
+    {
+        return m_packed;
+    }
+    
+    const unsigned int cols = m_nx + m_ne;
+    m_packed.assign((m_nx + m_nu) * cols, T(0));
+    for (unsigned int row=0;row<m_nx;row++)
+    {
+        std::copy(m_A->data() + row * m_nx, m_A->data() + (row + 1) * m_nx, m_packed.data() + row * cols);
+        std::copy(m_B->data() + row * m_ne, m_B->data() + (row + 1) * m_ne, m_packed.data() + row * cols + m_nx);
+    }
+    for (unsigned int row=0;row<m_nu;row++)
+    {
+        std::copy(m_C->data() + row * m_nx, m_C->data() + (row + 1) * m_nx, m_packed.data() + (m_nx + row) * cols);
+        std::copy(m_D->data() + row * m_ne, m_D->data() + (row + 1) * m_ne, m_packed.data() + (m_nx + row) * cols + m_nx);
+    }
+    m_packedA = m_A;
+    m_packedB = m_B;
+    m_packedC = m_C;
+    m_packedD = m_D;
+    
+    return m_packed;
+}
+
+/**
+ * @brief Outputs of candidate error trajectories from the current state, stepped in lockstep.
+ * @details The states of the candidates are the columns of X (nx x candidates), all equal to x_i at first.
+ * Each step is one product with the packed matrix [A B; C D]:
+ *
+ *      | X_{h+1} |   | A  B |   | X_h |
+ *      |   U_h   | = | C  D | * | E_h |
+ *
+ * The packed matrix is built once and cached until A, B, C or D is replaced: nothing is copied per call or per candidate.
+ * The buffer lengths cannot be checked: they must hold K x H x ne and K x H x nu values.
+ * @param candidates Number of candidate trajectories K.
+ * @param horizon Number of steps H.
+ * @param errors Error vectors, candidate by candidate then step by step (K x H x ne values).
+ * @param outputs Controller output vectors, same order (K x H x nu values).
+ * @return False if a buffer is null or the sizes overflow (nothing is written), true otherwise.
+ ******/
+template<typename T>
+bool StateSpaceController<T>::rollout(const unsigned int candidates, const unsigned int horizon, const T* errors, T* outputs) const
+{
+    if (candidates == 0 || horizon == 0)
+    {
+        return true;
+    }
+    
+    const std::size_t width = std::max<std::size_t>(m_nx + std::max(m_ne, m_nu), 1);
+    if ((!errors && m_ne > 0) || (!outputs && m_nu > 0) || (std::size_t)candidates > SIZE_MAX / horizon / width / sizeof(T))
+    {
+        std::cout << "\033[1;31mERROR: Rollout of " << candidates << " candidates over " << horizon << " steps needs K x H x ne errors and K x H x nu outputs\033[0m" << std::endl;
+        return false;
+    }
+    
+    const unsigned int rows = m_nx + m_nu, cols = m_nx + m_ne;
+    const std::vector<T>& M = packedMatrix();
+    
+    // Z = [X; E] and W = [X'; U], one column per candidate
+    std::vector<T> Z((std::size_t)cols * candidates), W((std::size_t)rows * candidates);
+    for (unsigned int row=0;row<m_nx;row++)
+    {
+        std::fill(Z.begin() + row * candidates, Z.begin() + (row + 1) * candidates, m_x_i[row]);
+    }
+    
+    for (unsigned int h=0;h<horizon;h++)
+    {
+        for (unsigned int k=0;k<candidates;k++)
+        {
+            const T* e = errors + ((std::size_t)k * horizon + h) * m_ne;
+            for (unsigned int j=0;j<m_ne;j++) Z[(m_nx + j) * candidates + k] = e[j];
+        }
+        
+        LinearAlgebraBackend<T>::gemm(rows, candidates, cols, T(1), M.data(), cols, Z.data(), candidates, T(0), W.data(), candidates, QSMatrix<T>::getThreadCount());
+        
+        for (unsigned int k=0;k<candidates;k++)
+        {
+            T* u = outputs + ((std::size_t)k * horizon + h) * m_nu;
+            for (unsigned int j=0;j<m_nu;j++) u[j] = W[(m_nx + j) * candidates + k];
+        }
+        std::copy(W.begin(), W.begin() + (std::size_t)m_nx * candidates, Z.begin());
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Outputs of candidate error trajectories from the current state.
+ * @param errors errors[k][h]: error vector of candidate k at step h.
+ * @return outputs[k][h]: controller output vector of candidate k at step h (empty if the horizons differ or a
+ * vector has less than ne values).
+ ******/
+template<typename T>
+std::vector<std::vector<std::vector<T> > > StateSpaceController<T>::rollout(const std::vector<std::vector<std::vector<T> > >& errors) const
+{
+    const unsigned int candidates = errors.size();
+    const unsigned int horizon = candidates ? errors[0].size() : 0;
+    
+    std::vector<T> flatErrors((std::size_t)candidates * horizon * m_ne);
+    for (unsigned int k=0;k<candidates;k++)
+    {
+        if (errors[k].size() != horizon)
+        {
+            std::cout << "\033[1;31mERROR: Rollout candidates must have the same horizon\033[0m" << std::endl;
+            return std::vector<std::vector<std::vector<T> > >();
+        }
+        for (unsigned int h=0;h<horizon;h++)
+        {
+            if (errors[k][h].size() < m_ne)
+            {
+                std::cout << "\033[1;31mERROR: Rollout vectors must have ne = " << m_ne << " values (candidate " << k << ", step " << h << ")\033[0m" << std::endl;
+                return std::vector<std::vector<std::vector<T> > >();
+            }
+            std::copy(errors[k][h].begin(), errors[k][h].begin() + m_ne, flatErrors.begin() + ((std::size_t)k * horizon + h) * m_ne);
+        }
+    }
+    
+    std::vector<T> flatOutputs((std::size_t)candidates * horizon * m_nu);
+    if (!rollout(candidates, horizon, flatErrors.data(), flatOutputs.data()))
+    {
+        return std::vector<std::vector<std::vector<T> > >();
+    }
+    
+    std::vector<std::vector<std::vector<T> > > outputs(candidates, std::vector<std::vector<T> >(horizon));
+    for (unsigned int k=0;k<candidates;k++)
+    {
+        for (unsigned int h=0;h<horizon;h++)
+        {
+            const T* u = flatOutputs.data() + ((std::size_t)k * horizon + h) * m_nu;
+            outputs[k][h].assign(u, u + m_nu);
+        }
+    }
+    
+    return outputs;
+}
+
+/**
+ * @brief Outputs of candidate reference trajectories from the current state, the plant output being held.
+ * @param references references[k][h]: reference vector of candidate k at step h.
+ * @param y_hold Plant output assumed during the horizon.
+ * @return outputs[k][h]: controller output vector of candidate k at step h (empty on a size error).
+ ******/
+template<typename T>
+std::vector<std::vector<std::vector<T> > > StateSpaceController<T>::rollout(const std::vector<std::vector<std::vector<T> > >& references, const std::vector<T>& y_hold) const
+{
+    if (y_hold.size() < m_ne)
+    {
+        std::cout << "\033[1;31mERROR: Rollout plant output must have ne = " << m_ne << " values\033[0m" << std::endl;
+        return std::vector<std::vector<std::vector<T> > >();
+    }
+    
+    std::vector<std::vector<std::vector<T> > > errors(references);
+    for (unsigned int k=0;k<errors.size();k++)
+    {
+        for (unsigned int h=0;h<errors[k].size();h++)
+        {
+            if (errors[k][h].size() < m_ne)
+            {
+                std::cout << "\033[1;31mERROR: Rollout vectors must have ne = " << m_ne << " values (candidate " << k << ", step " << h << ")\033[0m" << std::endl;
+                return std::vector<std::vector<std::vector<T> > >();
+            }
+            for (unsigned int j=0;j<m_ne;j++) errors[k][h][j] -= y_hold[j];
+        }
+    }
+    
+    return rollout(errors);
+}
+
 /**
  * @brief Computes the current controller output with the error vector, applies a saturation and increments time.
  * @details Saturation vectors are used to tune each controller output. 
@@ -634,10 +1016,12 @@ std::vector<T> StateSpaceController<T>::currentOutput(const std::vector<T>& e_i,
      * 
      * e_i : system error between global system output y_i and reference r_i
      */
-    currentOutput(e_i);
+    computeOutput(e_i);
     
     saturation(u_min, u_max); // Limit the controller output
     
+    publishSnapshot();
+    
     return m_u_i;
 }
 
@@ -657,10 +1041,12 @@ std::vector<T> StateSpaceController<T>::currentOutput(const std::vector<T>& e_i,
      * 
      * e_i : system error between global system output y_i and reference r_i
      */
-    currentOutput(e_i);
+    computeOutput(e_i);
     
     saturation(u_min, u_max); // Limit the controller output
     
+    publishSnapshot();
+    
     return m_u_i;
 }
 
@@ -685,7 +1071,9 @@ std::vector<T> StateSpaceController<T>::currentOutput(const std::vector<T>& r_i,
     
     currentError();   // Update error signal
     
-    currentOutput(m_e_i);
+    computeOutput(m_e_i);
+    
+    publishSnapshot();
     
     return m_u_i;
 }
@@ -714,10 +1102,12 @@ std::vector<T> StateSpaceController<T>::currentOutput(const std::vector<T>& r_i,
     
     currentError();   // Update error signal
     
-    currentOutput(m_e_i);
+    computeOutput(m_e_i);
     
     saturation(u_min, u_max); // Limit the controller output
     
+    publishSnapshot();
+    
     return m_u_i;
 }
 
@@ -745,10 +1135,12 @@ std::vector<T> StateSpaceController<T>::currentOutput(const std::vector<T>& r_i,
     
     currentError();   // Update error signal
     
-    currentOutput(m_e_i);
+    computeOutput(m_e_i);
     
     saturation(u_min, u_max); // Limit the controller output
     
+    publishSnapshot();
+    
     return m_u_i;
 }
 
@@ -796,6 +1188,235 @@ void StateSpaceController<T>::saturation(const T& u_min, const T& u_max)
     }
 }
 
+/**
+ * @brief Computes the controller output and the next state, increments time.
+ * @param e_i Current error vector.
+ ******/
+template<typename T>
+void StateSpaceController<T>::computeOutput(const std::vector<T>& e_i)
+{
+    if (m_atRest)
+    {
+        idleStep(e_i);
+        return;
+    }
+    
+    m_e_i = e_i;    // Update error signal
+    
+    // Update controller output
+    // m_u_i = m_C * m_x_i + m_D * m_e_i;
+    m_u_i = QSMatrix<T>::vectorAdd(*m_C * m_x_i, *m_D * m_e_i);
+    
+    nextState();  // Update next iteration state signal
+    
+    if (m_idleMode)
+    {
+        detectRest();
+    }
+}
+
+/**
+ * @brief Step of a controller at rest.
+ * @details While no error moves by more than the threshold from the error at rest, the output at rest is
+ * returned and the state is kept. Otherwise the state at rest x is a fixed point for the error at rest e_r:
+ * A*x + B*e = x + B*(e - e_r) and C*x + D*e = u_r + D*(e - e_r), computed from the columns of B and D of the
+ * inputs that changed. The controller then steps normally until it comes to rest again.
+ * @param e_i Current error vector.
+ ******/
+template<typename T>
+void StateSpaceController<T>::idleStep(const std::vector<T>& e_i)
+{
+    bool wake = false;
+    for (unsigned int k=0;k<m_ne && !wake;k++)
+    {
+        wake = std::abs(e_i[k] - m_restError[k]) > m_idleThreshold;
+    }
+    
+    m_e_i = e_i;
+    m_u_i = m_restOutput;
+    m_x_ib = m_x_i;
+    
+    if (!wake)
+    {
+        m_skippedSteps++;
+    }
+    else
+    {
+        const QSMatrix<T>& B = *m_B;
+        const QSMatrix<T>& D = *m_D;
+        for (unsigned int k=0;k<m_ne;k++)
+        {
+            const T delta = m_e_i[k] - m_restError[k];
+            if (delta == T(0))
+            {
+                continue;
+            }
+            for (unsigned int row=0;row<m_nx;row++) m_x_i[row] += B(row, k) * delta;
+            for (unsigned int row=0;row<m_nu;row++) m_u_i[row] += D(row, k) * delta;
+        }
+        m_atRest = false;
+    }
+    
+    m_t = m_i * m_t_s;
+    m_i++;
+}
+
+/**
+ * @brief Puts the controller at rest once the state is at the fixed point of the error.
+ * @details The residual r = A*x + B*e - x of the state x and error e is (A - I)*(x - x*), x* being the
+ * fixed point of e: the distance to x* is about |r| / (1 - rho), rho the convergence rate of the slowest
+ * mode of A. The controller comes to rest after IDLE_REST_STEPS consecutive steps with every residual
+ * within tolerance*(1 - rho), so a slow mode (e.g. an integrator fed a small error) moving little per step
+ * is not frozen: with rho = 1 only an exact fixed point is accepted. The output at rest is C*x + D*e.
+ ******/
+template<typename T>
+void StateSpaceController<T>::detectRest()
+{
+    if (!isCachedFrom(m_restA, m_A))
+    {
+        updateRestRate();
+    }
+    
+    const QSMatrix<T>& A = *m_A;
+    const QSMatrix<T>& B = *m_B;
+    const T bound = m_restRate < T(1) ? m_idleTolerance * (T(1) - m_restRate) : T(0);
+    
+    // Stops at the first row out of the bound: a step far from rest costs O(nx + ne)
+    for (unsigned int row=0;row<m_nx;row++)
+    {
+        T residual = -m_x_i[row];
+        for (unsigned int col=0;col<m_nx;col++) residual += A(row, col) * m_x_i[col];
+        for (unsigned int col=0;col<m_ne;col++) residual += B(row, col) * m_e_i[col];
+        
+        if (!(std::abs(residual) <= bound))
+        {
+            m_restSteps = 0;
+            return;
+        }
+    }
+    
+    if (++m_restSteps < IDLE_REST_STEPS)
+    {
+        return;
+    }
+    
+    const QSMatrix<T>& C = *m_C;
+    const QSMatrix<T>& D = *m_D;
+    m_restOutput.assign(m_nu, T(0));
+    for (unsigned int row=0;row<m_nu;row++)
+    {
+        for (unsigned int col=0;col<m_nx;col++) m_restOutput[row] += C(row, col) * m_x_i[col];
+        for (unsigned int col=0;col<m_ne;col++) m_restOutput[row] += D(row, col) * m_e_i[col];
+    }
+    
+    m_atRest = true;
+    m_restSteps = 0;
+    m_restError = m_e_i;
+}
+
+/**
+ * @brief Estimates the convergence rate of the slowest mode of A (spectral radius).
+ * @details rho = lim |A^k|^(1/k) is approached from above with k = 2^10 (ten squarings, rescaled at each one
+ * to stay in range), so the estimate errs on the side of a slower convergence. O(nx^3) matrix products:
+ * done by enableIdleMode() and again only when A is replaced.
+ ******/
+template<typename T>
+void StateSpaceController<T>::updateRestRate()
+{
+    m_restA = m_A;
+    
+    QSMatrix<T> power = *m_A;
+    double logNorm = 0;
+    
+    for (unsigned int j=0;j<=10;j++)
+    {
+        if (j > 0)
+        {
+            power = power * power;
+            logNorm *= 2;
+        }
+        
+        // Infinity norm of the rescaled power
+        T norm = 0;
+        for (unsigned int row=0;row<m_nx;row++)
+        {
+            T sum = 0;
+            for (unsigned int col=0;col<m_nx;col++) sum += std::abs(power(row, col));
+            norm = std::max(norm, sum);
+        }
+        
+        if (norm == T(0))
+        {
+            m_restRate = 0;
+            return;
+        }
+        if (!std::isfinite((double)norm))
+        {
+            m_restRate = 1;
+            return;
+        }
+        
+        logNorm += std::log((double)norm);
+        for (unsigned int row=0;row<m_nx;row++)
+        {
+            for (unsigned int col=0;col<m_nx;col++) power(row, col) /= norm;
+        }
+    }
+    
+    m_restRate = (T)std::exp(logNorm / 1024);
+}
+
+/**
+ * @brief Enables or disables the idle mode.
+ * @details The tolerance bounds the distance from the state to the fixed point of the error (estimated from
+ * the residual of a step and the slowest mode of A) accepted to stop stepping. Errors within the threshold
+ * of the error at rest are treated as equal to it.
+ * @param tolerance Largest distance from the state at rest to the fixed point of the error.
+ * @param threshold Largest error change ignored at rest.
+ * @param enable False to step on every call again.
+ ******/
+template<typename T>
+void StateSpaceController<T>::enableIdleMode(const T& tolerance, const T& threshold, const bool enable)
+{
+    m_idleMode = enable;
+    m_idleTolerance = tolerance;
+    m_idleThreshold = threshold;
+    m_atRest = false;
+    m_restSteps = 0;
+    
+    if (enable)
+    {
+        updateRestRate();
+    }
+}
+
+/**
+ * @return True if the idle mode is enabled.
+ ******/
+template<typename T>
+bool StateSpaceController<T>::isIdleModeEnabled() const
+{
+    return m_idleMode;
+}
+
+/**
+ * @return True if the controller is at rest (its next steps may be skipped).
+ ******/
+template<typename T>
+bool StateSpaceController<T>::isAtRest() const
+{
+    return m_atRest;
+}
+
+/**
+ * @return Steps returned from the cache since construction.
+ ******/
+template<typename T>
+unsigned long long StateSpaceController<T>::getSkippedSteps() const
+{
+    return m_skippedSteps;
+}
+
 /**
  * @brief Computes the next state vector value and increments time.
  ******/
@@ -808,7 +1429,7 @@ void StateSpaceController<T>::nextState()
     m_x_ib = m_x_i; // Backup of the last state for display
     
     //m_x_i = m_A * m_x_i + m_B * m_e_i;
-    m_x_i = QSMatrix<T>::vectorAdd(m_A * m_x_i, m_B * m_e_i);
+    m_x_i = QSMatrix<T>::vectorAdd(*m_A * m_x_i, *m_B * m_e_i);
     
     m_t = m_i * m_t_s;
     m_i++;
@@ -828,6 +1449,229 @@ void StateSpaceController<T>::reset()
     
     m_i = 0;
     m_t = 0;
+    m_atRest = false;
+    m_restSteps = 0;
+    
+    publishSnapshot();
+}
+
+/**
+ * @brief Enables or disables the snapshots published after each step.
+ * @details The buffer is created for the current dimensions and receives the current state. Copies of the
+ * controller do not share it (one writer per buffer).
+ * @param enable False to stop publishing (readers keep the last snapshot).
+ ******/
+template<typename T>
+void StateSpaceController<T>::enableSnapshots(const bool enable)
+{
+    if (!enable)
+    {
+        m_snapshot.reset();
+        return;
+    }
+    
+    m_snapshot = std::make_shared<SnapshotBuffer<T> >(m_nx, m_ne, m_nu);
+    publishSnapshot();
+}
+
+/**
+ * @return Snapshot buffer of the controller (null if snapshots are disabled).
+ * @details Monitoring threads keep this pointer and call read(); a new buffer replaces it if the dimensions
+ * change (loadControllerData(), = operator).
+ ******/
+template<typename T>
+std::shared_ptr<const SnapshotBuffer<T> > StateSpaceController<T>::getSnapshotBuffer() const
+{
+    return m_snapshot;
+}
+
+/**
+ * @brief Publishes time, signals and state if snapshots are enabled.
+ ******/
+template<typename T>
+void StateSpaceController<T>::publishSnapshot()
+{
+    if (!m_snapshot)
+    {
+        return;
+    }
+    
+    if (m_snapshot->getNx() != m_nx || m_snapshot->getNe() != m_ne || m_snapshot->getNu() != m_nu)
+    {
+        m_snapshot = std::make_shared<SnapshotBuffer<T> >(m_nx, m_ne, m_nu);
+    }
+    
+    m_snapshot->publish(m_i, m_t, m_r_i.data(), m_y_i.data(), m_e_i.data(), m_u_i.data(), m_x_i.data());
+}
+
+/**
+ * @return Checksum of the dimensions, the time step and A, B, C, D.
+ * @details Computed again only when a matrix (shared storage identity) or the time step has changed since
+ * the last call, so checkpointing every step does not read the matrices.
+ ******/
+template<typename T>
+std::uint64_t StateSpaceController<T>::coefficientHash() const
+{
+    if (isCachedFrom(m_hashA, m_A) && isCachedFrom(m_hashB, m_B) && isCachedFrom(m_hashC, m_C) && isCachedFrom(m_hashD, m_D) && m_hashT_s == m_t_s)
+    {
+        return m_hash;
+    }
+    
+    const std::uint32_t dimensions[3] = {m_nx, m_ne, m_nu};
+    
+    std::uint64_t hash = checkpointChecksum(dimensions, sizeof(dimensions));
+    hash = checkpointChecksum(&m_t_s, sizeof(m_t_s), hash);
+    hash = checkpointChecksum(m_A->data(), (std::size_t)m_nx * m_nx * sizeof(T), hash);
+    hash = checkpointChecksum(m_B->data(), (std::size_t)m_nx * m_ne * sizeof(T), hash);
+    hash = checkpointChecksum(m_C->data(), (std::size_t)m_nu * m_nx * sizeof(T), hash);
+    
+    m_hash = checkpointChecksum(m_D->data(), (std::size_t)m_nu * m_ne * sizeof(T), hash);
+    m_hashT_s = m_t_s;
+    m_hashA = m_A;
+    m_hashB = m_B;
+    m_hashC = m_C;
+    m_hashD = m_D;
+    
+    return m_hash;
+}
+
+/**
+ * @brief Checks that a cache was built from a matrix storage, without keeping that storage alive.
+ * @details The weak reference keeps the control block of the storage it was taken from, so a storage
+ * allocated after the old one was freed (even at the same address) never compares equal.
+ * @param cached Weak reference stored with the cache (empty: no cache).
+ * @param matrix Current matrix storage.
+ * @return True if the cache was built from this storage.
+ ******/
+template<typename T>
+bool StateSpaceController<T>::isCachedFrom(const std::weak_ptr<const QSMatrix<T> >& cached, const std::shared_ptr<const QSMatrix<T> >& matrix)
+{
+    return matrix && !cached.owner_before(matrix) && !matrix.owner_before(cached);
+}
+
+/**
+ * @param coefficients True to include A, B, C, D and the time step.
+ * @return Bytes of a checkpoint of this controller (header and payload).
+ ******/
+template<typename T>
+std::size_t StateSpaceController<T>::checkpointSize(const bool coefficients) const
+{
+    return sizeof(CheckpointHeader) + checkpointPayloadSize(m_nx, m_ne, m_nu, sizeof(T), coefficients);
+}
+
+/**
+ * @brief Writes step index, time, state and signals (and optionally the matrices) as a checkpoint.
+ * @param buffer Destination of checkpointSize(coefficients) bytes, aligned for a std::uint64_t.
+ * @param coefficients True to include A, B, C, D and the time step: the checkpoint then rebuilds the
+ * controller on its own, otherwise it can only be restored into a controller with the same matrices.
+ * @return Bytes written.
+ ******/
+template<typename T>
+std::size_t StateSpaceController<T>::saveCheckpoint(void* buffer, const bool coefficients) const
+{
+    CheckpointHeader* header = (CheckpointHeader*)buffer;
+    header->magic = CHECKPOINT_MAGIC;
+    header->version = CHECKPOINT_VERSION;
+    header->scalarSize = sizeof(T);
+    header->nx = m_nx;
+    header->ne = m_ne;
+    header->nu = m_nu;
+    header->flags = coefficients ? CHECKPOINT_COEFFICIENTS : 0;
+    header->i = m_i;
+    header->t = m_t;
+    header->t_s = m_t_s;
+    header->coefficientHash = coefficientHash();
+    header->payloadSize = checkpointPayloadSize(m_nx, m_ne, m_nu, sizeof(T), coefficients);
+    
+    T* payload = (T*)(header + 1);
+    payload = std::copy(m_x_i.begin(), m_x_i.end(), payload);
+    payload = std::copy(m_x_ib.begin(), m_x_ib.end(), payload);
+    payload = std::copy(m_r_i.begin(), m_r_i.end(), payload);
+    payload = std::copy(m_y_i.begin(), m_y_i.end(), payload);
+    payload = std::copy(m_e_i.begin(), m_e_i.end(), payload);
+    payload = std::copy(m_u_i.begin(), m_u_i.end(), payload);
+    if (coefficients)
+    {
+        payload = std::copy(m_A->data(), m_A->data() + m_nx * m_nx, payload);
+        payload = std::copy(m_B->data(), m_B->data() + m_nx * m_ne, payload);
+        payload = std::copy(m_C->data(), m_C->data() + m_nu * m_nx, payload);
+        payload = std::copy(m_D->data(), m_D->data() + m_nu * m_ne, payload);
+    }
+    
+    std::uint64_t checksum = checkpointChecksum(header, offsetof(CheckpointHeader, checksum));
+    header->checksum = checkpointChecksum(header + 1, header->payloadSize, checksum);
+    
+    return sizeof(CheckpointHeader) + header->payloadSize;
+}
+
+/**
+ * @brief Restores a checkpoint written by saveCheckpoint().
+ * @details The checkpoint is validated first (format, scalar type, size, checksum). A checkpoint with
+ * coefficients replaces the matrices, dimensions and time step; a state-only checkpoint must come from a
+ * controller with the same dimensions, time step and matrices. The vectors are then copied: no allocation
+ * when the dimensions do not change.
+ * @param buffer Checkpoint, aligned for a std::uint64_t.
+ * @param bytes Bytes available in the buffer.
+ * @return False if the checkpoint is rejected (the controller is left unchanged).
+ ******/
+template<typename T>
+bool StateSpaceController<T>::restoreCheckpoint(const void* buffer, const std::size_t bytes)
+{
+    const CheckpointHeader* header = checkpointValidate(buffer, bytes, sizeof(T));
+    if (!header)
+    {
+        return false;
+    }
+    
+    const unsigned int nx = header->nx, ne = header->ne, nu = header->nu;
+    const T* payload = (const T*)(header + 1);
+    const T* matrices = payload + 2 * nx + 3 * ne + nu;
+    
+    if (header->flags & CHECKPOINT_COEFFICIENTS)
+    {
+        QSMatrix<T> A(nx, nx, 0), B(nx, ne, 0), C(nu, nx, 0), D(nu, ne, 0);
+        std::copy(matrices, matrices + nx * nx, A.data());
+        matrices += nx * nx;
+        std::copy(matrices, matrices + nx * ne, B.data());
+        matrices += nx * ne;
+        std::copy(matrices, matrices + nu * nx, C.data());
+        matrices += nu * nx;
+        std::copy(matrices, matrices + nu * ne, D.data());
+        
+        m_A = std::make_shared<QSMatrix<T> >(std::move(A));
+        m_B = std::make_shared<QSMatrix<T> >(std::move(B));
+        m_C = std::make_shared<QSMatrix<T> >(std::move(C));
+        m_D = std::make_shared<QSMatrix<T> >(std::move(D));
+        m_t_s = header->t_s;
+        m_nx = nx;
+        m_ne = ne;
+        m_nu = nu;
+    }
+    else if (nx != m_nx || ne != m_ne || nu != m_nu || header->coefficientHash != coefficientHash())
+    {
+        std::cout << "\033[1;31mERROR: Checkpoint was saved by a controller with other matrices\033[0m" << std::endl;
+        return false;
+    }
+    
+    m_x_i.assign(payload, payload + nx);
+    payload += nx;
+    m_x_ib.assign(payload, payload + nx);
+    payload += nx;
+    m_r_i.assign(payload, payload + ne);
+    payload += ne;
+    m_y_i.assign(payload, payload + ne);
+    payload += ne;
+    m_e_i.assign(payload, payload + ne);
+    payload += ne;
+    m_u_i.assign(payload, payload + nu);
+    
+    m_i = header->i;
+    m_t = header->t;
+    m_atRest = false;
+    
+    publishSnapshot();
+    
+    return true;
 }
 
 /**
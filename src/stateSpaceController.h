@@ -12,8 +12,16 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include <memory>
 
 #include "QSMatrix.h"
+#include "stateSnapshot.h"
+#include "checkpointFormat.h"
+
+/**
+ * @brief Consecutive steps within the rest bound before a controller is put at rest (idle mode).
+ ******/
+#define IDLE_REST_STEPS 4
 
 /*
  * General State-Space Controller class.
@@ -101,6 +109,30 @@
  * See loadControllerData() or StateSpaceController::StateSpaceController() for file format and more details.
  * 
  * This class can be used as a state space controller alone or coupled with a comparator to generate the error vector by using overloaded member functions.
+ * 
+ * A, B, C and D are immutable and reference counted: copies of a controller share them and only copy the
+ * state vectors. The setters replace a matrix (copy-on-write), they never modify one shared with other controllers.
+ *
+ * With enableSnapshots(), each step publishes (i, t, r, y, e, u, x) in a SnapshotBuffer: monitoring threads
+ * read consistent copies from getSnapshotBuffer() without locking nor blocking the control loop.
+ *
+ * saveCheckpoint() writes the state (and optionally the matrices) in the binary format of checkpointFormat.h;
+ * restoreCheckpoint() validates one and copies it back, so that a restarted or standby process resumes the
+ * loop where it stopped instead of from reset(). See controllerCheckpoint.h for files and shared memory.
+ * The checksum of the matrices is computed once and kept until a matrix or the time step changes.
+ *
+ * advance() catches up k missed steps with a held error in O(log k) matrix/vector products, from the
+ * powers A^(2^j) and the matching sums (I + A + ... + A^(2^j - 1))*B, cached until A or B is replaced.
+ *
+ * In idle mode (enableIdleMode()), a controller whose state has reached the fixed point of its error (the
+ * residual A*x + B*e - x is checked against the convergence rate of the slowest mode of A) returns its
+ * cached output without stepping while the error stays within a threshold of the error at rest; a larger change wakes it with an
+ * O((nx + nu) * changed inputs) update instead of a full step.
+ *
+ * rollout() evaluates K candidate error (or reference) trajectories over H steps from the current state
+ * without modifying the controller: the K candidates are stepped together, one matrix product per step.
+ * The packed [A B; C D] it reads is cached until a matrix is replaced (concurrent rollouts on one object
+ * must be serialized).
  ******/
 template <typename T>
 class StateSpaceController
@@ -146,23 +178,76 @@ class StateSpaceController
     std::vector<T> currentOutput(const std::vector<T>& r_i, const std::vector<T>& y_i);
     std::vector<T> currentOutput(const std::vector<T>& r_i, const std::vector<T>& y_i, const std::vector<T>& u_min, const std::vector<T>& u_max);
     std::vector<T> currentOutput(const std::vector<T>& r_i, const std::vector<T>& y_i, const T& u_min, const T& u_max);
+    
+    /* Catch up k steps with the error held at e_hold (same result and time as k currentOutput(e_hold) calls)
+     * in O(log k) matrix/vector products
+     * 
+     * Returns the controller output of the last step (the current output if k = 0)
+     */
+    std::vector<T> advance(const unsigned int k, const std::vector<T>& e_hold);
+    
+    // Compute the cached powers needed by advance() for gaps up to maxSteps (outside the control loop)
+    void prepareAdvance(const unsigned int maxSteps);
+    
+    /* Idle mode: at rest when the state is within "tolerance" of the fixed point of the error; steps at rest
+     * return the cached output (time still advances) until an error moves by more than "threshold" from the
+     * error at rest
+     */
+    void enableIdleMode(const T& tolerance, const T& threshold, const bool enable = true);
+    bool isIdleModeEnabled() const;
+    bool isAtRest() const;
+    
+    // Steps returned from the cache in idle mode
+    unsigned long long getSkippedSteps() const;
+    
+    /* Outputs of candidate trajectories from the current state (the controller is not modified)
+     * 
+     * errors[k][h]: error vector of candidate k at step h (every candidate has the same horizon)
+     * OR
+     * references[k][h] with the plant output held at y_hold (e = r - y_hold)
+     * 
+     * These methods return outputs[k][h], the controller output vectors
+     */
+    std::vector<std::vector<std::vector<T> > > rollout(const std::vector<std::vector<std::vector<T> > >& errors) const;
+    std::vector<std::vector<std::vector<T> > > rollout(const std::vector<std::vector<std::vector<T> > >& references, const std::vector<T>& y_hold) const;
+    
+    /* Same on contiguous buffers: errors[candidates][horizon][ne] -> outputs[candidates][horizon][nu]
+     * errors holds candidates*horizon*ne values and outputs candidates*horizon*nu values (not checked)
+     * 
+     * Returns false (nothing written) if a buffer is null or the sizes do not fit in memory
+     */
+    bool rollout(const unsigned int candidates, const unsigned int horizon, const T* errors, T* outputs) const;
 	
     // help method
 	static void help();
 	
 	// State-space matrices
-	QSMatrix<T> getA() const;
+	const QSMatrix<T>& getA() const;
 	void setA(QSMatrix<T> A);
-    QSMatrix<T> getB() const;
+    const QSMatrix<T>& getB() const;
 	void setB(QSMatrix<T> B);
-    QSMatrix<T> getC() const;
+    const QSMatrix<T>& getC() const;
 	void setC(QSMatrix<T> C);
-    QSMatrix<T> getD() const;
+    const QSMatrix<T>& getD() const;
 	void setD(QSMatrix<T> D);
     
+    // Shared state-space matrices (no copy)
+    std::shared_ptr<const QSMatrix<T> > getSharedA() const;
+    void setA(std::shared_ptr<const QSMatrix<T> > A);
+    std::shared_ptr<const QSMatrix<T> > getSharedB() const;
+    void setB(std::shared_ptr<const QSMatrix<T> > B);
+    std::shared_ptr<const QSMatrix<T> > getSharedC() const;
+    void setC(std::shared_ptr<const QSMatrix<T> > C);
+    std::shared_ptr<const QSMatrix<T> > getSharedD() const;
+    void setD(std::shared_ptr<const QSMatrix<T> > D);
+    
+    // Do both controllers use the same A, B, C and D storage?
+    bool sharesMatricesWith(const StateSpaceController<T>& other) const;
+    
     // Time step (seconds)
+    // Matrices are not re-discretized (see ContinuousStateSpaceController)
     float getTimeStep() const;
-	void setTimeStep(const float t_s);
+	virtual void setTimeStep(const float t_s);
 
     // Current time (seconds)
     float getTime() const;
@@ -190,11 +275,53 @@ class StateSpaceController
     
     // Reset time and states (to zero)
     void reset();
+    
+    // Publish a snapshot (i, t, r, y, e, u, x) after every step; copies of the controller do not publish
+    void enableSnapshots(const bool enable = true);
+    
+    // Snapshots of this controller (null if disabled), to read from other threads
+    std::shared_ptr<const SnapshotBuffer<T> > getSnapshotBuffer() const;
+    
+    // Bytes of a checkpoint of the state, with or without the matrices and time step
+    std::size_t checkpointSize(const bool coefficients = false) const;
+    
+    // Write a checkpoint into buffer (checkpointSize() bytes), returns the bytes written
+    std::size_t saveCheckpoint(void* buffer, const bool coefficients = false) const;
+    
+    // Restore a checkpoint; false (controller unchanged) if it is invalid or is a state of other matrices
+    bool restoreCheckpoint(const void* buffer, const std::size_t bytes);
 	
 	protected:
+    // Compute the output and the next state (no saturation, no snapshot)
+    void computeOutput(const std::vector<T>& e_i);
+    
     // Compute the next state vector
     void nextState();  // gives x_ip1 (x i+1)
     
+    // Step at rest: cached output, or wake with incremental B*de and D*de updates
+    void idleStep(const std::vector<T>& e_i);
+    
+    // After a full step in idle mode: at rest if the state is at the fixed point of the error
+    void detectRest();
+    
+    // Estimate the convergence rate of the slowest mode of A (rest bound of the idle mode)
+    void updateRestRate();
+    
+    // Publish the current state if snapshots are enabled
+    void publishSnapshot();
+    
+    // Checksum of the dimensions, time step and matrices (identifies the controller in a checkpoint)
+    std::uint64_t coefficientHash() const;
+    
+    // Is "matrix" the storage a cache was built from? (the cache does not keep the storage alive)
+    static bool isCachedFrom(const std::weak_ptr<const QSMatrix<T> >& cached, const std::shared_ptr<const QSMatrix<T> >& matrix);
+    
+    // Packed [A B; C D] of rollout(), rebuilt if a matrix has been replaced
+    const std::vector<T>& packedMatrix() const;
+    
+    // Extend the advance() cache to "levels" powers (rebuilt if A or B has been replaced)
+    void extendPowerCache(const unsigned int levels);
+    
     // Compute the current error from reference r and plant output y
     void currentError();
     
@@ -203,23 +330,23 @@ class StateSpaceController
     void saturation(const T& u_min, const T& u_max);  // Use when there is only 1 min/max for all controller outputs.
         
     
-    // State-space matrices
+    // State-space matrices (immutable, shared by the copies of the controller)
     /**
      * @brief Controller A matrix in state space representation.
      ******/
-	QSMatrix<T> m_A;
+	std::shared_ptr<const QSMatrix<T> > m_A;
     /**
      * @brief Controller B matrix in state space representation.
      ******/
-	QSMatrix<T> m_B;
+	std::shared_ptr<const QSMatrix<T> > m_B;
     /**
      * @brief Controller C matrix in state space representation.
      ******/
-    QSMatrix<T> m_C;
+    std::shared_ptr<const QSMatrix<T> > m_C;
     /**
      * @brief Controller D matrix in state space representation.
      ******/
-	QSMatrix<T> m_D;
+	std::shared_ptr<const QSMatrix<T> > m_D;
     
     /**
      * @brief Time step of the controller (seconds).
@@ -282,6 +409,69 @@ class StateSpaceController
      * @brief Current controller output vector.
      ******/
     std::vector<T> m_u_i;
+    
+    /**
+     * @brief Snapshots published after each step (null if disabled).
+     ******/
+    std::shared_ptr<SnapshotBuffer<T> > m_snapshot;
+    
+    /**
+     * @brief A and B the advance() cache was computed from (the cache is stale when they differ from m_A, m_B).
+     ******/
+    std::shared_ptr<const QSMatrix<T> > m_powerA, m_powerB;
+    
+    /**
+     * @brief Cached A^(2^j), j = 0, 1, ...
+     ******/
+    std::vector<QSMatrix<T> > m_powers;
+    
+    /**
+     * @brief Cached (I + A + ... + A^(2^j - 1))*B, j = 0, 1, ...
+     ******/
+    std::vector<QSMatrix<T> > m_powerSums;
+    
+    /**
+     * @brief Packed [A B; C D] of rollout() (row-major) and the matrices it was built from (stale when they differ).
+     ******/
+    mutable std::vector<T> m_packed;
+    mutable std::weak_ptr<const QSMatrix<T> > m_packedA, m_packedB, m_packedC, m_packedD;
+    
+    /**
+     * @brief Cached coefficientHash() and the matrices and time step it was computed from (stale when they differ).
+     * @details Weak references: a replaced matrix is freed with its last user, not kept by the cache.
+     ******/
+    mutable std::uint64_t m_hash;
+    mutable float m_hashT_s;
+    mutable std::weak_ptr<const QSMatrix<T> > m_hashA, m_hashB, m_hashC, m_hashD;
+    
+    /**
+     * @brief Idle mode settings: enabled, state tolerance, error threshold.
+     ******/
+    bool m_idleMode;
+    T m_idleTolerance, m_idleThreshold;
+    
+    /**
+     * @brief True while the state is at a fixed point (idle mode).
+     ******/
+    bool m_atRest;
+    
+    /**
+     * @brief Consecutive steps within the rest bound, and convergence rate of the slowest mode of the A it
+     * was estimated from (idle mode).
+     ******/
+    unsigned int m_restSteps;
+    T m_restRate;
+    std::weak_ptr<const QSMatrix<T> > m_restA;
+    
+    /**
+     * @brief Steps returned from the cache.
+     ******/
+    unsigned long long m_skippedSteps;
+    
+    /**
+     * @brief Error and output (before saturation) when the controller came to rest.
+     ******/
+    std::vector<T> m_restError, m_restOutput;
 };
 
 #include "stateSpaceController.cpp"
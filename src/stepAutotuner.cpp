@@ -0,0 +1,628 @@
+/**
+ * @file stepAutotuner.cpp
+ * @brief Step kernels (dense, fused, sparse) and load-time autotuner choosing one per controller (source file).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef STEPAUTOTUNER_CPP
+#define STEPAUTOTUNER_CPP
+
+#include "stepAutotuner.h"
+#include "checkpointFormat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+
+/**
+ * @return Name of a strategy.
+ ******/
+inline const char* stepStrategyName(const StepStrategy strategy)
+{
+    switch (strategy)
+    {
+        case STEP_DENSE: return "dense";
+        case STEP_FUSED: return "fused";
+        case STEP_SPARSE: return "sparse";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Prints the time and error of each strategy and the selection.
+ ******/
+template<typename T>
+void AutotuneResult<T>::print() const
+{
+    if (cached)
+    {
+        std::cout << "Strategy " << stepStrategyName(strategy) << " (cached)" << std::endl;
+        return;
+    }
+
+    for (int s=0;s<STEP_STRATEGY_COUNT;s++)
+    {
+        std::cout << std::left << std::setw(8) << stepStrategyName((StepStrategy)s) << std::right << std::setw(12) << secondsPerStep[s] * 1e9 << " ns/step"
+                  << ", error " << maxError[s] << (verified[s] ? "" : " (rejected)") << std::endl;
+    }
+    std::cout << "Strategy " << stepStrategyName(strategy) << std::endl;
+}
+
+/**
+ * @brief Constructor: copies the matrices in the layout of the strategy.
+ * @param controller Controller (matrices and state; time restarts from 0).
+ * @param strategy Step kernel.
+ ******/
+template<typename T>
+TunedController<T>::TunedController(const StateSpaceController<T>& controller, const StepStrategy strategy):
+m_strategy(strategy), m_nx(controller.getNx()), m_ne(controller.getNe()), m_nu(controller.getNu()),
+m_z(m_nx + m_ne, T(0)), m_out(m_nu + m_nx, T(0)), m_t_s(controller.getTimeStep()), m_i(0), m_t(0)
+{
+    const std::vector<T> x = controller.getX_i();
+    std::copy(x.begin(), x.end(), m_z.begin());
+
+    if (m_strategy == STEP_DENSE)
+    {
+        m_A.assign(controller.getA().data(), controller.getA().data() + m_nx * m_nx);
+        m_B.assign(controller.getB().data(), controller.getB().data() + m_nx * m_ne);
+        m_C.assign(controller.getC().data(), controller.getC().data() + m_nu * m_nx);
+        m_D.assign(controller.getD().data(), controller.getD().data() + m_nu * m_ne);
+        return;
+    }
+
+    // [C D; A B], row-major
+    const unsigned int cols = m_nx + m_ne;
+    std::vector<T> F((m_nu + m_nx) * cols);
+    for (unsigned int row=0;row<m_nu;row++)
+    {
+        std::copy(controller.getC().data() + row * m_nx, controller.getC().data() + (row + 1) * m_nx, F.data() + row * cols);
+        std::copy(controller.getD().data() + row * m_ne, controller.getD().data() + (row + 1) * m_ne, F.data() + row * cols + m_nx);
+    }
+    for (unsigned int row=0;row<m_nx;row++)
+    {
+        std::copy(controller.getA().data() + row * m_nx, controller.getA().data() + (row + 1) * m_nx, F.data() + (m_nu + row) * cols);
+        std::copy(controller.getB().data() + row * m_ne, controller.getB().data() + (row + 1) * m_ne, F.data() + (m_nu + row) * cols + m_nx);
+    }
+
+    if (m_strategy == STEP_FUSED)
+    {
+        m_F.swap(F);
+        return;
+    }
+
+    m_strategy = STEP_SPARSE;
+    m_rowStarts.push_back(0);
+    for (unsigned int row=0;row<m_nu+m_nx;row++)
+    {
+        for (unsigned int col=0;col<cols;col++)
+        {
+            if (F[row * cols + col] != T(0))
+            {
+                m_values.push_back(F[row * cols + col]);
+                m_columns.push_back(col);
+            }
+        }
+        m_rowStarts.push_back(m_values.size());
+    }
+}
+
+/**
+ * @brief Computes the controller output and the next state with the kernel of the strategy.
+ * @param e_i Current error vector (ne values).
+ * @return Controller output vector (nu values, valid until the next step).
+ ******/
+template<typename T>
+const T* TunedController<T>::step(const T* e_i)
+{
+    T* x = m_z.data();
+    T* e = x + m_nx;
+    T* u = m_out.data();
+    T* xNext = u + m_nu;
+    if (e_i != e)
+    {
+        // step(r_i, y_i) writes e in place
+        std::copy(e_i, e_i + m_ne, e);
+    }
+
+    if (m_strategy == STEP_DENSE)
+    {
+        for (unsigned int row=0;row<m_nu;row++)
+        {
+            const T* c = m_C.data() + row*m_nx;
+            const T* d = m_D.data() + row*m_ne;
+            T sum = 0;
+            for (unsigned int col=0;col<m_nx;col++) sum += c[col] * x[col];
+            for (unsigned int col=0;col<m_ne;col++) sum += d[col] * e[col];
+            u[row] = sum;
+        }
+        for (unsigned int row=0;row<m_nx;row++)
+        {
+            const T* a = m_A.data() + row*m_nx;
+            const T* b = m_B.data() + row*m_ne;
+            T sum = 0;
+            for (unsigned int col=0;col<m_nx;col++) sum += a[col] * x[col];
+            for (unsigned int col=0;col<m_ne;col++) sum += b[col] * e[col];
+            xNext[row] = sum;
+        }
+    }
+    else if (m_strategy == STEP_FUSED)
+    {
+        const unsigned int rows = m_nu + m_nx, cols = m_nx + m_ne;
+        const T* f = m_F.data();
+        for (unsigned int row=0;row<rows;row++, f+=cols)
+        {
+            T sum = 0;
+            for (unsigned int col=0;col<cols;col++) sum += f[col] * x[col];
+            u[row] = sum;
+        }
+    }
+    else
+    {
+        const unsigned int rows = m_nu + m_nx;
+        for (unsigned int row=0;row<rows;row++)
+        {
+            T sum = 0;
+            for (unsigned int k=m_rowStarts[row];k<m_rowStarts[row+1];k++) sum += m_values[k] * x[m_columns[k]];
+            u[row] = sum;
+        }
+    }
+
+    std::copy(xNext, xNext + m_nx, x);
+
+    m_t = m_i * m_t_s;
+    m_i++;
+
+    return u;
+}
+
+/**
+ * @brief Computes the controller output from the reference and the plant output.
+ * @param r_i Current reference vector (ne values).
+ * @param y_i Current plant output vector (ne values).
+ * @return Controller output vector (nu values, valid until the next step).
+ ******/
+template<typename T>
+const T* TunedController<T>::step(const T* r_i, const T* y_i)
+{
+    T* e = m_z.data() + m_nx;
+    for (unsigned int k=0;k<m_ne;k++) e[k] = r_i[k] - y_i[k];
+
+    return step(e);
+}
+
+/**
+ * @return Controller output vector computed from the error vector.
+ ******/
+template<typename T>
+std::vector<T> TunedController<T>::currentOutput(const std::vector<T>& e_i)
+{
+    const T* u = step(e_i.data());
+
+    return std::vector<T>(u, u + m_nu);
+}
+
+/**
+ * @return Controller output vector computed from the reference and the plant output.
+ ******/
+template<typename T>
+std::vector<T> TunedController<T>::currentOutput(const std::vector<T>& r_i, const std::vector<T>& y_i)
+{
+    const T* u = step(r_i.data(), y_i.data());
+
+    return std::vector<T>(u, u + m_nu);
+}
+
+/**
+ * @brief Resets time and state vector.
+ ******/
+template<typename T>
+void TunedController<T>::reset()
+{
+    std::fill(m_z.begin(), m_z.end(), T(0));
+    std::fill(m_out.begin(), m_out.end(), T(0));
+    m_i = 0;
+    m_t = 0;
+}
+
+/**
+ * @return Step kernel.
+ ******/
+template<typename T>
+StepStrategy TunedController<T>::getStrategy() const
+{
+    return m_strategy;
+}
+
+/**
+ * @return Current state vector.
+ ******/
+template<typename T>
+std::vector<T> TunedController<T>::getX_i() const
+{
+    return std::vector<T>(m_z.begin(), m_z.begin() + m_nx);
+}
+
+/**
+ * @return Current state vector (nx values).
+ ******/
+template<typename T>
+const T* TunedController<T>::getState() const
+{
+    return m_z.data();
+}
+
+/**
+ * @return Controller output of the last step (nu values).
+ ******/
+template<typename T>
+const T* TunedController<T>::getOutput() const
+{
+    return m_out.data();
+}
+
+/**
+ * @return Coefficients read by a step.
+ ******/
+template<typename T>
+unsigned int TunedController<T>::getCoefficientCount() const
+{
+    if (m_strategy == STEP_SPARSE)
+    {
+        return m_values.size();
+    }
+
+    return (m_nu + m_nx) * (m_nx + m_ne);
+}
+
+/**
+ * @return Time step (seconds).
+ ******/
+template<typename T>
+float TunedController<T>::getTimeStep() const
+{
+    return m_t_s;
+}
+
+/**
+ * @return Current time (seconds).
+ ******/
+template<typename T>
+float TunedController<T>::getTime() const
+{
+    return m_t;
+}
+
+/**
+ * @return State vector dimension.
+ ******/
+template<typename T>
+unsigned int TunedController<T>::getNx() const
+{
+    return m_nx;
+}
+
+/**
+ * @return Error vector dimension.
+ ******/
+template<typename T>
+unsigned int TunedController<T>::getNe() const
+{
+    return m_ne;
+}
+
+/**
+ * @return Controller output vector dimension.
+ ******/
+template<typename T>
+unsigned int TunedController<T>::getNu() const
+{
+    return m_nu;
+}
+
+/**
+ * @brief Constructor: loads the decisions of the cache file made on this CPU.
+ * @param cachePath Cache file (created when the first decision is stored), empty for an in-memory cache.
+ * @param tolerance Largest relative output error of a strategy against StateSpaceController.
+ * @param minSeconds Measuring time of each strategy (three repetitions, the best is kept).
+ ******/
+template<typename T>
+StepAutotuner<T>::StepAutotuner(const std::string& cachePath, const T tolerance, const double minSeconds):
+m_cachePath(cachePath), m_tolerance(tolerance), m_minSeconds(minSeconds), m_cpuModel(cpuModel())
+{
+    loadCache();
+}
+
+/**
+ * @brief Strategy of a controller.
+ * @details From the cache if this controller (matrix hash) was tuned on this CPU model; otherwise every
+ * strategy is verified on 64 steps of random errors from a zero state, the verified ones are timed and the
+ * fastest is cached. STEP_DENSE is kept if no strategy is verified, and without measure for a controller with
+ * neither state nor output (nx + nu = 0: nothing to step).
+ * @param controller Controller.
+ * @param result If not null, measurements (result->cached is true when nothing was measured).
+ * @return Selected strategy.
+ ******/
+template<typename T>
+StepStrategy StepAutotuner<T>::select(const StateSpaceController<T>& controller, AutotuneResult<T>* result)
+{
+    const std::uint64_t hash = matrixHash(controller);
+    const std::string cacheKey = key(hash);
+
+    AutotuneResult<T> measured;
+    measured.strategy = STEP_DENSE;
+    measured.cached = false;
+    measured.matrixHash = hash;
+    for (int s=0;s<STEP_STRATEGY_COUNT;s++)
+    {
+        measured.secondsPerStep[s] = 0;
+        measured.maxError[s] = 0;
+        measured.verified[s] = false;
+    }
+
+    if (controller.getNx() + controller.getNu() == 0)
+    {
+        if (result) *result = measured;
+        return measured.strategy;
+    }
+
+    typename std::map<std::string, StepStrategy>::const_iterator cached = m_cache.find(cacheKey);
+    if (cached != m_cache.end())
+    {
+        measured.strategy = cached->second;
+        measured.cached = true;
+        if (result) *result = measured;
+        return cached->second;
+    }
+
+    const unsigned int steps = 64;
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    std::vector<T> errors(steps * controller.getNe());
+    for (unsigned int k=0;k<errors.size();k++) errors[k] = (T)distribution(generator);
+
+    double best = -1;
+    for (int s=0;s<STEP_STRATEGY_COUNT;s++)
+    {
+        measured.maxError[s] = verify(controller, (StepStrategy)s, errors, steps);
+        measured.verified[s] = measured.maxError[s] <= m_tolerance;
+        if (!measured.verified[s])
+        {
+            continue;
+        }
+
+        measured.secondsPerStep[s] = measure(controller, (StepStrategy)s, errors, steps);
+        if (best < 0 || measured.secondsPerStep[s] < best)
+        {
+            best = measured.secondsPerStep[s];
+            measured.strategy = (StepStrategy)s;
+        }
+    }
+
+    m_cache[cacheKey] = measured.strategy;
+    if (!m_cachePath.empty())
+    {
+        std::ofstream file(m_cachePath.c_str(), std::ios::app);
+        if (file)
+        {
+            file << stepStrategyName(measured.strategy) << " " << cacheKey << std::endl;
+        }
+        else
+        {
+            std::cout << "\033[1;31mERROR: Autotuner cache " << m_cachePath << " cannot be written\033[0m" << std::endl;
+        }
+    }
+
+    if (result) *result = measured;
+
+    return measured.strategy;
+}
+
+/**
+ * @return Controller stepped with the strategy selected for it.
+ ******/
+template<typename T>
+TunedController<T> StepAutotuner<T>::tune(const StateSpaceController<T>& controller, AutotuneResult<T>* result)
+{
+    return TunedController<T>(controller, select(controller, result));
+}
+
+/**
+ * @return Hash of the dimensions and of A, B, C, D.
+ ******/
+template<typename T>
+std::uint64_t StepAutotuner<T>::matrixHash(const StateSpaceController<T>& controller)
+{
+    const unsigned int nx = controller.getNx(), ne = controller.getNe(), nu = controller.getNu();
+    const std::uint32_t dimensions[3] = {nx, ne, nu};
+
+    std::uint64_t hash = checkpointChecksum(dimensions, sizeof(dimensions));
+    hash = checkpointChecksum(controller.getA().data(), (std::size_t)nx * nx * sizeof(T), hash);
+    hash = checkpointChecksum(controller.getB().data(), (std::size_t)nx * ne * sizeof(T), hash);
+    hash = checkpointChecksum(controller.getC().data(), (std::size_t)nu * nx * sizeof(T), hash);
+
+    return checkpointChecksum(controller.getD().data(), (std::size_t)nu * ne * sizeof(T), hash);
+}
+
+/**
+ * @return CPU model name (first "model name" of /proc/cpuinfo), "unknown" if not available.
+ ******/
+template<typename T>
+std::string StepAutotuner<T>::cpuModel()
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+
+    while (std::getline(cpuinfo, line))
+    {
+        if (line.compare(0, 10, "model name") == 0)
+        {
+            const std::size_t colon = line.find(':');
+            const std::size_t begin = line.find_first_not_of(" \t", colon + 1);
+            if (colon != std::string::npos && begin != std::string::npos)
+            {
+                return line.substr(begin);
+            }
+        }
+    }
+
+    return "unknown";
+}
+
+/**
+ * @return Cache key: matrix hash (hexadecimal), scalar size and CPU model.
+ ******/
+template<typename T>
+std::string StepAutotuner<T>::key(const std::uint64_t hash) const
+{
+    std::ostringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec << " " << sizeof(T) << " " << m_cpuModel;
+
+    return stream.str();
+}
+
+/**
+ * @brief Reads the cache file; lines of other strategies names or other CPUs are ignored.
+ ******/
+template<typename T>
+void StepAutotuner<T>::loadCache()
+{
+    if (m_cachePath.empty())
+    {
+        return;
+    }
+
+    std::ifstream file(m_cachePath.c_str());
+    std::string line;
+    while (std::getline(file, line))
+    {
+        const std::size_t space = line.find(' ');
+        if (space == std::string::npos)
+        {
+            continue;
+        }
+
+        const std::string name = line.substr(0, space);
+        for (int s=0;s<STEP_STRATEGY_COUNT;s++)
+        {
+            if (name == stepStrategyName((StepStrategy)s))
+            {
+                m_cache[line.substr(space + 1)] = (StepStrategy)s;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Steps a TunedController and StateSpaceController (same state) with the same errors.
+ * @return Largest |u - u_ref| / (1 + |u_ref|) (infinity if an output is not finite).
+ ******/
+template<typename T>
+T StepAutotuner<T>::verify(const StateSpaceController<T>& controller, const StepStrategy strategy, const std::vector<T>& errors, const unsigned int steps) const
+{
+    StateSpaceController<T> reference(controller);
+    reference.reset();
+    TunedController<T> candidate(reference, strategy);
+
+    const unsigned int ne = controller.getNe(), nu = controller.getNu();
+    std::vector<T> e(ne);
+    T maxError = 0;
+
+    for (unsigned int i=0;i<steps;i++)
+    {
+        std::copy(errors.begin() + i * ne, errors.begin() + (i + 1) * ne, e.begin());
+        const std::vector<T> expected = reference.currentOutput(e);
+        const T* u = candidate.step(e.data());
+
+        for (unsigned int k=0;k<nu;k++)
+        {
+            const T error = std::abs(u[k] - expected[k]) / (1 + std::abs(expected[k]));
+            if (!std::isfinite((double)error))
+            {
+                return std::numeric_limits<T>::infinity();
+            }
+            maxError = std::max(maxError, error);
+        }
+    }
+
+    return maxError;
+}
+
+/**
+ * @brief Times a strategy: batches of steps over the error sequence until minSeconds, best of three.
+ * @details The state is reset after each pass over the sequence, so unstable controllers are timed on finite values.
+ * @return Seconds per step.
+ ******/
+template<typename T>
+double StepAutotuner<T>::measure(const StateSpaceController<T>& controller, const StepStrategy strategy, const std::vector<T>& errors, const unsigned int steps) const
+{
+    typedef std::chrono::steady_clock Clock;
+
+    TunedController<T> candidate(controller, strategy);
+    const unsigned int ne = controller.getNe();
+    const unsigned int nu = controller.getNu();
+    double best = -1;
+    volatile T sink = 0;
+
+    for (int repetition=0;repetition<3;repetition++)
+    {
+        unsigned long long count = 0;
+        const Clock::time_point start = Clock::now();
+        double seconds = 0;
+
+        do
+        {
+            candidate.reset();
+            for (unsigned int i=0;i<steps;i++)
+            {
+                // Checksum of the whole output, so no part of the step can be left out
+                const T* u = candidate.step(errors.data() + i * ne);
+                T checksum = 0;
+                for (unsigned int j=0;j<nu;j++) checksum += u[j];
+                sink = sink + checksum;
+            }
+            count += steps;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (seconds < m_minSeconds);
+
+        const double perStep = seconds / count;
+        if (best < 0 || perStep < best)
+        {
+            best = perStep;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @return Cache file (empty: in memory only).
+ ******/
+template<typename T>
+const std::string& StepAutotuner<T>::getCachePath() const
+{
+    return m_cachePath;
+}
+
+/**
+ * @return Decisions known for this CPU model and the others of the cache file.
+ ******/
+template<typename T>
+unsigned int StepAutotuner<T>::getCacheSize() const
+{
+    return m_cache.size();
+}
+
+/**
+ * @return Relative tolerance of the verification.
+ ******/
+template<typename T>
+T StepAutotuner<T>::getTolerance() const
+{
+    return m_tolerance;
+}
+
+#endif  // STEPAUTOTUNER_CPP
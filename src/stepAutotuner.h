@@ -0,0 +1,163 @@
+/**
+ * @file stepAutotuner.h
+ * @brief Step kernels (dense, fused, sparse) and load-time autotuner choosing one per controller (header).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef STEPAUTOTUNER_H
+#define STEPAUTOTUNER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+
+/**
+ * @brief Step kernels of a TunedController.
+ ******/
+enum StepStrategy
+{
+    STEP_DENSE = 0,     // u = C*x + D*e, then x = A*x + B*e (four row-major matrices)
+    STEP_FUSED = 1,     // [u; x'] = [C D; A B] * [x; e] (one packed matrix, one pass)
+    STEP_SPARSE = 2,    // Same product with the non-zeros of [C D; A B] in CSR format
+    STEP_STRATEGY_COUNT = 3
+};
+
+// Name of a strategy ("dense", "fused", "sparse")
+const char* stepStrategyName(const StepStrategy strategy);
+
+/**
+ * @struct AutotuneResult
+ * @brief Measurements of StepAutotuner::select() for one controller.
+ ******/
+template <typename T>
+struct AutotuneResult
+{
+    StepStrategy strategy;                          // Strategy selected
+    bool cached;                                    // Taken from the cache (nothing measured)
+    std::uint64_t matrixHash;
+    double secondsPerStep[STEP_STRATEGY_COUNT];     // Best time per step of each strategy
+    T maxError[STEP_STRATEGY_COUNT];                // Largest relative output error against StateSpaceController
+    bool verified[STEP_STRATEGY_COUNT];             // Error within the tolerance
+
+    void print() const;
+};
+
+/**
+ * @class TunedController
+ * @brief Controller stepped by one of the StepStrategy kernels, without allocation.
+ * @details Same equations and time handling as StateSpaceController; the matrices are copied in the layout of
+ * the strategy. The state starts from the state of the controller it is built from.
+ ******/
+template <typename T>
+class TunedController
+{
+    public:
+
+    TunedController(const StateSpaceController<T>& controller, const StepStrategy strategy);
+
+    // One step: writes u_i (nu values, valid until the next step) and returns it
+    const T* step(const T* e_i);
+    const T* step(const T* r_i, const T* y_i);
+
+    // Same interface as StateSpaceController
+    std::vector<T> currentOutput(const std::vector<T>& e_i);
+    std::vector<T> currentOutput(const std::vector<T>& r_i, const std::vector<T>& y_i);
+
+    // Reset time and states (to zero)
+    void reset();
+
+    StepStrategy getStrategy() const;
+    std::vector<T> getX_i() const;
+    const T* getState() const;
+    const T* getOutput() const;
+
+    // Coefficients stored by the kernel (non-zeros for STEP_SPARSE)
+    unsigned int getCoefficientCount() const;
+
+    float getTimeStep() const;
+    float getTime() const;
+    unsigned int getNx() const;
+    unsigned int getNe() const;
+    unsigned int getNu() const;
+
+    protected:
+    StepStrategy m_strategy;
+    unsigned int m_nx, m_ne, m_nu;
+
+    std::vector<T> m_A, m_B, m_C, m_D;         // STEP_DENSE
+    std::vector<T> m_F;                        // STEP_FUSED: [C D; A B]
+    std::vector<T> m_values;                   // STEP_SPARSE: CSR of [C D; A B]
+    std::vector<unsigned int> m_columns, m_rowStarts;
+
+    std::vector<T> m_z;     // [x_i; e_i]
+    std::vector<T> m_out;   // [u_i; x_{i+1}]
+
+    float m_t_s;
+    unsigned int m_i;
+    float m_t;
+};
+
+/**
+ * @class StepAutotuner
+ * @brief Chooses the fastest step kernel of each controller on this CPU.
+ * @details select() steps a TunedController of every strategy on the actual matrices, checks its outputs
+ * against StateSpaceController (relative tolerance), times it, and keeps the fastest verified strategy. The
+ * decision is cached in memory and, with a cache file, persisted as one line per controller:
+ *
+ *      <strategy> <matrix hash> <sizeof(T)> <CPU model>
+ *
+ * so that a fleet of controllers is measured once per machine type; a changed matrix has another hash.
+ ******/
+template <typename T>
+class StepAutotuner
+{
+    public:
+
+    // cachePath empty: in memory only; minSeconds: measuring time per strategy and repetition
+    StepAutotuner(const std::string& cachePath = "", const T tolerance = std::sqrt(std::numeric_limits<T>::epsilon()), const double minSeconds = 1e-3);
+
+    // Strategy of a controller (cached, or measured and cached)
+    StepStrategy select(const StateSpaceController<T>& controller, AutotuneResult<T>* result = 0);
+
+    // TunedController with the selected strategy
+    TunedController<T> tune(const StateSpaceController<T>& controller, AutotuneResult<T>* result = 0);
+
+    // Hash of the dimensions and matrices of a controller, and model of this CPU (key of the cache)
+    static std::uint64_t matrixHash(const StateSpaceController<T>& controller);
+    static std::string cpuModel();
+
+    const std::string& getCachePath() const;
+    unsigned int getCacheSize() const;
+    T getTolerance() const;
+
+    protected:
+    // Cache key of a hash on this CPU
+    std::string key(const std::uint64_t hash) const;
+
+    // Load the decisions of the cache file made on this CPU
+    void loadCache();
+
+    // Largest relative error of a strategy against StateSpaceController over a few steps
+    T verify(const StateSpaceController<T>& controller, const StepStrategy strategy, const std::vector<T>& errors, const unsigned int steps) const;
+
+    // Best time per step of a strategy
+    double measure(const StateSpaceController<T>& controller, const StepStrategy strategy, const std::vector<T>& errors, const unsigned int steps) const;
+
+    std::string m_cachePath;
+    T m_tolerance;
+    double m_minSeconds;
+    std::string m_cpuModel;
+    std::map<std::string, StepStrategy> m_cache;
+};
+
+#include "stepAutotuner.cpp"
+
+#endif  // STEPAUTOTUNER_H
@@ -0,0 +1,67 @@
+/**
+ * @file advanceTest.cpp
+ * @brief Checks of StateSpaceController::advance() against k sequential steps with the held error.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "stateSpaceController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class StateSpaceController<double>;
+
+int main()
+{
+    const vector<vector<double> > e = testErrors(60, 3);
+
+    // Gaps of different lengths between normal steps, with a changing error
+    const unsigned int gaps[7] = {0, 1, 2, 3, 5, 17, 100};
+    StateSpaceController<double> K = testController(6, 3, 2, 0.6);
+    StateSpaceController<double> reference = testController(6, 3, 2, 0.6);
+    double outputDifference = 0, stateDifference = 0;
+    bool sameClock = true;
+    for (unsigned int i=0;i<e.size();i++)
+    {
+        const unsigned int k = gaps[i % 7];
+        vector<double> u_reference;
+        for (unsigned int s=0;s<k;s++) u_reference = reference.currentOutput(e[i]);
+        const vector<double> u = K.advance(k, e[i]);
+        if (k > 0)
+        {
+            outputDifference = max(outputDifference, maxDifference(u, u_reference));
+        }
+        stateDifference = max(stateDifference, maxDifference(K.getX_i(), reference.getX_i()));
+        sameClock = sameClock && fabs(K.getTime() - reference.getTime()) < 1e-4;
+
+        // Normal step between the gaps
+        const vector<double>& e_next = e[(i + 7) % e.size()];
+        outputDifference = max(outputDifference, maxDifference(K.currentOutput(e_next), reference.currentOutput(e_next)));
+    }
+    check(outputDifference < 1e-10 && stateDifference < 1e-10, "outputs and states of advance()");
+    check(sameClock, "time of advance()");
+
+    // advance(0) changes nothing and returns the current output
+    const vector<double> u_current = K.currentOutput(e[0]);
+    const vector<double> x = K.getX_i();
+    const float t = K.getTime();
+    check(K.advance(0, e[1]) == u_current && K.getX_i() == x && K.getTime() == t, "advance(0)");
+
+    // Precomputed powers give the same result, and a replaced A is used by the next advance()
+    StateSpaceController<double> prepared = testController(6, 3, 2, 0.6);
+    StateSpaceController<double> stepped = testController(6, 3, 2, 0.6);
+    prepared.prepareAdvance(1000);
+    vector<double> u_stepped;
+    for (unsigned int s=0;s<1000;s++) u_stepped = stepped.currentOutput(e[3]);
+    check(maxDifference(prepared.advance(1000, e[3]), u_stepped) < 1e-10, "prepared powers");
+
+    QSMatrix<double> A = prepared.getA();
+    A(0,0) = 0.2;
+    prepared.setA(A);
+    stepped.setA(A);
+    for (unsigned int s=0;s<33;s++) u_stepped = stepped.currentOutput(e[4]);
+    check(maxDifference(prepared.advance(33, e[4]), u_stepped) < 1e-10 && maxDifference(prepared.getX_i(), stepped.getX_i()) < 1e-10, "powers of a replaced A");
+
+    return testResult();
+}
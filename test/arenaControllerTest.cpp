@@ -0,0 +1,73 @@
+/**
+ * @file arenaControllerTest.cpp
+ * @brief Checks of ArenaStateSpaceController: same steps as StateSpaceController from one aligned block.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "arenaController.h"
+#include "testCheck.h"
+
+#include <cstdint>
+
+using namespace std;
+
+template class ArenaStateSpaceController<double>;
+template class ArenaStateSpaceController<float>;
+
+int main()
+{
+    const StateSpaceController<double> K = testController(6, 3, 2);
+    const vector<vector<double> > e = testErrors(200, 3);
+
+    // A bank taken from one monotonic arena
+    std::pmr::monotonic_buffer_resource arena(8 * ArenaStateSpaceController<double>::blockSize(6, 3, 2));
+    vector<ArenaStateSpaceController<double> > bank;
+    bank.reserve(4);
+    for (unsigned int k=0;k<4;k++) bank.emplace_back(K, &arena);
+
+    check(bank[0].getBlockSize() == ArenaStateSpaceController<double>::blockSize(6, 3, 2), "block size");
+    bool aligned = true, contiguous = true;
+    for (unsigned int k=0;k<4;k++)
+    {
+        aligned = aligned && (uintptr_t)bank[k].getBlock() % ARENA_ALIGNMENT == 0 && (uintptr_t)bank[k].getState() % ARENA_ALIGNMENT == 0;
+        if (k > 0) contiguous = contiguous && (const char*)bank[k].getBlock() == (const char*)bank[k-1].getBlock() + bank[k-1].getBlockSize();
+    }
+    check(aligned, "cache line aligned sections");
+    check(contiguous, "bank contiguous in the arena");
+
+    // Same outputs, states and time as StateSpaceController, through step() and currentOutput()
+    StateSpaceController<double> reference(K);
+    double difference = 0;
+    for (unsigned int i=0;i<e.size();i++)
+    {
+        const vector<double> u = reference.currentOutput(e[i]);
+        const double* u_step = bank[0].step(e[i].data());
+        difference = max(difference, maxDifference(vector<double>(u_step, u_step + 2), u));
+        difference = max(difference, maxDifference(bank[1].currentOutput(e[i]), u));
+    }
+    check(difference < 1e-12, "outputs");
+    check(maxDifference(bank[0].getX_i(), reference.getX_i()) < 1e-12 && bank[0].getStepCount() == e.size() && bank[0].getTime() == reference.getTime(), "state and time");
+
+    // Comparator: e = r - y
+    StateSpaceController<double> comparator(K);
+    const vector<double> r = {1, 2, 3}, y = {0.5, -1, 2};
+    check(maxDifference(bank[2].currentOutput(r, y), comparator.currentOutput(r, y)) < 1e-12, "comparator");
+
+    // Copies get their own block from the same resource, moves take the block
+    ArenaStateSpaceController<double> copy(bank[0]);
+    const void* block = copy.getBlock();
+    ArenaStateSpaceController<double> moved(std::move(copy));
+    check(moved.getBlock() == block && moved.getResource() == &arena && moved.getX_i() == bank[0].getX_i(), "copy and move");
+
+    bank[0].reset();
+    check(bank[0].getX_i() == vector<double>(6, 0) && bank[0].getStepCount() == 0, "reset");
+
+    // Huge page resource: blocks mapped with the requested alignment
+    HugePageMemoryResource pages;
+    void* p = pages.allocate(1000, 4096);
+    check(p != 0 && (uintptr_t)p % 4096 == 0, "huge page resource");
+    pages.deallocate(p, 1000, 4096);
+
+    return testResult();
+}
@@ -0,0 +1,92 @@
+/**
+ * @file asyncControllerTest.cpp
+ * @brief Checks of the coroutine step API on a FakeControllerClock: outputs, output buffer, missed samples.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "asyncController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class MeasurementChannel<double>;
+template class AsyncController<double>;
+
+/**
+ * @brief Publishes samples on a channel, "perPeriod" samples every "period" seconds.
+ ******/
+static ControllerTask sensor(ControllerExecutor& executor, MeasurementChannel<double>& channel, const vector<vector<double> >& samples, const double period, const unsigned int perPeriod)
+{
+    for (unsigned int i=0;i<samples.size();i++)
+    {
+        if (i % perPeriod == 0)
+        {
+            co_await executor.sleepFor(period);
+        }
+        channel.publish(samples[i]);
+    }
+}
+
+/**
+ * @brief Steps the controller "steps" times with the channel (and the reference r if not empty).
+ ******/
+static ControllerTask controlLoop(AsyncController<double>& K, MeasurementChannel<double>& channel, const vector<double>& r, const unsigned int steps, vector<vector<double> >& outputs, bool& sameBuffer)
+{
+    for (unsigned int i=0;i<steps;i++)
+    {
+        const vector<double>& u = r.empty() ? co_await K.step(channel) : co_await K.step(r, channel);
+        sameBuffer = sameBuffer && &u == &K.getOutput();
+        outputs.push_back(u);
+    }
+}
+
+int main()
+{
+    const vector<vector<double> > e = testErrors(40, 2);
+
+    // One sample per period: every sample is used, in order, at the time of the clock
+    {
+        FakeControllerClock clock;
+        ControllerExecutor executor(&clock);
+        MeasurementChannel<double> channel(executor, 2);
+        StateSpaceController<double> controller = testController(4, 2, 2);
+        AsyncController<double> K(controller);
+        vector<vector<double> > outputs;
+        bool sameBuffer = true;
+        executor.spawn(controlLoop(K, channel, vector<double>(), e.size(), outputs, sameBuffer));
+        executor.spawn(sensor(executor, channel, e, 0.01, 1));
+        executor.run();
+
+        StateSpaceController<double> reference = testController(4, 2, 2);
+        double difference = outputs.size() == e.size() ? 0 : INFINITY;
+        for (unsigned int i=0;i<outputs.size();i++) difference = max(difference, maxDifference(outputs[i], reference.currentOutput(e[i])));
+        check(difference < 1e-12, "outputs");
+        check(sameBuffer && K.getOutput() == outputs.back(), "output buffer of the controller");
+        check(K.getStepCount() == e.size() && K.getMissedSamples() == 0, "no missed sample");
+        check(fabs(clock.now() - 0.01 * e.size()) < 1e-9 && executor.getTaskCount() == 0, "clock and finished tasks");
+    }
+
+    // Two samples per period: the loop steps with the latest one and counts the other as missed
+    {
+        FakeControllerClock clock;
+        ControllerExecutor executor(&clock);
+        MeasurementChannel<double> channel(executor, 2);
+        StateSpaceController<double> controller = testController(4, 2, 2);
+        AsyncController<double> K(controller);
+        const vector<double> r = {0.5, -1};
+        vector<vector<double> > outputs;
+        bool sameBuffer = true;
+        executor.spawn(controlLoop(K, channel, r, e.size() / 2, outputs, sameBuffer));
+        executor.spawn(sensor(executor, channel, e, 0.01, 2));
+        executor.run();
+
+        StateSpaceController<double> reference = testController(4, 2, 2);
+        double difference = outputs.size() == e.size() / 2 ? 0 : INFINITY;
+        for (unsigned int i=0;i<outputs.size();i++) difference = max(difference, maxDifference(outputs[i], reference.currentOutput(r, e[2 * i + 1])));
+        check(difference < 1e-12, "outputs with the latest sample and a reference");
+        check(K.getStepCount() == e.size() / 2 && K.getMissedSamples() == e.size() / 2 - 1, "missed samples");
+    }
+
+    return testResult();
+}
@@ -0,0 +1,67 @@
+/**
+ * @file continuousTest.cpp
+ * @brief Checks of the discretizations of ContinuousStateSpaceController against analytic solutions.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "continuousStateSpaceController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class ContinuousStateSpaceController<double>;
+
+int main()
+{
+    // exp of a rotation generator
+    const double w = 3, t = 0.4;
+    QSMatrix<double> R(2, 2, 0);
+    R(0,1) = w * t;
+    R(1,0) = -w * t;
+    const QSMatrix<double> rotation = expm(R);
+    check(fabs(rotation(0,0) - cos(w * t)) < 1e-12 && fabs(rotation(0,1) - sin(w * t)) < 1e-12 && fabs(rotation(1,0) + sin(w * t)) < 1e-12, "expm");
+
+    // dx/dt = -2x + 3e, u = x: x(t) = 1.5*(1 - exp(-2t)) for e = 1 from x = 0
+    const QSMatrix<double> Ac(1, 1, -2), Bc(1, 1, 3), Cc(1, 1, 1), Dc(1, 1, 0);
+    const StateSpaceRealization<double> zoh = continuousToDiscrete(Ac, Bc, Cc, Dc, 0.01f, ZOH);
+    check(fabs(zoh.A(0,0) - exp(-2 * (double)0.01f)) < 1e-12 && fabs(zoh.B(0,0) - 1.5 * (1 - exp(-2 * (double)0.01f))) < 1e-12, "ZOH matrices");
+
+    // ZOH is exact at the samples, and keeps the state across time step changes
+    ContinuousStateSpaceController<double> K(Ac, Bc, Cc, Dc, 0.01f, ZOH);
+    const vector<double> e(1, 1);
+    double time = 0;
+    for (unsigned int i=0;i<50;i++)
+    {
+        K.currentOutput(e);
+        time += (double)0.01f;
+    }
+    K.setTimeStep(0.02f);
+    for (unsigned int i=0;i<25;i++)
+    {
+        K.currentOutput(e);
+        time += (double)0.02f;
+    }
+    check(fabs(K.getX_i()[0] - 1.5 * (1 - exp(-2 * time))) < 1e-9, "ZOH exact with a time step change");
+
+    // Each time step is discretized once
+    K.setTimeStep(0.01f);
+    check(K.getCacheSize() == 2 && fabs(K.getA()(0,0) - zoh.A(0,0)) < 1e-15, "discretization cache");
+    K.setTimeStep(0.05f);
+    check(K.getCacheSize() == 3, "new time step cached");
+    K.clearCache();
+    check(K.getCacheSize() == 0, "cache cleared");
+
+    // Tustin keeps the continuous DC gain (1.5)
+    ContinuousStateSpaceController<double> T(Ac, Bc, Cc, Dc, 0.05f, TUSTIN);
+    vector<double> u;
+    for (unsigned int i=0;i<2000;i++) u = T.currentOutput(e);
+    check(fabs(u[0] - 1.5) < 1e-9, "Tustin DC gain");
+
+    // Tustin maps s = 2/t_s*(z - 1)/(z + 1): the pole -2 becomes (1 - t_s)/(1 + t_s)
+    const StateSpaceRealization<double> tustin = continuousToDiscrete(Ac, Bc, Cc, Dc, 0.05f, TUSTIN);
+    const double ts = 0.05f;
+    check(fabs(tustin.A(0,0) - (1 - ts) / (1 + ts)) < 1e-12, "Tustin pole");
+
+    return testResult();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file controllerCheckpointTest.cpp
+ * @brief Checks of the controller checkpoints: round trips through a buffer, a file and a mirror, refused checkpoints.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "controllerCheckpoint.h"
+#include "testCheck.h"
+
+#include <unistd.h>
+
+using namespace std;
+
+template class CheckpointFile<double>;
+template class CheckpointMirror<double>;
+
+/**
+ * @return Largest difference between the next outputs of two controllers stepped with the same errors.
+ ******/
+static double continuationDifference(StateSpaceController<double>& a, StateSpaceController<double>& b)
+{
+    const vector<vector<double> > e = testErrors(20, a.getNe());
+    double difference = 0;
+    for (unsigned int i=0;i<e.size();i++) difference = max(difference, maxDifference(a.currentOutput(e[i]), b.currentOutput(e[i])));
+    return difference;
+}
+
+int main()
+{
+    StateSpaceController<double> K = testController(5, 2, 2);
+    const vector<vector<double> > e = testErrors(30, 2);
+    for (unsigned int i=0;i<e.size();i++) K.currentOutput(e[i]);
+
+    // State checkpoint restored into a controller of the same matrices
+    vector<uint64_t> buffer((K.checkpointSize() + 7) / 8);
+    check(K.saveCheckpoint(buffer.data()) == K.checkpointSize(), "checkpoint size");
+    StateSpaceController<double> restarted = testController(5, 2, 2);
+    check(restarted.restoreCheckpoint(buffer.data(), K.checkpointSize()), "state restored");
+    check(restarted.getX_i() == K.getX_i() && restarted.getTime() == K.getTime(), "restored state and time");
+    StateSpaceController<double> continued(K);
+    check(continuationDifference(continued, restarted) == 0, "restored controller continues the loop");
+
+    // Refused: other matrices, corrupted or truncated checkpoints (controller unchanged)
+    StateSpaceController<double> other = testController(5, 2, 2, 0.3);
+    check(!other.restoreCheckpoint(buffer.data(), K.checkpointSize()) && other.getX_i() == vector<double>(5, 0), "other matrices refused");
+    vector<uint64_t> corrupted(buffer);
+    ((char*)corrupted.data())[K.checkpointSize() - 3] ^= 0x10;
+    check(!restarted.restoreCheckpoint(corrupted.data(), K.checkpointSize()), "corrupted checkpoint refused");
+    check(!restarted.restoreCheckpoint(buffer.data(), K.checkpointSize() - 8), "truncated checkpoint refused");
+
+    // Checkpoint with the matrices restored into any controller
+    vector<uint64_t> full((K.checkpointSize(true) + 7) / 8);
+    K.saveCheckpoint(full.data(), true);
+    StateSpaceController<double> standby = testController(2, 1, 1);
+    check(standby.restoreCheckpoint(full.data(), K.checkpointSize(true)) && standby.getNx() == 5 && standby.getX_i() == K.getX_i(), "matrices restored");
+    StateSpaceController<double> continuedFull(K);
+    check(continuationDifference(continuedFull, standby) == 0, "controller restored with its matrices continues the loop");
+
+    // The cached hash does not keep a replaced matrix alive
+    StateSpaceController<double> replaced = testController(5, 2, 2);
+    vector<uint64_t> scratch((replaced.checkpointSize() + 7) / 8);
+    replaced.saveCheckpoint(scratch.data());
+    const shared_ptr<const QSMatrix<double> > A_old = replaced.getSharedA();
+    replaced.setA(QSMatrix<double>(5, 5, 0.1));
+    replaced.saveCheckpoint(scratch.data());
+    check(A_old.use_count() == 1, "replaced matrix released");
+    check(!restarted.restoreCheckpoint(scratch.data(), replaced.checkpointSize()), "checkpoint of replaced matrices refused");
+
+    // File: the last checkpoint is loaded after a restart
+    const string path = "/tmp/ssc_checkpoint_test_" + to_string(getpid());
+    {
+        CheckpointFile<double> file(path, K);
+        check(file.isOpen(), "file open");
+        StateSpaceController<double> looping(K);
+        for (unsigned int i=0;i<e.size();i++)
+        {
+            looping.currentOutput(e[i]);
+            check(file.checkpoint(looping), "checkpoint taken");
+        }
+        file.flush();
+        check(file.getWrittenCount() + file.getDroppedCount() == e.size() && file.getWrittenCount() > 0, "checkpoints written or dropped");
+
+        StateSpaceController<double> loaded = testController(5, 2, 2);
+        check(CheckpointFile<double>::load(path, loaded) && loaded.getX_i() == looping.getX_i() && loaded.getTime() == looping.getTime(), "file loaded");
+    }
+    remove(path.c_str());
+
+    // Mirror: a standby restores the latest checkpoint of the primary
+    const string name = "/ssc_checkpoint_test_" + to_string(getpid());
+    CheckpointMirror<double> primary(name, K.checkpointSize(true));
+    CheckpointMirror<double> secondary(name);
+    check(primary.isOpen() && secondary.isOpen(), "mirror open");
+    StateSpaceController<double> mirrored = testController(5, 2, 2);
+    check(!secondary.restore(mirrored), "nothing published yet");
+    check(primary.publish(K, true) && primary.getSequence() == 1, "published");
+    check(secondary.restore(mirrored) && mirrored.getX_i() == K.getX_i(), "mirror restored");
+
+    return testResult();
+}
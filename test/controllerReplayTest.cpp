@@ -0,0 +1,151 @@
+/**
+ * @file controllerReplayTest.cpp
+ * @brief Checks of controller_replay on generated CSV and binary columnar logs against StateSpaceController.
+ * @details Run with the path of controller_replay as argument (ctest passes it).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "stateSpaceController.h"
+#include "testCheck.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+template class StateSpaceController<double>;
+
+/**
+ * @brief Header of a binary columnar log (same layout as in controllerReplay.cpp).
+ ******/
+struct LogHeader
+{
+    char magic[8];
+    uint32_t columns;
+    uint32_t scalarSize;
+    uint64_t rows;
+};
+
+/**
+ * @brief Writes a binary columnar log: header, then each column.
+ ******/
+static void writeColumnar(const string& path, const vector<vector<double> >& samples, const uint64_t rows)
+{
+    LogHeader header = {"SSCLOG1", (uint32_t)samples[0].size(), sizeof(double), rows};
+    ofstream file(path.c_str(), ios::binary);
+    file.write((const char*)&header, sizeof(header));
+    for (unsigned int c=0;c<header.columns;c++)
+    {
+        for (unsigned int i=0;i<samples.size();i++) file.write((const char*)&samples[i][c], sizeof(double));
+    }
+}
+
+/**
+ * @brief Runs controller_replay; returns its exit code.
+ ******/
+static int replay(const string& tool, const string& arguments)
+{
+    const string command = "\"" + tool + "\" " + arguments + " > /dev/null";
+    const int status = system(command.c_str());
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        cout << "Usage: controller_replay_test <path of controller_replay>" << endl;
+        return 1;
+    }
+    const string tool = argv[1];
+    const string directory = "/tmp/ssc_replay_test_" + to_string(getpid());
+    mkdir(directory.c_str(), 0700);
+
+    // Controller file (format of StateSpaceController::help())
+    const StateSpaceController<double> K = testController(4, 2, 2);
+    {
+        ofstream file((directory + "/K.dat").c_str());
+        file << setprecision(17) << K.getTimeStep() << endl << 4 << endl << 2 << endl << 2 << endl;
+        for (const QSMatrix<double>* M : {&K.getA(), &K.getB(), &K.getC(), &K.getD()})
+        {
+            for (unsigned int i=0;i<M->get_rows();i++) for (unsigned int j=0;j<M->get_cols();j++) file << (*M)(i,j) << endl;
+        }
+    }
+    StateSpaceController<double> loaded((directory + "/K.dat").c_str());
+
+    // Logs: e_i in CSV with a header line, r_i and y_i in binary columns
+    const vector<vector<double> > e = testErrors(1000, 2);
+    {
+        ofstream csv((directory + "/errors.csv").c_str());
+        csv << "e0,e1" << endl << setprecision(17);
+        for (unsigned int i=0;i<e.size();i++) csv << e[i][0] << "," << e[i][1] << endl;
+    }
+    vector<vector<double> > ry(e.size());
+    for (unsigned int i=0;i<e.size();i++) ry[i] = {e[i][0], e[i][1], 0.1 * i, -0.05};
+    writeColumnar(directory + "/signals.bin", ry, ry.size());
+
+    // Small chunks so that several chunks are written
+    check(replay(tool, "-j 2 -n 100 -o " + directory + " -c " + directory + "/K.dat " + directory + "/errors.csv " + directory + "/signals.bin") == 0, "replay");
+
+    // CSV output: one line of nu values per sample
+    StateSpaceController<double> reference(loaded);
+    ifstream csvOutput((directory + "/errors.u.csv").c_str());
+    double difference = 0;
+    unsigned int lines = 0;
+    string line;
+    while (getline(csvOutput, line))
+    {
+        double u0 = 0, u1 = 0;
+        char comma = 0;
+        istringstream(line) >> u0 >> comma >> u1;
+        const vector<double> u = reference.currentOutput(e[lines]);
+        difference = max(difference, maxDifference(vector<double>({u0, u1}), u));
+        lines++;
+    }
+    check(lines == e.size() && difference == 0, "CSV outputs");
+
+    // Binary output: header with nu columns, then the columns of u
+    reference = loaded;
+    reference.reset();
+    ifstream binOutput((directory + "/signals.u.bin").c_str(), ios::binary);
+    LogHeader header;
+    binOutput.read((char*)&header, sizeof(header));
+    check(binOutput && header.columns == 2 && header.rows == e.size() && memcmp(header.magic, "SSCLOG1", 8) == 0, "binary header");
+    vector<double> columns(2 * e.size());
+    binOutput.read((char*)columns.data(), columns.size() * sizeof(double));
+    difference = 0;
+    for (unsigned int i=0;i<e.size();i++)
+    {
+        const vector<double> u = reference.currentOutput({ry[i][0], ry[i][1]}, {ry[i][2], ry[i][3]});
+        difference = max(difference, maxDifference(vector<double>({columns[i], columns[e.size() + i]}), u));
+    }
+    check(binOutput && difference == 0, "binary outputs");
+
+    // A header announcing more rows than the file holds is refused (also when the byte count overflows)
+    writeColumnar(directory + "/short.bin", ry, ry.size() + 1);
+    writeColumnar(directory + "/huge.bin", ry, UINT64_MAX / 8);
+    check(replay(tool, "-o " + directory + " -c " + directory + "/K.dat " + directory + "/short.bin") != 0, "truncated log refused");
+    check(replay(tool, "-o " + directory + " -c " + directory + "/K.dat " + directory + "/huge.bin") != 0, "overflowing row count refused");
+
+    // An output that would overwrite a log is refused before anything is written
+    check(replay(tool, "-o " + directory + " -c " + directory + "/K.dat " + directory + "/errors.csv " + directory + "/errors.u.csv") != 0, "output overwriting a log refused");
+    ifstream kept((directory + "/errors.u.csv").c_str());
+    lines = 0;
+    while (getline(kept, line)) lines++;
+    check(lines == e.size(), "log left untouched");
+
+    for (const char* name : {"K.dat", "errors.csv", "signals.bin", "errors.u.csv", "signals.u.bin", "short.bin", "huge.bin", "short.u.bin", "huge.u.bin"})
+    {
+        remove((directory + "/" + name).c_str());
+    }
+    rmdir(directory.c_str());
+
+    return testResult();
+}
@@ -0,0 +1,57 @@
+/**
+ * @file fixedPointTest.cpp
+ * @brief Checks of FixedPointStateSpaceController against the double controller it is built from.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "fixedPointController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class FixedPointStateSpaceController<int16_t>;
+template class FixedPointStateSpaceController<int32_t>;
+
+int main()
+{
+    const StateSpaceController<double> K = testController(6, 2, 2);
+    const vector<vector<double> > e = testErrors(500, 2);
+
+    // Q31 follows the reference closely, Q15 within its resolution
+    Q31StateSpaceController q31(K, 2, 20, 20);
+    const QuantizationReport report31 = q31.compareWithReference(e);
+    check(report31.steps == e.size() && report31.maxOutputError < 1e-6 && report31.saturations == 0, "Q31 output error");
+
+    Q15StateSpaceController q15(K, 2, 20, 20);
+    const QuantizationReport report15 = q15.compareWithReference(e);
+    check(report15.maxOutputError < 0.05 && report15.maxOutputError > report31.maxOutputError, "Q15 output error");
+
+    // Each matrix gets the largest scaling representing its biggest coefficient (B: 1, D: 0.3)
+    const QuantizationReport scaling = q15.quantizationReport();
+    check(scaling.fracB == 14 && scaling.fracD == 16, "per-matrix scaling");
+
+    // Steps match the reference step by step
+    StateSpaceController<double> reference(K);
+    q31.reset();
+    double difference = 0;
+    for (unsigned int i=0;i<e.size();i++)
+    {
+        difference = max(difference, maxDifference(q31.currentOutput(e[i]), reference.currentOutput(e[i])));
+    }
+    check(difference < 1e-6 && fabs(q31.getTime() - reference.getTime()) < 1e-6, "Q31 steps");
+
+    // Raw Q15 errors saturate to the symmetric range: -32768 acts as -32767
+    Q15StateSpaceController low(K, 2, 20, 20), high(K, 2, 20, 20);
+    const vector<int16_t> u_low = low.currentOutputRaw(vector<int16_t>(2, -32768));
+    const vector<int16_t> u_high = high.currentOutputRaw(vector<int16_t>(2, -32767));
+    check(u_low == u_high && low.getX_i() == high.getX_i(), "raw Q15 saturation");
+
+    // A short error vector is refused without stepping
+    const float time = q31.getTime();
+    const vector<double> previous = q31.getX_i();
+    q31.currentOutput(vector<double>(1, 0.5));
+    check(q31.getTime() == time && q31.getX_i() == previous, "error vector size");
+
+    return testResult();
+}
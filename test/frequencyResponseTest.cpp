@@ -0,0 +1,64 @@
+/**
+ * @file frequencyResponseTest.cpp
+ * @brief Checks of FrequencyResponse against a direct solve of (zI - A)^-1*B at each frequency.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "frequencyResponse.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class FrequencyResponse<double>;
+
+int main()
+{
+    const StateSpaceController<double> K = testController(7, 3, 2, 0.6);
+    const FrequencyResponse<double> response(K);
+
+    // Hessenberg form: A = Q*H*Q', H zero below its first subdiagonal
+    const QSMatrix<double> H = response.getHessenberg(), Q = response.getQ();
+    const QSMatrix<double> A = Q * H * Q.transpose();
+    double reconstruction = 0, belowSubdiagonal = 0;
+    for (unsigned int i=0;i<K.getNx();i++)
+    {
+        for (unsigned int j=0;j<K.getNx();j++)
+        {
+            reconstruction = max(reconstruction, fabs(A(i,j) - K.getA()(i,j)));
+            if (i > j + 1) belowSubdiagonal = max(belowSubdiagonal, fabs(H(i,j)));
+        }
+    }
+    check(reconstruction < 1e-12 && belowSubdiagonal == 0, "Hessenberg reduction");
+
+    const vector<double> w = FrequencyResponse<double>::logspace(0.1, response.getNyquistFrequency(), 50);
+    check(w.size() == 50 && fabs(w[0] - 0.1) < 1e-12 && fabs(w[49] - M_PI / (double)0.01f) < 1e-9, "logspace up to Nyquist");
+
+    // Every gain matches the direct solve, with one thread or several
+    const vector<QSMatrix<complex<double> > > single = response.evaluate(w, 1);
+    const vector<QSMatrix<complex<double> > > threaded = response.evaluate(w, 4);
+    double error = 0, threadDifference = 0;
+    for (unsigned int k=0;k<w.size();k++)
+    {
+        const vector<complex<double> > G = directFrequencyResponse(K, w[k]);
+        for (unsigned int row=0;row<K.getNu();row++)
+        {
+            for (unsigned int col=0;col<K.getNe();col++)
+            {
+                error = max(error, abs(single[k](row, col) - G[row * K.getNe() + col]));
+                threadDifference = max(threadDifference, abs(single[k](row, col) - threaded[k](row, col)));
+            }
+        }
+    }
+    check(single.size() == w.size() && error < 1e-10, "gains against the direct solve");
+    check(threaded.size() == w.size() && threadDifference == 0, "threaded evaluation");
+
+    // DC gain: C*(I - A)^-1*B + D, also reached by stepping with a constant error
+    StateSpaceController<double> stepped(K);
+    vector<double> u;
+    for (unsigned int i=0;i<500;i++) u = stepped.currentOutput(vector<double>{1, 0, 0});
+    const QSMatrix<complex<double> > G0 = response.evaluate(0.0);
+    check(fabs(G0(0,0).real() - u[0]) < 1e-10 && fabs(G0(1,0).real() - u[1]) < 1e-10 && fabs(G0(0,0).imag()) < 1e-12, "DC gain");
+
+    return testResult();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file gemmTest.cpp
+ * @brief Checks of the blocked, multithreaded gemm() against a triple loop (edge blocks, strides, alpha, beta).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "QSMatrix.h"
+#include "gemm.h"
+#include "testCheck.h"
+
+using namespace std;
+
+/**
+ * @return Largest difference between gemm() and the triple loop for C = alpha*A*B + beta*C.
+ ******/
+template <typename T>
+static double gemmError(const unsigned int m, const unsigned int n, const unsigned int k, const T alpha, const T beta, const unsigned int threads)
+{
+    // Leading dimensions larger than the matrices
+    const unsigned int lda = k + 3, ldb = n + 1, ldc = n + 2;
+    vector<T> A(m * lda), B(k * ldb), C(m * ldc), reference;
+    for (unsigned int i=0;i<A.size();i++) A[i] = (T)sin(0.1 * i);
+    for (unsigned int i=0;i<B.size();i++) B[i] = (T)cos(0.07 * i);
+    for (unsigned int i=0;i<C.size();i++) C[i] = (T)(0.01 * (i % 13));
+    reference = C;
+
+    for (unsigned int i=0;i<m;i++)
+    {
+        for (unsigned int j=0;j<n;j++)
+        {
+            double sum = 0;
+            for (unsigned int p=0;p<k;p++) sum += (double)A[i * lda + p] * B[p * ldb + j];
+            reference[i * ldc + j] = (T)(alpha * sum + beta * reference[i * ldc + j]);
+        }
+    }
+
+    gemm(m, n, k, alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldc, threads);
+
+    // Padding between the rows of C must be left untouched
+    double error = 0;
+    for (unsigned int i=0;i<C.size();i++) error = max(error, (double)fabs(C[i] - reference[i]) / (1 + fabs((double)reference[i])));
+    return error;
+}
+
+int main()
+{
+    // Sizes around the register and cache blocks, square and skinny
+    const unsigned int shapes[6][3] = {{1, 1, 1}, {3, 5, 7}, {17, 13, 9}, {64, 64, 64}, {130, 257, 71}, {301, 2, 300}};
+    for (unsigned int s=0;s<6;s++)
+    {
+        const unsigned int m = shapes[s][0], n = shapes[s][1], k = shapes[s][2];
+        const string name = " " + to_string(m) + "x" + to_string(n) + "x" + to_string(k);
+        check(gemmError<double>(m, n, k, 1.0, 0.0, 1) < 1e-12, "double" + name);
+        check(gemmError<double>(m, n, k, -0.5, 2.0, 4) < 1e-12, "double alpha, beta, 4 threads" + name);
+        check(gemmError<float>(m, n, k, 1.5f, 1.0f, 3) < 1e-4, "float" + name);
+    }
+
+    // QSMatrix::operator* goes through gemm()
+    QSMatrix<double> A(40, 30, 0), B(30, 20, 0);
+    for (unsigned int i=0;i<40;i++) for (unsigned int j=0;j<30;j++) A(i,j) = sin(i - 2.0 * j);
+    for (unsigned int i=0;i<30;i++) for (unsigned int j=0;j<20;j++) B(i,j) = cos(i + 0.5 * j);
+    const QSMatrix<double> C = A * B;
+    double error = 0;
+    for (unsigned int i=0;i<40;i++)
+    {
+        for (unsigned int j=0;j<20;j++)
+        {
+            double sum = 0;
+            for (unsigned int p=0;p<30;p++) sum += A(i,p) * B(p,j);
+            error = max(error, fabs(C(i,j) - sum));
+        }
+    }
+    check(C.get_rows() == 40 && C.get_cols() == 20 && error < 1e-12, "QSMatrix product");
+
+    return testResult();
+}
@@ -0,0 +1,90 @@
+/**
+ * @file idleModeTest.cpp
+ * @brief Checks of the idle mode: rest only near the fixed point of the error, outputs within the tolerance, wake-up.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "stateSpaceController.h"
+#include "continuousStateSpaceController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class StateSpaceController<double>;
+template class ContinuousStateSpaceController<double>;
+
+/**
+ * @return Scalar controller x_{i+1} = a*x_i + b*e_i, u_i = x_i.
+ ******/
+static StateSpaceController<double> scalarController(const double a, const double b)
+{
+    return StateSpaceController<double>(QSMatrix<double>(1, 1, a), QSMatrix<double>(1, 1, b), QSMatrix<double>(1, 1, 1), QSMatrix<double>(1, 1, 0), 0.01f);
+}
+
+/**
+ * @brief Steps an idle mode controller and a reference with the same errors.
+ * @return Largest output difference.
+ ******/
+static double idleDifference(StateSpaceController<double>& idle, StateSpaceController<double>& reference, const vector<double>& e, const unsigned int steps)
+{
+    double difference = 0;
+    for (unsigned int i=0;i<steps;i++) difference = max(difference, maxDifference(idle.currentOutput(e), reference.currentOutput(e)));
+    return difference;
+}
+
+int main()
+{
+    // Integrator with a small error: the state keeps moving by 1e-7 per step, it must never rest
+    StateSpaceController<double> integrator = scalarController(1, 1e-4), integratorReference = scalarController(1, 1e-4);
+    integrator.enableIdleMode(1e-3, 1e-6);
+    check(idleDifference(integrator, integratorReference, {1e-3}, 20000) < 1e-12 && integrator.getSkippedSteps() == 0, "integrator with an error never rests");
+
+    // Integrator without error: at its fixed point, it rests
+    StateSpaceController<double> still = scalarController(1, 1e-4), stillReference = scalarController(1, 1e-4);
+    still.enableIdleMode(1e-3, 1e-6);
+    check(idleDifference(still, stillReference, {0}, 20) == 0 && still.isAtRest() && still.getSkippedSteps() > 0, "integrator without error rests");
+
+    // Slow mode (0.999): rest only once the state is within the tolerance of its fixed point (x = 1000)
+    const double tolerance = 1e-2;
+    StateSpaceController<double> slow = scalarController(0.999, 1), slowReference = scalarController(0.999, 1);
+    slow.enableIdleMode(tolerance, 1e-6);
+    check(idleDifference(slow, slowReference, {1}, 3000) < 1e-9 && !slow.isAtRest(), "no rest far from the fixed point");
+    double difference = idleDifference(slow, slowReference, {1}, 20000);
+    check(slow.isAtRest() && slow.getSkippedSteps() > 0 && fabs(slow.getX_i()[0] - 1000) <= tolerance, "rest near the fixed point");
+    check(difference <= tolerance, "outputs at rest within the tolerance");
+
+    // Errors within the threshold stay at rest, a larger one wakes the controller up
+    const unsigned long long skipped = slow.getSkippedSteps();
+    slow.currentOutput({1 + 1e-7});
+    check(slow.isAtRest() && slow.getSkippedSteps() == skipped + 1, "error within the threshold");
+    slowReference.currentOutput({1 + 1e-7});
+    difference = idleDifference(slow, slowReference, {2}, 100);
+    check(!slow.isAtRest() && difference <= tolerance && slow.getTime() == slowReference.getTime(), "wake-up");
+
+    // Multivariable controller: outputs at rest within the tolerance times the norm of C
+    StateSpaceController<double> K = testController(5, 2, 2, 0.9), reference = testController(5, 2, 2, 0.9);
+    K.enableIdleMode(1e-6, 1e-9);
+    double C_norm = 0;
+    for (unsigned int row=0;row<2;row++)
+    {
+        double sum = 0;
+        for (unsigned int col=0;col<5;col++) sum += fabs(K.getC()(row, col));
+        C_norm = max(C_norm, sum);
+    }
+    check(idleDifference(K, reference, {0.3, -0.2}, 2000) <= 1e-6 * C_norm && K.isAtRest(), "multivariable rest");
+
+    // Continuous controller with a variable time step
+    ContinuousStateSpaceController<double> continuous(QSMatrix<double>(1, 1, -1), QSMatrix<double>(1, 1, 1), QSMatrix<double>(1, 1, 1), QSMatrix<double>(1, 1, 0), 0.01f);
+    ContinuousStateSpaceController<double> continuousReference(continuous);
+    continuous.enableIdleMode(1e-4, 1e-6);
+    difference = 0;
+    for (unsigned int i=0;i<3000;i++)
+    {
+        const float dt = 0.01f + 0.002f * (i % 3);
+        difference = max(difference, maxDifference(continuous.currentOutput({0.5}, dt), continuousReference.currentOutput({0.5}, dt)));
+    }
+    check(continuous.isAtRest() && difference <= 1e-4, "continuous rest with a variable time step");
+
+    return testResult();
+}
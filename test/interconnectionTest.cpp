@@ -0,0 +1,93 @@
+/**
+ * @file interconnectionTest.cpp
+ * @brief Checks of series, parallel, feedback and append against the controllers stepped separately, and of minimal realizations.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "interconnection.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template StateSpaceController<double> series(const StateSpaceController<double>&, const StateSpaceController<double>&, const bool);
+template StateSpaceController<double> parallel(const StateSpaceController<double>&, const StateSpaceController<double>&, const bool);
+template StateSpaceController<double> feedback(const StateSpaceController<double>&, const StateSpaceController<double>&, const int, const bool);
+template StateSpaceController<double> append(const StateSpaceController<double>&, const StateSpaceController<double>&, const bool);
+template StateSpaceController<double> minimalRealization(const StateSpaceController<double>&, const double);
+
+/**
+ * @return Largest difference between the frequency responses of two controllers at a few frequencies.
+ ******/
+static double responseDifference(const StateSpaceController<double>& a, const StateSpaceController<double>& b)
+{
+    double difference = 0;
+    for (const double w : {0.0, 1.0, 10.0, 100.0, 300.0})
+    {
+        const vector<complex<double> > Ga = directFrequencyResponse(a, w), Gb = directFrequencyResponse(b, w);
+        if (Ga.size() != Gb.size()) return INFINITY;
+        for (unsigned int k=0;k<Ga.size();k++) difference = max(difference, abs(Ga[k] - Gb[k]));
+    }
+    return difference;
+}
+
+int main()
+{
+    const vector<vector<double> > e = testErrors(100, 2);
+    const StateSpaceController<double> K1 = testController(3, 2, 2, 0.5), K2 = testController(4, 2, 1, 0.3);
+
+    // Series: K2 stepped on the outputs of K1
+    StateSpaceController<double> S = series(K1, K2), first(K1), second(K2);
+    double difference = 0;
+    for (unsigned int i=0;i<e.size();i++) difference = max(difference, maxDifference(S.currentOutput(e[i]), second.currentOutput(first.currentOutput(e[i]))));
+    check(S.getNx() == 7 && S.getNe() == 2 && S.getNu() == 1 && difference < 1e-12, "series");
+
+    // Parallel: sum of the outputs
+    const StateSpaceController<double> K3 = testController(2, 2, 2, 0.7);
+    StateSpaceController<double> P = parallel(K1, K3), a(K1), b(K3);
+    difference = 0;
+    for (unsigned int i=0;i<e.size();i++)
+    {
+        const vector<double> ua = a.currentOutput(e[i]), ub = b.currentOutput(e[i]);
+        difference = max(difference, maxDifference(P.currentOutput(e[i]), {ua[0] + ub[0], ua[1] + ub[1]}));
+    }
+    check(P.getNx() == 5 && difference < 1e-12, "parallel");
+
+    // Negative feedback through a strictly proper path: u_i = K1(e_i - H(u)_i), H stepped on u_i afterwards
+    StateSpaceController<double> H = testController(2, 2, 2, 0.2);
+    H.setD(QSMatrix<double>(2, 2, 0));
+    StateSpaceController<double> F = feedback(K1, H), forward(K1), path(H);
+    difference = 0;
+    for (unsigned int i=0;i<e.size();i++)
+    {
+        const vector<double> x_path = path.getX_i();
+        const QSMatrix<double>& C_path = path.getC();
+        const vector<double> v = {C_path(0,0) * x_path[0] + C_path(0,1) * x_path[1], C_path(1,0) * x_path[0] + C_path(1,1) * x_path[1]};
+        const vector<double> u = forward.currentOutput({e[i][0] - v[0], e[i][1] - v[1]});
+        path.currentOutput(u);
+        difference = max(difference, maxDifference(F.currentOutput(e[i]), u));
+    }
+    check(F.getNx() == 5 && difference < 1e-12, "feedback");
+
+    // Append: independent blocks
+    StateSpaceController<double> B = append(K1, K2), c(K1), d(K2);
+    difference = 0;
+    for (unsigned int i=0;i<e.size();i++)
+    {
+        const vector<double> uc = c.currentOutput(e[i]), ud = d.currentOutput({e[i][1], e[i][0]});
+        difference = max(difference, maxDifference(B.currentOutput({e[i][0], e[i][1], e[i][1], e[i][0]}), {uc[0], uc[1], ud[0]}));
+    }
+    check(B.getNe() == 4 && B.getNu() == 3 && difference < 1e-12, "append");
+
+    // Minimal realizations: a minimal controller (distinct poles) in parallel with itself needs only its own states
+    StateSpaceController<double> M = testController(3, 2, 2, 0.5);
+    QSMatrix<double> A_M = M.getA();
+    for (unsigned int k=0;k<3;k++) A_M(k,k) += 0.15 * k;
+    M.setA(A_M);
+    const StateSpaceController<double> doubled = parallel(M, M), minimal = parallel(M, M, true);
+    check(minimalRealization(M).getNx() == 3, "already minimal");
+    check(doubled.getNx() == 6 && minimal.getNx() == 3, "minimal parallel");
+    check(responseDifference(minimal, doubled) < 1e-6, "minimal realization keeps the response");
+
+    return testResult();
+}
@@ -0,0 +1,61 @@
+/**
+ * @file linearAlgebraBackendTest.cpp
+ * @brief Checks that the backend selected at configure time gives the results of the built-in kernels.
+ * @details Run with the backend of the build (SSC_LINALG_BACKEND): BUILTIN, CBLAS or EIGEN.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "linearAlgebraBackend.h"
+#include "QSMatrix.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template struct BuiltinBackend<double>;
+template struct LinearAlgebraBackend<double>;
+template struct LinearAlgebraBackend<float>;
+
+int main()
+{
+    cout << "Backend: " << LinearAlgebraBackend<double>::name() << endl;
+
+    // Above LINALG_BACKEND_SMALL_WORK, so a library backend is really called
+    const unsigned int n = 60, nrhs = 4;
+    vector<double> A(n * n), B(n * nrhs), x(n), C(n * n, 1), C_builtin(n * n, 1), y(n, 2), y_builtin(n, 2);
+    for (unsigned int i=0;i<n;i++)
+    {
+        for (unsigned int j=0;j<n;j++) A[i * n + j] = sin(0.3 * i + 1.1 * j) + (i == j ? 5 : 0);
+        for (unsigned int j=0;j<nrhs;j++) B[i * nrhs + j] = cos(i + 2.0 * j);
+        x[i] = 0.1 * i;
+    }
+
+    LinearAlgebraBackend<double>::gemm(n, n, n, 0.5, A.data(), n, A.data(), n, 2.0, C.data(), n);
+    BuiltinBackend<double>::gemm(n, n, n, 0.5, A.data(), n, A.data(), n, 2.0, C_builtin.data(), n);
+    check(maxDifference(C, C_builtin) < 1e-11, "gemm");
+
+    LinearAlgebraBackend<double>::gemv(n, n, -1.0, A.data(), n, x.data(), 0.5, y.data());
+    BuiltinBackend<double>::gemv(n, n, -1.0, A.data(), n, x.data(), 0.5, y_builtin.data());
+    check(maxDifference(y, y_builtin) < 1e-12, "gemv");
+
+    // solve() may be missing (-1): QSMatrix::solve() then uses its own LU
+    vector<double> factors(A), X(B);
+    const int solved = LinearAlgebraBackend<double>::solve(n, nrhs, factors.data(), X.data());
+    check(solved != 0, "solve of a regular system");
+    if (solved == 1)
+    {
+        vector<double> residual(n * nrhs);
+        BuiltinBackend<double>::gemm(n, nrhs, n, 1.0, A.data(), n, X.data(), nrhs, 0.0, residual.data(), nrhs);
+        check(maxDifference(residual, B) < 1e-11, "solution");
+    }
+
+    vector<double> singular(n * n, 1), S(B);
+    check(LinearAlgebraBackend<double>::solve(n, nrhs, singular.data(), S.data()) <= 0, "singular system");
+
+    // Small products stay on the built-in kernels with the same results
+    QSMatrix<float> small(3, 3, 1.5f);
+    const QSMatrix<float> product = small * small;
+    check(product(2,1) == 6.75f, "small float product");
+
+    return testResult();
+}
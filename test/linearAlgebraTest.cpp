@@ -0,0 +1,101 @@
+/**
+ * @file linearAlgebraTest.cpp
+ * @brief Checks of the LU and QR factorizations and the solves of QSMatrix, on one thread and several.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "QSMatrix.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class QSMatrix<double>;
+
+/**
+ * @return Largest absolute element of a matrix.
+ ******/
+static double maxAbs(const QSMatrix<double>& M)
+{
+    double largest = 0;
+    for (unsigned int i=0;i<M.get_rows();i++) for (unsigned int j=0;j<M.get_cols();j++) largest = max(largest, fabs(M(i,j)));
+    return largest;
+}
+
+/**
+ * @return Deterministic matrix with a dominant diagonal (well conditioned).
+ ******/
+static QSMatrix<double> testMatrix(const unsigned int rows, const unsigned int cols)
+{
+    QSMatrix<double> M(rows, cols, 0);
+    for (unsigned int i=0;i<rows;i++)
+    {
+        for (unsigned int j=0;j<cols;j++) M(i,j) = sin(0.37 * i + 1.3 * j + 0.1 * i * j);
+        if (i < cols) M(i,i) += 4;
+    }
+    return M;
+}
+
+int main()
+{
+    // Sizes above the blocking and threading thresholds, and a small one
+    const unsigned int sizes[2] = {7, 150};
+    for (unsigned int threads=1;threads<=4;threads+=3)
+    {
+        QSMatrix<double>::setThreadCount(threads);
+        for (unsigned int s=0;s<2;s++)
+        {
+            const unsigned int n = sizes[s];
+            const string name = " (n = " + to_string(n) + ", " + to_string(threads) + " threads)";
+            const QSMatrix<double> A = testMatrix(n, n);
+
+            // P*A = L*U
+            QSMatrix<double> LU(A);
+            vector<unsigned> pivots;
+            check(LU.luDecompose(pivots), "LU" + name);
+            QSMatrix<double> L(n, n, 0), U(n, n, 0), PA(n, n, 0);
+            for (unsigned int i=0;i<n;i++)
+            {
+                for (unsigned int j=0;j<n;j++)
+                {
+                    if (j < i) L(i,j) = LU(i,j);
+                    else U(i,j) = LU(i,j);
+                }
+                L(i,i) = 1;
+            }
+            vector<unsigned> rows(n);
+            for (unsigned int i=0;i<n;i++) rows[i] = i;
+            for (unsigned int i=0;i<n;i++) swap(rows[i], rows[pivots[i]]);
+            for (unsigned int i=0;i<n;i++) for (unsigned int j=0;j<n;j++) PA(i,j) = A(rows[i], j);
+            check(maxAbs(L * U - PA) < 1e-11, "P*A = L*U" + name);
+
+            // A = Q*R, Q orthogonal
+            QSMatrix<double> QR(A);
+            vector<double> tau;
+            QR.qrDecompose(tau);
+            const QSMatrix<double> Q = QR.qrQ(tau), R = QR.qrR();
+            QSMatrix<double> identity(n, n, 0);
+            for (unsigned int i=0;i<n;i++) identity(i,i) = 1;
+            check(maxAbs(Q * R - A) < 1e-11 && maxAbs(Q.transpose() * Q - identity) < 1e-12, "A = Q*R" + name);
+
+            // Solves, inverse
+            const QSMatrix<double> B = testMatrix(n, 3);
+            check(maxAbs(A * A.solve(B) - B) < 1e-11, "solve" + name);
+            const vector<double> b(n, 1);
+            check(maxDifference(A * A.solve(b), b) < 1e-11, "vector solve" + name);
+            check(maxAbs(A * A.inverse() - identity) < 1e-11, "inverse" + name);
+
+            // Least squares: A'*(A*X - B) = 0
+            const QSMatrix<double> tall = testMatrix(n + 5, n);
+            const QSMatrix<double> rhs = testMatrix(n + 5, 2);
+            check(maxAbs(tall.transpose() * (tall * tall.leastSquares(rhs) - rhs)) < 1e-9, "least squares" + name);
+        }
+    }
+
+    // Determinant of a triangular matrix with one row swap
+    QSMatrix<double> T(3, 3, 0);
+    T(0,1) = 2; T(0,2) = 1; T(1,0) = 3; T(1,1) = 1; T(2,2) = 4;
+    check(fabs(T.determinant() + 24) < 1e-12, "determinant");
+
+    return testResult();
+}
@@ -0,0 +1,45 @@
+/**
+ * @file mixedPrecisionTest.cpp
+ * @brief Checks of MixedPrecisionStateSpaceController against a double controller stepped alongside.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "mixedPrecisionController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class MixedPrecisionStateSpaceController<float>;
+
+int main()
+{
+    // Slow poles: float rounding accumulates over many steps
+    const StateSpaceController<double> K = testController(8, 2, 2, 0.95);
+    const vector<vector<double> > e = testErrors(1000, 2);
+
+    MixedPrecisionController mixed(K, 100);
+    StateSpaceController<double> reference(K);
+    double outputDifference = 0;
+    for (unsigned int i=0;i<e.size();i++)
+    {
+        outputDifference = max(outputDifference, maxDifference(mixed.currentOutput(e[i]), reference.currentOutput(e[i])));
+    }
+    check(outputDifference < 1e-4, "float steps follow the double controller");
+    check(mixed.getResyncCount() == e.size() / 100, "one resynchronization per interval");
+
+    // The synchronized state is the double state, not a float one
+    check(maxDifference(mixed.getSynchronizedState(), reference.getX_i()) < 1e-10, "resynchronized double state");
+    check(maxDifference(mixed.getX_i(), reference.getX_i()) < 1e-5, "float state after resynchronization");
+    check(mixed.getMaxDeviation() > 0 && mixed.getMaxDeviation() < 1e-4, "deviation at the resynchronizations");
+
+    // A drift threshold below one step of rounding resynchronizes on every step
+    MixedPrecisionController eager(K, 1000, 1e-12);
+    for (unsigned int i=0;i<10;i++) eager.currentOutput(e[i]);
+    check(eager.getResyncCount() == 10, "drift threshold");
+
+    // The amortized resynchronization is cheaper than a double step
+    check(mixed.getResyncCostPerStep() < (double)mixed.getStepCost(), "resynchronization cost");
+
+    return testResult();
+}
@@ -0,0 +1,64 @@
+/**
+ * @file modelReductionTest.cpp
+ * @brief Checks of balanced truncation: Lyapunov solutions and the H infinity error bound.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "modelReduction.h"
+#include "testCheck.h"
+
+using namespace std;
+
+int main()
+{
+    // Single-input single-output controller with spread poles
+    const unsigned int nx = 8;
+    QSMatrix<double> A(nx, nx, 0), B(nx, 1, 0), C(1, nx, 0), D(1, 1, 0.1);
+    for (unsigned int i=0;i<nx;i++)
+    {
+        for (unsigned int j=0;j<nx;j++) A(i,j) = 0.03 * sin(1.0 + i + 3.0 * j);
+        A(i,i) = 0.9 - 0.11 * i;
+        B(i,0) = 1.0 / (i + 1);
+        C(0,i) = cos(0.7 * i);
+    }
+    const StateSpaceController<double> K(A, B, C, D, 0.01f);
+
+    // Controllability Gramian: A*X*A' - X + B*B' = 0
+    QSMatrix<double> X;
+    check(discreteLyapunov(A, B * B.transpose(), X), "Lyapunov solved");
+    const QSMatrix<double> residual = A * X * A.transpose() - X + B * B.transpose();
+    double largest = 0;
+    for (unsigned int i=0;i<nx;i++) for (unsigned int j=0;j<nx;j++) largest = max(largest, fabs(residual(i,j)));
+    check(largest < 1e-10, "Lyapunov residual");
+
+    const vector<double> hsv = hankelSingularValues(K);
+    bool decreasing = hsv.size() == nx;
+    for (unsigned int k=1;k<hsv.size();k++) decreasing = decreasing && hsv[k] <= hsv[k-1] && hsv[k] >= 0;
+    check(decreasing, "Hankel singular values");
+
+    // |G(w) - Gr(w)| stays below twice the sum of the truncated Hankel singular values, up to Nyquist
+    for (unsigned int order=1;order<nx;order++)
+    {
+        BalancedTruncationReport<double> report;
+        const StateSpaceController<double> reduced = balancedTruncation(K, order, &report);
+        double bound = 0;
+        for (unsigned int k=order;k<nx;k++) bound += 2 * hsv[k];
+
+        double error = 0;
+        for (unsigned int k=0;k<=200;k++)
+        {
+            const double w = M_PI / 0.01 * k / 200;
+            error = max(error, abs(directFrequencyResponse(K, w)[0] - directFrequencyResponse(reduced, w)[0]));
+        }
+        check(report.success && reduced.getNx() == order && fabs(report.errorBound - bound) < 1e-9 * (1 + bound), "error bound of order " + to_string(order));
+        check(error <= bound * (1 + 1e-6) + 1e-12, "H infinity error of order " + to_string(order));
+    }
+
+    // The smallest order meeting a bound
+    BalancedTruncationReport<double> report;
+    const StateSpaceController<double> reduced = balancedTruncationErrorBound(K, 2 * hsv[3], &report);
+    check(report.errorBound <= 2 * hsv[3] && (reduced.getNx() == 0 || 2 * hsv[reduced.getNx() - 1] + report.errorBound > 2 * hsv[3]), "order from an error bound");
+
+    return testResult();
+}
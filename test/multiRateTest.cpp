@@ -0,0 +1,75 @@
+/**
+ * @file multiRateTest.cpp
+ * @brief Checks of MultiRateController against the same cascade stepped by hand.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "multiRateController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class MultiRateController<double>;
+
+int main()
+{
+    // Cascade: the outer loop (every 4 ticks) gives the reference of the inner loop (every tick)
+    StateSpaceController<double> outer = testController(3, 1, 1, 0.8);
+    StateSpaceController<double> inner = testController(2, 1, 1, 0.3);
+    outer.setTimeStep(0.04f);
+
+    StateSpaceController<double> outerPointer(outer), innerPointer(inner);
+    MultiRateController<double> byPointer(0.01f), byCopy(0.01f);
+    const unsigned int o1 = byPointer.addController(&outerPointer, 4), i1 = byPointer.addController(&innerPointer, 1);
+    const unsigned int o2 = byCopy.addControllerCopy(outer, 4), i2 = byCopy.addControllerCopy(inner, 1);
+    byPointer.connect(o1, 0, i1, 0);
+    byCopy.connect(o2, 0, i2, 0);
+    check(byCopy.getHyperperiod() == 4 && byCopy.getDivisor(o2) == 4, "hyperperiod");
+
+    StateSpaceController<double> outerHand(outer), innerHand(inner);
+    vector<double> u_outer(1, 0), u_inner;
+    double pointerDifference = 0, copyDifference = 0;
+    bool schedule = true;
+    for (unsigned int tick=0;tick<40;tick++)
+    {
+        const vector<double> r(1, sin(0.1 * tick)), y_outer(1, 0.5 * cos(0.05 * tick)), y_inner(1, 0.2 * sin(0.3 * tick));
+        byPointer.setReference(o1, r);
+        byPointer.setMeasurement(o1, y_outer);
+        byPointer.setMeasurement(i1, y_inner);
+        byCopy.setReference(o2, r);
+        byCopy.setMeasurement(o2, y_outer);
+        byCopy.setMeasurement(i2, y_inner);
+
+        schedule = schedule && byCopy.isDue(o2) == (tick % 4 == 0) && byCopy.isDue(i2);
+        const unsigned int steps = byCopy.tick();
+        byPointer.tick();
+        schedule = schedule && steps == (tick % 4 == 0 ? 2u : 1u);
+
+        // Outer loop first, its output held for the inner loop
+        if (tick % 4 == 0)
+        {
+            u_outer = outerHand.currentOutput(r, y_outer);
+        }
+        u_inner = innerHand.currentOutput(u_outer, y_inner);
+
+        pointerDifference = max(pointerDifference, maxDifference(byPointer.getOutput(i1), u_inner) + maxDifference(byPointer.getOutput(o1), u_outer));
+        copyDifference = max(copyDifference, maxDifference(byCopy.getOutput(i2), u_inner) + maxDifference(byCopy.getOutput(o2), u_outer));
+    }
+    check(schedule, "controllers due on each tick");
+    check(pointerDifference < 1e-12, "registered controllers");
+    check(copyDifference < 1e-12, "copied controllers");
+    check(maxDifference(byCopy.getX_i(o2), outerHand.getX_i()) < 1e-12 && fabs(byCopy.getTime() - 0.4) < 1e-5, "state and time");
+
+    // Vectors of the wrong size are refused
+    const vector<double> before = byCopy.getOutput(i2);
+    byCopy.setMeasurement(i2, vector<double>(2, 100));
+    byCopy.setReference(o2, vector<double>(3, 100));
+    byCopy.setReference(7, vector<double>(1, 100));
+    byCopy.tick();
+    u_outer = outerHand.currentOutput(vector<double>(1, sin(0.1 * 39)), vector<double>(1, 0.5 * cos(0.05 * 39)));
+    u_inner = innerHand.currentOutput(u_outer, vector<double>(1, 0.2 * sin(0.3 * 39)));
+    check(before.size() == 1 && maxDifference(byCopy.getOutput(i2), u_inner) < 1e-12, "wrong sizes refused");
+
+    return testResult();
+}
@@ -0,0 +1,95 @@
+/**
+ * @file numaControllerBankTest.cpp
+ * @brief Checks of NumaTopology and of NumaControllerBank against controllers stepped one by one.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "numaControllerBank.h"
+#include "testCheck.h"
+
+#include <fstream>
+#include <cstdint>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+template class NumaControllerBank<double>;
+
+int main()
+{
+    // Kernel lists
+    check(NumaTopology::parseList("0-3,8,10-11") == vector<unsigned int>({0, 1, 2, 3, 8, 10, 11}), "CPU list");
+
+    // Two nodes read from a sysfs-like directory
+    const string directory = "/tmp/ssc_numa_test_" + to_string(getpid());
+    mkdir(directory.c_str(), 0700);
+    mkdir((directory + "/node0").c_str(), 0700);
+    mkdir((directory + "/node2").c_str(), 0700);
+    ofstream(directory + "/online") << "0,2" << endl;
+    ofstream(directory + "/node0/cpulist") << "0-1" << endl;
+    ofstream(directory + "/node2/cpulist") << "2-3,6" << endl;
+    const NumaTopology sysfs = NumaTopology::fromSysfs(directory);
+    check(sysfs.getNodeCount() == 2 && sysfs.getNode(1).id == 2 && sysfs.getNode(1).cpus.size() == 3 && sysfs.nodeOfCpu(6) == 1, "sysfs topology");
+    remove((directory + "/node0/cpulist").c_str());
+    remove((directory + "/node2/cpulist").c_str());
+    remove((directory + "/online").c_str());
+    rmdir((directory + "/node0").c_str());
+    rmdir((directory + "/node2").c_str());
+    rmdir(directory.c_str());
+
+    // Node memory: page-aligned blocks, alignments above a page refused
+    NodeMemoryResource memory(0, false);
+    void* block = memory.allocate(100, 64);
+    check(block != 0 && (uintptr_t)block % 64 == 0 && memory.getMappedBytes() == 4096, "node memory block");
+    memory.deallocate(block, 100, 64);
+#if defined(__linux__)
+    bool refused = false;
+    try
+    {
+        void* aligned = memory.allocate(100, 8192);
+        memory.deallocate(aligned, 100, 8192);
+    }
+    catch (const std::bad_alloc&)
+    {
+        refused = true;
+    }
+    check(refused, "alignment above a page refused");
+#endif
+
+    // Bank of two shards on one node: controllers of different sizes are balanced over the shards
+    NumaControllerBank<double> bank(NumaTopology::singleNode(2), 2, false);
+    vector<StateSpaceController<double> > references;
+    for (unsigned int k=0;k<6;k++)
+    {
+        references.push_back(testController(2 + k, 2, 1 + k % 2, 0.3 + 0.1 * k));
+        bank.add(references.back());
+    }
+    check(bank.getShardCount() == 2 && bank.getControllerCount() == 6 && bank.getShardOf(5) != bank.getShardOf(4), "shards");
+
+    const vector<vector<double> > e = testErrors(50, 2);
+    double difference = 0;
+    for (unsigned int i=0;i<e.size();i++)
+    {
+        for (unsigned int k=0;k<6;k++) copy(e[i].begin(), e[i].end(), bank.input(k));
+        bank.step();
+        for (unsigned int k=0;k<6;k++)
+        {
+            const vector<double> u = references[k].currentOutput(e[i]);
+            difference = max(difference, maxDifference(vector<double>(bank.output(k), bank.output(k) + u.size()), u));
+        }
+    }
+    check(difference < 1e-12, "bank outputs");
+    const ShardStatistics statistics0 = bank.getStatistics(0), statistics1 = bank.getStatistics(1);
+    check(statistics0.steps == e.size() && statistics1.steps == e.size() && statistics0.controllers + statistics1.controllers == 6, "step statistics");
+
+    bank.reset();
+    for (unsigned int k=0;k<6;k++) copy(e[0].begin(), e[0].end(), bank.input(k));
+    bank.step();
+    StateSpaceController<double> first(references[0]);
+    first.reset();
+    check(maxDifference(vector<double>(bank.output(0), bank.output(0) + 1), first.currentOutput(e[0])) < 1e-12, "reset");
+
+    return testResult();
+}
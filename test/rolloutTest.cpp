@@ -0,0 +1,85 @@
+/**
+ * @file rolloutTest.cpp
+ * @brief Checks of StateSpaceController::rollout() against copies of the controller stepped with each candidate.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "stateSpaceController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class StateSpaceController<double>;
+template class StateSpaceController<float>;
+
+/**
+ * @return Largest difference between a rollout and copies of the controller stepped with the same errors.
+ ******/
+static double rolloutDifference(const StateSpaceController<double>& K, const vector<vector<vector<double> > >& errors, const vector<vector<vector<double> > >& outputs)
+{
+    if (outputs.size() != errors.size())
+    {
+        return INFINITY;
+    }
+
+    double difference = 0;
+    for (unsigned int k=0;k<errors.size();k++)
+    {
+        StateSpaceController<double> copy(K);
+        for (unsigned int h=0;h<errors[k].size();h++) difference = max(difference, maxDifference(outputs[k][h], copy.currentOutput(errors[k][h])));
+    }
+    return difference;
+}
+
+int main()
+{
+    // From a non-zero state
+    StateSpaceController<double> K = testController(6, 3, 2);
+    const vector<vector<double> > history = testErrors(10, 3);
+    for (unsigned int i=0;i<history.size();i++) K.currentOutput(history[i]);
+    const vector<double> x = K.getX_i();
+
+    const unsigned int candidates = 5, horizon = 12;
+    vector<vector<vector<double> > > errors(candidates);
+    for (unsigned int k=0;k<candidates;k++)
+    {
+        // Candidate k: the test errors shifted by k steps
+        const vector<vector<double> > e = testErrors(horizon + k, 3);
+        errors[k].assign(e.begin() + k, e.end());
+    }
+    check(rolloutDifference(K, errors, K.rollout(errors)) < 1e-12, "rollout of errors");
+    check(K.getX_i() == x, "controller not modified");
+
+    // References with a held plant output
+    const vector<double> y_hold = {0.3, -0.1, 0.2};
+    vector<vector<vector<double> > > shifted(errors);
+    for (unsigned int k=0;k<candidates;k++) for (unsigned int h=0;h<horizon;h++) for (unsigned int j=0;j<3;j++) shifted[k][h][j] -= y_hold[j];
+    check(rolloutDifference(K, shifted, K.rollout(errors, y_hold)) < 1e-12, "rollout of references");
+
+    // Contiguous buffers give the same outputs
+    vector<double> flatErrors, flatOutputs(candidates * horizon * 2, 0);
+    for (unsigned int k=0;k<candidates;k++) for (unsigned int h=0;h<horizon;h++) flatErrors.insert(flatErrors.end(), errors[k][h].begin(), errors[k][h].end());
+    check(K.rollout(candidates, horizon, flatErrors.data(), flatOutputs.data()), "contiguous rollout");
+    const vector<vector<vector<double> > > outputs = K.rollout(errors);
+    double difference = 0;
+    for (unsigned int k=0;k<candidates;k++) for (unsigned int h=0;h<horizon;h++) for (unsigned int j=0;j<2;j++) difference = max(difference, fabs(flatOutputs[(k * horizon + h) * 2 + j] - outputs[k][h][j]));
+    check(difference == 0, "contiguous outputs");
+
+    // Null buffers refused, empty rollouts accepted
+    check(!K.rollout(candidates, horizon, 0, flatOutputs.data()) && !K.rollout(candidates, horizon, flatErrors.data(), 0), "null buffers refused");
+    check(K.rollout(0, horizon, 0, 0) && K.rollout(candidates, 0, 0, 0), "empty rollouts");
+
+    // A replaced matrix is used by the next rollout (packed cache rebuilt)
+    QSMatrix<double> C = K.getC();
+    C(1,2) += 1;
+    K.setC(C);
+    check(rolloutDifference(K, errors, K.rollout(errors)) < 1e-12, "rollout after a matrix replacement");
+
+    // Copies sharing the matrices roll out from their own state
+    StateSpaceController<double> copy(K);
+    copy.reset();
+    check(rolloutDifference(copy, errors, copy.rollout(errors)) < 1e-12 && rolloutDifference(K, errors, K.rollout(errors)) < 1e-12, "rollout of a copy");
+
+    return testResult();
+}
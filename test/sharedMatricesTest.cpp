@@ -0,0 +1,54 @@
+/**
+ * @file sharedMatricesTest.cpp
+ * @brief Checks of the shared, immutable matrices of StateSpaceController (copies share, setters replace).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "stateSpaceController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+template class StateSpaceController<double>;
+template class StateSpaceController<float>;
+
+int main()
+{
+    StateSpaceController<double> K = testController(5, 2, 2);
+    const vector<vector<double> > e = testErrors(20, 2);
+
+    // A copy shares A, B, C and D but has its own state
+    StateSpaceController<double> copy(K);
+    check(copy.sharesMatricesWith(K) && copy.getSharedA() == K.getSharedA() && &copy.getA() == &K.getA(), "copy shares the matrices");
+    for (unsigned int i=0;i<e.size();i++) copy.currentOutput(e[i]);
+    check(K.getX_i() == vector<double>(5, 0) && copy.getX_i() != K.getX_i(), "copy has its own state");
+
+    // Assignment shares too
+    StateSpaceController<double> assigned;
+    assigned = K;
+    check(assigned.sharesMatricesWith(K), "assignment shares the matrices");
+
+    // Replacing a matrix of the copy leaves the original untouched
+    const QSMatrix<double> A_original = K.getA();
+    copy.setA(QSMatrix<double>(5, 5, 0.1));
+    check(!copy.sharesMatricesWith(K) && copy.getSharedB() == K.getSharedB(), "setter replaces one matrix");
+    check(K.getA()(0,0) == A_original(0,0) && copy.getA()(0,0) == 0.1, "original unchanged");
+
+    // Matrices can be shared explicitly between controllers of the same dimensions
+    StateSpaceController<double> other = testController(5, 2, 2, 0.2);
+    other.setA(K.getSharedA());
+    other.setB(K.getSharedB());
+    other.setC(K.getSharedC());
+    other.setD(K.getSharedD());
+    check(other.sharesMatricesWith(K), "explicit sharing");
+
+    // Shared matrices give the same outputs as owned copies of them
+    StateSpaceController<double> owned(K.getA(), K.getB(), K.getC(), K.getD(), K.getTimeStep());
+    StateSpaceController<double> shared(K);
+    double difference = 0;
+    for (unsigned int i=0;i<e.size();i++) difference = max(difference, maxDifference(owned.currentOutput(e[i]), shared.currentOutput(e[i])));
+    check(!owned.sharesMatricesWith(K) && difference == 0, "outputs with shared matrices");
+
+    return testResult();
+}
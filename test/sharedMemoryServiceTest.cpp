@@ -0,0 +1,111 @@
+/**
+ * @file sharedMemoryServiceTest.cpp
+ * @brief Checks of SharedMemoryControllerService and its client: outputs of the served controllers and segment checks.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "sharedMemoryService.h"
+#include "testCheck.h"
+
+#include <thread>
+#include <atomic>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+template class SharedMemoryControllerService<double>;
+template class SharedMemoryControllerClient<double>;
+template class SeqlockValue<double>;
+
+/**
+ * @brief Value larger than a word, torn if a read mixes two writes.
+ ******/
+struct Quadruple
+{
+    uint64_t values[4];
+};
+
+int main()
+{
+    // Seqlock: reads never mix two writes
+    SeqlockValue<Quadruple> published;
+    atomic<bool> done(false);
+    thread writer([&published, &done]() {
+        for (uint64_t i=1;i<=200000;i++) published.write({{i, i, i, i}});
+        done = true;
+    });
+    bool consistent = true;
+    while (!done)
+    {
+        const Quadruple value = published.read();
+        consistent = consistent && value.values[1] == value.values[0] && value.values[2] == value.values[0] && value.values[3] == value.values[0];
+    }
+    writer.join();
+    check(consistent && published.read().values[3] == 200000 && published.getVersion() == 200000, "seqlock reads");
+
+    const string name = "/ssc_test_" + to_string(getpid());
+    const vector<StateSpaceController<double> > controllers = {testController(4, 2, 2), testController(3, 1, 1, 0.7)};
+    SharedMemoryControllerService<double> service(name, controllers);
+    check(service.isOpen() && service.getControllerCount() == 2, "service open");
+
+    SharedMemoryControllerClient<double> client(name);
+    check(client.isOpen() && client.getControllerCount() == 2 && client.getNx(0) == 4 && client.getNe(1) == 1 && client.getNu(0) == 2, "client open");
+
+    // No output before the first step
+    vector<double> u(2);
+    check(client.readOutput(0, u.data()) == 0, "no output yet");
+
+    // Steps processed by the server match the controller stepped here with e = r - y
+    StateSpaceController<double> reference(controllers[0]);
+    const vector<vector<double> > r = testErrors(30, 2);
+    const vector<double> y = {0.25, -0.5};
+    double difference = 0;
+    uint64_t steps = 0;
+    for (unsigned int i=0;i<r.size();i++)
+    {
+        client.write(0, r[i].data(), y.data());
+        client.submit(0);
+        check(service.processPending() == 1, "one pending controller");
+        double time = 0;
+        steps = client.readOutput(0, u.data(), &time);
+        difference = max(difference, maxDifference(u, reference.currentOutput(r[i], y)));
+        check(fabs(time - reference.getTime()) < 1e-9, "time of the output");
+    }
+    check(steps == r.size() && difference < 1e-12, "served outputs");
+    check(service.processPending() == 0, "nothing pending");
+
+    // Served by a thread: waitOutput() sees the next step
+    thread server([&service]() { service.run(); });
+    vector<double> u1(1);
+    const double r1 = 1, y1 = 0;
+    client.write(1, &r1, &y1);
+    client.submit(1);
+    StateSpaceController<double> reference1(controllers[1]);
+    check(client.waitOutput(1, 0, u1.data(), 5) == 1 && fabs(u1[0] - reference1.currentOutput({r1}, {y1})[0]) < 1e-12, "wait for the output");
+    service.requestStop();
+    server.join();
+
+    // A client refuses a segment whose slot table lies outside of it
+    const int descriptor = shm_open(name.c_str(), O_RDWR, 0);
+    check(descriptor >= 0, "segment exists");
+    if (descriptor >= 0)
+    {
+        ShmServiceHeader* header = (ShmServiceHeader*)mmap(0, sizeof(ShmServiceHeader), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        close(descriptor);
+        const uint64_t offset = header->slotTableOffset;
+        header->slotTableOffset = header->segmentSize - 8;
+        SharedMemoryControllerClient<double> corrupted(name);
+        check(!corrupted.isOpen(), "slot table outside of the segment refused");
+        header->slotTableOffset = offset;
+        munmap(header, sizeof(ShmServiceHeader));
+    }
+
+    // A second service cannot take an existing segment
+    SharedMemoryControllerService<double> duplicate(name, controllers);
+    check(!duplicate.isOpen(), "existing segment refused");
+
+    return testResult();
+}
@@ -0,0 +1,85 @@
+/**
+ * @file socketControllerServerTest.cpp
+ * @brief Checks of SocketControllerServer and its client: synchronous and pipelined steps, batches and error replies.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "socketControllerServer.h"
+#include "testCheck.h"
+
+#include <thread>
+#include <map>
+#include <unistd.h>
+
+using namespace std;
+
+template class SocketControllerServer<double>;
+template class SocketControllerClient<double>;
+
+int main()
+{
+#if defined(__linux__)
+    const string path = "/tmp/ssc_socket_test_" + to_string(getpid());
+    const vector<StateSpaceController<double> > controllers = {testController(4, 2, 2), testController(3, 1, 1, 0.7)};
+
+    // Window long enough for the pipelined requests to be stepped together
+    SocketControllerServer<double> server(path, 0.02, 64);
+    check(server.isOpen(), "server open");
+    for (unsigned int k=0;k<controllers.size();k++) check(server.addController(controllers[k]) == k, "controller index");
+    thread loop([&server]() { server.run(); });
+
+    {
+        SocketControllerClient<double> client(path);
+        check(client.isOpen(), "client connected");
+
+        unsigned int nx = 0, ne = 0, nu = 0;
+        float t_s = 0;
+        check(client.info(0, nx, ne, nu, t_s) && nx == 4 && ne == 2 && nu == 2 && t_s == 0.01f, "info");
+        check(!client.info(5, nx, ne, nu, t_s), "info of an unknown controller");
+
+        // Synchronous steps, with e and with r and y
+        StateSpaceController<double> reference(controllers[0]);
+        const vector<vector<double> > e = testErrors(20, 2);
+        const vector<double> y = {0.25, -0.5};
+        double difference = 0;
+        for (unsigned int i=0;i<10;i++) difference = max(difference, maxDifference(client.step(0, e[i]), reference.currentOutput(e[i])));
+        for (unsigned int i=10;i<20;i++) difference = max(difference, maxDifference(client.step(0, e[i], y), reference.currentOutput(e[i], y)));
+        check(difference < 1e-12, "synchronous steps");
+
+        // Pipelined requests of both controllers: each controller is stepped in the order of its requests
+        StateSpaceController<double> reference1(controllers[1]);
+        map<uint32_t, vector<double> > expected;
+        for (unsigned int i=0;i<20;i++)
+        {
+            client.send(i % 2, 100 + i, e[i].data(), i % 2 == 0 ? 2 : 1);
+            expected[100 + i] = i % 2 == 0 ? reference.currentOutput(e[i]) : reference1.currentOutput({e[i][0]});
+        }
+        difference = 0;
+        for (unsigned int i=0;i<20;i++)
+        {
+            SocketMessageHeader header;
+            vector<double> u;
+            check(client.receive(header, u) && header.status == SOCKET_OK && expected.count(header.tag), "pipelined reply");
+            difference = max(difference, maxDifference(u, expected[header.tag]));
+        }
+        check(difference < 1e-12, "pipelined steps");
+
+        // Error replies
+        SocketMessageHeader header;
+        vector<double> u;
+        check(client.send(7, 1, e[0].data(), 2) && client.receive(header, u) && header.status == SOCKET_UNKNOWN_CONTROLLER && header.tag == 1, "unknown controller");
+        check(client.send(0, 2, e[0].data(), 1) && client.receive(header, u) && header.status == SOCKET_BAD_SIZE && header.tag == 2, "bad size");
+    }
+
+    server.requestStop();
+    loop.join();
+
+    const SocketServerStatistics statistics = server.getStatistics();
+    // 20 synchronous steps (one batch each), the 20 pipelined requests in few batches; 3 error replies with info()
+    check(statistics.requests == 44 && statistics.steps == 40 && statistics.errors == 3, "request statistics");
+    check(statistics.batches < 30 && statistics.meanBatchSize() > 1, "batches");
+#endif
+
+    return testResult();
+}
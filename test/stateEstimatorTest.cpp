@@ -0,0 +1,110 @@
+/**
+ * @file stateEstimatorTest.cpp
+ * @brief Checks of the steady-state Kalman filter on a noisy plant, of the Riccati solution and of EstimatedController.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "stateEstimator.h"
+#include "testCheck.h"
+
+#include <random>
+
+using namespace std;
+
+template class StateEstimator<double>;
+template class EstimatedController<double>;
+
+/**
+ * @return Largest absolute coefficient of a matrix.
+ ******/
+static double maxAbs(const QSMatrix<double>& M)
+{
+    double value = 0;
+    for (unsigned int i=0;i<M.get_rows();i++) for (unsigned int j=0;j<M.get_cols();j++) value = max(value, fabs(M(i,j)));
+    return value;
+}
+
+int main()
+{
+    // Plant: two states, one input, one measurement
+    QSMatrix<double> A(2, 2, 0), B(2, 1, 0), C(1, 2, 0), D(1, 1, 0), Q(2, 2, 0), R(1, 1, 0.01);
+    A(0,0) = 0.95; A(0,1) = 0.1; A(1,1) = 0.9;
+    B(1,0) = 1;
+    C(0,0) = 1;
+    Q(0,0) = 1e-4; Q(1,1) = 1e-4;
+
+    // Riccati fixed point and Kalman gain L = P*C'*(C*P*C' + R)^-1
+    QSMatrix<double> P(2, 2, 0);
+    check(discreteRiccati(A, C, Q, R, P), "Riccati solved");
+    const QSMatrix<double> S = C * P * C.transpose() + R;
+    const QSMatrix<double> residual = A * P * A.transpose() - A * P * C.transpose() * S.inverse() * C * P * A.transpose() + Q - P;
+    check(maxAbs(residual) < 1e-12 * (1 + maxAbs(P)), "Riccati residual");
+    bool success = false;
+    StateEstimator<double> kalman = StateEstimator<double>::kalman(A, B, C, D, Q, R, &success);
+    check(success && maxAbs(kalman.getGain() - P * C.transpose() * S.inverse()) < 1e-12, "Kalman gain");
+
+    // Noisy plant: the filtered estimate is much closer to the state than the measurement
+    mt19937 generator(7);
+    normal_distribution<double> process(0, 1e-2), measurement(0, 0.1);
+    vector<double> x = {1, -1};
+    double estimateError = 0, measurementError = 0, stateError[2] = {0, 0};
+    const unsigned int burnIn = 200, steps = 5000;
+    for (unsigned int i=0;i<burnIn+steps;i++)
+    {
+        const vector<double> u = {0.1 * sin(0.01 * i)};
+        const vector<double> y = {x[0] + measurement(generator)};
+        const vector<double> x_hat = kalman.update(y, u);
+        if (i >= burnIn)
+        {
+            estimateError += (x_hat[0] - x[0]) * (x_hat[0] - x[0]);
+            measurementError += (y[0] - x[0]) * (y[0] - x[0]);
+            for (unsigned int k=0;k<2;k++) stateError[k] += (x_hat[k] - x[k]) * (x_hat[k] - x[k]);
+        }
+        x = {A(0,0) * x[0] + A(0,1) * x[1] + process(generator), A(1,1) * x[1] + u[0] + process(generator)};
+    }
+    check(estimateError < 0.25 * measurementError, "estimate error below the measurement noise");
+
+    // Mean squared errors close to the a posteriori covariance P - L*C*P
+    const QSMatrix<double> posterior = P - kalman.getGain() * C * P;
+    check(stateError[0] / steps < 1.5 * posterior(0,0) && stateError[1] / steps < 1.5 * posterior(1,1), "errors of the steady-state covariance");
+
+    // Luenberger observer without noise: the estimate converges from a wrong initial state
+    StateEstimator<double> observer(A, B, C, D, kalman.getGain());
+    observer.reset({5, 5});
+    x = {0, 0};
+    for (unsigned int i=0;i<500;i++)
+    {
+        const vector<double> u = {sin(0.05 * i)};
+        observer.update({x[0]}, u);
+        x = {A(0,0) * x[0] + A(0,1) * x[1], A(1,1) * x[1] + u[0]};
+    }
+    check(maxDifference(observer.getPrediction(), x) < 1e-9, "observer converges");
+
+    // EstimatedController: same outputs and estimates as the controller and the estimator stepped separately
+    // (the fused controller starts from the prediction of the estimator)
+    const StateSpaceController<double> K = testController(3, 1, 1, 0.4);
+    EstimatedController<double> fused(K, kalman);
+    check(fused.isValid() && fused.getNx() == 3 && fused.getEstimatorNx() == 2, "fused dimensions");
+    StateSpaceController<double> controller(K);
+    StateEstimator<double> estimator(kalman);
+    const vector<vector<double> > y = testErrors(100, 1);
+    double outputDifference = 0, estimateDifference = 0;
+    for (unsigned int i=0;i<y.size();i++)
+    {
+        const vector<double> r = {0.5};
+        const vector<double> u = controller.currentOutput(r, y[i]);
+        estimator.update(y[i], u);
+        outputDifference = max(outputDifference, maxDifference(fused.currentOutput(r, y[i]), u));
+        estimateDifference = max(estimateDifference, maxDifference(vector<double>(fused.getEstimate(), fused.getEstimate() + 2), estimator.getEstimate()));
+        estimateDifference = max(estimateDifference, maxDifference(vector<double>(fused.getPrediction(), fused.getPrediction() + 2), estimator.getPrediction()));
+    }
+    check(outputDifference < 1e-12 && estimateDifference < 1e-12, "fused steps");
+    check(maxDifference(vector<double>(fused.getState(), fused.getState() + 3), controller.getX_i()) < 1e-12, "fused controller state");
+
+    // Mismatched dimensions are refused
+    EstimatedController<double> mismatched(testController(3, 2, 1), kalman);
+    check(!mismatched.isValid(), "mismatched dimensions");
+
+    return testResult();
+}
@@ -0,0 +1,85 @@
+/**
+ * @file stateSnapshotTest.cpp
+ * @brief Checks of the state snapshots: contents after a step, torn-free reads while a writer publishes, bank snapshots.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "stateSnapshot.h"
+#include "stateSpaceController.h"
+#include "numaControllerBank.h"
+#include "testCheck.h"
+
+#include <thread>
+#include <atomic>
+
+using namespace std;
+
+template class SnapshotBuffer<double>;
+
+int main()
+{
+    // Snapshot of a controller: the signals and the state after its last step
+    StateSpaceController<double> K = testController(4, 2, 2);
+    check(!K.getSnapshotBuffer(), "snapshots disabled by default");
+    K.enableSnapshots();
+    const shared_ptr<const SnapshotBuffer<double> > buffer = K.getSnapshotBuffer();
+    check(buffer && buffer->getVersion() == 1 && buffer->read().x == vector<double>(4, 0), "current state published when enabled");
+    const vector<vector<double> > r = testErrors(10, 2);
+    const vector<double> y = {0.25, -0.5};
+    vector<double> u;
+    for (unsigned int i=0;i<r.size();i++) u = K.currentOutput(r[i], y);
+
+    const ControllerSnapshot<double> snapshot = buffer->read();
+    const vector<double> e = {r.back()[0] - y[0], r.back()[1] - y[1]};
+    check(snapshot.i == r.size() && snapshot.t == K.getTime() && snapshot.version == r.size() + 1, "step count, time and version");
+    check(snapshot.r == r.back() && snapshot.y == y && maxDifference(snapshot.e, e) < 1e-15, "r, y and e");
+    check(snapshot.u == u && snapshot.x == K.getX_i(), "u and x");
+
+    // Reads never mix two publications: every value of a snapshot is its step count
+    SnapshotBuffer<double> shared(8, 3, 2);
+    atomic<bool> done(false);
+    thread writer([&shared, &done]() {
+        vector<double> values(8);
+        for (unsigned int i=1;i<=200000;i++)
+        {
+            fill(values.begin(), values.end(), (double)i);
+            shared.publish(i, 0.001f * i, values.data(), values.data(), values.data(), values.data(), values.data());
+        }
+        done = true;
+    });
+    bool consistent = true;
+    unsigned int reads = 0;
+    ControllerSnapshot<double> reading;
+    while (!done || reads == 0)
+    {
+        shared.read(reading);
+        for (const vector<double>* values : {&reading.r, &reading.y, &reading.e, &reading.u, &reading.x})
+        {
+            for (unsigned int k=0;k<values->size();k++) consistent = consistent && (*values)[k] == (double)reading.i;
+        }
+        reads++;
+    }
+    writer.join();
+    check(consistent && reading.r.size() == 3 && reading.u.size() == 2 && reading.x.size() == 8, "torn-free reads");
+    check(shared.getVersion() == 200000 && shared.read().i == 200000, "last publication");
+
+    // Bank snapshots: each controller publishes after the step of its worker
+    NumaControllerBank<double> bank(NumaTopology::singleNode(2), 2, false);
+    ControllerSnapshot<double> banked;
+    bank.add(testController(3, 2, 1));
+    bank.add(testController(5, 2, 2, 0.6));
+    check(!bank.readSnapshot(0, banked), "bank snapshots disabled by default");
+    bank.enableSnapshots();
+    StateSpaceController<double> reference = testController(5, 2, 2, 0.6);
+    for (unsigned int i=0;i<r.size();i++)
+    {
+        for (unsigned int k=0;k<2;k++) copy(r[i].begin(), r[i].end(), bank.input(k));
+        bank.step();
+        reference.currentOutput(r[i]);
+    }
+    check(bank.readSnapshot(1, banked) && banked.i == r.size() && banked.e == r.back(), "bank snapshot signals");
+    check(maxDifference(banked.x, reference.getX_i()) < 1e-12 && banked.u == vector<double>(bank.output(1), bank.output(1) + 2), "bank snapshot state and output");
+
+    return testResult();
+}
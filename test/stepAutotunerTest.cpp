@@ -0,0 +1,78 @@
+/**
+ * @file stepAutotunerTest.cpp
+ * @brief Checks of the step kernels against StateSpaceController and of the autotuner decisions and cache file.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "stepAutotuner.h"
+#include "testCheck.h"
+
+#include <unistd.h>
+
+using namespace std;
+
+template class TunedController<double>;
+template class StepAutotuner<double>;
+
+int main()
+{
+    // Sparse matrices: every other coefficient of A and C is zero
+    StateSpaceController<double> K = testController(8, 3, 2);
+    QSMatrix<double> A = K.getA(), C = K.getC();
+    for (unsigned int i=0;i<8;i++) for (unsigned int j=0;j<8;j++) if ((i + j) % 2) A(i,j) = 0;
+    for (unsigned int i=0;i<2;i++) for (unsigned int j=0;j<8;j++) if ((i + j) % 2) C(i,j) = 0;
+    K.setA(A);
+    K.setC(C);
+    const vector<vector<double> > e = testErrors(50, 3);
+    for (unsigned int i=0;i<10;i++) K.currentOutput(e[i]);
+
+    // Each kernel continues from the state of the controller with the same outputs
+    for (unsigned int s=0;s<STEP_STRATEGY_COUNT;s++)
+    {
+        const StepStrategy strategy = (StepStrategy)s;
+        TunedController<double> tuned(K, strategy);
+        StateSpaceController<double> reference(K);
+        double difference = maxDifference(tuned.getX_i(), reference.getX_i());
+        const vector<double> r = {0.1, 0.2, 0.3};
+        for (unsigned int i=10;i<30;i++) difference = max(difference, maxDifference(tuned.currentOutput(e[i]), reference.currentOutput(e[i])));
+        for (unsigned int i=30;i<50;i++) difference = max(difference, maxDifference(tuned.currentOutput(r, e[i]), reference.currentOutput(r, e[i])));
+        check(tuned.getStrategy() == strategy && difference < 1e-12, string("kernel ") + stepStrategyName(strategy));
+    }
+    check(TunedController<double>(K, STEP_SPARSE).getCoefficientCount() < TunedController<double>(K, STEP_FUSED).getCoefficientCount(), "sparse coefficients");
+
+    // Selection among the verified kernels, then from the cache
+    const string path = "/tmp/ssc_autotune_test_" + to_string(getpid());
+    remove(path.c_str());
+    {
+        StepAutotuner<double> tuner(path, 1e-9, 1e-4);
+        AutotuneResult<double> result;
+        const StepStrategy strategy = tuner.select(K, &result);
+        check(!result.cached && result.strategy == strategy && result.verified[strategy] && result.secondsPerStep[strategy] > 0, "selection measured");
+        for (unsigned int s=0;s<STEP_STRATEGY_COUNT;s++) check(!result.verified[s] || result.secondsPerStep[strategy] <= result.secondsPerStep[s], "fastest verified kernel");
+
+        check(tuner.select(K, &result) == strategy && result.cached && tuner.getCacheSize() == 1, "selection cached");
+        TunedController<double> tuned = tuner.tune(K);
+        check(tuned.getStrategy() == strategy, "tuned controller");
+
+        // Another tuner on this machine reads the decision from the file
+        StepAutotuner<double> restarted(path, 1e-9, 1e-4);
+        check(restarted.getCacheSize() == 1 && restarted.select(K, &result) == strategy && result.cached, "cache file");
+
+        // Changed matrices have another hash and are measured
+        StateSpaceController<double> changed(K);
+        A(0,0) += 0.01;
+        changed.setA(A);
+        check(StepAutotuner<double>::matrixHash(changed) != StepAutotuner<double>::matrixHash(K), "hash of changed matrices");
+        restarted.select(changed, &result);
+        check(!result.cached && restarted.getCacheSize() == 2, "changed matrices measured");
+    }
+    remove(path.c_str());
+
+    // A controller without state nor output is not timed
+    StateSpaceController<double> empty(QSMatrix<double>(0, 0, 0), QSMatrix<double>(0, 2, 0), QSMatrix<double>(0, 0, 0), QSMatrix<double>(0, 2, 0), 0.01f);
+    StepAutotuner<double> tuner;
+    check(tuner.select(empty) == STEP_DENSE, "empty controller");
+
+    return testResult();
+}
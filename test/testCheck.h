@@ -0,0 +1,173 @@
+/**
+ * @file testCheck.h
+ * @brief Checks and reference computations shared by the tests (run by ctest).
+ * @details A test program counts its failed checks and returns 1 if any failed. The references are computed
+ * the straightforward way (direct solves, step by step), independently of the code under test.
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <complex>
+#include <cmath>
+
+#include "QSMatrix.h"
+#include "stateSpaceController.h"
+
+/**
+ * @brief Number of failed checks of the test program.
+ ******/
+inline int& testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+/**
+ * @brief Prints a failed check.
+ * @param passed Result of the check.
+ * @param name Name printed if it failed.
+ ******/
+inline void check(const bool passed, const std::string& name)
+{
+    if (!passed)
+    {
+        std::cout << "\033[1;31mFAILED: " << name << "\033[0m" << std::endl;
+        testFailures()++;
+    }
+}
+
+/**
+ * @brief Prints the result of the test program.
+ * @return Exit code of the test program (0 if every check passed).
+ ******/
+inline int testResult()
+{
+    if (testFailures() == 0)
+    {
+        std::cout << "All checks passed" << std::endl;
+    }
+
+    return testFailures() == 0 ? 0 : 1;
+}
+
+/**
+ * @return Largest absolute difference between two vectors (infinity if their sizes differ).
+ ******/
+template <typename T>
+double maxDifference(const std::vector<T>& a, const std::vector<T>& b)
+{
+    if (a.size() != b.size())
+    {
+        return INFINITY;
+    }
+
+    double difference = 0;
+    for (unsigned int k=0;k<a.size();k++)
+    {
+        difference = std::max(difference, (double)std::abs(a[k] - b[k]));
+    }
+
+    return difference;
+}
+
+/**
+ * @brief Deterministic stable controller.
+ * @details A has small coupling terms around a diagonal of "pole" (spectral radius below about pole + 0.1*nx*0.02).
+ * @param nx State dimension.
+ * @param ne Error dimension.
+ * @param nu Output dimension.
+ * @param pole Diagonal of A.
+ * @return Controller with a 0.01 s time step.
+ ******/
+inline StateSpaceController<double> testController(const unsigned int nx, const unsigned int ne, const unsigned int nu, const double pole = 0.5)
+{
+    QSMatrix<double> A(nx, nx, 0), B(nx, ne, 0), C(nu, nx, 0), D(nu, ne, 0);
+    for (unsigned int i=0;i<nx;i++)
+    {
+        for (unsigned int j=0;j<nx;j++) A(i,j) = 0.02 * std::sin(i + 2.0 * j);
+        A(i,i) += pole;
+        for (unsigned int j=0;j<ne;j++) B(i,j) = std::cos(i + 0.5 * j);
+    }
+    for (unsigned int i=0;i<nu;i++)
+    {
+        for (unsigned int j=0;j<nx;j++) C(i,j) = 0.2 * std::sin(i - 1.0 * j);
+        for (unsigned int j=0;j<ne;j++) D(i,j) = 0.1 * (i + j + 1);
+    }
+
+    return StateSpaceController<double>(A, B, C, D, 0.01f);
+}
+
+/**
+ * @brief Deterministic error sequence (sums of sines, different for each input).
+ * @param steps Number of error vectors.
+ * @param ne Error dimension.
+ * @return e[i]: error vector of step i.
+ ******/
+inline std::vector<std::vector<double> > testErrors(const unsigned int steps, const unsigned int ne)
+{
+    std::vector<std::vector<double> > e(steps, std::vector<double>(ne));
+    for (unsigned int i=0;i<steps;i++)
+    {
+        for (unsigned int j=0;j<ne;j++) e[i][j] = std::sin(0.07 * i * (j + 1)) + 0.5 * std::cos(0.31 * i + j);
+    }
+
+    return e;
+}
+
+/**
+ * @brief Frequency response G(z) = C*(zI - A)^-1*B + D with z = exp(j*w*t_s), by Gaussian elimination.
+ * @param controller Controller.
+ * @param w Angular frequency (rad/s).
+ * @return G(row, col) at index row*ne + col.
+ ******/
+inline std::vector<std::complex<double> > directFrequencyResponse(const StateSpaceController<double>& controller, const double w)
+{
+    typedef std::complex<double> Complex;
+    const unsigned int nx = controller.getNx(), ne = controller.getNe(), nu = controller.getNu();
+    const QSMatrix<double>& A = controller.getA();
+    const QSMatrix<double>& B = controller.getB();
+    const QSMatrix<double>& C = controller.getC();
+    const QSMatrix<double>& D = controller.getD();
+    const Complex z = std::exp(Complex(0, w * controller.getTimeStep()));
+
+    // [zI - A | B], reduced to [I | X]
+    std::vector<std::vector<Complex> > M(nx, std::vector<Complex>(nx + ne));
+    for (unsigned int i=0;i<nx;i++)
+    {
+        for (unsigned int j=0;j<nx;j++) M[i][j] = (i == j ? z : Complex(0)) - A(i,j);
+        for (unsigned int j=0;j<ne;j++) M[i][nx + j] = B(i,j);
+    }
+    for (unsigned int k=0;k<nx;k++)
+    {
+        unsigned int pivot = k;
+        for (unsigned int i=k+1;i<nx;i++) if (std::abs(M[i][k]) > std::abs(M[pivot][k])) pivot = i;
+        std::swap(M[k], M[pivot]);
+        for (unsigned int i=0;i<nx;i++)
+        {
+            if (i == k) continue;
+            const Complex factor = M[i][k] / M[k][k];
+            for (unsigned int j=k;j<nx+ne;j++) M[i][j] -= factor * M[k][j];
+        }
+    }
+
+    std::vector<Complex> G(nu * ne);
+    for (unsigned int row=0;row<nu;row++)
+    {
+        for (unsigned int col=0;col<ne;col++)
+        {
+            Complex sum = D(row, col);
+            for (unsigned int k=0;k<nx;k++) sum += C(row, k) * M[k][nx + col] / M[k][k];
+            G[row * ne + col] = sum;
+        }
+    }
+
+    return G;
+}
+
+#endif  // TESTCHECK_H
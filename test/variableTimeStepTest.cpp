@@ -0,0 +1,57 @@
+/**
+ * @file variableTimeStepTest.cpp
+ * @brief Checks of the variable time step mode of ContinuousStateSpaceController (time step table).
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "continuousStateSpaceController.h"
+#include "testCheck.h"
+
+using namespace std;
+
+int main()
+{
+    // dx/dt = -2x + 3e, u = x + 0.5e
+    const QSMatrix<double> Ac(1, 1, -2), Bc(1, 1, 3), Cc(1, 1, 1), Dc(1, 1, 0.5);
+    const vector<double> e(1, 1);
+
+    // Jittered intervals: each call propagates over the measured dt with the error held since the previous one
+    vector<float> dt(400);
+    for (unsigned int i=0;i<dt.size();i++) dt[i] = 0.01f + 0.004f * (float)sin(1.7 * i);
+
+    ContinuousStateSpaceController<double> exact(Ac, Bc, Cc, Dc, 0.01f, ZOH);
+    ContinuousStateSpaceController<double> linear(Ac, Bc, Cc, Dc, 0.01f, ZOH);
+    ContinuousStateSpaceController<double> nearest(Ac, Bc, Cc, Dc, 0.01f, ZOH);
+    linear.setTimeStepTable(0.005f, 0.015f, 11, LINEAR_INTERPOLATION);
+    nearest.setTimeStepTable(0.005f, 0.015f, 11, NEAREST_TIME_STEP);
+    check(linear.getTableSize() == 11, "table size");
+
+    double time = 0, linearError = 0, nearestError = 0;
+    vector<double> u;
+    for (unsigned int i=0;i<dt.size();i++)
+    {
+        u = exact.currentOutput(e, dt[i]);
+        if (i > 0) time += dt[i];
+        linearError = max(linearError, fabs(linear.currentOutput(e, dt[i])[0] - u[0]));
+        nearestError = max(nearestError, fabs(nearest.currentOutput(e, dt[i])[0] - u[0]));
+    }
+
+    // Exact discretization of each interval: analytic solution at the accumulated time
+    check(fabs(u[0] - (1.5 * (1 - exp(-2 * time)) + 0.5)) < 1e-9, "exact variable time step");
+    check(fabs(exact.getTime() - time) < 1e-4, "time accumulates the intervals");
+    check(linearError < 1e-4 && linearError < nearestError, "interpolated table");
+    check(nearestError < 1e-2, "nearest table time step");
+
+    // Tustin has no variable time step mode: a fixed step is made
+    ContinuousStateSpaceController<double> tustin(Ac, Bc, Cc, Dc, 0.01f, TUSTIN);
+    ContinuousStateSpaceController<double> fixed(Ac, Bc, Cc, Dc, 0.01f, TUSTIN);
+    check(maxDifference(tustin.currentOutput(e, 0.02f), fixed.currentOutput(e)) == 0, "Tustin falls back to a fixed step");
+
+    // The Tustin state is transformed on a time step change: a constant error keeps the output steady
+    for (unsigned int i=0;i<3000;i++) fixed.currentOutput(e);
+    fixed.setTimeStep(0.03f);
+    check(fabs(fixed.currentOutput(e)[0] - 2.0) < 1e-9, "Tustin state transform");
+
+    return testResult();
+}
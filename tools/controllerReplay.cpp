@@ -0,0 +1,517 @@
+/**
+ * @file controllerReplay.cpp
+ * @brief Offline replay of recorded logs through state-space controllers, at full speed.
+ * @details Every (controller, log) pair is a job; jobs run on a pool of threads. A log is memory-mapped and
+ * read sequentially with read-ahead, each sample goes through StateSpaceController::currentOutput() and the
+ * command trajectory is written in chunks, in the format of the log:
+ *
+ *  - CSV (any other extension than .bin): one sample per line, ne columns (e_i) or 2*ne columns (r_i then
+ *    y_i), separated by commas, semicolons or blanks; lines not starting with a number (headers) are
+ *    skipped. Output: one line of nu values per sample (shortest exact representation).
+ *  - Binary columnar (.bin): ReplayLogHeader followed by the columns, each one "rows" doubles. Output: same
+ *    format with nu columns.
+ *
+ * Output file: <output directory>/<log name>[.<controller name>].u.<extension> (controller name only with
+ * several controllers). Nothing is replayed if an output file is one of the logs or controller files, or if
+ * two jobs have the same output file. Samples/s are reported per job and for the whole replay.
+ *
+ * Usage: controller_replay [-j threads] [-n chunk samples] [-o output directory] -c controller [-c controller ...] log [log ...]
+ * (default: all cores, 65536 samples, current directory)
+ * @author Alexis Proux
+ * @date 1 July 2021
+ ******/
+
+#include "stateSpaceController.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// Header of a binary columnar log
+struct ReplayLogHeader
+{
+    char magic[8];              // "SSCLOG1"
+    uint32_t columns;
+    uint32_t scalarSize;        // sizeof(double)
+    uint64_t rows;
+};
+
+const char REPLAY_LOG_MAGIC[8] = "SSCLOG1";
+
+// Bytes read ahead of the current position
+const size_t READ_AHEAD = 8u << 20;
+
+/**
+ * @brief Read-only memory map of a log file.
+ ******/
+class MappedLog
+{
+    public:
+
+    MappedLog(const string& path): m_base(0), m_size(0)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if (fd < 0 || fstat(fd, &status) != 0)
+        {
+            if (fd >= 0) close(fd);
+            return;
+        }
+
+        m_size = status.st_size;
+        if (m_size > 0)
+        {
+            void* base = mmap(0, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (base != MAP_FAILED)
+            {
+                m_base = (const char*)base;
+                madvise(base, m_size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedLog()
+    {
+        if (m_base) munmap((void*)m_base, m_size);
+    }
+
+    // Starts reading [offset, offset + length) in the background
+    void readAhead(size_t offset, size_t length) const
+    {
+        if (!m_base || offset >= m_size) return;
+        const size_t page = sysconf(_SC_PAGESIZE);
+        const size_t begin = offset / page * page;
+        const size_t end = min(m_size, offset + length);
+        madvise((void*)(m_base + begin), end - begin, MADV_WILLNEED);
+    }
+
+    const char* data() const { return m_base; }
+    size_t size() const { return m_size; }
+    bool isOpen() const { return m_base != 0; }
+
+    private:
+    const char* m_base;
+    size_t m_size;
+};
+
+/**
+ * @brief Output file written with one write() per chunk (pwrite() at an offset for columnar files).
+ ******/
+class ChunkWriter
+{
+    public:
+
+    ChunkWriter(const string& path): m_fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)), m_failed(m_fd < 0) {}
+    ~ChunkWriter() { if (m_fd >= 0) close(m_fd); }
+
+    void write(const char* data, size_t bytes, off_t offset = -1)
+    {
+        while (!m_failed && bytes > 0)
+        {
+            const ssize_t written = (offset < 0) ? ::write(m_fd, data, bytes) : pwrite(m_fd, data, bytes, offset);
+            if (written <= 0)
+            {
+                m_failed = true;
+                return;
+            }
+            data += written;
+            bytes -= written;
+            if (offset >= 0) offset += written;
+        }
+    }
+
+    bool isOpen() const { return m_fd >= 0; }
+    bool failed() const { return m_failed; }
+
+    private:
+    int m_fd;
+    bool m_failed;
+};
+
+// Job result
+struct ReplayJob
+{
+    unsigned int controller;
+    string log;
+    string output;
+    uint64_t samples;
+    double seconds;
+    string error;
+};
+
+/**
+ * @brief One sample through the controller: values are e_i (ne values) or r_i then y_i (2*ne values).
+ ******/
+const vector<double>& replayStep(StateSpaceController<double>& controller, const double* values, const unsigned int columns,
+                                 vector<double>& r, vector<double>& y, vector<double>& u)
+{
+    const unsigned int ne = r.size();
+    if (columns == ne)
+    {
+        copy(values, values + ne, r.begin());
+        u = controller.currentOutput(r);
+    }
+    else
+    {
+        copy(values, values + ne, r.begin());
+        copy(values + ne, values + 2 * ne, y.begin());
+        u = controller.currentOutput(r, y);
+    }
+
+    return u;
+}
+
+/**
+ * @brief Parses the numbers of a CSV line.
+ * @return False if the line does not start with a number (header or empty line).
+ ******/
+bool parseLine(const char* begin, const char* end, vector<double>& values)
+{
+    values.clear();
+    const char* p = begin;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p == end || !(isdigit((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.'))
+    {
+        return false;
+    }
+
+    while (p < end)
+    {
+        if (*p == '+') p++;
+        double value;
+        const from_chars_result result = from_chars(p, end, value);
+        if (result.ec != errc())
+        {
+            return !values.empty();
+        }
+        values.push_back(value);
+        p = result.ptr;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',' || *p == ';' || *p == '\r')) p++;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Replays a CSV log.
+ ******/
+void replayCsv(StateSpaceController<double>& controller, const MappedLog& log, ChunkWriter& writer, const unsigned int chunk, ReplayJob& job)
+{
+    const unsigned int ne = controller.getNe(), nu = controller.getNu();
+    vector<double> r(ne), y(ne), u(nu), values;
+    string buffer;
+    buffer.reserve((size_t)chunk * nu * 25);
+    char number[32];
+
+    const char* p = log.data();
+    const char* end = p + log.size();
+    size_t readAheadOffset = 0;
+    unsigned int columns = 0;
+    unsigned int inChunk = 0;
+
+    while (p < end)
+    {
+        const size_t offset = p - log.data();
+        if (offset >= readAheadOffset)
+        {
+            log.readAhead(offset, READ_AHEAD);
+            readAheadOffset = offset + READ_AHEAD / 2;
+        }
+
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (!lineEnd) lineEnd = end;
+
+        if (parseLine(p, lineEnd, values))
+        {
+            if (columns == 0)
+            {
+                columns = values.size();
+                if (columns != ne && columns != 2 * ne)
+                {
+                    job.error = to_string(columns) + " columns (ne = " + to_string(ne) + " or 2*ne expected)";
+                    return;
+                }
+            }
+            if (values.size() != columns)
+            {
+                job.error = "line " + to_string(job.samples + 1) + " has " + to_string(values.size()) + " columns";
+                return;
+            }
+
+            replayStep(controller, values.data(), columns, r, y, u);
+            for (unsigned int k=0;k<nu;k++)
+            {
+                const to_chars_result result = to_chars(number, number + sizeof(number), u[k]);
+                buffer.append(number, result.ptr);
+                buffer.push_back(k + 1 < nu ? ',' : '\n');
+            }
+            job.samples++;
+
+            if (++inChunk == chunk)
+            {
+                writer.write(buffer.data(), buffer.size());
+                buffer.clear();
+                inChunk = 0;
+            }
+        }
+
+        p = lineEnd + 1;
+    }
+
+    writer.write(buffer.data(), buffer.size());
+}
+
+/**
+ * @brief Replays a binary columnar log.
+ ******/
+void replayColumnar(StateSpaceController<double>& controller, const MappedLog& log, ChunkWriter& writer, const unsigned int chunk, ReplayJob& job)
+{
+    ReplayLogHeader header;
+    if (log.size() < sizeof(header))
+    {
+        job.error = "truncated header";
+        return;
+    }
+    memcpy(&header, log.data(), sizeof(header));
+
+    const unsigned int ne = controller.getNe(), nu = controller.getNu();
+    const unsigned int columns = header.columns;
+    const uint64_t rows = header.rows;
+    if (memcmp(header.magic, REPLAY_LOG_MAGIC, sizeof(header.magic)) != 0 || header.scalarSize != sizeof(double))
+    {
+        job.error = "not a binary columnar log of doubles";
+        return;
+    }
+    if (columns != ne && columns != 2 * ne)
+    {
+        job.error = to_string(columns) + " columns (ne = " + to_string(ne) + " or 2*ne expected)";
+        return;
+    }
+    // Bounds computed by division: rows comes from the file and columns * rows * 8 may overflow
+    if (columns == 0 || columns > SIZE_MAX / sizeof(double) || rows > (log.size() - sizeof(header)) / (columns * sizeof(double)))
+    {
+        job.error = "truncated data";
+        return;
+    }
+    if (nu > 0 && rows > (UINT64_MAX - sizeof(header)) / ((uint64_t)nu * sizeof(double)))
+    {
+        job.error = "output too large";
+        return;
+    }
+
+    ReplayLogHeader outputHeader = header;
+    outputHeader.columns = nu;
+    writer.write((const char*)&outputHeader, sizeof(outputHeader), 0);
+
+    const char* data = log.data() + sizeof(header);
+    vector<double> r(ne), y(ne), u(nu), values(columns);
+    vector<double> outputs((size_t)nu * chunk);
+
+    for (uint64_t start=0;start<rows;start+=chunk)
+    {
+        const unsigned int count = min<uint64_t>(chunk, rows - start);
+
+        // Next chunk of every column
+        for (unsigned int c=0;c<columns;c++)
+        {
+            log.readAhead(sizeof(header) + (c * rows + start + count) * sizeof(double), (size_t)chunk * sizeof(double));
+        }
+
+        for (unsigned int i=0;i<count;i++)
+        {
+            for (unsigned int c=0;c<columns;c++)
+            {
+                memcpy(&values[c], data + (c * rows + start + i) * sizeof(double), sizeof(double));
+            }
+            replayStep(controller, values.data(), columns, r, y, u);
+            for (unsigned int k=0;k<nu;k++) outputs[(size_t)k * chunk + i] = u[k];
+        }
+        job.samples += count;
+
+        for (unsigned int k=0;k<nu;k++)
+        {
+            writer.write((const char*)&outputs[(size_t)k * chunk], count * sizeof(double), sizeof(header) + (k * rows + start) * sizeof(double));
+        }
+    }
+}
+
+// File name without directory and extension
+string stem(const string& path)
+{
+    const size_t slash = path.find_last_of('/');
+    const string name = (slash == string::npos) ? path : path.substr(slash + 1);
+    const size_t dot = name.find_last_of('.');
+
+    return (dot == string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+// Extension with its dot ("" if none)
+string extension(const string& path)
+{
+    const size_t slash = path.find_last_of('/');
+    const size_t dot = path.find_last_of('.');
+
+    return (dot == string::npos || (slash != string::npos && dot < slash)) ? "" : path.substr(dot);
+}
+
+// True if both paths exist and are the same file (device and inode)
+bool sameFile(const string& first, const string& second)
+{
+    struct stat a, b;
+    if (stat(first.c_str(), &a) != 0 || stat(second.c_str(), &b) != 0)
+    {
+        return false;
+    }
+
+    return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int threadCount = max(1u, thread::hardware_concurrency());
+    unsigned int chunk = 65536;
+    string outputDirectory = ".";
+    vector<string> controllerPaths, logs;
+
+    for (int k=1;k<argc;k++)
+    {
+        const string argument = argv[k];
+        if (argument == "-j" && k + 1 < argc) threadCount = max(1, atoi(argv[++k]));
+        else if (argument == "-n" && k + 1 < argc) chunk = max(1, atoi(argv[++k]));
+        else if (argument == "-o" && k + 1 < argc) outputDirectory = argv[++k];
+        else if (argument == "-c" && k + 1 < argc) controllerPaths.push_back(argv[++k]);
+        else logs.push_back(argument);
+    }
+
+    if (controllerPaths.empty() || logs.empty())
+    {
+        cout << "Usage: controller_replay [-j threads] [-n chunk samples] [-o output directory] -c controller [-c controller ...] log [log ...]" << endl;
+        return 1;
+    }
+
+    vector<StateSpaceController<double> > controllers;
+    for (unsigned int c=0;c<controllerPaths.size();c++)
+    {
+        if (!ifstream(controllerPaths[c].c_str()))
+        {
+            cout << "\033[1;31mERROR: Unable to open controller file " << controllerPaths[c] << "\033[0m" << endl;
+            return 1;
+        }
+        controllers.push_back(StateSpaceController<double>(controllerPaths[c]));
+    }
+
+    vector<ReplayJob> jobs;
+    for (unsigned int l=0;l<logs.size();l++)
+    {
+        for (unsigned int c=0;c<controllers.size();c++)
+        {
+            ReplayJob job;
+            job.controller = c;
+            job.log = logs[l];
+            job.output = outputDirectory + "/" + stem(logs[l]) + (controllers.size() > 1 ? "." + stem(controllerPaths[c]) : "") + ".u" + extension(logs[l]);
+            job.samples = 0;
+            job.seconds = 0;
+            jobs.push_back(job);
+        }
+    }
+
+    // Outputs are truncated when opened: they must not be inputs nor shared by two jobs
+    vector<string> inputs(logs);
+    inputs.insert(inputs.end(), controllerPaths.begin(), controllerPaths.end());
+    for (unsigned int j=0;j<jobs.size();j++)
+    {
+        for (unsigned int k=0;k<inputs.size();k++)
+        {
+            if (sameFile(jobs[j].output, inputs[k]))
+            {
+                cout << "\033[1;31mERROR: Output " << jobs[j].output << " is the input file " << inputs[k] << "\033[0m" << endl;
+                return 1;
+            }
+        }
+        for (unsigned int k=0;k<j;k++)
+        {
+            if (jobs[k].output == jobs[j].output || sameFile(jobs[k].output, jobs[j].output))
+            {
+                cout << "\033[1;31mERROR: " << jobs[k].log << " and " << jobs[j].log << " have the same output " << jobs[j].output << "\033[0m" << endl;
+                return 1;
+            }
+        }
+    }
+
+    atomic<unsigned int> next(0);
+    mutex printMutex;
+    vector<thread> threads;
+
+    const Clock::time_point start = Clock::now();
+    for (unsigned int t=0;t<min<size_t>(threadCount, jobs.size());t++)
+    {
+        threads.push_back(thread([&]()
+        {
+            for (unsigned int j=next++;j<jobs.size();j=next++)
+            {
+                ReplayJob& job = jobs[j];
+                const Clock::time_point jobStart = Clock::now();
+
+                // Shares the matrices of the loaded controller, own state from zero
+                StateSpaceController<double> controller(controllers[job.controller]);
+                controller.reset();
+
+                MappedLog log(job.log);
+                ChunkWriter writer(job.output);
+                if (!log.isOpen()) job.error = "unable to read the log";
+                else if (!writer.isOpen()) job.error = "unable to create " + job.output;
+                else if (extension(job.log) == ".bin") replayColumnar(controller, log, writer, chunk, job);
+                else replayCsv(controller, log, writer, chunk, job);
+                if (job.error.empty() && writer.failed()) job.error = "write error on " + job.output;
+
+                job.seconds = chrono::duration<double>(Clock::now() - jobStart).count();
+
+                lock_guard<mutex> lock(printMutex);
+                if (job.error.empty())
+                {
+                    cout << job.log << " x " << controllerPaths[job.controller] << " -> " << job.output << ": " << job.samples << " samples, "
+                         << setprecision(4) << job.samples / job.seconds << " samples/s" << endl;
+                }
+                else
+                {
+                    cout << "\033[1;31mERROR: " << job.log << " x " << controllerPaths[job.controller] << ": " << job.error << "\033[0m" << endl;
+                }
+            }
+        }));
+    }
+    for (unsigned int t=0;t<threads.size();t++) threads[t].join();
+    const double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    uint64_t samples = 0;
+    unsigned int failed = 0;
+    for (unsigned int j=0;j<jobs.size();j++)
+    {
+        samples += jobs[j].samples;
+        failed += !jobs[j].error.empty();
+    }
+
+    cout << jobs.size() << " jobs on " << threads.size() << " threads, " << samples << " samples in " << setprecision(4) << seconds << " s" << endl;
+    cout << "Throughput: " << samples / seconds << " samples/s" << endl;
+
+    return failed ? 1 : 0;
+}